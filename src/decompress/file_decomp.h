@@ -321,6 +321,12 @@ SO_PUBLIC void File_Decomp_Free(fd_session_t*);
 
 /* Call the error alerting call-back function */
 SO_PUBLIC void File_Decomp_Alert(fd_session_t*, int Event);
+
+/* Limit the memory of decompression contexts across all threads, 0 for no limit */
+SO_PUBLIC void File_Decomp_Set_Memcap(uint64_t);
+
+/* Free the idle decompression contexts pooled by this thread */
+SO_PUBLIC void File_Decomp_Thread_Term();
 }
 #endif
 
@@ -29,6 +29,8 @@
 #include "main/thread.h"
 #include "utils/util.h"
 
+#include "file_decomp_pool.h"
+
 #ifdef UNIT_TEST
 #include "catch/snort_catch.h"
 #endif
@@ -902,23 +904,17 @@ static fd_status_t Init_Stream(fd_session_t* SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
-        int z_ret;
-
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
+        z_stream*& z_s = StPtr->PDF_Decomp_State.Deflate.StreamDeflate;
 
-        memset( (char*)z_s, 0, sizeof(z_stream));
+        fd_status_t Ret_Code = fd_inflate_acquire(z_s, 47);
 
-        z_s->zalloc = (alloc_func)nullptr;
-        z_s->zfree = (free_func)nullptr;
-        SYNC_IN(z_s)
+        if ( Ret_Code == File_Decomp_DecompError )
+            File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
 
-        z_ret = inflateInit2(z_s, 47);
+        if ( Ret_Code != File_Decomp_OK )
+            return Ret_Code;
 
-        if ( z_ret != Z_OK )
-        {
-            File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
-            return File_Decomp_Error;
-        }
+        SYNC_IN(z_s)
 
         break;
     }
@@ -945,7 +941,7 @@ static fd_status_t Decomp_Stream(fd_session_t* SessionPtr)
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
         int z_ret;
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
+        z_stream* z_s = StPtr->PDF_Decomp_State.Deflate.StreamDeflate;
 
         SYNC_IN(z_s)
 
@@ -1002,17 +998,7 @@ fd_status_t File_Decomp_End_PDF(fd_session_t* SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
-        int z_ret;
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
-
-        z_ret = inflateEnd(z_s);
-
-        if ( z_ret != Z_OK )
-        {
-            File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
-            return File_Decomp_Error;
-        }
-
+        fd_inflate_release(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
         break;
     }
     default:
@@ -1084,12 +1070,15 @@ fd_status_t File_Decomp_PDF(fd_session_t* SessionPtr)
         case ( PDF_STATE_INIT_STREAM ):
         {
             /* Initialize the selected decompression engine. */
-            if ( Init_Stream(SessionPtr) != File_Decomp_OK )
+            fd_status_t Ret_Code = Init_Stream(SessionPtr);
+            if ( Ret_Code != File_Decomp_OK )
             {
                 File_Decomp_End_PDF(SessionPtr);
                 if ( Close_Stream(SessionPtr) != File_Decomp_OK )
                     return File_Decomp_Error;
-                File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
+                /* A stream skipped at the memcap is passed on without an alert */
+                if ( Ret_Code != File_Decomp_Error )
+                    File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
                 break;
             }
 
@@ -65,7 +65,8 @@ struct fd_PDF_Parse_t
 
 struct fd_PDF_Deflate_t
 {
-    z_stream StreamDeflate;
+    // from the context pool while a stream is decompressed
+    z_stream* StreamDeflate;
 };
 
 struct fd_PDF_t
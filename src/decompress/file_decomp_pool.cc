@@ -0,0 +1,289 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// file_decomp_pool.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "file_decomp_pool.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include "utils/util.h"
+
+using namespace snort;
+
+/* Idle contexts kept per thread and engine, beyond that they are freed */
+#define FD_POOL_MAX_IDLE  (32)
+
+/* Allocations are prefixed with their size for the memory accounting */
+#define FD_ALLOC_HDR_LEN  (alignof(std::max_align_t))
+
+THREAD_LOCAL FileDecompPoolStats fd_pool_stats;
+
+static std::atomic<uint64_t> fd_memory_used{0};
+static std::atomic<uint64_t> fd_memcap{0};
+
+static void* fd_alloc(size_t size)
+{
+    uint8_t* p = (uint8_t*)snort_alloc(size + FD_ALLOC_HDR_LEN);
+    *(size_t*)p = size;
+    fd_memory_used += size;
+    return p + FD_ALLOC_HDR_LEN;
+}
+
+static void fd_free(void* ptr)
+{
+    if ( ptr == nullptr )
+        return;
+
+    uint8_t* p = (uint8_t*)ptr - FD_ALLOC_HDR_LEN;
+    fd_memory_used -= *(size_t*)p;
+    snort_free(p);
+}
+
+static voidpf fd_zlib_alloc(voidpf, uInt items, uInt size)
+{ return fd_alloc((size_t)items * size); }
+
+static void fd_zlib_free(voidpf, voidpf ptr)
+{ fd_free(ptr); }
+
+#ifdef HAVE_LZMA
+static void* fd_lzma_alloc(void*, size_t nmemb, size_t size)
+{ return fd_alloc(nmemb * size); }
+
+static void fd_lzma_free(void*, void* ptr)
+{ fd_free(ptr); }
+
+static const lzma_allocator fd_lzma_allocator = { fd_lzma_alloc, fd_lzma_free, nullptr };
+#endif
+
+namespace
+{
+struct ContextPool
+{
+    ~ContextPool();
+    void trim();
+
+    std::vector<z_stream*> inflate_idle;
+#ifdef HAVE_LZMA
+    std::vector<lzma_stream*> lzma_idle;
+#endif
+};
+}
+
+static THREAD_LOCAL ContextPool* fd_pool = nullptr;
+
+static void free_inflate(z_stream* z_s)
+{
+    inflateEnd(z_s);
+    delete z_s;
+}
+
+#ifdef HAVE_LZMA
+static void free_lzma(lzma_stream* l_s)
+{
+    lzma_end(l_s);
+    delete l_s;
+}
+#endif
+
+ContextPool::~ContextPool()
+{ trim(); }
+
+void ContextPool::trim()
+{
+    for ( auto z_s : inflate_idle )
+        free_inflate(z_s);
+    inflate_idle.clear();
+
+#ifdef HAVE_LZMA
+    for ( auto l_s : lzma_idle )
+        free_lzma(l_s);
+    lzma_idle.clear();
+#endif
+}
+
+static ContextPool* get_pool()
+{
+    if ( !fd_pool )
+        fd_pool = new ContextPool;
+
+    return fd_pool;
+}
+
+/* Check the memcap before a new context is created.  Idle contexts of this
+   thread are dropped first, so a thread that switches between engines does
+   not starve itself. */
+static bool memcap_reached(ContextPool* pool)
+{
+    uint64_t cap = fd_memcap.load(std::memory_order_relaxed);
+
+    if ( !cap or fd_memory_used.load(std::memory_order_relaxed) < cap )
+        return false;
+
+    pool->trim();
+
+    if ( fd_memory_used.load(std::memory_order_relaxed) < cap )
+        return false;
+
+    fd_pool_stats.memcap_hits++;
+    return true;
+}
+
+static bool can_pool(size_t idle)
+{
+    uint64_t cap = fd_memcap.load(std::memory_order_relaxed);
+
+    return idle < FD_POOL_MAX_IDLE and
+        (!cap or fd_memory_used.load(std::memory_order_relaxed) < cap);
+}
+
+static void context_released()
+{
+    if ( fd_pool_stats.contexts_in_use )
+        fd_pool_stats.contexts_in_use--;
+}
+
+fd_status_t fd_inflate_acquire(z_stream*& z_s, int window_bits)
+{
+    assert(!z_s);
+    ContextPool* pool = get_pool();
+
+    while ( !pool->inflate_idle.empty() )
+    {
+        z_s = pool->inflate_idle.back();
+        pool->inflate_idle.pop_back();
+
+        // the window is kept as long as its size does not change
+        if ( inflateReset2(z_s, window_bits) == Z_OK )
+        {
+            fd_pool_stats.context_reuses++;
+            fd_pool_stats.contexts_in_use++;
+            return File_Decomp_OK;
+        }
+
+        free_inflate(z_s);
+        z_s = nullptr;
+    }
+
+    if ( memcap_reached(pool) )
+        return File_Decomp_Error;
+
+    z_s = new z_stream;
+    memset((char*)z_s, 0, sizeof(z_stream));
+
+    z_s->zalloc = fd_zlib_alloc;
+    z_s->zfree = fd_zlib_free;
+
+    if ( inflateInit2(z_s, window_bits) != Z_OK )
+    {
+        delete z_s;
+        z_s = nullptr;
+        return File_Decomp_DecompError;
+    }
+
+    fd_pool_stats.contexts_in_use++;
+    return File_Decomp_OK;
+}
+
+void fd_inflate_release(z_stream*& z_s)
+{
+    if ( !z_s )
+        return;
+
+    if ( fd_pool and can_pool(fd_pool->inflate_idle.size()) )
+        fd_pool->inflate_idle.push_back(z_s);
+    else
+        free_inflate(z_s);
+
+    z_s = nullptr;
+    context_released();
+}
+
+#ifdef HAVE_LZMA
+fd_status_t fd_lzma_acquire(lzma_stream*& l_s)
+{
+    assert(!l_s);
+    ContextPool* pool = get_pool();
+    bool reused = false;
+
+    if ( !pool->lzma_idle.empty() )
+    {
+        l_s = pool->lzma_idle.back();
+        pool->lzma_idle.pop_back();
+        reused = true;
+    }
+    else if ( memcap_reached(pool) )
+        return File_Decomp_Error;
+    else
+    {
+        l_s = new lzma_stream;
+        memset((char*)l_s, 0, sizeof(lzma_stream));
+        l_s->allocator = &fd_lzma_allocator;
+    }
+
+    // liblzma keeps the coder and dictionary of a stream initialized again
+    // with the same decoder
+    if ( lzma_alone_decoder(l_s, UINT64_MAX) != LZMA_OK )
+    {
+        free_lzma(l_s);
+        l_s = nullptr;
+        return File_Decomp_DecompError;
+    }
+
+    if ( reused )
+        fd_pool_stats.context_reuses++;
+
+    fd_pool_stats.contexts_in_use++;
+    return File_Decomp_OK;
+}
+
+void fd_lzma_release(lzma_stream*& l_s)
+{
+    if ( !l_s )
+        return;
+
+    if ( fd_pool and can_pool(fd_pool->lzma_idle.size()) )
+        fd_pool->lzma_idle.push_back(l_s);
+    else
+        free_lzma(l_s);
+
+    l_s = nullptr;
+    context_released();
+}
+#endif
+
+uint64_t fd_pool_memory_used()
+{ return fd_memory_used.load(std::memory_order_relaxed); }
+
+namespace snort
+{
+void File_Decomp_Set_Memcap(uint64_t memcap)
+{ fd_memcap = memcap; }
+
+void File_Decomp_Thread_Term()
+{
+    delete fd_pool;
+    fd_pool = nullptr;
+}
+}
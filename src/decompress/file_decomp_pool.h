@@ -0,0 +1,68 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// file_decomp_pool.h
+
+#ifndef FILE_DECOMP_POOL_H
+#define FILE_DECOMP_POOL_H
+
+// Per-thread pools of zlib and lzma decoder contexts.  A released context
+// keeps its state and window allocations and is reset for the next file
+// instead of being torn down.  All context memory is accounted against a
+// process-wide memcap (see File_Decomp_Set_Memcap()); once it is reached,
+// no new contexts are created and the affected file or stream is passed on
+// without decompression.  The cap is only checked when a context is created;
+// memory a decoder allocates after that (eg the zlib window on the first
+// inflate) is counted but not refused so the total may overshoot by up to
+// one window per active context.
+
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+#include <zlib.h>
+
+#include "framework/counts.h"
+#include "main/thread.h"
+
+#include "file_decomp.h"
+
+struct FileDecompPoolStats
+{
+    PegCount contexts_in_use;
+    PegCount context_reuses;
+    PegCount memcap_hits;
+};
+
+extern THREAD_LOCAL FileDecompPoolStats fd_pool_stats;
+
+/* Get an initialized inflate stream.  Returns File_Decomp_Error if the
+   memcap is reached and File_Decomp_DecompError if zlib fails. */
+fd_status_t fd_inflate_acquire(z_stream*&, int window_bits);
+
+/* Return the stream to the pool and clear the pointer, null is ignored */
+void fd_inflate_release(z_stream*&);
+
+#ifdef HAVE_LZMA
+/* Same as above for an lzma_alone decoder */
+fd_status_t fd_lzma_acquire(lzma_stream*&);
+void fd_lzma_release(lzma_stream*&);
+#endif
+
+/* Current footprint of all decompression contexts, in bytes */
+uint64_t fd_pool_memory_used();
+
+#endif
@@ -62,9 +62,10 @@ enum fd_SWF_States
 
 struct fd_SWF_t
 {
-    z_stream StreamZLIB;
+    // decoder contexts are taken from the pool in file_decomp_pool
+    z_stream* StreamZLIB;
 #ifdef HAVE_LZMA
-    lzma_stream StreamLZMA;
+    lzma_stream* StreamLZMA;
 #endif
     uint8_t Header_Bytes[SWF_MAX_HEADER];
     uint8_t State;
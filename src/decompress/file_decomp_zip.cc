@@ -26,34 +26,27 @@
 #include "helpers/boyer_moore_search.h"
 #include "utils/util.h"
 
+#include "file_decomp_pool.h"
+
 using namespace snort;
 
 // initialize zlib decompression
 static fd_status_t Inflate_Init(fd_session_t* SessionPtr)
 {
-    z_stream* z_s = &(SessionPtr->ZIP->Stream);
-
-    memset((char*)z_s, 0, sizeof(z_stream));
+    z_stream*& z_s = SessionPtr->ZIP->Stream;
 
-    z_s->zalloc = (alloc_func)nullptr;
-    z_s->zfree = (free_func)nullptr;
+    if ( fd_inflate_acquire(z_s, -MAX_WBITS) != File_Decomp_OK )
+        return File_Decomp_Error;
 
     SYNC_IN(z_s)
 
-    int z_ret = inflateInit2(z_s, -MAX_WBITS);
-
-    if ( z_ret != Z_OK )
-        return File_Decomp_Error;
-
     return File_Decomp_OK;
 }
 
 // end zlib decompression
 static fd_status_t Inflate_End(fd_session_t* SessionPtr)
 {
-    z_stream* z_s = &(SessionPtr->ZIP->Stream);
-
-    inflateEnd(z_s);
+    fd_inflate_release(SessionPtr->ZIP->Stream);
 
     return File_Decomp_OK;
 }
@@ -63,7 +56,7 @@ static fd_status_t Inflate(fd_session_t* SessionPtr)
 {
     const uint8_t *zlib_start, *zlib_end;
 
-    z_stream* z_s = &(SessionPtr->ZIP->Stream);
+    z_stream* z_s = SessionPtr->ZIP->Stream;
 
     zlib_start = SessionPtr->Next_In;
 
@@ -75,8 +75,8 @@ enum fd_ZIP_states
 
 struct fd_ZIP_t
 {
-    // zlib stream
-    z_stream Stream;
+    // zlib stream, from the context pool while inflating
+    z_stream* Stream;
 
     // decompression progress
     uint32_t progress;
@@ -0,0 +1,208 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// file_decomp_pool_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "../file_decomp_pool.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+static const char* text =
+    "the quick brown fox jumps over the lazy dog, the quick brown fox jumps over the lazy dog";
+
+static uLong deflate_text(uint8_t* buf, uLong len)
+{
+    uLongf out_len = len;
+    CHECK(compress(buf, &out_len, (const Bytef*)text, strlen(text) + 1) == Z_OK);
+    return out_len;
+}
+
+static void inflate_text(z_stream* z_s, uint8_t* in, uLong in_len)
+{
+    uint8_t out[256];
+
+    z_s->next_in = in;
+    z_s->avail_in = in_len;
+    z_s->next_out = out;
+    z_s->avail_out = sizeof(out);
+
+    CHECK(inflate(z_s, Z_SYNC_FLUSH) == Z_STREAM_END);
+    STRCMP_EQUAL(text, (const char*)out);
+}
+
+TEST_GROUP(file_decomp_pool)
+{
+    void setup() override
+    {
+        memset(&fd_pool_stats, 0, sizeof(fd_pool_stats));
+        File_Decomp_Set_Memcap(0);
+    }
+
+    void teardown() override
+    {
+        File_Decomp_Thread_Term();
+        File_Decomp_Set_Memcap(0);
+    }
+};
+
+TEST(file_decomp_pool, inflate_reuse)
+{
+    z_stream* z_s = nullptr;
+
+    CHECK(fd_inflate_acquire(z_s, MAX_WBITS) == File_Decomp_OK);
+    CHECK(z_s != nullptr);
+    CHECK(fd_pool_stats.contexts_in_use == 1);
+    CHECK(fd_pool_memory_used() > 0);
+
+    z_stream* first = z_s;
+    fd_inflate_release(z_s);
+    CHECK(z_s == nullptr);
+    CHECK(fd_pool_stats.contexts_in_use == 0);
+
+    CHECK(fd_inflate_acquire(z_s, -MAX_WBITS) == File_Decomp_OK);
+    CHECK(z_s == first);
+    CHECK(fd_pool_stats.context_reuses == 1);
+    CHECK(fd_pool_stats.contexts_in_use == 1);
+
+    fd_inflate_release(z_s);
+}
+
+TEST(file_decomp_pool, inflate_after_reset)
+{
+    uint8_t buf[256];
+    uLong len = deflate_text(buf, sizeof(buf));
+    z_stream* z_s = nullptr;
+
+    CHECK(fd_inflate_acquire(z_s, MAX_WBITS) == File_Decomp_OK);
+    inflate_text(z_s, buf, len);
+    uint64_t used = fd_pool_memory_used();
+    fd_inflate_release(z_s);
+
+    // the reset context decodes again without growing
+    CHECK(fd_inflate_acquire(z_s, MAX_WBITS) == File_Decomp_OK);
+    inflate_text(z_s, buf, len);
+    CHECK(fd_pool_memory_used() == used);
+    fd_inflate_release(z_s);
+}
+
+TEST(file_decomp_pool, memcap)
+{
+    z_stream* z1 = nullptr;
+    z_stream* z2 = nullptr;
+
+    CHECK(fd_inflate_acquire(z1, MAX_WBITS) == File_Decomp_OK);
+
+    File_Decomp_Set_Memcap(1);
+    CHECK(fd_inflate_acquire(z2, MAX_WBITS) == File_Decomp_Error);
+    CHECK(z2 == nullptr);
+    CHECK(fd_pool_stats.memcap_hits == 1);
+
+    // over the memcap a released context is freed rather than pooled
+    fd_inflate_release(z1);
+    CHECK(fd_pool_memory_used() == 0);
+
+    CHECK(fd_inflate_acquire(z2, MAX_WBITS) == File_Decomp_OK);
+    CHECK(fd_pool_stats.context_reuses == 0);
+    fd_inflate_release(z2);
+}
+
+TEST(file_decomp_pool, memcap_reuses_idle)
+{
+    z_stream* z_s = nullptr;
+    z_stream* idle = nullptr;
+
+    CHECK(fd_inflate_acquire(z_s, MAX_WBITS) == File_Decomp_OK);
+    CHECK(fd_inflate_acquire(idle, MAX_WBITS) == File_Decomp_OK);
+    fd_inflate_release(idle);
+
+    File_Decomp_Set_Memcap(fd_pool_memory_used());
+
+    // the idle context is reused, not counted against the memcap
+    CHECK(fd_inflate_acquire(idle, MAX_WBITS) == File_Decomp_OK);
+    CHECK(fd_pool_stats.context_reuses == 1);
+    CHECK(fd_pool_stats.memcap_hits == 0);
+
+    fd_inflate_release(idle);
+    fd_inflate_release(z_s);
+}
+
+#ifdef HAVE_LZMA
+// idle contexts of one engine are freed when the other needs a new one
+TEST(file_decomp_pool, memcap_trims_idle)
+{
+    const unsigned num = 4;
+    z_stream* z_s[num] = { };
+
+    for ( auto& z : z_s )
+        CHECK(fd_inflate_acquire(z, MAX_WBITS) == File_Decomp_OK);
+
+    for ( auto& z : z_s )
+        fd_inflate_release(z);
+
+    uint64_t idle = fd_pool_memory_used();
+    CHECK(idle > 0);
+
+    lzma_stream* l_s = nullptr;
+    File_Decomp_Set_Memcap(idle);
+
+    CHECK(fd_lzma_acquire(l_s) == File_Decomp_OK);
+    CHECK(fd_pool_stats.memcap_hits == 0);
+
+    // only the new lzma context is left
+    uint64_t used = fd_pool_memory_used();
+    CHECK(used > 0);
+    CHECK(used < idle / num);
+
+    fd_lzma_release(l_s);
+    File_Decomp_Set_Memcap(0);
+
+    // the idle inflate contexts are gone
+    CHECK(fd_inflate_acquire(z_s[0], MAX_WBITS) == File_Decomp_OK);
+    CHECK(fd_pool_stats.context_reuses == 0);
+    fd_inflate_release(z_s[0]);
+}
+
+TEST(file_decomp_pool, lzma_reuse)
+{
+    lzma_stream* l_s = nullptr;
+
+    CHECK(fd_lzma_acquire(l_s) == File_Decomp_OK);
+    CHECK(l_s != nullptr);
+
+    lzma_stream* first = l_s;
+    fd_lzma_release(l_s);
+
+    CHECK(fd_lzma_acquire(l_s) == File_Decomp_OK);
+    CHECK(l_s == first);
+    CHECK(fd_pool_stats.context_reuses == 1);
+
+    fd_lzma_release(l_s);
+    CHECK(fd_pool_stats.contexts_in_use == 0);
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
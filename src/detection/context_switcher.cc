@@ -231,6 +231,32 @@ void ContextSwitcher::resume(IpsContext* c)
     busy.emplace_back(c);
 }
 
+void ContextSwitcher::park()
+{
+    assert(busy.size() == 1);
+
+    IpsContext* c = busy.back();
+    assert(c->state == IpsContext::BUSY);
+
+    debug_logf(detection_trace, TRACE_DETECTION_ENGINE, nullptr,
+        "(wire) %" PRIu64 " cs::park %" PRIu64 " (i=%zu)\n",
+        c->packet_number, c->context_num, idle.size());
+
+    busy.pop_back();
+}
+
+void ContextSwitcher::unpark(IpsContext* c)
+{
+    assert(busy.empty());
+    assert(c->state == IpsContext::BUSY);
+
+    debug_logf(detection_trace, TRACE_DETECTION_ENGINE, nullptr,
+        "(wire) %" PRIu64 " cs::unpark %" PRIu64 " (i=%zu)\n",
+        c->packet_number, c->context_num, idle.size());
+
+    busy.emplace_back(c);
+}
+
 IpsContext* ContextSwitcher::get_context() const
 {
     if ( busy.empty() )
@@ -450,5 +476,47 @@ TEST_CASE("ContextSwitcher abort", "[ContextSwitcher]")
     CHECK(mgr.idle_count() == max);
     CHECK(!mgr.busy_count());
 }
+
+TEST_CASE("ContextSwitcher park", "[ContextSwitcher]")
+{
+    const unsigned max = 3;
+    ContextSwitcher mgr;
+
+    for ( unsigned i = 0; i < max; ++i )
+        mgr.push(new IpsContext);
+
+    mgr.start();
+    IpsContext* c1 = mgr.get_context();
+    mgr.park();
+    CHECK(!mgr.get_context());
+    CHECK(c1->state == IpsContext::BUSY);
+
+    mgr.start();
+    IpsContext* c2 = mgr.get_context();
+    CHECK(c2 != c1);
+    mgr.park();
+    CHECK(mgr.idle_count() == max-2);
+    CHECK(!mgr.busy_count());
+
+    mgr.unpark(c1);
+    CHECK(mgr.get_context() == c1);
+    mgr.stop();
+    CHECK(c1->state == IpsContext::IDLE);
+
+    mgr.unpark(c2);
+    CHECK(mgr.get_context() == c2);
+    mgr.interrupt();
+    mgr.complete();
+    mgr.stop();
+
+    CHECK(mgr.idle_count() == max);
+    CHECK(!mgr.busy_count());
+
+    // parked contexts are released by abort
+    mgr.start();
+    mgr.park();
+    mgr.abort();
+    CHECK(mgr.idle_count() == max);
+}
 #endif
 
@@ -36,7 +36,11 @@
 // 3.  suspend may be called to pause the current context and activate the
 // prior. multiple contexts may be suspended.
 //
-// 4.  there is no ordering of idle contexts. busy contexts are in strict LIFO
+// 4.  park may be called after a wire packet is decoded to set its context
+// aside, still busy, so the next wire packet can be started. unpark makes it
+// current again once no other wire packet is in progress.
+//
+// 5.  there is no ordering of idle contexts. busy contexts are in strict LIFO
 // order. context dependency chains are maintained in depth-first order by Flow.
 
 #include <vector>
@@ -69,6 +73,9 @@ public:
     void suspend();
     void resume(snort::IpsContext*);
 
+    void park();
+    void unpark(snort::IpsContext*);
+
     snort::IpsContext* get_context() const;
     snort::IpsContext* get_next() const;
 
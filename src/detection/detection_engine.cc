@@ -42,6 +42,7 @@
 #include "stream/stream.h"
 #include "time/packet_time.h"
 #include "trace/trace_api.h"
+#include "trace/trace_points.h"
 #include "utils/stats.h"
 
 #include "context_switcher.h"
@@ -743,8 +744,10 @@ static int log_events(void* event, void* user)
 int DetectionEngine::log_events(Packet* p)
 {
     Profile profile(eventqPerfStats);
+    uint64_t trace_start = TracePoints::start();
     SF_EVENTQ* pq = p->context->equeue;
     sfeventq_action(pq, ::log_events, (void*)p);
+    TracePoints::add(TP_EVENT_QUEUE, p, pq->cur_nodes, trace_start);
     return 0;
 }
 
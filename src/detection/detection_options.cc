@@ -743,29 +743,70 @@ struct node_profile_stats
     uint64_t checks;
     uint64_t latency_timeouts;
     uint64_t latency_suspends;
+
+    double elapsed_var;
 };
 
+static hr_duration scale_duration(hr_duration d, double f)
+{ return hr_duration(static_cast<uint64_t>(TO_TICKS(d) * f)); }
+
+// when rule profiling is sampled only some checks were timed; scale those
+// up to all checks and estimate the variance of the scaled total using the
+// sample variance with the finite population correction
+static void extrapolate_node_stats(node_profile_stats& ns, uint64_t timed, double elapsed_sq)
+{
+    if ( !timed or timed >= ns.checks )
+        return;
+
+    double n = timed;
+    double N = ns.checks;
+    double mean = TO_TICKS(ns.elapsed) / n;
+
+    ns.elapsed = scale_duration(ns.elapsed, N / n);
+    ns.elapsed_match = scale_duration(ns.elapsed_match, N / n);
+    ns.elapsed_no_match = scale_duration(ns.elapsed_no_match, N / n);
+
+    if ( timed < 2 )
+        return;
+
+    double s2 = (elapsed_sq - n * mean * mean) / (n - 1);
+
+    if ( s2 > 0 )
+        ns.elapsed_var = N * N * s2 / n * (1 - n / N);
+}
+
+// stats are summed over instances [first, last); with live set the leaf
+// totals go there instead of being added to the otn state
 static void detection_option_node_update_otn_stats(detection_option_tree_node_t* node,
-    node_profile_stats* stats, uint64_t checks, uint64_t timeouts, uint64_t suspends)
+    node_profile_stats* stats, uint64_t checks, uint64_t timeouts, uint64_t suspends,
+    unsigned first, unsigned last, OtnStateMap* live)
 {
     node_profile_stats local_stats; /* cumulative stats for this node */
     node_profile_stats node_stats;  /* sum of all instances */
 
+    uint64_t timed = 0;
+    double elapsed_sq = 0;
+
     memset(&node_stats, 0, sizeof(node_stats));
 
-    for ( unsigned i = 0; i < ThreadConfig::get_instance_max(); ++i )
+    for ( unsigned i = first; i < last; ++i )
     {
         node_stats.elapsed += node->state[i].elapsed;
         node_stats.elapsed_match += node->state[i].elapsed_match;
         node_stats.elapsed_no_match += node->state[i].elapsed_no_match;
         node_stats.checks += node->state[i].checks;
+        timed += node->state[i].timed;
+        elapsed_sq += node->state[i].elapsed_sq;
     }
 
+    extrapolate_node_stats(node_stats, timed, elapsed_sq);
+
     if ( stats )
     {
         local_stats.elapsed = stats->elapsed + node_stats.elapsed;
         local_stats.elapsed_match = stats->elapsed_match + node_stats.elapsed_match;
         local_stats.elapsed_no_match = stats->elapsed_no_match + node_stats.elapsed_no_match;
+        local_stats.elapsed_var = stats->elapsed_var + node_stats.elapsed_var;
 
         if (node_stats.checks > stats->checks)
             local_stats.checks = node_stats.checks;
@@ -780,6 +821,7 @@ static void detection_option_node_update_otn_stats(detection_option_tree_node_t*
         local_stats.elapsed = node_stats.elapsed;
         local_stats.elapsed_match = node_stats.elapsed_match;
         local_stats.elapsed_no_match = node_stats.elapsed_no_match;
+        local_stats.elapsed_var = node_stats.elapsed_var;
         local_stats.checks = node_stats.checks;
         local_stats.latency_timeouts = timeouts;
         local_stats.latency_suspends = suspends;
@@ -792,11 +834,30 @@ static void detection_option_node_update_otn_stats(detection_option_tree_node_t*
         // Right now, it looks like we're missing out on some stats although it's possible
         // that this is "corrected" in the profiler code
         auto* otn = (OptTreeNode*)node->option_data;
-        auto& state = otn->state[get_instance_id()];
+        OtnState* ps;
+
+        if ( live )
+        {
+            auto it = live->find(otn);
+
+            if ( it == live->end() )
+            {
+                // matches and alerts are counted directly in the otn state
+                it = live->emplace(otn, OtnState()).first;
+                it->second.matches = otn->state[first].matches;
+                it->second.alerts = otn->state[first].alerts;
+            }
+            ps = &it->second;
+        }
+        else
+            ps = &otn->state[get_instance_id()];
+
+        auto& state = *ps;
 
         state.elapsed += local_stats.elapsed;
         state.elapsed_match += local_stats.elapsed_match;
         state.elapsed_no_match += local_stats.elapsed_no_match;
+        state.elapsed_var += local_stats.elapsed_var;
 
         if (local_stats.checks > state.checks)
             state.checks = local_stats.checks;
@@ -809,10 +870,29 @@ static void detection_option_node_update_otn_stats(detection_option_tree_node_t*
     {
         for ( int i = 0; i < node->num_children; ++i )
             detection_option_node_update_otn_stats(node->children[i], &local_stats, checks,
-                timeouts, suspends);
+                timeouts, suspends, first, last, live);
     }
 }
 
+static void detection_option_tree_update_otn_stats(detection_option_tree_node_t* node,
+    unsigned first, unsigned last, OtnStateMap* live)
+{
+    uint64_t checks = 0;
+    uint64_t timeouts = 0;
+    uint64_t suspends = 0;
+
+    for ( unsigned i = first; i < last; ++i )
+    {
+        checks += node->state[i].checks;
+        timeouts += node->state[i].latency_timeouts;
+        suspends += node->state[i].latency_suspends;
+    }
+
+    if ( checks )
+        detection_option_node_update_otn_stats(node, nullptr, checks, timeouts, suspends,
+            first, last, live);
+}
+
 void detection_option_tree_update_otn_stats(XHash* doth)
 {
     if ( !doth )
@@ -823,22 +903,32 @@ void detection_option_tree_update_otn_stats(XHash* doth)
         auto* node = (detection_option_tree_node_t*)hnode->data;
         assert(node);
 
-        uint64_t checks = 0;
-        uint64_t timeouts = 0;
-        uint64_t suspends = 0;
+        detection_option_tree_update_otn_stats(node, 0, ThreadConfig::get_instance_max(),
+            nullptr);
+    }
+}
 
-        for ( unsigned i = 0; i < ThreadConfig::get_instance_max(); ++i )
-        {
-            checks += node->state[i].checks;
-            timeouts += node->state[i].latency_timeouts;
-            suspends += node->state[i].latency_suspends;
-        }
+void detection_option_tree_get_nodes(XHash* doth, DotNodeList& nodes)
+{
+    if ( !doth )
+        return;
 
-        if ( checks )
-            detection_option_node_update_otn_stats(node, nullptr, checks, timeouts, suspends);
+    for ( auto hnode = doth->find_first_node(); hnode; hnode = doth->find_next_node() )
+    {
+        auto* node = (detection_option_tree_node_t*)hnode->data;
+        assert(node);
+        nodes.emplace_back(node);
     }
 }
 
+void detection_option_tree_get_otn_stats(const DotNodeList& nodes, OtnStateMap& stats)
+{
+    unsigned id = get_instance_id();
+
+    for ( auto* node : nodes )
+        detection_option_tree_update_otn_stats(node, id, id + 1, &stats);
+}
+
 detection_option_tree_root_t* new_root(OptTreeNode* otn)
 {
     detection_option_tree_root_t* p = (detection_option_tree_root_t*)
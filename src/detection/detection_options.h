@@ -33,6 +33,9 @@
 
 #include <sys/time.h>
 
+#include <unordered_map>
+#include <vector>
+
 #include "detection/rule_option_types.h"
 #include "time/clock_defs.h"
 #include "trace/trace_api.h"
@@ -45,6 +48,8 @@ class XHash;
 struct Packet;
 struct SnortConfig;
 }
+struct OptTreeNode;
+struct OtnState;
 struct RuleLatencyState;
 
 typedef int (* eval_func_t)(void* option_data, class Cursor&, snort::Packet*);
@@ -73,6 +78,10 @@ struct dot_node_state_t
     uint64_t checks;
     uint64_t disables;
 
+    // sampled profiling; elapsed covers only the timed checks
+    uint64_t timed;
+    double elapsed_sq;
+
     unsigned latency_timeouts;
     unsigned latency_suspends;
 
@@ -86,8 +95,15 @@ struct dot_node_state_t
         else
             elapsed_no_match += delta;
 
+        double t = TO_TICKS(delta);
+        elapsed_sq += t * t;
+
         ++checks;
+        ++timed;
     }
+
+    void count()
+    { ++checks; }
 };
 
 struct detection_option_tree_node_t;
@@ -160,6 +176,14 @@ int detection_option_node_evaluate(
 void print_option_tree(detection_option_tree_node_t*, int level);
 void detection_option_tree_update_otn_stats(snort::XHash*);
 
+// live rule profiling; the node list is gathered on the main thread and
+// then each packet thread totals its own instance without touching otn state
+using DotNodeList = std::vector<detection_option_tree_node_t*>;
+using OtnStateMap = std::unordered_map<const OptTreeNode*, OtnState>;
+
+void detection_option_tree_get_nodes(snort::XHash*, DotNodeList&);
+void detection_option_tree_get_otn_stats(const DotNodeList&, OtnStateMap&);
+
 detection_option_tree_root_t* new_root(OptTreeNode*);
 void free_detection_option_root(void** existing_tree);
 
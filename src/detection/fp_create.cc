@@ -34,6 +34,10 @@
 
 #include "fp_create.h"
 
+#include <algorithm>
+#include <cinttypes>
+#include <vector>
+
 #include "framework/mpse.h"
 #include "framework/mpse_batch.h"
 #include "hash/ghash.h"
@@ -742,8 +746,9 @@ static int fpAddRuleGroupRule(
  *
  * 1) Build tcp/udp/icmp/ip src and dst RuleGroup objects based on the PortList Objects rules.
  *
- * 2) For each protocols PortList objects walk it's ports and assign the PORT_RULE_MAP src and
- *    dst RuleGroup[port] array pointers to that PortList objects RuleGroup.
+ * 2) For each protocols PortList objects walk it's ports and assign the src and dst
+ *    RuleGroup[port] pointers to that PortList objects RuleGroup, then compact those into
+ *    the PORT_RULE_MAP src and dst PortGroupTables.
  *
  * Implementation:
  *
@@ -818,6 +823,9 @@ static void fpCreateInitRuleMap(
     prm->prmNumSrcGroups = 0;
     prm->prmNumDstGroups = 0;
 
+    // groups are assigned per port here and then compacted into the map
+    std::vector<RuleGroup*> port_groups(MAX_PORTS);
+
     /* Process src PORT groups */
     if ( src )
     {
@@ -837,14 +845,17 @@ static void fpCreateInitRuleMap(
             prm->prmNumSrcGroups++;
 
             /* Add this port group to the src table at each port that uses it */
-            PortIteratorData pit_data(prm->prmSrcPort, po->group);
+            PortIteratorData pit_data(port_groups.data(), po->group);
             PortObject2Iterate(po, PortIteratorData::set, &pit_data);
         }
+        prm->prmSrcPort.build(port_groups.data());
     }
 
     /* process destination port groups */
     if ( dst )
     {
+        std::fill(port_groups.begin(), port_groups.end(), nullptr);
+
         for (GHashNode* node = dst->pt_mpxo_hash->find_first();
              node;
              node = dst->pt_mpxo_hash->find_next())
@@ -861,9 +872,10 @@ static void fpCreateInitRuleMap(
             prm->prmNumDstGroups++;
 
             /* Add this port group to the src table at each port that uses it */
-            PortIteratorData pit_data(prm->prmDstPort, po->group);
+            PortIteratorData pit_data(port_groups.data(), po->group);
             PortObject2Iterate(po, PortIteratorData::set, &pit_data);
         }
+        prm->prmDstPort.build(port_groups.data());
     }
 }
 
@@ -888,29 +900,17 @@ static void fpFreeRuleMaps(SnortConfig* sc)
     if (sc == nullptr)
         return;
 
-    if (sc->prmIpRTNX != nullptr)
-    {
-        snort_free(sc->prmIpRTNX);
-        sc->prmIpRTNX = nullptr;
-    }
+    prmFreeMap(sc->prmIpRTNX);
+    sc->prmIpRTNX = nullptr;
 
-    if (sc->prmIcmpRTNX != nullptr)
-    {
-        snort_free(sc->prmIcmpRTNX);
-        sc->prmIcmpRTNX = nullptr;
-    }
+    prmFreeMap(sc->prmIcmpRTNX);
+    sc->prmIcmpRTNX = nullptr;
 
-    if (sc->prmTcpRTNX != nullptr)
-    {
-        snort_free(sc->prmTcpRTNX);
-        sc->prmTcpRTNX = nullptr;
-    }
+    prmFreeMap(sc->prmTcpRTNX);
+    sc->prmTcpRTNX = nullptr;
 
-    if (sc->prmUdpRTNX != nullptr)
-    {
-        snort_free(sc->prmUdpRTNX);
-        sc->prmUdpRTNX = nullptr;
-    }
+    prmFreeMap(sc->prmUdpRTNX);
+    sc->prmUdpRTNX = nullptr;
 }
 
 static int fpGetFinalPattern(
@@ -1446,6 +1446,34 @@ static void fp_sum_port_groups(PortTable* tab, unsigned& c)
     PortTableFinalize(tab);
 }
 
+static void fp_print_port_map(
+    const char* name, PORT_RULE_MAP* prm, const PortTable* src, const PortTable* dst)
+{
+    unsigned groups = prm->prmNumSrcGroups + prm->prmNumDstGroups;
+    unsigned blocks = prm->prmSrcPort.get_block_count() + prm->prmDstPort.get_block_count();
+    size_t bytes = prm->prmSrcPort.get_memory() + prm->prmDstPort.get_memory();
+    uint64_t usecs = src->compile_usecs + dst->compile_usecs;
+
+    LogMessage("%8s%8u%8u%8zu%10" PRIu64 "\n", name, groups, blocks, bytes, usecs);
+}
+
+static void fp_print_port_maps(SnortConfig* sc, RulePortTables* port_tables)
+{
+    if ( !sc->prmTcpRTNX->prmNumSrcGroups and !sc->prmTcpRTNX->prmNumDstGroups and
+        !sc->prmUdpRTNX->prmNumSrcGroups and !sc->prmUdpRTNX->prmNumDstGroups and
+        !sc->prmIcmpRTNX->prmNumSrcGroups and !sc->prmIcmpRTNX->prmNumDstGroups and
+        !sc->prmIpRTNX->prmNumSrcGroups and !sc->prmIpRTNX->prmNumDstGroups )
+        return;
+
+    LogLabel("port group maps");
+    LogMessage("%8s%8s%8s%8s%10s\n", " ", "groups", "blocks", "bytes", "usecs");
+
+    fp_print_port_map("tcp", sc->prmTcpRTNX, port_tables->tcp.src, port_tables->tcp.dst);
+    fp_print_port_map("udp", sc->prmUdpRTNX, port_tables->udp.src, port_tables->udp.dst);
+    fp_print_port_map("icmp", sc->prmIcmpRTNX, port_tables->icmp.src, port_tables->icmp.dst);
+    fp_print_port_map("ip", sc->prmIpRTNX, port_tables->ip.src, port_tables->ip.dst);
+}
+
 static bool fp_print_port_groups(RulePortTables* port_tables)
 {
     unsigned src = 0;
@@ -1602,6 +1630,8 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
             ParseError("Failed to compile %u search engines", expected - c);
     }
 
+    fp_print_port_maps(sc, port_tables);
+
     bool label = fp_print_port_groups(port_tables);
     fp_print_service_groups(sc->spgmmTable, !label);
 
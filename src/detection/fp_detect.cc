@@ -63,6 +63,7 @@
 #include "search_engines/pat_stats.h"
 #include "stream/stream.h"
 #include "trace/trace_api.h"
+#include "trace/trace_points.h"
 #include "utils/stats.h"
 #include "utils/util.h"
 
@@ -347,6 +348,7 @@ static void detection_option_tree_evaluate(detection_option_tree_root_t* root,
     if ( RuleLatency::suspended() )
         return;
 
+    RuleContext::sample();
     Cursor c(eval_data.p);
 
     debug_log(detection_trace, TRACE_RULE_EVAL, eval_data.p, "Starting tree eval\n");
@@ -1297,7 +1299,10 @@ void fp_complete(Packet* p, bool search)
     if ( search )
     {
         Profile mpse_profile(mpsePerfStats);
+        uint64_t trace_start = TracePoints::start();
+        uint32_t searches = c->searches.items.size();
         c->searches.search_sync();
+        TracePoints::add(TP_MPSE_SEARCH, p, searches, trace_start);
     }
     {
         Profile rule_profile(rulePerfStats);
@@ -1333,7 +1338,10 @@ static void fp_immediate(Packet* p)
     MpseStash* stash = c->stash;
     {
         Profile mpse_profile(mpsePerfStats);
+        uint64_t trace_start = TracePoints::start();
+        uint32_t searches = c->searches.items.size();
         c->searches.search_sync();
+        TracePoints::add(TP_MPSE_SEARCH, p, searches, trace_start);
     }
     {
         Profile rule_profile(rulePerfStats);
@@ -1347,8 +1355,10 @@ static void fp_immediate(MpseGroup* mpg, Packet* p, const uint8_t* buf, unsigned
     MpseStash* stash = p->context->stash;
     {
         Profile mpse_profile(mpsePerfStats);
+        uint64_t trace_start = TracePoints::start();
         int start_state = 0;
         mpg->get_normal_mpse()->search(buf, len, rule_tree_queue, p->context, &start_state);
+        TracePoints::add(TP_MPSE_SEARCH, p, 0, trace_start);
     }
     {
         Profile rule_profile(rulePerfStats);
@@ -37,16 +37,77 @@
 
 #include "pcrm.h"
 
+#include <cstring>
+#include <map>
+#include <unordered_map>
+
 #include "main/snort_config.h"
-#include "utils/util.h"
 
 #include "fp_config.h"
 
+#ifdef UNIT_TEST
+#include <vector>
+
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
+PortGroupTable::PortGroupTable()
+{
+    // every port maps to the single empty block until built
+    memset(blocks, 0, sizeof(blocks));
+    cells.assign(block_size, 0);
+    groups.emplace_back(nullptr);
+}
+
+void PortGroupTable::build(RuleGroup* const* port_groups)
+{
+    std::unordered_map<RuleGroup*, uint16_t> group_index;
+    std::map<std::vector<uint16_t>, uint8_t> block_index;
+    std::vector<uint16_t> block(block_size);
+
+    cells.clear();
+    groups.clear();
+
+    for ( unsigned b = 0; b < num_blocks; ++b )
+    {
+        for ( unsigned i = 0; i < block_size; ++i )
+        {
+            RuleGroup* g = port_groups[(b << block_bits) | i];
+            auto gi = group_index.emplace(g, (uint16_t)groups.size());
+
+            if ( gi.second )
+                groups.emplace_back(g);
+
+            block[i] = gi.first->second;
+        }
+
+        auto bi = block_index.emplace(block, (uint8_t)(cells.size() >> block_bits));
+
+        if ( bi.second )
+            cells.insert(cells.end(), block.begin(), block.end());
+
+        blocks[b] = bi.first->second;
+    }
+
+    cells.shrink_to_fit();
+    groups.shrink_to_fit();
+}
+
+size_t PortGroupTable::get_memory() const
+{
+    return sizeof(*this) + cells.size() * sizeof(cells[0]) + groups.size() * sizeof(groups[0]);
+}
+
 PORT_RULE_MAP* prmNewMap()
 {
-    return (PORT_RULE_MAP*)snort_calloc(sizeof(PORT_RULE_MAP));
+    return new PORT_RULE_MAP;
+}
+
+void prmFreeMap(PORT_RULE_MAP* prm)
+{
+    delete prm;
 }
 
 /*
@@ -90,10 +151,10 @@ static int prmFindRuleGroup(
     *src = *dst = *gen = nullptr;
 
     if ( (dport != ANYPORT) and (dport < MAX_PORTS) )
-        *dst = p->prmDstPort[dport];
+        *dst = p->prmDstPort.get(dport);
 
     if ( (sport != ANYPORT) and (sport < MAX_PORTS) )
-        *src = p->prmSrcPort[sport];
+        *src = p->prmSrcPort.get(sport);
 
     /* If no Src/Dst rules - use the generic set, if any exist  */
     if ( p->prmGeneric and (p->prmGeneric->rule_count > 0) )
@@ -141,3 +202,96 @@ int prmFindRuleGroupUdp(PORT_RULE_MAP* prm, int dport, int sport, RuleGroup** sr
     return prmFindRuleGroup(prm, dport, sport, src, dst, gen);
 }
 
+
+#ifdef UNIT_TEST
+
+// groups are only compared so any distinct pointers will do
+static RuleGroup* group(unsigned i)
+{ return (RuleGroup*)(uintptr_t)(8 * (i + 1)); }
+
+static bool matches(const PortGroupTable& tab, const std::vector<RuleGroup*>& map)
+{
+    for ( int port = 0; port < MAX_PORTS; ++port )
+        if ( tab.get(port) != map[port] )
+            return false;
+
+    return true;
+}
+
+TEST_CASE("port group table", "[PortGroupTable]")
+{
+    PortGroupTable tab;
+    std::vector<RuleGroup*> map(MAX_PORTS, nullptr);
+
+    SECTION("empty")
+    {
+        CHECK(matches(tab, map));
+        CHECK(tab.get_block_count() == 1);
+
+        tab.build(map.data());
+        CHECK(matches(tab, map));
+        CHECK(tab.get_block_count() == 1);
+    }
+
+    SECTION("dedupe")
+    {
+        // 80 and 443 are in different blocks
+        map[80] = group(0);
+        map[443] = group(1);
+
+        // same layout in two blocks
+        map[8080] = group(2);
+        map[8080 + 256 * 4] = group(2);
+
+        // these three blocks are all group 3
+        for ( int port = 0x1000; port < 0x1300; ++port )
+            map[port] = group(3);
+
+        tab.build(map.data());
+        CHECK(matches(tab, map));
+
+        // empty, 80, 443, 8080, and all group 3
+        CHECK(tab.get_block_count() == 5);
+    }
+
+    SECTION("distinct blocks")
+    {
+        // every block is different so all 256 are stored
+        for ( int port = 0; port < MAX_PORTS; ++port )
+            map[port] = group(port >> 8);
+
+        tab.build(map.data());
+        CHECK(matches(tab, map));
+        CHECK(tab.get_block_count() == 256);
+    }
+
+    SECTION("distinct groups")
+    {
+        // every port has its own group
+        for ( int port = 0; port < MAX_PORTS; ++port )
+            map[port] = group(port);
+
+        tab.build(map.data());
+        CHECK(matches(tab, map));
+        CHECK(tab.get_block_count() == 256);
+    }
+
+    SECTION("rebuild")
+    {
+        for ( int port = 0; port < MAX_PORTS; ++port )
+            map[port] = group(port & 0xff);
+
+        tab.build(map.data());
+        CHECK(matches(tab, map));
+        CHECK(tab.get_block_count() == 1);
+
+        std::fill(map.begin(), map.end(), nullptr);
+        map[53] = group(0);
+
+        tab.build(map.data());
+        CHECK(matches(tab, map));
+        CHECK(tab.get_block_count() == 2);
+    }
+}
+
+#endif
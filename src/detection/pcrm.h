@@ -29,26 +29,67 @@
 // rule groups by source and dest ports as well as any
 // (generic refers to any)
 
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
 #include "ports/port_group.h"
 #include "protocols/packet.h"
 
 #define ANYPORT (-1)
 
+// PortGroupTable maps ports to rule groups in two levels.  The top level
+// selects one of 256 blocks of 256 ports and each block holds indexes into
+// the list of distinct groups.  Identical blocks are stored once, so the
+// usual few groups spread over mostly unused ports take a few KB instead of
+// a full pointer array per protocol and direction.
+class PortGroupTable
+{
+public:
+    PortGroupTable();
+
+    // port_groups has MAX_PORTS entries, nullptr where no group applies
+    void build(RuleGroup* const* port_groups);
+
+    RuleGroup* get(int port) const
+    {
+        assert(port >= 0 and port < snort::MAX_PORTS);
+        unsigned cell = (blocks[port >> block_bits] << block_bits) | (port & block_mask);
+        return groups[cells[cell]];
+    }
+
+    unsigned get_block_count() const
+    { return cells.size() >> block_bits; }
+
+    size_t get_memory() const;
+
+private:
+    static constexpr unsigned block_bits = 8;
+    static constexpr unsigned block_size = 1 << block_bits;
+    static constexpr unsigned block_mask = block_size - 1;
+    static constexpr unsigned num_blocks = snort::MAX_PORTS >> block_bits;
+
+    uint8_t blocks[num_blocks];
+    std::vector<uint16_t> cells;
+    std::vector<RuleGroup*> groups;
+};
+
 struct PORT_RULE_MAP
 {
-    int prmNumDstRules;
-    int prmNumSrcRules;
-    int prmNumGenericRules;
+    int prmNumDstRules = 0;
+    int prmNumSrcRules = 0;
+    int prmNumGenericRules = 0;
 
-    int prmNumDstGroups;
-    int prmNumSrcGroups;
+    int prmNumDstGroups = 0;
+    int prmNumSrcGroups = 0;
 
-    RuleGroup* prmSrcPort[snort::MAX_PORTS];
-    RuleGroup* prmDstPort[snort::MAX_PORTS];
-    RuleGroup* prmGeneric;
+    PortGroupTable prmSrcPort;
+    PortGroupTable prmDstPort;
+    RuleGroup* prmGeneric = nullptr;
 };
 
 PORT_RULE_MAP* prmNewMap();
+void prmFreeMap(PORT_RULE_MAP*);
 
 int prmFindRuleGroupTcp(PORT_RULE_MAP*, int, int, RuleGroup**, RuleGroup**, RuleGroup**);
 int prmFindRuleGroupUdp(PORT_RULE_MAP*, int, int, RuleGroup**, RuleGroup**, RuleGroup**);
@@ -65,6 +65,9 @@ struct OtnState
     hr_duration elapsed_match = 0_ticks;
     hr_duration elapsed_no_match = 0_ticks;
 
+    // of the extrapolated elapsed time when rule profiling is sampled
+    double elapsed_var = 0.0;
+
     uint64_t checks = 0;
     uint64_t matches = 0;
     uint8_t noalerts = 0;
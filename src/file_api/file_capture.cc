@@ -38,6 +38,9 @@
 #include "utils/stats.h"
 #include "utils/util.h"
 
+#include "file_capture_writer.h"
+#include "file_config.h"
+#include "file_lib.h"
 #include "file_mempool.h"
 #include "file_stats.h"
 
@@ -50,11 +53,8 @@ using namespace snort;
 FileMemPool* FileCapture::file_mempool = nullptr;
 int64_t FileCapture::capture_block_size = 0;
 
-std::mutex FileCapture::capture_mutex;
-std::condition_variable FileCapture::capture_cv;
-std::thread* FileCapture::file_storer = nullptr;
-std::queue<FileCapture*> FileCapture::files_waiting;
-bool FileCapture::running = true;
+std::vector<FileCaptureWriter*> FileCapture::writers;
+unsigned FileCapture::num_dirs = 0;
 
 FileCaptureState FileCapture::error_capture(FileCaptureState state)
 {
@@ -62,30 +62,6 @@ FileCaptureState FileCapture::error_capture(FileCaptureState state)
     return state;
 }
 
-// Only one writer thread supported
-void FileCapture::writer_thread()
-{
-    while (true)
-    {
-        // Wait until there are files
-        std::unique_lock<std::mutex> lk(capture_mutex);
-        capture_cv.wait(lk, [] { return !running or !files_waiting.empty(); });
-
-        // When !running we write out any remaining files before exiting.
-        // FIXIT-L should take dirty_pig into account. But this thread does not have convenient
-        // access to snort_conf.
-        if (files_waiting.empty())
-            break;
-
-        FileCapture* file = files_waiting.front();
-        files_waiting.pop();
-        lk.unlock();
-
-        file->store_file();
-        delete file;
-    }
-}
-
 FileCapture::FileCapture(int64_t min_size, int64_t max_size)
 {
     capture_size = 0;
@@ -131,11 +107,25 @@ FileCapture::~FileCapture()
         delete file_info;
 }
 
-void FileCapture::init(int64_t memcap, int64_t block_size)
+void FileCapture::init(const FileConfig& conf)
+{
+    capture_block_size = conf.capture_block_size;
+    init_mempool(conf.capture_memcap, capture_block_size);
+    init_writers(conf.capture_dirs, conf.capture_writers, conf.capture_direct_io);
+}
+
+// writers are grouped by directory so that each disk has its own queues
+void FileCapture::init_writers(const std::vector<std::string>& dirs, unsigned writers_per_dir,
+    bool direct_io)
 {
-    capture_block_size = block_size;
-    init_mempool(memcap, capture_block_size);
-    file_storer = new std::thread(writer_thread);
+    static const std::vector<std::string> log_dir { "" };
+    const std::vector<std::string>& wd = dirs.empty() ? log_dir : dirs;
+
+    num_dirs = wd.size();
+
+    for ( const auto& d : wd )
+        for ( unsigned i = 0; i < writers_per_dir; ++i )
+            writers.emplace_back(new FileCaptureWriter(d, direct_io));
 }
 
 /*
@@ -144,18 +134,12 @@ void FileCapture::init(int64_t memcap, int64_t block_size)
  */
 void FileCapture::exit()
 {
-    {
-        std::lock_guard<std::mutex> lk(capture_mutex);
-        running = false;
-    }
-    capture_cv.notify_one();
+    // FIXIT-L should take dirty_pig into account when storing remaining files
+    for ( auto* w : writers )
+        delete w;
 
-    if (file_storer)
-    {
-        file_storer->join();
-        delete file_storer;
-        file_storer = nullptr;
-    }
+    writers.clear();
+    num_dirs = 0;
 }
 
 /*
@@ -523,15 +507,21 @@ void FileCapture::store_file_async()
     if (!sha)
         return;
 
-    std::string file_name = file_info->sha_to_string(sha);
+    if ( writers.empty() )
+        return;
+
+    FileCaptureWriter* writer = writers[FileCaptureWriter::select(sha, writers.size(), num_dirs)];
 
+    std::string file_name = file_info->sha_to_string(sha);
     std::string file_full_name;
-    get_instance_file(file_full_name, file_name.c_str());
-    file_info->set_file_name(file_full_name.c_str(), file_full_name.size());
 
-    std::lock_guard<std::mutex> lk(capture_mutex);
-    files_waiting.push(this);
-    capture_cv.notify_one();
+    if ( writer->get_dir().empty() )
+        get_instance_file(file_full_name, file_name.c_str());
+    else
+        file_full_name = writer->get_dir() + "/" + file_name;
+
+    file_info->set_file_name(file_full_name.c_str(), file_full_name.size());
+    writer->queue(this);
 }
 
 /*Log file capture mempool usage*/
@@ -548,6 +538,9 @@ void FileCapture::print_mem_usage()
         LogCount("Buffers in release list", file_mempool->released());
         LogCount("Memory usage in bytes", file_mempool->allocated() * block_size);
     }
+
+    for ( unsigned i = 0; i < writers.size(); ++i )
+        writers[i]->print_stats(i);
 }
 
 //--------------------------------------------------------------------------
@@ -31,13 +31,13 @@
 // 3) Then file data can be read through file_capture_read()
 // 4) Finally, file data must be released from mempool file_capture_release()
 
-#include <condition_variable>
-#include <mutex>
-#include <queue>
-#include <thread>
+#include <string>
+#include <vector>
 
 #include "file_api.h"
 
+class FileCaptureWriter;
+class FileConfig;
 class FileMemPool;
 
 namespace snort
@@ -57,7 +57,7 @@ public:
     ~FileCapture();
 
     // this must be called during snort init
-    static void init(int64_t memcap, int64_t block_size);
+    static void init(const FileConfig&);
 
     // Capture file data to local buffer
     // This is the main function call to enable file capture
@@ -77,7 +77,7 @@ public:
     // Store files on local disk
     void store_file();
 
-    // Store file to disk asynchronously
+    // Store file to disk asynchronously, the writer takes ownership
     void store_file_async();
 
     // Log file capture mempool usage
@@ -98,9 +98,11 @@ public:
     void get_file_reset() { current_block = head; }
 
 private:
+    friend class ::FileCaptureWriter;
 
     static void init_mempool(int64_t max_file_mem, int64_t block_size);
-    static void writer_thread();
+    static void init_writers(const std::vector<std::string>& dirs, unsigned writers_per_dir,
+        bool direct_io);
     inline FileCaptureBlock* create_file_buffer();
     inline FileCaptureState save_to_file_buffer(const uint8_t* file_data, int data_size,
         int64_t max_size);
@@ -108,11 +110,8 @@ private:
 
     static FileMemPool* file_mempool;
     static int64_t capture_block_size;
-    static std::mutex capture_mutex;
-    static std::condition_variable capture_cv;
-    static std::thread* file_storer;
-    static std::queue<FileCapture*> files_waiting;
-    static bool running;
+    static std::vector<FileCaptureWriter*> writers;
+    static unsigned num_dirs;
 
     uint64_t capture_size;
     FileCaptureBlock* last;  /* last block of file data */
@@ -124,6 +123,7 @@ private:
     snort::FileInfo* file_info = nullptr;
     int64_t capture_min_size;
     int64_t capture_max_size;
+    FileCapture* next_queued = nullptr;
 };
 }
 
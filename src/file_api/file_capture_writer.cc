@@ -0,0 +1,330 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// file_capture_writer.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "file_capture_writer.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <set>
+
+#include "log/messages.h"
+#include "utils/stats.h"
+#include "utils/util.h"
+
+#include "file_capture.h"
+#include "file_lib.h"
+
+using namespace snort;
+
+// files are written in chunks of this size; it is a multiple of the O_DIRECT
+// alignment required by common file systems and devices
+#define WRITE_SIZE (1024 * 1024)
+#define DIO_ALIGN 4096
+
+FileCaptureWriter::FileCaptureWriter(const std::string& d, bool dio) : dir(d), direct_io(dio)
+{
+    void* p = nullptr;
+
+    if ( !posix_memalign(&p, DIO_ALIGN, WRITE_SIZE) )
+        buf = (uint8_t*)p;
+
+    writer = new std::thread(&FileCaptureWriter::writer_thread, this);
+}
+
+FileCaptureWriter::~FileCaptureWriter()
+{
+    stop();
+    free(buf);
+}
+
+// the sha is uniformly distributed so its leading bytes pick the directory
+// and then the writer for that directory
+unsigned FileCaptureWriter::select(const uint8_t* sha, unsigned num_writers, unsigned num_dirs)
+{
+    uint32_t hash;
+    memcpy(&hash, sha, sizeof(hash));
+
+    unsigned per_dir = num_writers / num_dirs;
+    return (hash % num_dirs) * per_dir + (hash / num_dirs) % per_dir;
+}
+
+// a missing or read only directory fails every file so only the first is logged
+static bool first_failure(const std::string& dir)
+{
+    static std::mutex dirs_mutex;
+    static std::set<std::string> dirs;
+
+    std::lock_guard<std::mutex> lk(dirs_mutex);
+    return dirs.insert(dir).second;
+}
+
+void FileCaptureWriter::queue(FileCapture* file)
+{
+    // count first so that the backlog seen by the writer never goes negative
+    queued.fetch_add(1, std::memory_order_relaxed);
+
+    FileCapture* head = pending.load(std::memory_order_relaxed);
+
+    do
+        file->next_queued = head;
+    while ( !pending.compare_exchange_weak(head, file,
+        std::memory_order_release, std::memory_order_relaxed) );
+
+    // the writer also polls so a notification racing with its wait only delays it
+    if ( !head )
+        wait_cv.notify_one();
+}
+
+void FileCaptureWriter::stop()
+{
+    if ( !writer )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lk(wait_mutex);
+        running = false;
+    }
+    wait_cv.notify_one();
+
+    writer->join();
+    delete writer;
+    writer = nullptr;
+}
+
+void FileCaptureWriter::writer_thread()
+{
+    while ( true )
+    {
+        FileCapture* list = pending.exchange(nullptr, std::memory_order_acquire);
+
+        if ( !list )
+        {
+            // remaining files are written before exiting
+            if ( !running )
+                break;
+
+            std::unique_lock<std::mutex> lk(wait_mutex);
+            wait_cv.wait_for(lk, std::chrono::milliseconds(100),
+                [this] { return !running or pending.load(std::memory_order_relaxed); });
+            continue;
+        }
+
+        uint64_t done = stored + skipped + failed;
+        uint64_t backlog = queued - done;
+
+        if ( backlog > max_backlog )
+            max_backlog = backlog;
+
+        // the list is last in, first out
+        FileCapture* fifo = nullptr;
+
+        while ( list )
+        {
+            FileCapture* next = list->next_queued;
+            list->next_queued = fifo;
+            fifo = list;
+            list = next;
+        }
+
+        while ( fifo )
+        {
+            FileCapture* next = fifo->next_queued;
+            auto start = std::chrono::steady_clock::now();
+
+            if ( store(fifo) )
+            {
+                auto usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start);
+                busy_usec += usec.count();
+            }
+            delete fifo;
+            fifo = next;
+        }
+    }
+}
+
+bool FileCaptureWriter::write_buf(int fd, size_t len)
+{
+    size_t done = 0;
+
+    while ( done < len )
+    {
+        ssize_t n = write(fd, buf + done, len - done);
+
+        if ( n < 0 )
+        {
+            if ( errno == EINTR or errno == EAGAIN )
+                continue;
+
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+bool FileCaptureWriter::store(FileCapture* file)
+{
+    FileInfo* file_info = file->get_file_info();
+
+    if ( !file_info or !buf )
+    {
+        ++failed;
+        return false;
+    }
+
+    const std::string& name = file_info->get_file_name();
+
+    // the file is named by its sha256 so an existing file is the same file
+    struct stat st;
+
+    if ( stat(name.c_str(), &st) == 0 )
+    {
+        ++skipped;
+        return false;
+    }
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    int fd = -1;
+    bool dio = false;
+
+#ifdef O_DIRECT
+    if ( direct_io )
+    {
+        // not all file systems support O_DIRECT
+        fd = open(name.c_str(), flags | O_DIRECT, 0644);
+        dio = fd >= 0;
+    }
+#endif
+
+    if ( fd < 0 )
+        fd = open(name.c_str(), flags, 0644);
+
+    if ( fd < 0 )
+    {
+        if ( first_failure(dir) )
+            ErrorMessage("File inspect: can't create %s - %s!\n", name.c_str(), get_error(errno));
+
+        ++failed;
+        return false;
+    }
+
+    if ( dio )
+        ++direct;
+
+    file->get_file_reset();
+
+    uint64_t total = 0;
+    size_t used = 0;
+    bool ok = true;
+    FileCaptureBlock* more;
+
+    do
+    {
+        uint8_t* data = nullptr;
+        int size = 0;
+
+        more = file->get_file_data(&data, &size);
+
+        if ( !data or !size )
+            break;
+
+        while ( ok and size > 0 )
+        {
+            size_t n = WRITE_SIZE - used;
+
+            if ( n > (size_t)size )
+                n = size;
+
+            memcpy(buf + used, data, n);
+            used += n;
+            data += n;
+            size -= n;
+            total += n;
+
+            if ( used == WRITE_SIZE )
+            {
+                ok = write_buf(fd, used);
+                used = 0;
+            }
+        }
+    }
+    while ( ok and more );
+
+    if ( ok and used )
+    {
+        if ( dio )
+        {
+            // O_DIRECT requires whole blocks; the padding is truncated
+            size_t len = (used + DIO_ALIGN - 1) & ~(size_t)(DIO_ALIGN - 1);
+            memset(buf + used, 0, len - used);
+            ok = write_buf(fd, len) and !ftruncate(fd, total);
+        }
+        else
+            ok = write_buf(fd, used);
+    }
+
+    int err = errno;
+    close(fd);
+
+    if ( !ok )
+    {
+        ErrorMessage("File inspect: disk writing error - %s!\n", get_error(err));
+        unlink(name.c_str());
+        ++failed;
+        return false;
+    }
+
+    ++stored;
+    bytes += total;
+    return true;
+}
+
+void FileCaptureWriter::print_stats(unsigned id) const
+{
+    uint64_t done = stored + skipped + failed;
+
+    LogMessage("File capture writer %u: %s\n", id,
+        dir.empty() ? "log directory" : dir.c_str());
+
+    LogCount("Files queued", queued);
+    LogCount("Files stored", stored);
+    LogCount("Files already stored", skipped);
+    LogCount("Files failed", failed);
+    LogCount("Files written direct", direct);
+    LogCount("Backlog", queued - done);
+    LogCount("Max backlog", max_backlog);
+    LogCount("Bytes written", bytes);
+
+    if ( busy_usec )
+        LogStat("Write rate (MB/s)", (double)bytes / busy_usec);
+}
+
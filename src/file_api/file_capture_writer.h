@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// file_capture_writer.h
+
+#ifndef FILE_CAPTURE_WRITER_H
+#define FILE_CAPTURE_WRITER_H
+
+// A file capture writer is a thread that stores captured files to one
+// directory.  Packet threads queue files with a lock free multiple producer,
+// single consumer list.  The writer coalesces file blocks into large aligned
+// writes, optionally with O_DIRECT to keep captured files out of the page cache.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace snort
+{
+class FileCapture;
+}
+
+class FileCaptureWriter
+{
+public:
+    // empty dir means the instance log directory
+    FileCaptureWriter(const std::string& dir, bool direct_io);
+    ~FileCaptureWriter();
+
+    const std::string& get_dir() const
+    { return dir; }
+
+    // takes ownership, called from packet threads
+    void queue(snort::FileCapture*);
+
+    // stores everything queued so far and joins the thread
+    void stop();
+
+    void print_stats(unsigned id) const;
+
+    uint64_t get_stored() const
+    { return stored; }
+
+    uint64_t get_skipped() const
+    { return skipped; }
+
+    uint64_t get_failed() const
+    { return failed; }
+
+    // writers are grouped by directory; returns the writer for the given sha256
+    static unsigned select(const uint8_t* sha, unsigned num_writers, unsigned num_dirs);
+
+private:
+    void writer_thread();
+    bool store(snort::FileCapture*);
+    bool write_buf(int fd, size_t len);
+
+private:
+    std::string dir;
+    bool direct_io;
+
+    uint8_t* buf = nullptr;
+    std::thread* writer = nullptr;
+    std::mutex wait_mutex;
+    std::condition_variable wait_cv;
+    std::atomic<bool> running { true };
+
+    std::atomic<snort::FileCapture*> pending { nullptr };
+
+    // updated by the writer except for queued
+    std::atomic<uint64_t> queued { 0 };
+    std::atomic<uint64_t> stored { 0 };
+    std::atomic<uint64_t> skipped { 0 };
+    std::atomic<uint64_t> failed { 0 };
+    std::atomic<uint64_t> direct { 0 };
+    std::atomic<uint64_t> bytes { 0 };
+    std::atomic<uint64_t> busy_usec { 0 };
+    std::atomic<uint64_t> max_backlog { 0 };
+};
+
+#endif
+
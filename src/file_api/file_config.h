@@ -36,6 +36,8 @@
 #define DEFAULT_FILE_CAPTURE_MAX_SIZE       1048576     // 1 MiB
 #define DEFAULT_FILE_CAPTURE_MIN_SIZE       0           // 0
 #define DEFAULT_FILE_CAPTURE_BLOCK_SIZE     32768       // 32 KiB
+#define DEFAULT_FILE_CAPTURE_WRITERS        1           // per directory
+#define DEFAULT_FILE_DECOMPRESS_MEM         0           // MiB, 0 is unlimited
 #define DEFAULT_MAX_FILES_CACHED            65536
 #define DEFAULT_MAX_FILES_PER_FLOW          128
 
@@ -52,6 +54,9 @@ public:
     uint32_t find_file_type_id(const uint8_t* buf, int len, uint64_t file_offset, void** context);
     std::string file_type_name(uint32_t id) const;
 
+    uint64_t get_decompress_memcap() const
+    { return (uint64_t)decompress_memcap * 1024 * 1024; }
+
     int64_t file_type_depth = DEFAULT_FILE_TYPE_DEPTH;
     int64_t file_signature_depth = DEFAULT_FILE_SIGNATURE_DEPTH;
     int64_t file_block_timeout = DEFAULT_FILE_BLOCK_TIMEOUT;
@@ -61,6 +66,10 @@ public:
     int64_t capture_max_size = DEFAULT_FILE_CAPTURE_MAX_SIZE;
     int64_t capture_min_size = DEFAULT_FILE_CAPTURE_MIN_SIZE;
     int64_t capture_block_size = DEFAULT_FILE_CAPTURE_BLOCK_SIZE;
+    unsigned capture_writers = DEFAULT_FILE_CAPTURE_WRITERS;
+    bool capture_direct_io = false;
+    std::vector<std::string> capture_dirs;
+    int64_t decompress_memcap = DEFAULT_FILE_DECOMPRESS_MEM;
     int64_t file_depth =  0;
     int64_t max_files_cached = DEFAULT_MAX_FILES_CACHED;
     uint64_t max_files_per_flow = DEFAULT_MAX_FILES_PER_FLOW;
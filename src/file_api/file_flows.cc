@@ -29,8 +29,10 @@
 
 #include "file_flows.h"
 
+#include "decompress/file_decomp.h"
 #include "detection/detection_engine.h"
 #include "log/messages.h"
+#include "main/reload_tuner.h"
 #include "main/snort_config.h"
 #include "managers/inspector_manager.h"
 #include "packet_tracer/packet_tracer.h"
@@ -548,6 +550,35 @@ bool FileInspect::configure(SnortConfig*)
     return true;
 }
 
+// the decompression memcap is process wide so it is only changed once the
+// reloaded config is in use, not while it is being parsed or verified
+class FileDecompReloadTuner : public ReloadResourceTuner
+{
+public:
+    explicit FileDecompReloadTuner(uint64_t memcap) : memcap(memcap) { }
+
+    bool tinit() override
+    {
+        File_Decomp_Set_Memcap(memcap);
+        return false;
+    }
+
+    bool tune_packet_context() override
+    { return true; }
+
+    bool tune_idle_context() override
+    { return true; }
+
+private:
+    uint64_t memcap;
+};
+
+void FileInspect::install_reload_handler(SnortConfig* sc)
+{
+    if ( config )
+        sc->register_reload_handler(new FileDecompReloadTuner(config->get_decompress_memcap()));
+}
+
 static void file_config_show(const FileConfig* fc)
 {
     if ( ConfigLogger::log_flag("enable_type", FileService::is_file_type_id_enabled()) )
@@ -565,8 +596,20 @@ static void file_config_show(const FileConfig* fc)
         ConfigLogger::log_value("capture_max_size", fc->capture_max_size);
         ConfigLogger::log_value("capture_min_size", fc->capture_min_size);
         ConfigLogger::log_value("capture_block_size", fc->capture_block_size);
+        ConfigLogger::log_value("capture_writers", fc->capture_writers);
+        ConfigLogger::log_flag("capture_direct_io", fc->capture_direct_io);
+
+        std::string dirs;
+        for ( const auto& d : fc->capture_dirs )
+        {
+            if ( !dirs.empty() )
+                dirs += " ";
+            dirs += d;
+        }
+        ConfigLogger::log_value("capture_dirs", dirs.empty() ? "none" : dirs.c_str());
     }
 
+    ConfigLogger::log_value("decompress_memcap", fc->decompress_memcap);
     ConfigLogger::log_value("lookup_timeout", fc->file_lookup_timeout);
     ConfigLogger::log_value("max_files_cached", fc->max_files_cached);
     ConfigLogger::log_value("max_files_per_flow", fc->max_files_per_flow);
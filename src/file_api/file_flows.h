@@ -46,6 +46,7 @@ public:
     ~FileInspect() override;
     void eval(Packet*) override { }
     bool configure(SnortConfig*) override;
+    void install_reload_handler(SnortConfig*) override;
     void show(const SnortConfig*) const override;
     FileConfig* config;
 };
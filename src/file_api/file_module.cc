@@ -29,6 +29,7 @@
 
 #include "file_module.h"
 
+#include "decompress/file_decomp_pool.h"
 #include "log/messages.h"
 #include "main/snort.h"
 #include "main/snort_config.h"
@@ -75,6 +76,15 @@ static const Parameter file_id_params[] =
     { "capture_block_size", Parameter::PT_INT, "8:max53", "32768",
       "file capture block size in bytes" },
 
+    { "capture_dirs", Parameter::PT_STRING, nullptr, nullptr,
+      "space separated list of directories for captured files (default is the log directory)" },
+
+    { "capture_writers", Parameter::PT_INT, "1:32", "1",
+      "number of threads storing captured files to each capture directory" },
+
+    { "capture_direct_io", Parameter::PT_BOOL, nullptr, "false",
+      "store captured files with O_DIRECT, bypassing the page cache" },
+
     { "max_files_cached", Parameter::PT_INT, "8:max53", "65536",
       "maximal number of files cached in memory" },
 
@@ -99,6 +109,9 @@ static const Parameter file_id_params[] =
     { "decompress_buffer_size", Parameter::PT_INT, "1024:max31", "100000",
       "file decompression buffer size" },
 
+    { "decompress_memcap", Parameter::PT_INT, "0:max53", "0",
+      "memcap for new file decompression contexts in megabytes across all threads (0 is unlimited)" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -109,6 +122,9 @@ static const PegInfo file_pegs[] =
     { CountType::SUM, "cache_failures", "number of file cache add failures" },
     { CountType::SUM, "files_not_processed", "number of files not processed due to per-flow limit" },
     { CountType::MAX, "max_concurrent_files", "maximum files processed concurrently on a flow" },
+    { CountType::NOW, "decomp_contexts_in_use", "number of zlib and lzma decompression contexts in use" },
+    { CountType::SUM, "decomp_context_reuses", "number of decompression contexts reused from the pool" },
+    { CountType::SUM, "decomp_memcap_hits", "number of files or streams not decompressed due to memcap" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -151,6 +167,12 @@ const RuleMap* FileIdModule::get_rules() const
 
 void FileIdModule::sum_stats(bool accumulate_now_stats)
 {
+    file_counts.decomp_contexts_in_use = fd_pool_stats.contexts_in_use;
+    file_counts.decomp_context_reuses += fd_pool_stats.context_reuses;
+    file_counts.decomp_memcap_hits += fd_pool_stats.memcap_hits;
+    fd_pool_stats.context_reuses = 0;
+    fd_pool_stats.memcap_hits = 0;
+
     file_stats_sum();
     Module::sum_stats(accumulate_now_stats);
 }
@@ -187,6 +209,21 @@ bool FileIdModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("capture_block_size") )
         fc->capture_block_size = v.get_int64();
 
+    else if ( v.is("capture_dirs") )
+    {
+        std::string dir;
+        v.set_first_token();
+
+        while ( v.get_next_token(dir) )
+            fc->capture_dirs.emplace_back(dir);
+    }
+
+    else if ( v.is("capture_writers") )
+        fc->capture_writers = v.get_uint32();
+
+    else if ( v.is("capture_direct_io") )
+        fc->capture_direct_io = v.get_bool();
+
     else if ( v.is("max_files_cached") )
         fc->max_files_cached = v.get_int64();
 
@@ -208,6 +245,9 @@ bool FileIdModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("decompress_buffer_size") )
         FileService::decode_conf.set_decompress_buffer_size(v.get_uint32());
 
+    else if ( v.is("decompress_memcap") )
+        fc->decompress_memcap = v.get_int64();
+
     else if ( v.is("rules_file") )
     {
         magic_file = "include ";
@@ -29,6 +29,7 @@
 
 #include "file_service.h"
 
+#include "decompress/file_decomp.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
 #include "mime/file_mime_process.h"
@@ -53,6 +54,9 @@ DecodeConfig FileService::decode_conf;
 static int64_t max_files_cached = 0;
 static int64_t capture_memcap = 0;
 static int64_t capture_block_size = 0;
+static unsigned capture_writers = 0;
+static bool capture_direct_io = false;
+static std::vector<std::string> capture_dirs;
 
 void FileService::init()
 {
@@ -76,11 +80,17 @@ void FileService::post_init()
         file_cache->set_lookup_timeout(conf->file_lookup_timeout);
     }
 
+    // reloads apply the decompression memcap through FileInspect's reload handler
+    File_Decomp_Set_Memcap(conf->get_decompress_memcap());
+
     if (file_capture_enabled)
     {
-        FileCapture::init(conf->capture_memcap, conf->capture_block_size);
+        FileCapture::init(*conf);
         capture_memcap = conf->capture_memcap;
         capture_block_size = conf->capture_block_size;
+        capture_writers = conf->capture_writers;
+        capture_direct_io = conf->capture_direct_io;
+        capture_dirs = conf->capture_dirs;
     }
     const SnortConfig* sc = SnortConfig::get_conf();
     conf->snort_protocol_id = sc->proto_ref->find("file_id");
@@ -102,6 +112,12 @@ void FileService::verify_reload(const SnortConfig* sc)
             ReloadError("Changing file_id.capture_memcap requires a restart.\n");
         if (capture_block_size != conf->capture_block_size)
             ReloadError("Changing file_id.capture_block_size requires a restart.\n");
+        if (capture_writers != conf->capture_writers)
+            ReloadError("Changing file_id.capture_writers requires a restart.\n");
+        if (capture_direct_io != conf->capture_direct_io)
+            ReloadError("Changing file_id.capture_direct_io requires a restart.\n");
+        if (capture_dirs != conf->capture_dirs)
+            ReloadError("Changing file_id.capture_dirs requires a restart.\n");
     }
 
     if (conf->snort_protocol_id == UNKNOWN_PROTOCOL_ID)
@@ -123,7 +139,10 @@ void FileService::thread_init()
 { file_stats_init(); }
 
 void FileService::thread_term()
-{ file_stats_term(); }
+{
+    file_stats_term();
+    File_Decomp_Thread_Term();
+}
 
 void FileService::enable_file_type()
 {
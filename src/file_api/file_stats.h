@@ -37,6 +37,9 @@ struct FileCounts
     PegCount cache_add_fails;
     PegCount files_over_flow_limit_not_processed;
     PegCount max_concurrent_files_per_flow;
+    PegCount decomp_contexts_in_use;
+    PegCount decomp_context_reuses;
+    PegCount decomp_memcap_hits;
     PegCount files_buffered_total;
     PegCount files_released_total;
     PegCount files_freed_total;
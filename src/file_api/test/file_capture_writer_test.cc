@@ -0,0 +1,335 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// file_capture_writer_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdarg>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "file_api/file_capture.h"
+#include "file_api/file_capture_writer.h"
+#include "file_api/file_lib.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+// a capture's min size is its index here; its data is returned in odd sized blocks
+struct TestFile
+{
+    std::string name;
+    std::string data;
+};
+
+#define TEST_BLOCK 1000
+
+static std::vector<TestFile> s_files;
+static std::vector<unsigned> s_order;
+static FileCaptureBlock s_more;
+static unsigned s_errors = 0;
+
+namespace snort
+{
+FileCapture::FileCapture(int64_t idx, int64_t max) :
+    capture_size(0), last(nullptr), head(nullptr), capture_min_size(idx), capture_max_size(max)
+{
+    file_info = new FileInfo;
+    const std::string& name = s_files[idx].name;
+    file_info->set_file_name(name.c_str(), name.size());
+}
+
+FileCapture::~FileCapture()
+{ delete file_info; }
+
+// only called by the writer thread
+FileCaptureBlock* FileCapture::get_file_data(uint8_t** buff, int* size)
+{
+    const std::string& data = s_files[capture_min_size].data;
+
+    if ( !capture_size )
+        s_order.emplace_back(capture_min_size);
+
+    size_t n = data.size() - capture_size;
+
+    if ( n > TEST_BLOCK )
+        n = TEST_BLOCK;
+
+    *buff = (uint8_t*)data.data() + capture_size;
+    *size = n;
+    capture_size += n;
+
+    return capture_size < data.size() ? &s_more : nullptr;
+}
+
+FileInfo::~FileInfo() = default;
+
+void FileInfo::set_file_name(const char* name, uint32_t len)
+{
+    file_name.assign(name, len);
+    file_name_set = true;
+}
+
+std::string& FileInfo::get_file_name()
+{ return file_name; }
+
+void ErrorMessage(const char*, ...)
+{ ++s_errors; }
+
+void LogMessage(const char*, ...) { }
+
+const char* get_error(int err)
+{ return strerror(err); }
+
+void LogCount(const char*, uint64_t, FILE*) { }
+void LogStat(const char*, double, FILE*) { }
+}
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+static unsigned add_file(const std::string& dir, size_t len)
+{
+    unsigned idx = s_files.size();
+    TestFile tf;
+
+    tf.name = dir + "/" + std::to_string(idx);
+
+    for ( size_t i = 0; i < len; ++i )
+        tf.data += (char)(idx * 7 + i);
+
+    s_files.emplace_back(tf);
+    return idx;
+}
+
+static bool stored(unsigned idx)
+{
+    const TestFile& tf = s_files[idx];
+    std::ifstream ifs(tf.name, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    struct stat st;
+
+    if ( stat(tf.name.c_str(), &st) or (size_t)st.st_size != tf.data.size() )
+        return false;
+
+    return data == tf.data;
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(file_capture_writer)
+{
+    std::string dir;
+
+    // the current directory is more likely than /tmp to support O_DIRECT
+    void setup() override
+    {
+        char tmp[] = "fcw_test_XXXXXX";
+        CHECK(mkdtemp(tmp));
+        dir = tmp;
+        s_errors = 0;
+    }
+
+    void teardown() override
+    {
+        for ( const auto& tf : s_files )
+            unlink(tf.name.c_str());
+
+        rmdir(dir.c_str());
+        s_files.clear();
+        s_order.clear();
+    }
+};
+
+// each producer's files are stored in the order it queued them
+TEST(file_capture_writer, fifo_per_producer)
+{
+    const unsigned producers = 4;
+    const unsigned per_producer = 250;
+
+    // files are numbered producer by producer
+    for ( unsigned i = 0; i < producers * per_producer; ++i )
+        add_file(dir, 1 + i % 3000);
+
+    FileCaptureWriter writer(dir, false);
+    std::vector<std::thread> threads;
+
+    for ( unsigned p = 0; p < producers; ++p )
+    {
+        threads.emplace_back([&writer, p]()
+        {
+            for ( unsigned i = 0; i < per_producer; ++i )
+                writer.queue(new FileCapture(p * per_producer + i, 0));
+        });
+    }
+    for ( auto& t : threads )
+        t.join();
+
+    writer.stop();
+
+    CHECK(writer.get_stored() == producers * per_producer);
+    CHECK(s_order.size() == producers * per_producer);
+
+    std::vector<int> last(producers, -1);
+
+    for ( auto idx : s_order )
+    {
+        unsigned p = idx / per_producer;
+        CHECK((int)idx > last[p]);
+        last[p] = idx;
+    }
+
+    for ( unsigned i = 0; i < s_files.size(); ++i )
+        CHECK(stored(i));
+}
+
+// with O_DIRECT the last partial block is padded and then truncated
+TEST(file_capture_writer, direct_io_length)
+{
+    const size_t write_size = 1024 * 1024;
+    const size_t lens[] = { 1, 4095, 4096, 4097, write_size - 1, write_size, write_size + 4097 };
+
+    for ( auto len : lens )
+        add_file(dir, len);
+
+    FileCaptureWriter writer(dir, true);
+
+    for ( unsigned i = 0; i < s_files.size(); ++i )
+        writer.queue(new FileCapture(i, 0));
+
+    writer.stop();
+
+    CHECK(writer.get_stored() == s_files.size());
+    CHECK(writer.get_failed() == 0);
+
+    for ( unsigned i = 0; i < s_files.size(); ++i )
+        CHECK(stored(i));
+}
+
+// files are named by sha256 so an existing file is not written again
+TEST(file_capture_writer, existing_file)
+{
+    unsigned idx = add_file(dir, 10);
+
+    {
+        std::ofstream ofs(s_files[idx].name);
+        ofs << "old";
+    }
+
+    FileCaptureWriter writer(dir, false);
+    writer.queue(new FileCapture(idx, 0));
+    writer.stop();
+
+    CHECK(writer.get_stored() == 0);
+    CHECK(writer.get_skipped() == 1);
+    CHECK(!stored(idx));
+}
+
+// only the first failure for a directory is logged
+TEST(file_capture_writer, open_failure)
+{
+    std::string missing = dir + "/missing";
+    std::string other = dir + "/other";
+
+    for ( unsigned i = 0; i < 3; ++i )
+        add_file(missing, 10);
+
+    add_file(other, 10);
+
+    FileCaptureWriter w1(missing, false);
+    FileCaptureWriter w2(missing, false);
+    FileCaptureWriter w3(other, false);
+
+    w1.queue(new FileCapture(0, 0));
+    w1.queue(new FileCapture(1, 0));
+    w1.stop();
+
+    w2.queue(new FileCapture(2, 0));
+    w2.stop();
+
+    CHECK(w1.get_failed() == 2);
+    CHECK(w2.get_failed() == 1);
+    CHECK(s_errors == 1);
+
+    w3.queue(new FileCapture(3, 0));
+    w3.stop();
+
+    CHECK(w3.get_failed() == 1);
+    CHECK(s_errors == 2);
+}
+
+// the sha picks the directory and then one of its writers
+TEST(file_capture_writer, select)
+{
+    std::mt19937 rng(7);
+
+    for ( unsigned num_dirs = 1; num_dirs <= 3; ++num_dirs )
+    {
+        for ( unsigned per_dir = 1; per_dir <= 4; ++per_dir )
+        {
+            unsigned num_writers = num_dirs * per_dir;
+            std::set<unsigned> used;
+
+            for ( unsigned i = 0; i < 1000; ++i )
+            {
+                uint8_t sha[32];
+
+                for ( auto& b : sha )
+                    b = rng();
+
+                uint32_t hash;
+                memcpy(&hash, sha, sizeof(hash));
+
+                unsigned idx = FileCaptureWriter::select(sha, num_writers, num_dirs);
+
+                CHECK(idx < num_writers);
+                CHECK(idx / per_dir == hash % num_dirs);
+                used.insert(idx);
+            }
+            CHECK(used.size() == num_writers);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    MemoryLeakWarningPlugin::turnOffNewDeleteOverloads();
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -24,7 +24,6 @@
 #include "expect_cache.h"
 
 #include "detection/ips_context.h"
-#include "hash/zhash.h"
 #include "packet_io/sfdaq_instance.h"
 #include "packet_tracer/packet_tracer.h"
 #include "protocols/packet.h"
@@ -36,13 +35,14 @@
 
 using namespace snort;
 
-/* Reasonably small, and prime */
-// FIXIT-L size based on max_tcp + max_udp?
-#define MAX_HASH 1021
 #define MAX_LIST    8
 #define MAX_DATA    4
 #define MAX_WAIT  300
 
+// one second buckets; must be greater than MAX_WAIT
+#define WHEEL_SIZE 512
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+
 static THREAD_LOCAL std::vector<ExpectFlow*>* packet_expect_flows = nullptr;
 
 ExpectFlow::~ExpectFlow()
@@ -117,9 +117,73 @@ struct ExpectNode
     ExpectFlow* head = nullptr;
     ExpectFlow* tail = nullptr;
 
+    FlowKey key;
+    unsigned hash = 0;
+    ExpectOwner* owner = nullptr;
+
+    // time wheel bucket linkage; next is also used for the free list
+    ExpectNode* prev = nullptr;
+    ExpectNode* next = nullptr;
+
     void clear(ExpectFlow*&);
 };
 
+struct ExpectSlot
+{
+    unsigned hash;
+    unsigned node;  // index + 1, 0 if empty
+};
+
+// the key of a control flow with expected nodes; nodes hold a pointer to
+// it but the slots refer to it by index so it doesn't move
+struct ExpectOwner
+{
+    FlowKey key;
+    unsigned hash;
+    unsigned count;
+    ExpectOwner* next;  // free list
+};
+
+// true if home is cyclically in (i, j] ie the entry at j can't move to i
+static inline bool in_run(unsigned home, unsigned i, unsigned j)
+{
+    return (i <= j) ? (i < home and home <= j) : (i < home or home <= j);
+}
+
+// the table is at least twice the max entries so there is always an empty slot
+static void add_slot(ExpectSlot* table, unsigned mask, unsigned hash, unsigned id)
+{
+    unsigned i = hash & mask;
+
+    while ( table[i].node )
+        i = (i + 1) & mask;
+
+    table[i].hash = hash;
+    table[i].node = id;
+}
+
+static void remove_slot(ExpectSlot* table, unsigned mask, unsigned hash, unsigned id)
+{
+    unsigned i = hash & mask;
+
+    while ( table[i].node != id )
+    {
+        assert(table[i].node);
+        i = (i + 1) & mask;
+    }
+
+    // backward shift deletion keeps probe sequences short without tombstones
+    for ( unsigned j = (i + 1) & mask; table[j].node; j = (j + 1) & mask )
+    {
+        if ( in_run(table[j].hash & mask, i, j) )
+            continue;
+
+        table[i] = table[j];
+        i = j;
+    }
+    table[i].node = 0;
+}
+
 void ExpectNode::clear(ExpectFlow*& list)
 {
     while (head)
@@ -138,18 +202,194 @@ void ExpectNode::clear(ExpectFlow*& list)
 // private ExpectCache methods
 //-------------------------------------------------------------------------
 
-void ExpectCache::prune_lru()
+ExpectNode* ExpectCache::find_node(const FlowKey& key, unsigned hash)
 {
-    ExpectNode* node = static_cast<ExpectNode*>( hash_table->lru_first() );
+    ++lookups;
+
+    // the table is at least twice the max nodes so there is always an empty slot
+    for ( unsigned i = hash & mask; ; i = (i + 1) & mask )
+    {
+        const ExpectSlot& slot = slots[i];
+        ++probes;
+
+        if ( !slot.node )
+            return nullptr;
+
+        if ( slot.hash == hash )
+        {
+            ExpectNode* node = nodes + slot.node - 1;
+
+            if ( FlowKey::is_equal(&node->key, &key, 0) )
+                return node;
+        }
+    }
+}
+
+ExpectNode* ExpectCache::add_node(const FlowKey& key, unsigned hash)
+{
+    ExpectNode* node = free_nodes;
     assert(node);
+    free_nodes = node->next;
+    ++num_nodes;
+
+    node->key = key;
+    node->hash = hash;
+    add_slot(slots, mask, hash, node - nodes + 1);
+
+    node->expires = packet_time() + MAX_WAIT;
+    wheel_link(node);
+
+    return node;
+}
+
+ExpectOwner* ExpectCache::find_owner(const FlowKey& key, unsigned hash)
+{
+    for ( unsigned i = hash & mask; ; i = (i + 1) & mask )
+    {
+        const ExpectSlot& slot = owner_slots[i];
+
+        if ( !slot.node )
+            return nullptr;
+
+        if ( slot.hash == hash )
+        {
+            ExpectOwner* owner = owners + slot.node - 1;
+
+            if ( FlowKey::is_equal(&owner->key, &key, 0) )
+                return owner;
+        }
+    }
+}
+
+// each owner has at least one node so there is always a free owner
+void ExpectCache::set_owner(ExpectNode* node, const FlowKey& key, unsigned hash)
+{
+    assert(!node->owner);
+    ExpectOwner* owner = find_owner(key, hash);
+
+    if ( !owner )
+    {
+        owner = free_owners;
+        assert(owner);
+        free_owners = owner->next;
+
+        owner->key = key;
+        owner->hash = hash;
+        owner->count = 0;
+        add_slot(owner_slots, mask, hash, owner - owners + 1);
+    }
+    owner->count++;
+    node->owner = owner;
+}
+
+void ExpectCache::clear_owner(ExpectNode* node)
+{
+    ExpectOwner* owner = node->owner;
+    node->owner = nullptr;
+
+    assert(owner->count);
+
+    if ( --owner->count )
+        return;
+
+    remove_slot(owner_slots, mask, owner->hash, owner - owners + 1);
+    owner->next = free_owners;
+    free_owners = owner;
+}
+
+void ExpectCache::wheel_link(ExpectNode* node)
+{
+    ExpectNode*& bucket = wheel[node->expires & WHEEL_MASK];
+
+    node->prev = nullptr;
+    node->next = bucket;
+
+    if ( bucket )
+        bucket->prev = node;
+
+    bucket = node;
+}
+
+void ExpectCache::wheel_unlink(ExpectNode* node)
+{
+    if ( node->prev )
+        node->prev->next = node->next;
+    else
+        wheel[node->expires & WHEEL_MASK] = node->next;
+
+    if ( node->next )
+        node->next->prev = node->prev;
+
+    node->prev = node->next = nullptr;
+}
+
+void ExpectCache::release(ExpectNode* node)
+{
     node->clear(free_list);
-    hash_table->release();
-    ++prunes;
+    wheel_unlink(node);
+    remove_slot(slots, mask, node->hash, node - nodes + 1);
+
+    if ( node->owner )
+        clear_owner(node);
+
+    node->next = free_nodes;
+    free_nodes = node;
+    --num_nodes;
+}
+
+// release everything that expired in the seconds since the last call; the
+// exact expiration checks on lookup still apply if time goes backwards
+void ExpectCache::expire(time_t now)
+{
+    if ( now <= wheel_time )
+        return;
+
+    time_t t = (now - wheel_time > WHEEL_SIZE) ? now - WHEEL_SIZE : wheel_time;
+    wheel_time = now;
+
+    for ( ; num_nodes and t < now; ++t )
+    {
+        ExpectNode* node = wheel[t & WHEEL_MASK];
+
+        while ( node )
+        {
+            ExpectNode* next = node->next;
+
+            if ( node->expires < now )
+            {
+                release(node);
+                ++expired;
+            }
+            node = next;
+        }
+    }
+}
+
+// the first node found from the current second is the closest to expiring
+void ExpectCache::prune_oldest()
+{
+    for ( unsigned i = 0; i < WHEEL_SIZE; ++i )
+    {
+        ExpectNode* node = wheel[(wheel_time + i) & WHEEL_MASK];
+
+        if ( node )
+        {
+            release(node);
+            ++prunes;
+            return;
+        }
+    }
+    assert(false);
 }
 
 ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
 {
-    if (!hash_table->get_num_nodes())
+    if (!num_nodes)
+        return nullptr;
+
+    expire(packet_time());
+
+    if (!num_nodes)
         return nullptr;
 
     const SfIp* srcIP = p->ptrs.ip_api.get_src();
@@ -172,7 +412,7 @@ ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
     */
     // FIXIT-P X This should be optimized to only do full matches when full keys
     //      are present, likewise for partial keys.
-    ExpectNode* node = static_cast<ExpectNode*>( hash_table->get_user_data(&key) );
+    ExpectNode* node = find_node(key, hash_ops->do_hash((const uint8_t*)&key, sizeof(key)));
     if (!node)
     {
         // FIXIT-M X This logic could fail if IPs were equal because the original key
@@ -193,12 +433,12 @@ ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
             port2 = key.port_h;
             key.port_h = 0;
         }
-        node = static_cast<ExpectNode*> ( hash_table->get_user_data(&key) );
+        node = find_node(key, hash_ops->do_hash((const uint8_t*)&key, sizeof(key)));
         if (!node)
         {
             key.port_l = port1;
             key.port_h = port2;
-            node = static_cast<ExpectNode*> ( hash_table->get_user_data(&key) );
+            node = find_node(key, hash_ops->do_hash((const uint8_t*)&key, sizeof(key)));
             if (!node)
                 return nullptr;
         }
@@ -206,8 +446,8 @@ ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
     if (!node->head || (p->pkth->ts.tv_sec > node->expires))
     {
         if (node->head)
-            node->clear(free_list);
-        hash_table->release_node(&key);
+            ++expired;
+        release(node);
         return nullptr;
     }
     /* Make sure the packet direction is correct */
@@ -226,7 +466,7 @@ ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
     return node;
 }
 
-bool ExpectCache::process_expected(ExpectNode* node, FlowKey& key, Packet* p, Flow* lws)
+bool ExpectCache::process_expected(ExpectNode* node, Packet* p, Flow* lws)
 {
     ExpectFlow* head;
     FlowData* fd;
@@ -262,7 +502,7 @@ bool ExpectCache::process_expected(ExpectNode* node, FlowKey& key, Packet* p, Fl
     }
 
     if (!node->count)
-        hash_table->release_node(&key);
+        release(node);
 
     return ignoring;
 }
@@ -271,13 +511,40 @@ bool ExpectCache::process_expected(ExpectNode* node, FlowKey& key, Packet* p, Fl
 // public ExpectCache methods
 //-------------------------------------------------------------------------
 
-ExpectCache::ExpectCache(uint32_t max)
+ExpectCache::ExpectCache(uint32_t max, uint32_t max_per_flow)
 {
-    // -size forces use of abs(size) ie w/o bumping up
-    hash_table = new ZHash(-MAX_HASH, sizeof(FlowKey));
+    hash_ops = new FlowHashKeyOps(max);
+
+    unsigned size = 1;
+    while (size < 2 * max)
+        size <<= 1;
+
+    mask = size - 1;
+    slots = new ExpectSlot[size]();
+    wheel = new ExpectNode*[WHEEL_SIZE]();
+
     nodes = new ExpectNode[max];
-    for (unsigned i = 0; i < max; ++i)
-        hash_table->push(nodes + i);
+    free_nodes = nullptr;
+    for (unsigned i = max; i > 0; --i)
+    {
+        nodes[i - 1].next = free_nodes;
+        free_nodes = nodes + i - 1;
+    }
+
+    // a cap at or above the cache size is no cap
+    max_per_owner = (max_per_flow < max) ? max_per_flow : 0;
+
+    if ( max_per_owner )
+    {
+        owner_slots = new ExpectSlot[size]();
+        owners = new ExpectOwner[max];
+
+        for (unsigned i = max; i > 0; --i)
+        {
+            owners[i - 1].next = free_owners;
+            free_owners = owners + i - 1;
+        }
+    }
 
     /* Preallocate a pool of ExpectFlows big enough to handle the worst case
         requirement (max number of nodes * max flows per node) and add them all
@@ -299,7 +566,11 @@ ExpectCache::ExpectCache(uint32_t max)
 
 ExpectCache::~ExpectCache()
 {
-    delete hash_table;
+    delete hash_ops;
+    delete[] slots;
+    delete[] owner_slots;
+    delete[] owners;
+    delete[] wheel;
     delete[] nodes;
     delete[] pool;
     delete packet_expect_flows;
@@ -338,20 +609,45 @@ int ExpectCache::add_flow(const Packet *ctrlPkt, PktType type, IpProtocol ip_pro
     bool reversed_key = key.init(ctrlPkt->context->conf, type, ip_proto, cliIP, cliPort,
         srvIP, srvPort, vlanId, mplsId, *ctrlPkt->pkth);
 
+    expire(packet_time());
+
     bool new_node = false;
-    ExpectNode* node = static_cast<ExpectNode*> ( hash_table->get_user_data(&key) );
-    if ( !node )
+    unsigned hash = hash_ops->do_hash((const uint8_t*)&key, sizeof(key));
+    ExpectNode* node = find_node(key, hash);
+
+    if ( node and packet_time() > node->expires )
     {
-        if ( hash_table->full() )
-            prune_lru();
-        node = static_cast<ExpectNode*> ( hash_table->get(&key) );
-        assert(node);
-        new_node = true;
+        // node is past its expiration date, whack it and start over
+        if ( node->head )
+            ++expired;
+        release(node);
+        node = nullptr;
     }
-    else if ( packet_time() > node->expires )
+
+    if ( !node )
     {
-        // node is past its expiration date, whack it and reuse it.
-        node->clear(free_list);
+        const FlowKey* owner = (max_per_owner and ctrlPkt->flow) ? ctrlPkt->flow->key : nullptr;
+        unsigned owner_hash = 0;
+
+        if ( owner )
+        {
+            owner_hash = hash_ops->do_hash((const uint8_t*)owner, sizeof(*owner));
+            const ExpectOwner* eo = find_owner(*owner, owner_hash);
+
+            if ( eo and eo->count >= max_per_owner )
+            {
+                ++capped;
+                return -1;
+            }
+        }
+        if ( !free_nodes )
+            prune_oldest();
+
+        node = add_node(key, hash);
+
+        if ( owner )
+            set_owner(node, *owner, owner_hash);
+
         new_node = true;
     }
 
@@ -440,7 +736,14 @@ int ExpectCache::add_flow(const Packet *ctrlPkt, PktType type, IpProtocol ip_pro
         new_expect_flow = true;
     }
     last->add_flow_data(fd);
-    node->expires = packet_time() + MAX_WAIT;
+
+    time_t expires = packet_time() + MAX_WAIT;
+    if ( node->expires != expires )
+    {
+        wheel_unlink(node);
+        node->expires = expires;
+        wheel_link(node);
+    }
     ++expects;
     if ( new_expect_flow )
     {
@@ -467,6 +770,6 @@ bool ExpectCache::check(Packet* p, Flow* lws)
     if (!node)
         return false;
 
-    return process_expected(node, key, p, lws);
+    return process_expected(node, p, lws);
 }
 
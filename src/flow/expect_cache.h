@@ -37,11 +37,18 @@
 //    has the same preproc id in the flow data list
 // -- when a new expect is added, the last list struct is used if the
 //    given preproc id is not already in the flow data list
-// -- nodes are preallocated and stored in hash table; if there is no node
-//    available when an expect is added, LRU nodes are pruned
-// -- list structs are also preallocated and stored in free list; if there
-//    is no list struct available when an expect is added, LRU nodes are
-//    pruned freeing up both nodes and list structs
+// -- nodes are preallocated and indexed by an open addressing table of
+//    (hash, node) slots sized to at least twice the number of nodes so
+//    probe sequences stay short and a miss touches only a cache line or two
+// -- nodes are also linked into a time wheel of one second buckets by
+//    expiration time; expired nodes are released as time advances and if
+//    there is no node available when an expect is added, the node closest
+//    to expiring is pruned
+// -- list structs are preallocated and stored in free list; there is
+//    always one available since each node may have at most MAX_LIST
+// -- if configured, a control flow may hold at most max_per_flow nodes so
+//    one busy control flow (eg a sip trunk) can't crowd out all the others;
+//    control flows are identified by their key since flows are pooled
 // -- the number of list structs per node is capped at MAX_LIST; once
 //    reached, requests to add new expects requiring new list structs fail
 // -- the number of data structs per list struct is not capped
@@ -65,6 +72,8 @@
 #include "target_based/snort_protocols.h"
 
 struct ExpectNode;
+struct ExpectOwner;
+struct ExpectSlot;
 
 namespace snort
 {
@@ -90,7 +99,7 @@ struct SO_PUBLIC ExpectFlow
 class ExpectCache
 {
 public:
-    ExpectCache(uint32_t max);
+    ExpectCache(uint32_t max, uint32_t max_per_flow);
     ~ExpectCache();
 
     ExpectCache(const ExpectCache&) = delete;
@@ -109,26 +118,61 @@ public:
     unsigned long get_realized() { return realized; }
     unsigned long get_prunes() { return prunes; }
     unsigned long get_overflows() { return overflows; }
+    unsigned long get_expired() { return expired; }
+    unsigned long get_capped() { return capped; }
+    unsigned long get_lookups() { return lookups; }
+    unsigned long get_probes() { return probes; }
+
     void reset_stats()
     {
         expects = 0;
         realized = 0;
         prunes = 0;
         overflows = 0;
+        expired = 0;
+        capped = 0;
+        lookups = 0;
+        probes = 0;
     }
 
 private:
-    void prune_lru();
+    void expire(time_t);
+    void prune_oldest();
+    void release(ExpectNode*);
+
+    ExpectNode* find_node(const snort::FlowKey&, unsigned hash);
+    ExpectNode* add_node(const snort::FlowKey&, unsigned hash);
+
+    void wheel_link(ExpectNode*);
+    void wheel_unlink(ExpectNode*);
+
+    ExpectOwner* find_owner(const snort::FlowKey&, unsigned hash);
+    void set_owner(ExpectNode*, const snort::FlowKey&, unsigned hash);
+    void clear_owner(ExpectNode*);
 
-    ExpectNode* get_node(snort::FlowKey&, bool&);
     snort::ExpectFlow* get_flow(ExpectNode*, uint32_t, int16_t);
     bool set_data(ExpectNode*, snort::ExpectFlow*&, snort::FlowData*);
     ExpectNode* find_node_by_packet(snort::Packet*, snort::FlowKey&);
-    bool process_expected(ExpectNode*, snort::FlowKey&, snort::Packet*, snort::Flow*);
+    bool process_expected(ExpectNode*, snort::Packet*, snort::Flow*);
 
 private:
-    class ZHash* hash_table;
+    snort::FlowHashKeyOps* hash_ops;
+
+    ExpectSlot* slots;
+    unsigned mask;
+
     ExpectNode* nodes;
+    ExpectNode* free_nodes;
+    ExpectNode** wheel;
+    time_t wheel_time = 0;
+    unsigned num_nodes = 0;
+
+    // only allocated if max_per_owner is not zero
+    ExpectSlot* owner_slots = nullptr;
+    ExpectOwner* owners = nullptr;
+    ExpectOwner* free_owners = nullptr;
+    unsigned max_per_owner;
+
     snort::ExpectFlow* pool;
     snort::ExpectFlow* free_list;
 
@@ -136,6 +180,10 @@ private:
     unsigned long realized = 0;
     unsigned long prunes = 0;
     unsigned long overflows = 0;
+    unsigned long expired = 0;
+    unsigned long capped = 0;
+    unsigned long lookups = 0;
+    unsigned long probes = 0;
 };
 
 #endif
@@ -110,6 +110,11 @@ Flow* FlowCache::find(const FlowKey* key)
     return flow;
 }
 
+// lookup without touching the flow or the cache order; the flow may still
+// be released or replaced before the packet gets to stream
+Flow* FlowCache::peek(const FlowKey* key)
+{ return (Flow*)hash_table->peek_user_data(key); }
+
 // always prepend
 void FlowCache::link_uni(Flow* flow)
 {
@@ -52,6 +52,7 @@ public:
     FlowCache& operator=(const FlowCache&) = delete;
 
     snort::Flow* find(const snort::FlowKey*);
+    snort::Flow* peek(const snort::FlowKey*);
     snort::Flow* allocate(const snort::FlowKey*);
 
     bool release(snort::Flow*, PruneReason = PruneReason::NONE, bool do_cleanup = true);
@@ -36,6 +36,7 @@
 #include "pub_sub/intrinsic_event_ids.h"
 #include "pub_sub/packet_events.h"
 #include "stream/stream.h"
+#include "trace/trace_points.h"
 #include "utils/util.h"
 
 #include "expect_cache.h"
@@ -386,6 +387,9 @@ bool FlowControl::process(PktType type, Packet* p, bool* new_flow)
     if ( !get_proto_session[to_utype(type)] )
         return false;
 
+    uint64_t trace_start = TracePoints::start();
+    bool created = false;
+
     FlowKey key;
     set_key(&key, p);
     Flow* flow = cache->find(&key);
@@ -409,6 +413,8 @@ bool FlowControl::process(PktType type, Packet* p, bool* new_flow)
 
             if ( new_flow )
                 *new_flow = true;
+
+            created = true;
         }
     }
 
@@ -418,6 +424,8 @@ bool FlowControl::process(PktType type, Packet* p, bool* new_flow)
         flow->session = get_proto_session[to_utype(type)](flow);
     }
 
+    TracePoints::add_flow(TP_FLOW_LOOKUP, flow, p, created, trace_start);
+
     num_flows += process(flow, p);
 
     // FIXIT-M refactor to unlink_uni immediately after session
@@ -428,6 +436,21 @@ bool FlowControl::process(PktType type, Packet* p, bool* new_flow)
     return true;
 }
 
+// the lookup done by process() is repeated when the packet gets to stream
+// since earlier packets may create or release the flow in the meantime;
+// this one only warms the cache row and the flow for it
+void FlowControl::prefetch_flow(Packet* p)
+{
+    if ( !p->has_ip() or !get_proto_session[to_utype(p->type())] )
+        return;
+
+    FlowKey key;
+    set_key(&key, p);
+
+    if ( Flow* flow = cache->peek(&key) )
+        __builtin_prefetch(flow);
+}
+
 unsigned FlowControl::process(Flow* flow, Packet* p)
 {
     unsigned news = 0;
@@ -570,14 +593,14 @@ void FlowControl::update_stats(Flow* flow, Packet* p)
 // expected
 //-------------------------------------------------------------------------
 
-void FlowControl::init_exp(uint32_t max)
+void FlowControl::init_exp(uint32_t max, uint32_t max_per_flow)
 {
     max >>= 9;
 
     if ( !max )
         max = 2;
 
-    exp_cache = new ExpectCache(max);
+    exp_cache = new ExpectCache(max, max_per_flow);
 }
 
 void FlowControl::check_expected_flow(Flow* flow, Packet* p)
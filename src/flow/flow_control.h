@@ -55,10 +55,11 @@ public:
     void set_flow_cache_config(const FlowCacheConfig& cfg);
     const FlowCacheConfig& get_flow_cache_config() const;
     void init_proto(PktType, snort::InspectSsnFunc);
-    void init_exp(uint32_t max);
+    void init_exp(uint32_t max, uint32_t max_per_flow);
     unsigned get_flows_allocated() const;
 
     bool process(PktType, snort::Packet*, bool* new_flow = nullptr);
+    void prefetch_flow(snort::Packet*);
     snort::Flow* find_flow(const snort::FlowKey*);
     snort::Flow* new_flow(const snort::FlowKey*);
     void release_flow(const snort::FlowKey*);
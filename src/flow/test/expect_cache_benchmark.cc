@@ -0,0 +1,270 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// expect_cache_benchmark.cc
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <daq_common.h>
+
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "detection/ips_context.h"
+#include "flow/expect_cache.h"
+#include "flow/flow.h"
+#include "framework/data_bus.h"
+#include "main/snort_config.h"
+#include "packet_tracer/packet_tracer.h"
+#include "protocols/packet.h"
+#include "protocols/vlan.h"
+#include "sfip/sf_ip.h"
+#include "stream/stream.h"
+#include "time/packet_time.h"
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+static time_t s_packet_time = 1000;
+static SnortConfig* s_conf = nullptr;
+static std::vector<FlowData*> s_realized;
+
+THREAD_LOCAL PacketTracer* snort::s_pkt_trace = nullptr;
+
+namespace snort
+{
+time_t packet_time()
+{ return s_packet_time; }
+
+const SnortConfig* SnortConfig::get_conf()
+{ return s_conf; }
+
+SnortConfig::SnortConfig(const SnortConfig* const, const char*) { }
+SnortConfig::~SnortConfig() = default;
+
+IpsContext::IpsContext(unsigned) { }
+IpsContext::~IpsContext() = default;
+
+Packet::Packet(bool) { }
+Packet::~Packet() = default;
+
+Flow::Flow() = default;
+Flow::~Flow() = default;
+
+int Flow::set_flow_data(FlowData* fd)
+{
+    s_realized.emplace_back(fd);
+    return 0;
+}
+
+unsigned FlowData::flow_data_id = 0;
+
+FlowData::FlowData(unsigned u, Inspector*)
+{
+    next = prev = nullptr;
+    handler = nullptr;
+    id = u;
+}
+
+FlowData::~FlowData() = default;
+
+void PacketTracer::log(const char*, ...) { }
+
+void DataBus::publish(unsigned, unsigned, DataEvent&, Flow*) { }
+
+namespace ip
+{
+void IpApi::set(const SfIp& sip, const SfIp& dip)
+{
+    type = IAT_DATA;
+    src = sip;
+    dst = dip;
+    iph = nullptr;
+}
+}
+
+namespace layer
+{
+const vlan::VlanTagHdr* get_vlan_layer(const Packet* const)
+{ return nullptr; }
+}
+}
+
+//--------------------------------------------------------------------------
+// a sip media workload: each call is a control flow that expects an audio
+// and a video stream with rtp and rtcp from the callee to a known port on
+// the caller.  most new flows are not expected at all.
+//--------------------------------------------------------------------------
+
+#define CACHE_SIZE 1024
+#define NUM_CALLS   200
+#define NUM_MEDIA     4
+
+class MediaData : public FlowData
+{
+public:
+    MediaData() : FlowData(media_id) { }
+    static unsigned media_id;
+};
+
+unsigned MediaData::media_id = FlowData::create_flow_data_id();
+
+struct Endpoint
+{
+    Packet pkt;
+    DAQ_PktHdr_t pkth = { };
+
+    Endpoint(IpsContext* ctx, const SfIp& sip, uint16_t sp, const SfIp& dip, uint16_t dp)
+    {
+        pkt.context = ctx;
+        pkt.pkth = &pkth;
+        pkt.flow = nullptr;
+        pkt.daq_instance = nullptr;
+        pkt.proto_bits = 0;
+        pkt.ip_proto_next = IpProtocol::UDP;
+        pkt.ptrs.set_pkt_type(PktType::UDP);
+        pkt.ptrs.ip_api.set(sip, dip);
+        pkt.ptrs.sp = sp;
+        pkt.ptrs.dp = dp;
+    }
+};
+
+struct SipCalls
+{
+    SnortConfig conf;
+    IpsContext ctx;
+    ExpectCache cache;
+
+    std::vector<Flow*> calls;
+    std::vector<SfIp> callers;
+    std::vector<Endpoint*> media;
+    std::vector<Endpoint*> others;
+
+    SipCalls() : cache(CACHE_SIZE, 0)
+    {
+        s_conf = &conf;
+        ctx.conf = &conf;
+
+        SfIp callee;
+        uint32_t c = htonl(0x0a010001);
+        callee.set(&c, AF_INET);
+
+        for ( unsigned i = 0; i < NUM_CALLS; ++i )
+        {
+            SfIp caller;
+            uint32_t a = htonl(0x0a020000 + i);
+            caller.set(&a, AF_INET);
+
+            calls.emplace_back(new Flow);
+            callers.emplace_back(caller);
+
+            for ( unsigned m = 0; m < NUM_MEDIA; ++m )
+                media.emplace_back(new Endpoint(&ctx, callee, 40000 + i, caller, 20000 + 2 * m));
+        }
+
+        // unrelated new flows with the same addresses but other ports
+        for ( unsigned i = 0; i < CACHE_SIZE; ++i )
+        {
+            SfIp client;
+            uint32_t a = htonl(0x0a030000 + i);
+            client.set(&a, AF_INET);
+            others.emplace_back(new Endpoint(&ctx, client, 50000 + i, callers[i % NUM_CALLS], 443));
+        }
+    }
+
+    ~SipCalls()
+    {
+        for ( auto* f : calls )
+            delete f;
+        for ( auto* e : media )
+            delete e;
+        for ( auto* e : others )
+            delete e;
+    }
+
+    void invite(unsigned i)
+    {
+        Endpoint& sip = *others[i];
+        sip.pkt.flow = calls[i];
+
+        for ( unsigned m = 0; m < NUM_MEDIA; ++m )
+        {
+            const Packet& rtp = media[i * NUM_MEDIA + m]->pkt;
+            cache.add_flow(&sip.pkt, PktType::UDP, IpProtocol::UDP, rtp.ptrs.ip_api.get_src(), 0,
+                rtp.ptrs.ip_api.get_dst(), rtp.ptrs.dp, SSN_DIR_BOTH, new MediaData);
+        }
+        sip.pkt.flow = nullptr;
+    }
+};
+
+TEST_CASE("expect cache sip media", "[expect_cache]")
+{
+    SipCalls sip;
+    Flow flow;
+
+    for ( unsigned i = 0; i < NUM_CALLS; ++i )
+        sip.invite(i);
+
+    BENCHMARK("new flow not expected")
+    {
+        unsigned n = 0;
+        for ( auto* e : sip.others )
+            n += sip.cache.is_expected(&e->pkt);
+        return n;
+    };
+
+    BENCHMARK("new flow expected")
+    {
+        unsigned n = 0;
+        for ( auto* e : sip.media )
+            n += sip.cache.is_expected(&e->pkt);
+        return n;
+    };
+
+    BENCHMARK("invite and realize media")
+    {
+        unsigned n = 0;
+        for ( unsigned i = 0; i < NUM_CALLS; ++i )
+        {
+            for ( unsigned m = 0; m < NUM_MEDIA; ++m )
+                n += sip.cache.check(&sip.media[i * NUM_MEDIA + m]->pkt, &flow);
+            sip.invite(i);
+        }
+        for ( auto* fd : s_realized )
+            delete fd;
+        s_realized.clear();
+        return n;
+    };
+
+    BENCHMARK("invite with expiration")
+    {
+        ++s_packet_time;
+        for ( unsigned i = 0; i < NUM_CALLS; ++i )
+            sip.invite(i);
+        return sip.cache.get_expects();
+    };
+}
+
+#endif
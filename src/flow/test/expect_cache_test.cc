@@ -0,0 +1,438 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// expect_cache_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <daq_common.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "detection/ips_context.h"
+#include "flow/expect_cache.h"
+#include "flow/flow.h"
+#include "flow/flow_key.h"
+#include "framework/data_bus.h"
+#include "main/snort_config.h"
+#include "packet_tracer/packet_tracer.h"
+#include "protocols/packet.h"
+#include "protocols/vlan.h"
+#include "sfip/sf_ip.h"
+#include "stream/stream.h"
+#include "time/packet_time.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+static time_t s_packet_time = 1000;
+static SnortConfig* s_conf = nullptr;
+static std::vector<FlowData*> s_realized;
+
+THREAD_LOCAL PacketTracer* snort::s_pkt_trace = nullptr;
+
+namespace snort
+{
+time_t packet_time()
+{ return s_packet_time; }
+
+const SnortConfig* SnortConfig::get_conf()
+{ return s_conf; }
+
+SnortConfig::SnortConfig(const SnortConfig* const, const char*) { }
+SnortConfig::~SnortConfig() = default;
+
+IpsContext::IpsContext(unsigned) { }
+IpsContext::~IpsContext() = default;
+
+Packet::Packet(bool) { }
+Packet::~Packet() = default;
+
+Flow::Flow() = default;
+Flow::~Flow() = default;
+
+// handle_expected() is called after this so keep the data until the test ends
+int Flow::set_flow_data(FlowData* fd)
+{
+    s_realized.emplace_back(fd);
+    return 0;
+}
+
+unsigned FlowData::flow_data_id = 0;
+
+FlowData::FlowData(unsigned u, Inspector*)
+{
+    next = prev = nullptr;
+    handler = nullptr;
+    id = u;
+}
+
+FlowData::~FlowData() = default;
+
+void PacketTracer::log(const char*, ...) { }
+
+void DataBus::publish(unsigned, unsigned, DataEvent&, Flow*) { }
+
+namespace ip
+{
+void IpApi::set(const SfIp& sip, const SfIp& dip)
+{
+    type = IAT_DATA;
+    src = sip;
+    dst = dip;
+    iph = nullptr;
+}
+}
+
+namespace layer
+{
+const vlan::VlanTagHdr* get_vlan_layer(const Packet* const)
+{ return nullptr; }
+}
+}
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+#define MAX_WAIT 300
+
+class TestData : public FlowData
+{
+public:
+    TestData() : FlowData(test_id) { }
+    static unsigned test_id;
+};
+
+unsigned TestData::test_id = FlowData::create_flow_data_id();
+
+struct TestPacket
+{
+    Packet pkt;
+    DAQ_PktHdr_t pkth = { };
+
+    TestPacket(IpsContext* ctx, uint32_t sip, uint16_t sp, uint32_t dip, uint16_t dp)
+    {
+        SfIp src;
+        SfIp dst;
+        sip = htonl(sip);
+        dip = htonl(dip);
+        src.set(&sip, AF_INET);
+        dst.set(&dip, AF_INET);
+
+        pkt.context = ctx;
+        pkt.pkth = &pkth;
+        pkt.flow = nullptr;
+        pkt.daq_instance = nullptr;
+        pkt.proto_bits = 0;
+        pkt.ip_proto_next = IpProtocol::UDP;
+        pkt.ptrs.set_pkt_type(PktType::UDP);
+        pkt.ptrs.ip_api.set(src, dst);
+        pkt.ptrs.sp = sp;
+        pkt.ptrs.dp = dp;
+    }
+
+    void set_time()
+    { pkth.ts.tv_sec = s_packet_time; }
+};
+
+// the control packet for an expect and a data packet that matches it
+struct Expected
+{
+    TestPacket ctrl;
+    TestPacket data;
+
+    Expected(IpsContext* ctx, unsigned i) :
+        ctrl(ctx, 0x0a030000 + i, 5060, 0x0a020000 + i, 5060),
+        data(ctx, 0x0a010001, 40000 + i, 0x0a020000 + i, 20000 + i)
+    { }
+};
+
+class ExpectTest
+{
+public:
+    ExpectTest(unsigned max, unsigned max_per_flow, unsigned num) : cache(max, max_per_flow)
+    {
+        s_conf = &conf;
+        ctx.conf = &conf;
+
+        for ( unsigned i = 0; i < num; ++i )
+            expected.emplace_back(new Expected(&ctx, i));
+    }
+
+    ~ExpectTest()
+    {
+        for ( auto* e : expected )
+            delete e;
+
+        for ( auto* fd : s_realized )
+            delete fd;
+
+        s_realized.clear();
+    }
+
+    int add(unsigned i, Flow* owner = nullptr)
+    {
+        Packet& ctrl = expected[i]->ctrl.pkt;
+        const Packet& data = expected[i]->data.pkt;
+
+        ctrl.flow = owner;
+        FlowData* fd = new TestData;
+
+        int rc = cache.add_flow(&ctrl, PktType::UDP, IpProtocol::UDP, data.ptrs.ip_api.get_src(),
+            0, data.ptrs.ip_api.get_dst(), data.ptrs.dp, SSN_DIR_BOTH, fd);
+
+        if ( rc )
+            delete fd;
+
+        return rc;
+    }
+
+    bool is_expected(unsigned i)
+    {
+        expected[i]->data.set_time();
+        return cache.is_expected(&expected[i]->data.pkt);
+    }
+
+    bool realize(unsigned i)
+    {
+        unsigned n = s_realized.size();
+        expected[i]->data.set_time();
+        cache.check(&expected[i]->data.pkt, &flow);
+        return s_realized.size() > n;
+    }
+
+    SnortConfig conf;
+    IpsContext ctx;
+    ExpectCache cache;
+    Flow flow;
+    std::vector<Expected*> expected;
+};
+
+// a control flow with its own key
+struct ControlFlow
+{
+    Flow flow;
+    FlowKey key;
+
+    ControlFlow(unsigned i)
+    {
+        memset((void*)&key, 0, sizeof(key));
+        key.ip_l[3] = i;
+        key.port_l = 5060;
+        flow.key = &key;
+    }
+};
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(expect_cache)
+{
+    void setup() override
+    { s_packet_time = 1000; }
+};
+
+TEST(expect_cache, add_and_realize)
+{
+    ExpectTest t(16, 0, 4);
+
+    CHECK(!t.is_expected(0));
+    CHECK(t.add(0) == 0);
+    CHECK(t.is_expected(0));
+    CHECK(!t.is_expected(1));
+
+    CHECK(t.realize(0));
+    CHECK(!t.is_expected(0));
+    CHECK(!t.realize(0));
+
+    CHECK(t.cache.get_expects() == 1);
+    CHECK(t.cache.get_realized() == 1);
+}
+
+// a small table with a random mix of adds, realizes, and time steps forces
+// collisions and backward shifts; results must match a simple model
+TEST(expect_cache, backward_shift)
+{
+    const unsigned max = 16;
+    const unsigned num = 64;
+
+    ExpectTest t(max, 0, num);
+    std::map<unsigned, time_t> model;
+    std::mt19937 rng(5);
+
+    for ( unsigned step = 0; step < 20000; ++step )
+    {
+        unsigned i = rng() % num;
+        unsigned op = rng() % 8;
+
+        if ( op < 4 )
+        {
+            // only new nodes and no pruning so the model stays simple
+            if ( model.size() < max and !model.count(i) )
+            {
+                CHECK(t.add(i) == 0);
+                model[i] = s_packet_time + MAX_WAIT;
+            }
+        }
+        else if ( op < 7 )
+        {
+            CHECK(t.realize(i) == (model.count(i) != 0));
+            model.erase(i);
+        }
+        else
+            s_packet_time += rng() % 100;
+
+        // the cache releases nodes that expired before now
+        for ( auto it = model.begin(); it != model.end(); )
+        {
+            if ( it->second < s_packet_time )
+                it = model.erase(it);
+            else
+                ++it;
+        }
+
+        if ( !(step % 64) )
+        {
+            for ( unsigned j = 0; j < num; ++j )
+                CHECK(t.is_expected(j) == (model.count(j) != 0));
+        }
+    }
+    CHECK(t.cache.get_prunes() == 0);
+    CHECK(t.cache.get_expired() > 0);
+}
+
+TEST(expect_cache, wheel_expiry)
+{
+    ExpectTest t(8, 0, 16);
+
+    for ( unsigned i = 0; i < 8; ++i )
+        CHECK(t.add(i) == 0);
+
+    s_packet_time += MAX_WAIT;
+    CHECK(t.is_expected(0));
+
+    // everything is released as time advances, not just what is looked up
+    s_packet_time += 1;
+    CHECK(!t.is_expected(8));
+    CHECK(t.cache.get_expired() == 8);
+
+    for ( unsigned i = 8; i < 16; ++i )
+        CHECK(t.add(i) == 0);
+
+    CHECK(t.cache.get_prunes() == 0);
+
+    for ( unsigned i = 0; i < 8; ++i )
+        CHECK(!t.is_expected(i));
+}
+
+TEST(expect_cache, prune_oldest)
+{
+    ExpectTest t(4, 0, 5);
+
+    for ( unsigned i = 0; i < 4; ++i )
+    {
+        CHECK(t.add(i) == 0);
+        s_packet_time += 1;
+    }
+    CHECK(t.add(4) == 0);
+    CHECK(t.cache.get_prunes() == 1);
+
+    CHECK(!t.is_expected(0));
+
+    for ( unsigned i = 1; i < 5; ++i )
+        CHECK(t.is_expected(i));
+}
+
+TEST(expect_cache, no_cap_by_default)
+{
+    ExpectTest t(16, 0, 16);
+    ControlFlow trunk(1);
+
+    for ( unsigned i = 0; i < 16; ++i )
+        CHECK(t.add(i, &trunk.flow) == 0);
+
+    CHECK(t.cache.get_capped() == 0);
+}
+
+TEST(expect_cache, cap)
+{
+    ExpectTest t(16, 4, 8);
+    ControlFlow trunk(1);
+    ControlFlow other(2);
+
+    for ( unsigned i = 0; i < 4; ++i )
+        CHECK(t.add(i, &trunk.flow) == 0);
+
+    CHECK(t.add(4, &trunk.flow) == -1);
+    CHECK(t.cache.get_capped() == 1);
+    CHECK(!t.is_expected(4));
+
+    // more for an existing node doesn't count against the cap
+    CHECK(t.add(3, &trunk.flow) == 0);
+
+    // other flows are not affected
+    CHECK(t.add(4, &other.flow) == 0);
+
+    // realizing frees up room
+    CHECK(t.realize(0));
+    CHECK(t.add(5, &trunk.flow) == 0);
+    CHECK(t.add(6, &trunk.flow) == -1);
+    CHECK(t.cache.get_capped() == 2);
+
+    // expiration frees up room too
+    s_packet_time += MAX_WAIT + 1;
+    CHECK(t.add(6, &trunk.flow) == 0);
+    CHECK(t.cache.get_capped() == 2);
+}
+
+// flows are pooled so the same Flow may be a different control flow later
+TEST(expect_cache, cap_by_key)
+{
+    ExpectTest t(16, 2, 4);
+    ControlFlow trunk(1);
+    FlowKey reused;
+
+    CHECK(t.add(0, &trunk.flow) == 0);
+    CHECK(t.add(1, &trunk.flow) == 0);
+    CHECK(t.add(2, &trunk.flow) == -1);
+
+    memset((void*)&reused, 0, sizeof(reused));
+    reused.ip_l[3] = 3;
+    trunk.flow.key = &reused;
+
+    CHECK(t.add(2, &trunk.flow) == 0);
+    CHECK(t.add(3, &trunk.flow) == 0);
+    CHECK(t.cache.get_capped() == 1);
+}
+
+int main(int argc, char** argv)
+{
+    MemoryLeakWarningPlugin::turnOffNewDeleteOverloads();
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
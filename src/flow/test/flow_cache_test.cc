@@ -97,7 +97,7 @@ void Flow::set_mpls_layer_per_dir(Packet*) { }
 void DetectionEngine::disable_all(Packet*) { }
 void Stream::drop_traffic(const Packet*, char) { }
 bool Stream::blocked_flow(Packet*) { return true; }
-ExpectCache::ExpectCache(uint32_t) { }
+ExpectCache::ExpectCache(uint32_t, uint32_t) { }
 bool ExpectCache::check(Packet*, Flow*) { return true; }
 bool ExpectCache::is_expected(Packet*) { return true; }
 Flow* HighAvailabilityManager::import(Packet&, FlowKey&) { return nullptr; }
@@ -272,6 +272,41 @@ TEST(flow_prune, prune_all_blocked_flows)
     delete cache;
 }
 
+// Peeking a flow finds it without moving it to the MRU
+TEST(flow_prune, peek_flows)
+{
+    FlowCacheConfig fcg;
+    fcg.max_flows = 2;
+    FlowCache *cache = new FlowCache(fcg);
+
+    FlowKey flow_key;
+    memset(&flow_key, 0, sizeof(FlowKey));
+    flow_key.pkt_type = PktType::TCP;
+
+    flow_key.port_l = 1;
+    Flow* first = cache->allocate(&flow_key);
+
+    flow_key.port_l = 2;
+    Flow* second = cache->allocate(&flow_key);
+
+    flow_key.port_l = 1;
+    CHECK(cache->peek(&flow_key) == first);
+
+    // the first flow is still the LRU
+    CHECK(cache->delete_flows(1) == 1);
+    CHECK(cache->peek(&flow_key) == nullptr);
+
+    flow_key.port_l = 2;
+    CHECK(cache->peek(&flow_key) == second);
+
+    flow_key.port_l = 3;
+    CHECK(cache->peek(&flow_key) == nullptr);
+
+    cache->purge();
+    CHECK(cache->get_flows_allocated() == 0);
+    delete cache;
+}
+
 int main(int argc, char** argv)
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
@@ -25,6 +25,8 @@
 // elements in stats must be the same as the number of elements in the peg
 // info (and in the same sequence).
 
+#include <atomic>
+
 #include "main/snort_types.h"
 
 typedef uint64_t PegCount;
@@ -50,6 +52,80 @@ struct PegInfo
 };
 
 
+// single writer, multiple reader copy of one thread's counts (a seqlock).
+// the owning thread publishes between packets and any other thread can read
+// a consistent copy at any time without locking or messaging the owner.  a
+// read that overlaps a publish is simply retried.
+class PegSnapshot
+{
+public:
+    PegSnapshot() = default;
+    PegSnapshot(const PegSnapshot&) = delete;
+    PegSnapshot& operator=(const PegSnapshot&) = delete;
+
+    ~PegSnapshot()
+    { delete[] counts; }
+
+    void init(unsigned n)
+    {
+        delete[] counts;
+        counts = new std::atomic<PegCount>[n];
+        num = n;
+
+        for ( unsigned i = 0; i < num; ++i )
+            counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    unsigned size() const
+    { return num; }
+
+    // owning thread only; base, if given, is added to src
+    void publish(const PegCount* src, const PegCount* base = nullptr)
+    {
+        uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for ( unsigned i = 0; i < num; ++i )
+            counts[i].store(base ? src[i] + base[i] : src[i], std::memory_order_relaxed);
+
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // any thread; dst must hold size() counts
+    void read(PegCount* dst) const
+    {
+        uint64_t before, after;
+
+        do
+        {
+            before = seq.load(std::memory_order_acquire);
+
+            if ( before & 1 )
+            {
+                after = before + 1;
+                continue;
+            }
+
+            for ( unsigned i = 0; i < num; ++i )
+                dst[i] = counts[i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq.load(std::memory_order_relaxed);
+        }
+        while ( before != after );
+    }
+
+    // number of completed publishes
+    uint64_t get_version() const
+    { return seq.load(std::memory_order_acquire) >> 1; }
+
+private:
+    std::atomic<uint64_t> seq { 0 };
+    std::atomic<PegCount>* counts = nullptr;
+    unsigned num = 0;
+};
+
 namespace snort
 {
 SO_PUBLIC extern const struct PegInfo simple_pegs[];
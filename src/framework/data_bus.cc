@@ -108,10 +108,11 @@ void DataBus::clone(DataBus& from, const char* exclude_name)
             if ( !exclude_name || strcmp(exclude_name, h->module_name) )
             {
                 h->cloned = true;
-                _subscribe(i, 0, h);
+                add_handler(i, h);
             }
         }
     }
+    compile();
 }
 
 unsigned DataBus::get_id(const PubKey& key)
@@ -163,13 +164,32 @@ void DataBus::unsubscribe_global(const PubKey& key, unsigned eid, DataHandler* h
 // notify subscribers of event
 void DataBus::publish(unsigned pid, unsigned eid, DataEvent& e, Flow* f)
 {
-    SnortConfig::get_conf()->global_dbus->_publish(pid, eid, e, f);
+    unsigned idx = pid + eid;
+
+    SnortConfig::get_conf()->global_dbus->_publish(idx, e, f);
 
     NetworkPolicy* ni = get_network_policy();
-    ni->dbus._publish(pid, eid, e, f);
+    ni->dbus._publish(idx, e, f);
 
     InspectionPolicy* pi = get_inspection_policy();
-    pi->dbus._publish(pid, eid, e, f);
+    pi->dbus._publish(idx, e, f);
+}
+
+// the buses are looked up once for the whole batch
+void DataBus::publish(unsigned pid, unsigned eid, DataEvent* const* e, unsigned num, Flow* f)
+{
+    unsigned idx = pid + eid;
+
+    const DataBus* gb = SnortConfig::get_conf()->global_dbus;
+    const DataBus& nb = get_network_policy()->dbus;
+    const DataBus& ib = get_inspection_policy()->dbus;
+
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        gb->_publish(idx, *e[i], f);
+        nb._publish(idx, *e[i], f);
+        ib._publish(idx, *e[i], f);
+    }
 }
 
 void DataBus::publish(unsigned pid, unsigned eid, const uint8_t* buf, unsigned len, Flow* f)
@@ -201,9 +221,8 @@ static bool compare(DataHandler* a, DataHandler* b)
     return false;
 }
 
-void DataBus::_subscribe(unsigned pid, unsigned eid, DataHandler* h)
+void DataBus::add_handler(unsigned idx, DataHandler* h)
 {
-    unsigned idx = pid + eid;
     assert(idx < next_event);
 
     if ( next_event > pub_sub.size() )
@@ -215,6 +234,29 @@ void DataBus::_subscribe(unsigned pid, unsigned eid, DataHandler* h)
     std::sort(subs.begin(), subs.end(), compare);
 }
 
+// rebuild the publishing table after subscriptions change; this is done
+// at configuration time only so publishing is a pair of array lookups
+void DataBus::compile()
+{
+    first.clear();
+    handlers.clear();
+
+    first.reserve(pub_sub.size() + 1);
+    first.emplace_back(0);
+
+    for ( const auto& subs : pub_sub )
+    {
+        handlers.insert(handlers.end(), subs.begin(), subs.end());
+        first.emplace_back(handlers.size());
+    }
+}
+
+void DataBus::_subscribe(unsigned pid, unsigned eid, DataHandler* h)
+{
+    add_handler(pid + eid, h);
+    compile();
+}
+
 void DataBus::_subscribe(const PubKey& key, unsigned eid, DataHandler* h)
 {
     unsigned pid = get_id(key);
@@ -237,19 +279,15 @@ void DataBus::_unsubscribe(const PubKey& key, unsigned eid, DataHandler* h)
             break;
         }
     }
+    compile();
 }
 
-void DataBus::_publish(unsigned pid, unsigned eid, DataEvent& e, Flow* f) const
+void DataBus::_publish(unsigned idx, DataEvent& e, Flow* f) const
 {
-    unsigned idx = pid + eid;
-
     // not all instances are full size
-    if ( idx >= pub_sub.size() )
+    if ( idx + 1 >= first.size() )
         return;
 
-    const SubList& subs = pub_sub[idx];
-
-    for ( auto* h : subs )
-        h->handle(e, f);
+    for ( unsigned i = first[idx]; i < first[idx + 1]; ++i )
+        handlers[i]->handle(e, f);
 }
-
@@ -121,6 +121,11 @@ public:
     // runtime methods
     static void publish(unsigned pub_id, unsigned evt_id, DataEvent&, Flow* = nullptr);
 
+    // publish several events of the same type for the same flow; each event
+    // is delivered to all subscribers before the next one as with publish()
+    static void publish(unsigned pub_id, unsigned evt_id, DataEvent* const*, unsigned num,
+        Flow* = nullptr);
+
     // convenience methods
     static void publish(unsigned pub_id, unsigned evt_id, const uint8_t*, unsigned, Flow* = nullptr);
     static void publish(unsigned pub_id, unsigned evt_id, Packet*, Flow* = nullptr);
@@ -129,11 +134,19 @@ private:
     void _subscribe(unsigned pub_id, unsigned evt_id, DataHandler*);
     void _subscribe(const PubKey&, unsigned evt_id, DataHandler*);
     void _unsubscribe(const PubKey&, unsigned evt_id, DataHandler*);
-    void _publish(unsigned pub_id, unsigned evt_id, DataEvent&, Flow*) const;
+    void _publish(unsigned idx, DataEvent&, Flow*) const;
+
+    void add_handler(unsigned idx, DataHandler*);
+    void compile();
 
 private:
     typedef std::vector<DataHandler*> SubList;
     std::vector<SubList> pub_sub;
+
+    // the subscriptions above flattened for publishing:  the handlers for
+    // event index i are handlers[first[i]] up to handlers[first[i + 1]]
+    std::vector<unsigned> first;
+    std::vector<DataHandler*> handlers;
 };
 }
 
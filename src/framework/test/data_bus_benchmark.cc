@@ -0,0 +1,178 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// data_bus_benchmark.cc
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "framework/data_bus.h"
+#include "main/policy.h"
+#include "main/snort_config.h"
+#include "main/thread.h"
+#include "utils/stats.h"
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+InspectionPolicy::InspectionPolicy(unsigned int) { }
+InspectionPolicy::~InspectionPolicy() = default;
+NetworkPolicy::NetworkPolicy(unsigned int, unsigned int) { }
+NetworkPolicy::~NetworkPolicy() = default;
+
+static InspectionPolicy* s_inspection_policy = nullptr;
+static NetworkPolicy* s_network_policy = nullptr;
+
+namespace snort
+{
+static SnortConfig* s_conf = nullptr;
+
+const SnortConfig* SnortConfig::get_conf()
+{ return s_conf; }
+
+SnortConfig::SnortConfig(const SnortConfig* const, const char*)
+{ global_dbus = new DataBus(); }
+
+SnortConfig::~SnortConfig()
+{ delete global_dbus; }
+
+NetworkPolicy* get_network_policy()
+{ return s_network_policy; }
+
+InspectionPolicy* get_inspection_policy()
+{ return s_inspection_policy; }
+
+THREAD_LOCAL PacketCount pc;
+}
+
+//--------------------------------------------------------------------------
+// the subscriptions resemble a packet event with a few global and many
+// inspection policy subscribers plus events nobody subscribed to
+//--------------------------------------------------------------------------
+
+class BenchEvent : public DataEvent
+{
+public:
+    unsigned value = 0;
+};
+
+class BenchHandler : public DataHandler
+{
+public:
+    BenchHandler() : DataHandler("bench") { }
+
+    void handle(DataEvent& e, Flow*) override
+    { sum += static_cast<BenchEvent&>(e).value; }
+
+    unsigned sum = 0;
+};
+
+struct BenchIds { enum : unsigned { BUSY, QUIET, num_ids }; };
+
+static const PubKey bench_pub_key { "bench", BenchIds::num_ids };
+
+static constexpr unsigned num_global = 2;
+static constexpr unsigned num_network = 1;
+static constexpr unsigned num_inspection = 6;
+static constexpr unsigned batch_size = 16;
+
+TEST_CASE("data bus publish", "[data_bus]")
+{
+    SnortConfig sc;
+    InspectionPolicy ip;
+    NetworkPolicy np;
+
+    s_conf = &sc;
+    s_inspection_policy = &ip;
+    s_network_policy = &np;
+
+    unsigned pub_id = DataBus::get_id(bench_pub_key);
+    REQUIRE(DataBus::valid(pub_id));
+
+    std::vector<BenchHandler*> handlers;
+
+    for ( unsigned i = 0; i < num_global + num_network + num_inspection; ++i )
+    {
+        BenchHandler* h = new BenchHandler;
+        handlers.emplace_back(h);
+
+        if ( i < num_global )
+            DataBus::subscribe_global(bench_pub_key, BenchIds::BUSY, h, sc);
+
+        else if ( i < num_global + num_network )
+            DataBus::subscribe_network(bench_pub_key, BenchIds::BUSY, h);
+
+        else
+            DataBus::subscribe(bench_pub_key, BenchIds::BUSY, h);
+    }
+
+    BenchEvent events[batch_size];
+    DataEvent* batch[batch_size];
+
+    for ( unsigned i = 0; i < batch_size; ++i )
+    {
+        events[i].value = i + 1;
+        batch[i] = &events[i];
+    }
+
+    DataBus::publish(pub_id, BenchIds::BUSY, batch, batch_size);
+
+    for ( auto* h : handlers )
+        CHECK(h->sum == batch_size * (batch_size + 1) / 2);
+
+    BENCHMARK("publish subscribed")
+    {
+        DataBus::publish(pub_id, BenchIds::BUSY, events[0]);
+        return handlers[0]->sum;
+    };
+
+    BENCHMARK("publish unsubscribed")
+    {
+        DataBus::publish(pub_id, BenchIds::QUIET, events[0]);
+        return handlers[0]->sum;
+    };
+
+    BENCHMARK("publish subscribed x16")
+    {
+        for ( unsigned i = 0; i < batch_size; ++i )
+            DataBus::publish(pub_id, BenchIds::BUSY, events[i]);
+        return handlers[0]->sum;
+    };
+
+    BENCHMARK("publish subscribed batch of 16")
+    {
+        DataBus::publish(pub_id, BenchIds::BUSY, batch, batch_size);
+        return handlers[0]->sum;
+    };
+
+    // the buses own the handlers
+    s_conf = nullptr;
+    s_inspection_policy = nullptr;
+    s_network_policy = nullptr;
+}
+
+#endif
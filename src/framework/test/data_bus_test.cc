@@ -257,6 +257,84 @@ TEST(data_bus, order2)
     delete h9;
 }
 
+TEST(data_bus, publish_batch)
+{
+    UTestHandler hg;
+    DataBus::subscribe_global(pub_key, DbUtIds::EVENT, &hg, *snort_conf);
+
+    UTestHandler* hn = new UTestHandler();
+    DataBus::subscribe_network(pub_key, DbUtIds::EVENT, hn);
+
+    UTestHandler* hi = new UTestHandler();
+    DataBus::subscribe(pub_key, DbUtIds::EVENT, hi);
+
+    UTestEvent e0(100), e1(200);
+    DataEvent* batch[] = { &e0, &e1 };
+
+    s_next = 0;
+    DataBus::publish(pub_id, DbUtIds::EVENT, batch, 1);
+
+    CHECK(100 == hg.evt_msg);
+    CHECK(100 == hn->evt_msg);
+    CHECK(100 == hi->evt_msg);
+
+    CHECK(1 == hg.seq);
+    CHECK(2 == hn->seq);
+    CHECK(3 == hi->seq);
+
+    DataBus::publish(pub_id, DbUtIds::EVENT, batch, 2);
+
+    CHECK(200 == hg.evt_msg);
+    CHECK(200 == hn->evt_msg);
+    CHECK(200 == hi->evt_msg);
+
+    CHECK(7 == hg.seq);
+    CHECK(8 == hn->seq);
+    CHECK(9 == hi->seq);
+
+    DataBus::unsubscribe_global(pub_key, DbUtIds::EVENT, &hg, *snort_conf);
+    DataBus::unsubscribe_network(pub_key, DbUtIds::EVENT, hn);
+    DataBus::unsubscribe(pub_key, DbUtIds::EVENT, hi);
+
+    DataBus::publish(pub_id, DbUtIds::EVENT, batch, 2);
+    CHECK(9 == s_next); // unsubscribed!
+
+    delete hn;
+    delete hi;
+}
+
+TEST(data_bus, clone)
+{
+    UTestHandler* h0 = new UTestHandler();
+    UTestHandler* h1 = new UTestHandler(1);
+
+    DataBus::subscribe(pub_key, DbUtIds::EVENT, h0);
+    DataBus::subscribe(pub_key, DbUtIds::EVENT, h1);
+
+    InspectionPolicy other;
+    other.dbus.clone(my_inspection_policy.dbus);
+
+    DataBus::unsubscribe(pub_key, DbUtIds::EVENT, h0);
+    DataBus::unsubscribe(pub_key, DbUtIds::EVENT, h1);
+
+    s_next = 0;
+    UTestEvent event(100);
+    DataBus::publish(pub_id, DbUtIds::EVENT, event);
+    CHECK(0 == s_next);
+
+    mock().setDataObject("my_inspection_policy", "InspectionPolicy", &other);
+    DataBus::publish(pub_id, DbUtIds::EVENT, event);
+
+    CHECK(1 == h1->seq);
+    CHECK(2 == h0->seq);
+
+    DataBus::unsubscribe(pub_key, DbUtIds::EVENT, h0);
+    DataBus::unsubscribe(pub_key, DbUtIds::EVENT, h1);
+
+    delete h0;
+    delete h1;
+}
+
 //-------------------------------------------------------------------------
 // main
 //-------------------------------------------------------------------------
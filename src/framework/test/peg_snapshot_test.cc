@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// peg_snapshot_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "framework/counts.h"
+
+#include <thread>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_GROUP(peg_snapshot)
+{ };
+
+TEST(peg_snapshot, init_zeros)
+{
+    PegSnapshot snap;
+    snap.init(3);
+
+    PegCount dst[3] = { 7, 7, 7 };
+    snap.read(dst);
+
+    CHECK_EQUAL(3u, snap.size());
+    CHECK_EQUAL(0u, snap.get_version());
+    CHECK_EQUAL(0u, dst[0]);
+    CHECK_EQUAL(0u, dst[1]);
+    CHECK_EQUAL(0u, dst[2]);
+}
+
+TEST(peg_snapshot, publish_read)
+{
+    PegSnapshot snap;
+    snap.init(3);
+
+    PegCount src[3] = { 1, 2, 3 };
+    snap.publish(src);
+
+    PegCount base[3] = { 10, 0, 30 };
+    src[1] = 5;
+    snap.publish(src, base);
+
+    PegCount dst[3];
+    snap.read(dst);
+
+    CHECK_EQUAL(2u, snap.get_version());
+    CHECK_EQUAL(11u, dst[0]);
+    CHECK_EQUAL(5u, dst[1]);
+    CHECK_EQUAL(33u, dst[2]);
+}
+
+// every publish writes the same value to all counts so any torn read
+// shows up as a mismatch
+TEST(peg_snapshot, concurrent)
+{
+    const unsigned num = 64;
+    const PegCount last = 20000;
+
+    PegSnapshot snap;
+    snap.init(num);
+
+    std::thread writer([&snap, num, last]()
+    {
+        PegCount src[num];
+
+        for ( PegCount v = 1; v <= last; ++v )
+        {
+            for ( unsigned i = 0; i < num; ++i )
+                src[i] = v;
+
+            snap.publish(src);
+        }
+    });
+
+    PegCount dst[num];
+    PegCount prev = 0;
+    bool torn = false;
+    bool backwards = false;
+
+    do
+    {
+        snap.read(dst);
+
+        for ( unsigned i = 1; i < num; ++i )
+            torn = torn or dst[i] != dst[0];
+
+        backwards = backwards or dst[0] < prev;
+        prev = dst[0];
+    }
+    while ( prev < last );
+
+    writer.join();
+
+    CHECK(!torn);
+    CHECK(!backwards);
+    CHECK_EQUAL(last, snap.get_version());
+}
+
+//-------------------------------------------------------------------------
+// main
+//-------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -129,6 +129,37 @@ TEST(xhash, free_anr_lru_delete_tail_node_test)
     delete test_table;
 }
 
+// Verify peek finds the data without changing the LRU order
+TEST(xhash, peek_user_data_test)
+{
+    XHash* test_table = new XHash(4, sizeof(struct xhash_test_key), 0, 0);
+    CHECK(test_table);
+
+    int data[4];
+
+    for (unsigned i = 0; i < 4; i++)
+    {
+        xhash_test_key xtk;
+        xtk.key = 10 * (i + 1);
+        int ret = test_table->insert(&xtk, &data[i]);
+        CHECK(ret == HASH_OK);
+    }
+
+    xhash_test_key xtk;
+    xtk.key = 10;
+    CHECK(test_table->peek_user_data(&xtk) == &data[0]);
+    CHECK(test_table->get_mru_user_data() == &data[3]);
+    CHECK(test_table->get_lru_user_data() == &data[0]);
+
+    CHECK(test_table->get_user_data(&xtk) == &data[0]);
+    CHECK(test_table->get_mru_user_data() == &data[0]);
+
+    xtk.key = 50;
+    CHECK(test_table->peek_user_data(&xtk) == nullptr);
+
+    delete test_table;
+}
+
 int main(int argc, char** argv)
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
@@ -304,6 +304,23 @@ void* XHash::get_user_data(const void* key)
     return ( hnode ) ? hnode->data : nullptr;
 }
 
+// unlike get_user_data(), neither the row order nor the lru is updated
+void* XHash::peek_user_data(const void* key)
+{
+    assert(key);
+
+    unsigned hashkey = hashkey_ops->do_hash((const unsigned char*)key, keysize);
+
+    unsigned index = hashkey & (nrows - 1);
+    for (HashNode* hnode = table[index]; hnode; hnode = hnode->next)
+    {
+        if ( hashkey_ops->key_compare(hnode->key, key, keysize) )
+            return hnode->data;
+    }
+
+    return nullptr;
+}
+
 void XHash::release()
 {
     HashNode* node = lru_cache->get_current_node();
@@ -58,6 +58,7 @@ public:
     HashNode* find_next_node();
     void* get_user_data();
     void* get_user_data(const void* key);
+    void* peek_user_data(const void* key);
     void release();
     int release_node(const void* key);
     int release_node(HashNode* node);
@@ -103,7 +103,9 @@ char* snort_strdup(const char* s)
 MemoryContext::MemoryContext(MemoryTracker&) { }
 MemoryContext::~MemoryContext() = default;
 
+THREAD_LOCAL TimeContext* ProfileContext::curr_time = nullptr;
 bool TimeProfilerStats::enabled = false;
+bool TimeProfilerStats::exclusive = false;
 }
 
 extern const BaseApi* ips_regex;
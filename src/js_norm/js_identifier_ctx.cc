@@ -23,6 +23,7 @@
 
 #include "js_identifier_ctx.h"
 
+#include <algorithm>
 #include <cassert>
 #include <memory.h>
 
@@ -33,6 +34,8 @@ using namespace jsn;
 
 #define NORM_NAME_SIZE 9 // size of the normalized form plus null symbol
 #define NORM_NAME_CNT 65536
+#define NAME_BLOCK_SIZE 4096
+#define NAME_TABLE_MIN_SIZE 64
 
 #define TYPE_NORMALIZED     1
 #define TYPE_IGNORED_ID     2
@@ -63,6 +66,93 @@ static void init_norm_names()
 
 static int _init_norm_names __attribute__((unused)) = (static_cast<void>(init_norm_names()), 0);
 
+JSIdentifierCtx::Name::Name(const char* s, size_t l) : str(s), len(l), hash(14695981039346656037ULL)
+{
+    // FNV-1a
+    for (size_t i = 0; i < l; ++i)
+        hash = (hash ^ static_cast<uint8_t>(s[i])) * 1099511628211ULL;
+}
+
+JSIdentifierCtx::Name JSIdentifierCtx::NameArena::intern(const Name& n)
+{
+    while (cur < blocks.size() and used + n.len > blocks[cur].size)
+    {
+        ++cur;
+        used = 0;
+    }
+
+    if (cur == blocks.size())
+    {
+        size_t size = std::max<size_t>(NAME_BLOCK_SIZE, n.len);
+        blocks.push_back({std::unique_ptr<char[]>(new char[size]), size});
+    }
+
+    char* s = blocks[cur].data.get() + used;
+    memcpy(s, n.str, n.len);
+    used += n.len;
+
+    Name interned(n);
+    interned.str = s;
+    return interned;
+}
+
+JSIdentifierCtx::NormId* JSIdentifierCtx::NameTable::find(const Name& n)
+{
+    if (slots.empty())
+        return nullptr;
+
+    auto& slot = slots[lookup(n)];
+    return slot.name.str ? &slot.id : nullptr;
+}
+
+JSIdentifierCtx::NormId& JSIdentifierCtx::NameTable::insert(const Name& n, const NormId& id)
+{
+    if ((used.size() + 1) * 2 > slots.size())
+        grow();
+
+    auto i = lookup(n);
+    assert(!slots[i].name.str);
+
+    used.push_back(i);
+    slots[i] = {n, id};
+    return slots[i].id;
+}
+
+void JSIdentifierCtx::NameTable::clear()
+{
+    for (auto i : used)
+        slots[i].name.str = nullptr;
+    used.clear();
+}
+
+size_t JSIdentifierCtx::NameTable::lookup(const Name& n) const
+{
+    const size_t mask = slots.size() - 1;
+    size_t i = n.hash & mask;
+
+    while (slots[i].name.str and !NameEqual()(slots[i].name, n))
+        i = (i + 1) & mask;
+
+    return i;
+}
+
+void JSIdentifierCtx::NameTable::grow()
+{
+    std::vector<Slot> old(std::max<size_t>(NAME_TABLE_MIN_SIZE, slots.size() * 2));
+    old.swap(slots);
+
+    std::vector<size_t> old_used;
+    old_used.swap(used);
+    used.reserve(old_used.size());
+
+    for (auto i : old_used)
+    {
+        auto j = lookup(old[i].name);
+        used.push_back(j);
+        slots[j] = old[i];
+    }
+}
+
 JSIdentifierCtx::JSIdentifierCtx(int32_t depth, uint32_t max_scope_depth,
     const std::unordered_set<std::string>& ignored_ids_list,
     const std::unordered_set<std::string>& ignored_props_list)
@@ -72,8 +162,10 @@ JSIdentifierCtx::JSIdentifierCtx(int32_t depth, uint32_t max_scope_depth,
     norm_name = norm_names;
     norm_name_end = norm_names + NORM_NAME_SIZE * std::min(depth, NORM_NAME_CNT);
     scopes.emplace_back(JSProgramScopeType::GLOBAL);
+    scope_depth = 1;
 
     init_ignored_names();
+    memcpy(&id_fast, &ignored_fast, sizeof(id_fast));
 }
 
 const char* JSIdentifierCtx::substitute(unsigned char c, bool is_property)
@@ -92,11 +184,22 @@ const char* JSIdentifierCtx::substitute(const char* id_name, bool is_property)
     if (id_name[1] == '\0')
         return substitute(*id_name, is_property);
 
-    const auto it = id_names.find(id_name);
-    if (it != id_names.end() && is_substituted(it->second, is_property))
-        return is_property ? it->second.prop_name : it->second.id_name;
+    const Name name(id_name, strlen(id_name));
+    auto id = id_names.find(name);
+
+    if (!id)
+    {
+        const auto ign = ignored_names.find(name);
+        if (ign != ignored_names.end())
+            id = &id_names.insert(ign->first, ign->second);
+        else
+            id = &id_names.insert(names.intern(name), NormId());
+    }
+
+    if (is_substituted(*id, is_property))
+        return is_property ? id->prop_name : id->id_name;
 
-    return acquire_norm_name(id_names[id_name]);
+    return acquire_norm_name(*id);
 }
 
 bool JSIdentifierCtx::is_ignored(const char* id_name) const
@@ -135,23 +238,25 @@ const char* JSIdentifierCtx::acquire_norm_name(NormId& id)
 
 void JSIdentifierCtx::init_ignored_names()
 {
+    // keys refer to the configured strings, which outlive the context
     for (const auto& iid : ignored_ids_list)
         if (iid.length() == 1)
-            id_fast[(unsigned)iid[0]] = {iid.c_str(), nullptr, TYPE_IGNORED_ID};
+            ignored_fast[(unsigned)iid[0]] = {iid.c_str(), nullptr, TYPE_IGNORED_ID};
         else
-            id_names[iid] = {iid.c_str(), nullptr, TYPE_IGNORED_ID};
+            ignored_names[Name(iid.c_str(), iid.length())] = {iid.c_str(), nullptr, TYPE_IGNORED_ID};
 
     for (const auto& iprop : ignored_props_list)
     {
         if (iprop.length() == 1)
         {
-            id_fast[(unsigned)iprop[0]].prop_name = iprop.c_str();
-            id_fast[(unsigned)iprop[0]].type |= TYPE_IGNORED_PROP;
+            ignored_fast[(unsigned)iprop[0]].prop_name = iprop.c_str();
+            ignored_fast[(unsigned)iprop[0]].type |= TYPE_IGNORED_PROP;
         }
         else
         {
-            id_names[iprop].prop_name = iprop.c_str();
-            id_names[iprop].type |= TYPE_IGNORED_PROP;
+            auto& id = ignored_names[Name(iprop.c_str(), iprop.length())];
+            id.prop_name = iprop.c_str();
+            id.type |= TYPE_IGNORED_PROP;
         }
     }
 }
@@ -160,10 +265,15 @@ bool JSIdentifierCtx::scope_push(JSProgramScopeType t)
 {
     assert(t != JSProgramScopeType::GLOBAL && t != JSProgramScopeType::PROG_SCOPE_TYPE_MAX);
 
-    if (scopes.size() >= max_scope_depth)
+    if (scope_depth >= max_scope_depth)
         return false;
 
-    scopes.emplace_back(t);
+    if (scope_depth < scopes.size())
+        scopes[scope_depth].reuse(t);
+    else
+        scopes.emplace_back(t);
+
+    ++scope_depth;
     return true;
 }
 
@@ -171,40 +281,49 @@ bool JSIdentifierCtx::scope_pop(JSProgramScopeType t)
 {
     assert(t != JSProgramScopeType::GLOBAL && t != JSProgramScopeType::PROG_SCOPE_TYPE_MAX);
 
-    if (scopes.back().type() != t)
+    auto& scope = scopes[scope_depth - 1];
+    if (scope.type() != t)
         return false;
 
-    assert(scopes.size() != 1);
-    scopes.pop_back();
+    assert(scope_depth != 1);
+    scope.unwind();
+    --scope_depth;
     return true;
 }
 
 void JSIdentifierCtx::reset()
 {
-    memset(&id_fast, 0, sizeof(id_fast));
+    while (scope_depth > 0)
+        scopes[--scope_depth].unwind();
+    scope_depth = 1;
+
+    memcpy(&id_fast, &ignored_fast, sizeof(id_fast));
     norm_name = norm_names;
     id_names.clear();
-    scopes.clear();
-    scopes.emplace_back(JSProgramScopeType::GLOBAL);
-    init_ignored_names();
+    aliases.clear();
+    names.rewind();
 }
 
 void JSIdentifierCtx::add_alias(const char* alias, const std::string&& value)
 {
     assert(alias);
-    assert(!scopes.empty());
+    assert(scope_depth);
+
+    const Name name(alias, strlen(alias));
+    auto it = aliases.find(name);
 
-    auto& a = aliases[alias];
-    a.emplace_back(std::move(value));
+    if (it == aliases.end())
+        it = aliases.emplace(names.intern(name), Alias()).first;
 
-    scopes.back().reference(a);
+    it->second.emplace_back(std::move(value));
+    scopes[scope_depth - 1].reference(it->second);
 }
 
 const char* JSIdentifierCtx::alias_lookup(const char* alias) const
 {
     assert(alias);
 
-    const auto& i = aliases.find(alias);
+    const auto& i = aliases.find(Name(alias, strlen(alias)));
 
     return i != aliases.end() && !i->second.empty()
         ? i->second.back().c_str() : nullptr;
@@ -216,13 +335,13 @@ const char* JSIdentifierCtx::alias_lookup(const char* alias) const
 
 bool JSIdentifierCtx::scope_check(const std::list<JSProgramScopeType>& compare) const
 {
-    if (scopes.size() != compare.size())
+    if (scope_depth != compare.size())
         return false;
 
     auto cmp = compare.begin();
-    for (auto it = scopes.begin(); it != scopes.end(); ++it, ++cmp)
+    for (size_t i = 0; i < scope_depth; ++i, ++cmp)
     {
-        if (it->type() != *cmp)
+        if (scopes[i].type() != *cmp)
             return false;
     }
     return true;
@@ -231,9 +350,9 @@ bool JSIdentifierCtx::scope_check(const std::list<JSProgramScopeType>& compare)
 const std::list<JSProgramScopeType> JSIdentifierCtx::get_types() const
 {
     std::list<JSProgramScopeType> return_list;
-    for (const auto& scope : scopes)
+    for (size_t i = 0; i < scope_depth; ++i)
     {
-        return_list.push_back(scope.type());
+        return_list.push_back(scopes[i].type());
     }
     return return_list;
 }
@@ -20,7 +20,9 @@
 #ifndef JS_IDENTIFIER_CTX
 #define JS_IDENTIFIER_CTX
 
+#include <cstring>
 #include <list>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -79,10 +81,74 @@ private:
         uint8_t type = 0;
     };
 
+    // identifier bytes (not null-terminated) with the hash computed once per lookup
+    struct Name
+    {
+        Name() = default;
+        Name(const char* s, size_t l);
+
+        const char* str = nullptr;
+        size_t len = 0;
+        uint64_t hash = 0;
+    };
+
+    struct NameHash
+    {
+        size_t operator()(const Name& n) const
+        { return static_cast<size_t>(n.hash); }
+    };
+
+    struct NameEqual
+    {
+        bool operator()(const Name& a, const Name& b) const
+        { return a.hash == b.hash and a.len == b.len and !memcmp(a.str, b.str, a.len); }
+    };
+
+    // open addressing table of identifiers, the slots are kept for the next PDU
+    class NameTable
+    {
+    public:
+        NormId* find(const Name&);
+        NormId& insert(const Name&, const NormId&);
+        void clear();
+
+    private:
+        struct Slot
+        {
+            Name name;
+            NormId id;
+        };
+
+        size_t lookup(const Name&) const;
+        void grow();
+
+        std::vector<Slot> slots;
+        std::vector<size_t> used;
+    };
+
+    // bump allocator for identifier names, blocks are kept for the next PDU
+    class NameArena
+    {
+    public:
+        Name intern(const Name&);
+        void rewind()
+        { cur = 0; used = 0; }
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<char[]> data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        size_t cur = 0;
+        size_t used = 0;
+    };
+
     using Alias = std::vector<std::string>;
-    using AliasRef = std::list<Alias*>;
-    using AliasMap = std::unordered_map<std::string, Alias>;
-    using NameMap = std::unordered_map<std::string, NormId>;
+    using AliasMap = std::unordered_map<Name, Alias, NameHash, NameEqual>;
+    using IgnoredMap = std::unordered_map<Name, NormId, NameHash, NameEqual>;
 
     class ProgramScope
     {
@@ -90,8 +156,16 @@ private:
         ProgramScope(JSProgramScopeType t) : t(t)
         {}
 
-        ~ProgramScope()
-        { for (auto a : to_remove) a->pop_back(); }
+        void reuse(JSProgramScopeType new_type)
+        { t = new_type; }
+
+        // aliases are unwound explicitly, so the storage can be reused by the next scope
+        void unwind()
+        {
+            for (auto a : to_remove)
+                a->pop_back();
+            to_remove.clear();
+        }
 
         void reference(Alias& a)
         { to_remove.push_back(&a); }
@@ -101,7 +175,7 @@ private:
 
     private:
         JSProgramScopeType t;
-        AliasRef to_remove{};
+        std::vector<Alias*> to_remove;
     };
 
     inline const char* substitute(unsigned char c, bool is_property);
@@ -109,12 +183,19 @@ private:
     inline const char* acquire_norm_name(NormId& id);
     inline void init_ignored_names();
 
-    // do not swap next two lines, the destructor frees them in the reverse order
     AliasMap aliases;
-    std::list<ProgramScope> scopes;
+
+    // scopes[0..scope_depth) are live, the rest is kept allocated for reuse
+    std::vector<ProgramScope> scopes;
+    size_t scope_depth = 0;
 
     NormId id_fast[256];
-    NameMap id_names;
+    NameTable id_names;
+    NameArena names;
+
+    // ignored identifiers are looked up on the first occurrence only
+    NormId ignored_fast[256];
+    IgnoredMap ignored_names;
     const std::unordered_set<std::string>& ignored_ids_list;
     const std::unordered_set<std::string>& ignored_props_list;
 
@@ -25,6 +25,8 @@
 
 #include <cstring>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "catch/catch.hpp"
 
@@ -296,5 +298,58 @@ TEST_CASE("JS Normalizer, unescape", "[JSNormalizer]")
     };
 }
 
+TEST_CASE("JS Normalizer, identifier context", "[JSIdentifierCtx]")
+{
+    // obfuscated scripts: long generated names, mostly unique within a PDU
+    std::vector<std::string> names;
+    for (int it = 0; it < 4096; ++it)
+        names.push_back("_0x" + std::to_string(0x5a3c11 + it * 7919) + "_" + std::to_string(it % 61));
+
+    const std::unordered_set<std::string> ignored_ids({"console", "eval", "document", "window"});
+    const std::unordered_set<std::string> ignored_props({"length", "prototype", "push"});
+    JSIdentifierCtx ident_ctx(default_config.identifier_depth, default_config.max_scope_depth,
+        ignored_ids, ignored_props);
+
+    BENCHMARK("substitute, reset per PDU")
+    {
+        const char* last = nullptr;
+        for (int pdu = 0; pdu < 4; ++pdu)
+        {
+            for (const auto& n : names)
+                last = ident_ctx.substitute(n.c_str(), false);
+            ident_ctx.reset();
+        }
+        return last;
+    };
+
+    BENCHMARK("substitute, repeated names")
+    {
+        const char* last = nullptr;
+        for (int rep = 0; rep < 16; ++rep)
+            for (int it = 0; it < 256; ++it)
+                last = ident_ctx.substitute(names[it].c_str(), rep % 2);
+        ident_ctx.reset();
+        return last;
+    };
+
+    BENCHMARK("nested scopes with aliases")
+    {
+        for (int pdu = 0; pdu < 4; ++pdu)
+        {
+            for (int it = 0; it < 1024; ++it)
+            {
+                ident_ctx.scope_push(JSProgramScopeType::FUNCTION);
+                ident_ctx.add_alias(names[it % 64].c_str(), "eval");
+                ident_ctx.scope_push(JSProgramScopeType::BLOCK);
+                ident_ctx.add_alias(names[it % 32].c_str(), "console.log");
+                ident_ctx.scope_pop(JSProgramScopeType::BLOCK);
+                ident_ctx.scope_pop(JSProgramScopeType::FUNCTION);
+            }
+            ident_ctx.reset();
+        }
+        return ident_ctx.alias_lookup(names[0].c_str());
+    };
+}
+
 #endif
 
@@ -0,0 +1,112 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// alert_ring.h
+
+#ifndef ALERT_RING_H
+#define ALERT_RING_H
+
+// Layout of the alert_ring logger's memory mapped output file, shared with
+// the reader under tools/.  Everything is in host byte order.
+//
+// <file> ::= <header> <schema> <pad> <slot>*
+//
+// The header and schema describe the fixed size records so a reader needs
+// nothing but the file to parse them.  The slots start at header_size, a
+// multiple of the page size, and there are capacity of them.  Record n is
+// written to slot n % capacity and head is then advanced to n + 1 with a
+// release store.
+//
+// A reader tails the file without syscalls by polling head.  It copies
+// slot pos % capacity when pos < head and keeps the copy only if head is
+// still < pos + capacity afterwards; record pos + capacity is written to
+// the same slot while head == pos + capacity so otherwise the writer lapped
+// it and it resumes at head - capacity + 1.  See alert_ring_copy().
+//
+// The writer protocol for record n is:
+//
+//     release fence          // head = n is visible before the slot changes
+//     fill slot n % capacity
+//     head.store(n + 1, release)
+//
+// The fence pairs with the acquire fence in alert_ring_copy(): if a copy
+// saw any part of record n then its reload of head sees at least n, so a
+// record torn by a rewrite is never kept.  The release store alone only
+// orders the fill before head and would let the next fill of the slot be
+// seen first.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#define ALERT_RING_MAGIC "ARNG"
+#define ALERT_RING_VERSION 1
+
+enum AlertRingType : uint16_t
+{
+    ART_U8, ART_U16, ART_U32, ART_U64,
+    ART_IP,    // 16 bytes, IPv4 as ::ffff:a.b.c.d, all zero if none
+    ART_STR,   // nul terminated within size
+    ART_MAX
+};
+
+struct AlertRingField
+{
+    char name[24];
+    uint16_t type;
+    uint16_t offset;
+    uint32_t size;
+};
+
+struct AlertRingHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;
+    uint64_t capacity;
+    uint32_t num_fields;
+    uint32_t schema_offset;
+
+    // the only field updated after the file is created
+    alignas(64) std::atomic<uint64_t> head;
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+    "head must have the same layout in every process");
+
+// Copy record pos (< head) from slots to rec.  head is reloaded and if the
+// copy may be torn false is returned and pos is moved past the records lost.
+inline bool alert_ring_copy(
+    const AlertRingHeader* h, const uint8_t* slots, uint64_t& pos, uint64_t& head, uint8_t* rec)
+{
+    memcpy(rec, slots + (pos % h->capacity) * h->record_size, h->record_size);
+
+    // keep the slot reads ahead of the head reload
+    std::atomic_thread_fence(std::memory_order_acquire);
+    head = h->head.load(std::memory_order_acquire);
+
+    if ( head >= pos + h->capacity )
+    {
+        pos = head - h->capacity + 1;
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,172 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// async_writer.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "async_writer.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+using namespace snort;
+
+// each record starts on an 8 byte boundary with this header
+struct RecordHeader
+{
+    uint32_t len;
+    uint32_t type;
+};
+
+// marks the unused end of the ring, the next record is at offset 0
+#define WRAP_TYPE (0xFFFFFFFF)
+
+// how long the writer sleeps if it misses a wakeup
+#define WRITER_IDLE_MS (100)
+
+static inline size_t record_size(uint32_t len)
+{ return (sizeof(RecordHeader) + len + 7) & ~(size_t)7; }
+
+const PegInfo snort::async_writer_pegs[] =
+{
+    { CountType::SUM, "records", "records queued for the writer thread" },
+    { CountType::SUM, "dropped", "records dropped because the writer ring was full" },
+    { CountType::NOW, "ring_depth", "bytes waiting in the writer ring as of the last record queued" },
+    { CountType::MAX, "max_ring_depth", "maximum bytes waiting in the writer ring" },
+    { CountType::END, nullptr, nullptr }
+};
+
+AsyncWriter::AsyncWriter(AsyncWriterSink& s, size_t ring_size, AsyncWriterStats& st) :
+    sink(s), stats(st), size((ring_size + 7) & ~(size_t)7)
+{
+    assert(size >= sizeof(RecordHeader));
+    ring = new uint8_t[size];
+    thread = new std::thread(&AsyncWriter::writer, this);
+}
+
+AsyncWriter::~AsyncWriter()
+{
+    running = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cond.notify_one();
+    }
+
+    thread->join();
+    delete thread;
+    delete[] ring;
+}
+
+bool AsyncWriter::put(uint32_t type, const void* hdr, uint32_t hdr_len, const void* data, uint32_t len)
+{
+    assert(type != WRAP_TYPE);
+
+    const size_t h = head.load(std::memory_order_relaxed);
+    const size_t used = h - tail.load(std::memory_order_acquire);
+    const size_t off = h % size;
+    const size_t need = record_size(hdr_len + len);
+
+    // records are contiguous, the end of the ring is skipped if it is too short
+    const size_t skip = (size - off < need) ? size - off : 0;
+
+    if ( need + skip > size - used )
+    {
+        stats.dropped++;
+        return false;
+    }
+
+    if ( skip )
+        ((RecordHeader*)(ring + off))->type = WRAP_TYPE;
+
+    uint8_t* rec = ring + (h + skip) % size;
+    *(RecordHeader*)rec = { hdr_len + len, type };
+    rec += sizeof(RecordHeader);
+
+    if ( hdr_len )
+        memcpy(rec, hdr, hdr_len);
+
+    if ( len )
+        memcpy(rec + hdr_len, data, len);
+
+    head.store(h + skip + need, std::memory_order_seq_cst);
+
+    if ( sleeping.load(std::memory_order_seq_cst) )
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cond.notify_one();
+    }
+
+    stats.records++;
+    stats.depth = used + skip + need;
+
+    if ( stats.depth > stats.max_depth )
+        stats.max_depth = stats.depth;
+
+    return true;
+}
+
+void AsyncWriter::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    sleeping.store(true, std::memory_order_seq_cst);
+
+    // recheck after announcing, so an append made meanwhile is not missed
+    if ( running and head.load(std::memory_order_seq_cst) == tail.load(std::memory_order_relaxed) )
+        cond.wait_for(lock, std::chrono::milliseconds(WRITER_IDLE_MS));
+
+    sleeping.store(false, std::memory_order_relaxed);
+}
+
+void AsyncWriter::writer()
+{
+    while ( true )
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        const size_t h = head.load(std::memory_order_acquire);
+
+        if ( t == h )
+        {
+            if ( !running )
+                break;
+
+            wait();
+            continue;
+        }
+
+        while ( t != h )
+        {
+            const size_t off = t % size;
+            const RecordHeader* rec = (const RecordHeader*)(ring + off);
+
+            if ( rec->type == WRAP_TYPE )
+            {
+                t += size - off;
+                continue;
+            }
+
+            sink.write(rec->type, (const uint8_t*)(rec + 1), rec->len);
+            t += record_size(rec->len);
+            tail.store(t, std::memory_order_release);
+        }
+
+        sink.flush();
+    }
+}
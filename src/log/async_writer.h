@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// async_writer.h
+
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+// AsyncWriter decouples a logger from its output file.  The packet thread
+// copies serialized records into a single producer, single consumer ring
+// and a dedicated thread hands them to the logger's sink, flushing once per
+// batch.  A stalled disk then fills the ring instead of stalling packet
+// processing; records that do not fit are dropped and counted.
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "framework/counts.h"
+#include "main/snort_types.h"
+
+namespace snort
+{
+class SO_PUBLIC AsyncWriterSink
+{
+public:
+    virtual ~AsyncWriterSink() = default;
+
+    // called on the writer thread for each record in the order appended
+    virtual void write(uint32_t type, const uint8_t*, uint32_t len) = 0;
+
+    // called on the writer thread after each batch of records
+    virtual void flush() = 0;
+};
+
+struct AsyncWriterStats
+{
+    PegCount records;
+    PegCount dropped;
+    PegCount depth;
+    PegCount max_depth;
+};
+
+// pegs matching AsyncWriterStats for loggers that have no others
+SO_PUBLIC extern const PegInfo async_writer_pegs[];
+
+class SO_PUBLIC AsyncWriter
+{
+public:
+    AsyncWriter(AsyncWriterSink&, size_t ring_size, AsyncWriterStats&);
+
+    // writes out the queued records and joins the writer thread
+    ~AsyncWriter();
+
+    // copy a record into the ring, false if it was dropped
+    bool put(uint32_t type, const void* data, uint32_t len)
+    { return put(type, data, len, nullptr, 0); }
+
+    // same, with the record given in two parts
+    bool put(uint32_t type, const void* hdr, uint32_t hdr_len, const void* data, uint32_t len);
+
+private:
+    void writer();
+    void wait();
+
+    AsyncWriterSink& sink;
+    AsyncWriterStats& stats;
+
+    uint8_t* ring;
+    const size_t size;
+
+    // free running offsets, the ring index is offset % size
+    std::atomic<size_t> head { 0 };
+    std::atomic<size_t> tail { 0 };
+
+    std::atomic<bool> running { true };
+    std::atomic<bool> sleeping { false };
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    std::thread* thread;
+};
+}
+
+#endif
@@ -156,7 +156,9 @@ void LogFlow(Packet* p)
     log_mutex.lock();
     TextLog_NewLine(text_log);
     LogTimeStamp(text_log, p);
-    TextLog_Print(text_log, " %s ", p->get_type());
+    TextLog_Putc(text_log, ' ');
+    TextLog_Puts(text_log, p->get_type());
+    TextLog_Putc(text_log, ' ');
     LogIpAddrs(text_log, p);
     TextLog_NewLine(text_log);
     log_mutex.unlock();
@@ -57,9 +57,22 @@ namespace snort
  */
 void LogTimeStamp(TextLog* log, Packet* p)
 {
-    char timestamp[TIMEBUF_SIZE];
-    ts_print((const struct timeval*)&p->pkth->ts, timestamp);
-    TextLog_Puts(log, timestamp);
+    TextLog_PutTimestamp(log, (const struct timeval*)&p->pkth->ts);
+}
+
+/*--------------------------------------------------------------------
+ * prints "[gid:sid:rev] "
+ *--------------------------------------------------------------------
+ */
+void LogRuleId(TextLog* log, const Event& e)
+{
+    TextLog_Putc(log, '[');
+    TextLog_PutU64(log, e.sig_info->gid);
+    TextLog_Putc(log, ':');
+    TextLog_PutU64(log, e.sig_info->sid);
+    TextLog_Putc(log, ':');
+    TextLog_PutU64(log, e.sig_info->rev);
+    TextLog_Puts(log, "] ");
 }
 
 /*--------------------------------------------------------------------
@@ -73,9 +86,15 @@ void LogTimeStamp(TextLog* log, Packet* p)
 void LogPriorityData(TextLog* log, const Event& e)
 {
     if ( e.sig_info->class_type and !e.sig_info->class_type->text.empty() )
-        TextLog_Print(log, "[Classification: %s] ", e.sig_info->class_type->text.c_str());
+    {
+        TextLog_Puts(log, "[Classification: ");
+        TextLog_Puts(log, e.sig_info->class_type->text.c_str());
+        TextLog_Puts(log, "] ");
+    }
 
-    TextLog_Print(log, "[Priority: %d] ", e.sig_info->priority);
+    TextLog_Puts(log, "[Priority: ");
+    TextLog_PutU64(log, e.sig_info->priority);
+    TextLog_Puts(log, "] ");
 }
 
 /*--------------------------------------------------------------------
@@ -91,7 +110,9 @@ bool LogAppID(TextLog* log, Packet* p)
 
         if ( app_name )
         {
-            TextLog_Print(log, "[AppID: %s] ", app_name);
+            TextLog_Puts(log, "[AppID: ");
+            TextLog_Puts(log, app_name);
+            TextLog_Puts(log, "] ");
             return true;
         }
     }
@@ -278,9 +299,9 @@ void LogIpAddrs(TextLog* log, Packet* p)
         }
         else
         {
-            TextLog_Print(log, ip_fmt,
-                sfip_ntop(p->ptrs.ip_api.get_src(), src, sizeof(src)),
-                sfip_ntop(p->ptrs.ip_api.get_dst(), dst, sizeof(dst)));
+            TextLog_PutIp(log, p->ptrs.ip_api.get_src());
+            TextLog_Puts(log, " -> ");
+            TextLog_PutIp(log, p->ptrs.ip_api.get_dst());
         }
     }
     else
@@ -300,9 +321,13 @@ void LogIpAddrs(TextLog* log, Packet* p)
         }
         else
         {
-            TextLog_Print(log, ip_fmt,
-                sfip_ntop(p->ptrs.ip_api.get_src(), src, sizeof(src)), p->ptrs.sp,
-                sfip_ntop(p->ptrs.ip_api.get_dst(), dst, sizeof(dst)), p->ptrs.dp);
+            TextLog_PutIp(log, p->ptrs.ip_api.get_src());
+            TextLog_Putc(log, ':');
+            TextLog_PutU64(log, p->ptrs.sp);
+            TextLog_Puts(log, " -> ");
+            TextLog_PutIp(log, p->ptrs.ip_api.get_dst());
+            TextLog_Putc(log, ':');
+            TextLog_PutU64(log, p->ptrs.dp);
         }
     }
 }
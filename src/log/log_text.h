@@ -36,6 +36,7 @@ namespace ip { struct IP4Hdr; }
 namespace tcp { struct TCPHdr; }
 
 SO_PUBLIC void LogTimeStamp(TextLog*, Packet*);
+SO_PUBLIC void LogRuleId(TextLog*, const Event&);
 SO_PUBLIC void LogPriorityData(TextLog*, const Event&);
 SO_PUBLIC void LogXrefs(TextLog*, const Event&);
 
@@ -0,0 +1,185 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// alert_ring_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../alert_ring.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+// each record is filled with its sequence number so a torn copy shows up
+// as a mix of two of them
+#define WORDS 32
+#define RECORD_SIZE (WORDS * sizeof(uint64_t))
+
+struct TestRing
+{
+    TestRing(unsigned cap) : slots(cap * RECORD_SIZE)
+    {
+        memset((char*)&hdr, 0, sizeof(hdr));
+        hdr.record_size = RECORD_SIZE;
+        hdr.capacity = cap;
+        hdr.head.store(0);
+    }
+
+    // same order as RingLogger::alert()
+    void write(uint64_t n)
+    {
+        std::atomic_thread_fence(std::memory_order_release);
+
+        volatile uint64_t* w = (volatile uint64_t*)(slots.data() + (n % hdr.capacity) * RECORD_SIZE);
+
+        for ( unsigned i = 0; i < WORDS; ++i )
+            w[i] = n;
+
+        hdr.head.store(n + 1, std::memory_order_release);
+    }
+
+    AlertRingHeader hdr;
+    std::vector<uint8_t> slots;
+};
+
+static bool intact(const uint8_t* rec, uint64_t n)
+{
+    for ( unsigned i = 0; i < WORDS; ++i )
+    {
+        uint64_t v;
+        memcpy(&v, rec + i * sizeof(v), sizeof(v));
+
+        if ( v != n )
+            return false;
+    }
+    return true;
+}
+
+TEST_GROUP(alert_ring) { };
+
+TEST(alert_ring, read_behind)
+{
+    TestRing ring(4);
+    uint8_t rec[RECORD_SIZE];
+
+    for ( uint64_t n = 0; n < 3; ++n )
+        ring.write(n);
+
+    uint64_t pos = 0;
+    uint64_t head = 0;
+
+    CHECK(alert_ring_copy(&ring.hdr, ring.slots.data(), pos, head, rec));
+    CHECK(pos == 0);
+    CHECK(head == 3);
+    CHECK(intact(rec, 0));
+}
+
+TEST(alert_ring, slot_being_rewritten)
+{
+    TestRing ring(4);
+    uint8_t rec[RECORD_SIZE];
+
+    for ( uint64_t n = 0; n < 4; ++n )
+        ring.write(n);
+
+    // record 4 goes to slot 0 while head is still 4
+    uint64_t pos = 0;
+    uint64_t head = 0;
+
+    CHECK_FALSE(alert_ring_copy(&ring.hdr, ring.slots.data(), pos, head, rec));
+    CHECK(pos == 1);
+
+    CHECK(alert_ring_copy(&ring.hdr, ring.slots.data(), pos, head, rec));
+    CHECK(intact(rec, 1));
+}
+
+TEST(alert_ring, lapped)
+{
+    TestRing ring(4);
+    uint8_t rec[RECORD_SIZE];
+
+    for ( uint64_t n = 0; n < 10; ++n )
+        ring.write(n);
+
+    uint64_t pos = 2;
+    uint64_t head = 0;
+
+    CHECK_FALSE(alert_ring_copy(&ring.hdr, ring.slots.data(), pos, head, rec));
+    CHECK(pos == 7);
+
+    CHECK(alert_ring_copy(&ring.hdr, ring.slots.data(), pos, head, rec));
+    CHECK(intact(rec, 7));
+}
+
+TEST(alert_ring, writer_laps_reader)
+{
+    const uint64_t max = 2000000;
+    TestRing ring(4);
+
+    std::thread writer([&ring, max]()
+    {
+        for ( uint64_t n = 0; n < max; ++n )
+            ring.write(n);
+    });
+
+    uint8_t rec[RECORD_SIZE];
+    uint64_t pos = 0;
+    uint64_t head = 0;
+    uint64_t read = 0;
+    uint64_t lost = 0;
+    uint64_t torn = 0;
+
+    while ( pos < max )
+    {
+        if ( pos == head )
+        {
+            head = ring.hdr.head.load(std::memory_order_acquire);
+            continue;
+        }
+
+        uint64_t from = pos;
+
+        if ( !alert_ring_copy(&ring.hdr, ring.slots.data(), pos, head, rec) )
+        {
+            CHECK(pos > from);
+            lost += pos - from;
+            continue;
+        }
+
+        if ( !intact(rec, pos) )
+            torn++;
+
+        read++;
+        pos++;
+    }
+    writer.join();
+
+    CHECK(torn == 0);
+    CHECK(read + lost == max);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,177 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// async_writer_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../async_writer.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+// records carry their sequence number and a pattern derived from it
+class TestSink : public AsyncWriterSink
+{
+public:
+    void write(uint32_t type, const uint8_t* buf, uint32_t len) override
+    {
+        while ( blocked )
+            std::this_thread::yield();
+
+        if ( len < sizeof(uint32_t) )
+        {
+            empty++;
+            return;
+        }
+
+        uint32_t seq;
+        memcpy(&seq, buf, sizeof(seq));
+
+        if ( count and seq <= last )
+            bad++;
+
+        if ( type != seq % 3 )
+            bad++;
+
+        for ( uint32_t i = sizeof(seq); i < len; ++i )
+            if ( buf[i] != (uint8_t)(seq + i) )
+                bad++;
+
+        last = seq;
+        count++;
+    }
+
+    void flush() override
+    { flushes++; }
+
+    std::atomic<bool> blocked { false };
+    unsigned count = 0;
+    unsigned empty = 0;
+    unsigned bad = 0;
+    unsigned flushes = 0;
+    uint32_t last = 0;
+};
+
+static void put(AsyncWriter& w, uint32_t seq, uint32_t len, bool* ok = nullptr)
+{
+    uint8_t buf[512];
+    assert(len >= sizeof(seq) and len <= sizeof(buf));
+
+    memcpy(buf, &seq, sizeof(seq));
+
+    for ( uint32_t i = sizeof(seq); i < len; ++i )
+        buf[i] = (uint8_t)(seq + i);
+
+    // split the record to exercise the two part put
+    bool b = w.put(seq % 3, buf, 2, buf + 2, len - 2);
+
+    if ( ok )
+        *ok = b;
+}
+
+TEST_GROUP(async_writer)
+{ };
+
+TEST(async_writer, drain_on_delete)
+{
+    TestSink sink;
+    AsyncWriterStats stats { };
+    AsyncWriter* w = new AsyncWriter(sink, 65536, stats);
+
+    for ( uint32_t seq = 0; seq < 100; ++seq )
+        put(*w, seq, 4 + seq);
+
+    delete w;
+
+    CHECK(sink.count == 100);
+    CHECK(sink.bad == 0);
+    CHECK(sink.flushes > 0);
+    CHECK(stats.records == 100);
+    CHECK(stats.dropped == 0);
+    CHECK(stats.max_depth > 0);
+}
+
+TEST(async_writer, wrap)
+{
+    TestSink sink;
+    AsyncWriterStats stats { };
+    {
+        AsyncWriter w(sink, 1000, stats);
+
+        for ( uint32_t seq = 0; seq < 20000; ++seq )
+            put(w, seq, 4 + (seq * 37) % 300);
+    }
+    CHECK(sink.bad == 0);
+    CHECK(sink.count == stats.records);
+    CHECK(stats.records + stats.dropped == 20000);
+    CHECK(stats.max_depth <= 1000);
+}
+
+TEST(async_writer, drop_when_full)
+{
+    TestSink sink;
+    AsyncWriterStats stats { };
+    {
+        AsyncWriter w(sink, 256, stats);
+        sink.blocked = true;
+
+        bool ok = true;
+        uint32_t seq = 0;
+
+        while ( ok )
+            put(w, seq++, 60, &ok);
+
+        CHECK(stats.dropped == 1);
+        CHECK(stats.records == seq - 1);
+
+        // the writer catches up once unblocked
+        sink.blocked = false;
+    }
+    CHECK(sink.bad == 0);
+    CHECK(sink.count == stats.records);
+}
+
+TEST(async_writer, empty_record)
+{
+    TestSink sink;
+    AsyncWriterStats stats { };
+    {
+        AsyncWriter w(sink, 64, stats);
+        CHECK(w.put(0, &stats, 0));
+        CHECK(!w.put(0, nullptr, 128));
+    }
+    CHECK(sink.empty == 1);
+    CHECK(stats.records == 1);
+    CHECK(stats.dropped == 1);
+}
+
+int main(int argc, char* argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,230 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// text_log_benchmark.cc
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <arpa/inet.h>
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "log/log.h"
+#include "log/text_log.h"
+#include "main/snort_config.h"
+#include "sfip/sf_ip.h"
+#include "utils/util.h"
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+static std::vector<FILE*> s_files;
+
+FILE* OpenAlertFile(const char*)
+{
+    FILE* f = tmpfile();
+    s_files.push_back(f);
+    return f;
+}
+
+int RollAlertFile(const char*)
+{ return 0; }
+
+namespace snort
+{
+const SnortConfig* SnortConfig::get_conf()
+{ return nullptr; }
+
+char* snort_strdup(const char* s)
+{ return strdup(s); }
+
+// the default (no year, local time == UTC) format of the real one
+void ts_print(const struct timeval* tv, char* buf, bool)
+{
+    int s = tv->tv_sec % 86400;
+    time_t t = tv->tv_sec - s;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+
+    snprintf(buf, TIMEBUF_SIZE, "%02d/%02d-%02d:%02d:%02d.%06u",
+        tm.tm_mon + 1, tm.tm_mday, s / 3600, (s % 3600) / 60, s % 60,
+        (unsigned)tv->tv_usec);
+}
+}
+
+//--------------------------------------------------------------------------
+// alert_fast style lines, formatted both ways
+//--------------------------------------------------------------------------
+
+struct Alert
+{
+    struct timeval ts;
+    SfIp src, dst;
+    uint16_t sp, dp;
+    uint32_t gid, sid, rev, priority;
+};
+
+static void print_alert(TextLog* log, const Alert& a)
+{
+    char ts[TIMEBUF_SIZE];
+    ts_print(&a.ts, ts);
+    TextLog_Puts(log, ts);
+
+    TextLog_Puts(log, " [**] ");
+    TextLog_Print(log, "[%u:%u:%u] ", a.gid, a.sid, a.rev);
+    TextLog_Puts(log, "benchmark alert [**] ");
+    TextLog_Print(log, "[Priority: %d] ", a.priority);
+
+    SfIpString src, dst;
+    TextLog_Print(log, "{%s} %s:%d -> %s:%d", "TCP",
+        sfip_ntop(&a.src, src, sizeof(src)), a.sp,
+        sfip_ntop(&a.dst, dst, sizeof(dst)), a.dp);
+
+    TextLog_NewLine(log);
+}
+
+static void put_alert(TextLog* log, const Alert& a)
+{
+    TextLog_PutTimestamp(log, &a.ts);
+
+    TextLog_Puts(log, " [**] ");
+    TextLog_Putc(log, '[');
+    TextLog_PutU64(log, a.gid);
+    TextLog_Putc(log, ':');
+    TextLog_PutU64(log, a.sid);
+    TextLog_Putc(log, ':');
+    TextLog_PutU64(log, a.rev);
+    TextLog_Puts(log, "] ");
+    TextLog_Puts(log, "benchmark alert [**] ");
+    TextLog_Puts(log, "[Priority: ");
+    TextLog_PutU64(log, a.priority);
+    TextLog_Puts(log, "] ");
+
+    TextLog_Puts(log, "{TCP} ");
+    TextLog_PutIp(log, &a.src);
+    TextLog_Putc(log, ':');
+    TextLog_PutU64(log, a.sp);
+    TextLog_Puts(log, " -> ");
+    TextLog_PutIp(log, &a.dst);
+    TextLog_Putc(log, ':');
+    TextLog_PutU64(log, a.dp);
+
+    TextLog_NewLine(log);
+}
+
+static const unsigned num_alerts = 1024;
+
+// many alerts per second, as in an alert storm
+static void make_alerts(std::vector<Alert>& alerts)
+{
+    alerts.resize(num_alerts);
+
+    for ( unsigned i = 0; i < num_alerts; ++i )
+    {
+        Alert& a = alerts[i];
+        a.ts = { (time_t)(1700000000 + i / 256), (suseconds_t)((i * 7919) % 1000000) };
+
+        uint32_t s = htonl(0x0a000000 + i * 13);
+        uint32_t d = htonl(0xc0a80000 + i);
+        a.src.set(&s, AF_INET);
+        a.dst.set(&d, AF_INET);
+
+        a.sp = 1024 + i;
+        a.dp = (i & 1) ? 80 : 443;
+        a.gid = 1;
+        a.sid = 2000000 + i * 31;
+        a.rev = 1 + i % 9;
+        a.priority = 1 + i % 4;
+    }
+}
+
+// format into the buffer only, the result is discarded
+static const char* format(TextLog* log, void (*f)(TextLog*, const Alert&), const Alert& a)
+{
+    TextLog_Reset(log);
+    f(log, a);
+    return TextLog_Avail(log) ? "ok" : "full";
+}
+
+static std::string contents(FILE* f)
+{
+    std::string s;
+    rewind(f);
+
+    int c;
+    while ( (c = fgetc(f)) != EOF )
+        s += (char)c;
+
+    return s;
+}
+
+TEST_CASE("text log alert formatting", "[text_log]")
+{
+    std::vector<Alert> alerts;
+    make_alerts(alerts);
+
+    s_files.clear();
+    TextLog* log = TextLog_Init("bench", 64 * K_BYTES);
+    TextLog* ref = TextLog_Init("bench", 64 * K_BYTES);
+    REQUIRE(s_files.size() == 2);
+
+    for ( const auto& a : alerts )
+    {
+        put_alert(log, a);
+        print_alert(ref, a);
+    }
+    TextLog_Flush(log);
+    TextLog_Flush(ref);
+
+    std::string out = contents(s_files[0]);
+    REQUIRE(out.size() > num_alerts * 64);
+    CHECK(out == contents(s_files[1]));
+
+    unsigned i = 0;
+
+    BENCHMARK("TextLog_Print")
+    {
+        return format(ref, print_alert, alerts[i++ % num_alerts]);
+    };
+
+    i = 0;
+
+    BENCHMARK("TextLog_Put")
+    {
+        return format(log, put_alert, alerts[i++ % num_alerts]);
+    };
+
+    TextLog_Reset(log);
+    TextLog_Reset(ref);
+    TextLog_Term(log);
+    TextLog_Term(ref);
+}
+
+#endif
@@ -37,6 +37,8 @@
 #include <algorithm>
 #include <cstdarg>
 
+#include "main/snort_config.h"
+#include "sfip/sf_ip.h"
 #include "utils/util.h"
 
 #include "log.h"
@@ -57,6 +59,12 @@ struct TextLog
     size_t maxFile;
     time_t last;
 
+/* timestamp cache: */
+    time_t ts_sec;
+    const SnortConfig* ts_conf;
+    unsigned ts_len;
+    char ts_prefix[TIMEBUF_SIZE];
+
 /* buffer attributes: */
     unsigned int pos;
     unsigned int maxBuf;
@@ -98,6 +106,53 @@ static size_t TextLog_Size(FILE* file)
     return err ? 0 : sbuf.st_size;
 }
 
+/*-------------------------------------------------------------------
+ * digit conversion: two digits per division, written right to left
+ *-------------------------------------------------------------------
+ */
+static const char s_digits[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// returns the start of the digits which end at end
+static inline char* put_u64(uint64_t v, char* end)
+{
+    while ( v >= 100 )
+    {
+        unsigned i = (v % 100) * 2;
+        v /= 100;
+        end -= 2;
+        memcpy(end, s_digits + i, 2);
+    }
+    if ( v >= 10 )
+    {
+        end -= 2;
+        memcpy(end, s_digits + v * 2, 2);
+    }
+    else
+        *--end = '0' + v;
+
+    return end;
+}
+
+// exactly 6 digits with leading zeros
+static inline void put_usec(unsigned v, char* buf)
+{
+    memcpy(buf + 4, s_digits + (v % 100) * 2, 2);
+    v /= 100;
+    memcpy(buf + 2, s_digits + (v % 100) * 2, 2);
+    v /= 100;
+    memcpy(buf, s_digits + (v % 100) * 2, 2);
+}
+
 namespace snort
 {
 int TextLog_Avail(TextLog* const txt)
@@ -130,6 +185,7 @@ TextLog* TextLog_Init(
     txt->size = TextLog_Size(txt->file);
     txt->last = time(nullptr);
     txt->maxFile = maxFile;
+    txt->ts_conf = nullptr;
 
     txt->maxBuf = maxBuf;
     TextLog_Reset(txt);
@@ -222,26 +278,49 @@ bool TextLog_Putc(TextLog* const txt, char c)
  */
 bool TextLog_Write(TextLog* const txt, const char* str, int len)
 {
-    do
+    if ( len <= 0 )
+        return true;
+
+    // like "%.*s", stop at an embedded nul
+    int n = strnlen(str, len);
+    bool ok = (n == len);
+
+    while ( n > 0 )
     {
         int avail = TextLog_Avail(txt);
-        int n = snprintf(txt->buf+txt->pos, avail, "%.*s", len, str);
-        if ( n < avail and n < len )
-            return false;
 
-        // actual bytes written:
-        // 1) if avail is a limit, auto-appended '\0' should be truncated
-        // 2) avail could be zero from the start, keep it as 0
-        int l = std::min(n, avail > 0 ? avail - 1 : 0);
+        if ( avail <= 0 )
+        {
+            if ( !TextLog_Flush(txt) )
+                return false;
+            continue;
+        }
+        int l = std::min(n, avail);
+        memcpy(txt->buf + txt->pos, str, l);
         txt->pos += l;
         str += l;
-        len -= l;
-
-        if ( n >= avail )
-            TextLog_Flush(txt);
+        n -= l;
     }
-    while ( len > 0 );
+    txt->buf[txt->pos] = '\0';
+    return ok;
+}
+
+/*-------------------------------------------------------------------
+ * TextLog_Append: append a short chunk formatted by the caller
+ *-------------------------------------------------------------------
+ */
+static bool TextLog_Append(TextLog* const txt, const char* str, int len)
+{
+    if ( TextLog_Avail(txt) < len )
+    {
+        TextLog_Flush(txt);
 
+        if ( TextLog_Avail(txt) < len )
+            return false;
+    }
+    memcpy(txt->buf + txt->pos, str, len);
+    txt->pos += len;
+    txt->buf[txt->pos] = '\0';
     return true;
 }
 
@@ -312,4 +391,82 @@ bool TextLog_Quote(TextLog* const txt, const char* qs)
 
     return true;
 }
+
+/*-------------------------------------------------------------------
+ * TextLog_PutU64: append unsigned decimal
+ *-------------------------------------------------------------------
+ */
+bool TextLog_PutU64(TextLog* const txt, uint64_t v)
+{
+    char buf[20];
+    char* end = buf + sizeof(buf);
+    char* start = put_u64(v, end);
+    return TextLog_Append(txt, start, end - start);
+}
+
+/*-------------------------------------------------------------------
+ * TextLog_PutIp: append IP address, dotted quad done here
+ *-------------------------------------------------------------------
+ */
+bool TextLog_PutIp(TextLog* const txt, const SfIp* ip)
+{
+    if ( !ip )
+        return true;
+
+    if ( !ip->is_ip4() or SfIp::test_features )
+    {
+        SfIpString str;
+        return TextLog_Write(txt, ip->ntop(str), strlen(str));
+    }
+
+    const uint8_t* b = (const uint8_t*)ip->get_ip4_ptr();
+    char buf[INET_ADDRSTRLEN];
+    char* end = buf + sizeof(buf);
+    char* start = end;
+
+    for ( int i = 3; i >= 0; --i )
+    {
+        start = put_u64(b[i], start);
+
+        if ( i )
+            *--start = '.';
+    }
+    return TextLog_Append(txt, start, end - start);
+}
+
+/*-------------------------------------------------------------------
+ * TextLog_PutTimestamp: append packet time
+ * ts_print() is only called when the second or config changes
+ *-------------------------------------------------------------------
+ */
+bool TextLog_PutTimestamp(TextLog* const txt, const struct timeval* tv)
+{
+    const SnortConfig* sc = SnortConfig::get_conf();
+
+    if ( tv->tv_sec != txt->ts_sec or sc != txt->ts_conf )
+    {
+        struct timeval sec = { tv->tv_sec, 0 };
+        ts_print(&sec, txt->ts_prefix);
+
+        // cache everything but the microseconds
+        const char* dot = strrchr(txt->ts_prefix, '.');
+        txt->ts_len = dot ? dot - txt->ts_prefix + 1 : 0;
+        txt->ts_sec = tv->tv_sec;
+        txt->ts_conf = sc;
+    }
+
+    if ( !txt->ts_len or tv->tv_usec >= 1000000 )
+    {
+        // not the usual layout, nothing to cache
+        char buf[TIMEBUF_SIZE];
+        ts_print(tv, buf);
+        return TextLog_Write(txt, buf, strlen(buf));
+    }
+
+    char buf[TIMEBUF_SIZE + 6];
+    memcpy(buf, txt->ts_prefix, txt->ts_len);
+    put_usec((unsigned)tv->tv_usec, buf + txt->ts_len);
+
+    return TextLog_Append(txt, buf, txt->ts_len + 6);
+}
 } // namespace snort
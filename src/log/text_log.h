@@ -32,8 +32,14 @@
  * that, the file is closed, renamed, and reopened.  The current
  * file always has the same name.  Old files are renamed to that
  * name plus a timestamp.
+ *
+ * The TextLog_Put*() functions append common types without going through
+ * vsnprintf(), which is most of the cost of formatting an alert.
  */
 
+#include <sys/time.h>
+
+#include <cstdint>
 #include <cstring>
 
 #include "main/snort_types.h"
@@ -48,6 +54,8 @@ struct TextLog;
 
 namespace snort
 {
+struct SfIp;
+
 SO_PUBLIC TextLog* TextLog_Init(
     const char* name, unsigned int maxBuf = 0, size_t maxFile = 0);
 SO_PUBLIC void TextLog_Term(TextLog*);
@@ -57,6 +65,15 @@ SO_PUBLIC bool TextLog_Quote(TextLog* const, const char*);
 SO_PUBLIC bool TextLog_Write(TextLog* const, const char*, int len);
 SO_PUBLIC bool TextLog_Print(TextLog* const, const char* format, ...) __attribute__((format (printf, 2, 3)));
 
+// decimal, same as "%" PRIu64
+SO_PUBLIC bool TextLog_PutU64(TextLog* const, uint64_t);
+
+// same as sfip_ntop(), nothing for a null address
+SO_PUBLIC bool TextLog_PutIp(TextLog* const, const SfIp*);
+
+// same as ts_print(); the text up to the second is cached per TextLog
+SO_PUBLIC bool TextLog_PutTimestamp(TextLog* const, const struct timeval*);
+
 SO_PUBLIC bool TextLog_Flush(TextLog* const);
 SO_PUBLIC int TextLog_Avail(TextLog* const);
 SO_PUBLIC void TextLog_Reset(TextLog* const);
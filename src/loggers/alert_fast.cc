@@ -235,15 +235,21 @@ void FastLogger::alert(Packet* p, const char* msg, const Event& event)
     LogTimeStamp(fast_log, p);
 
     if ( p->active->packet_was_dropped() )
-        TextLog_Print(fast_log, " [%s]", p->active->get_action_string());
+    {
+        TextLog_Puts(fast_log, " [");
+        TextLog_Puts(fast_log, p->active->get_action_string());
+        TextLog_Putc(fast_log, ']');
+    }
 
     TextLog_Puts(fast_log, " [**] ");
-
-    TextLog_Print(fast_log, "[%u:%u:%u] ",
-        event.sig_info->gid, event.sig_info->sid, event.sig_info->rev);
+    LogRuleId(fast_log, event);
 
     if (p->context->conf->alert_interface())
-        TextLog_Print(fast_log, " <%s> ", SFDAQ::get_input_spec());
+    {
+        TextLog_Puts(fast_log, " <");
+        TextLog_Puts(fast_log, SFDAQ::get_input_spec());
+        TextLog_Puts(fast_log, "> ");
+    }
 
     if ( msg )
         TextLog_Puts(fast_log, msg);
@@ -253,7 +259,9 @@ void FastLogger::alert(Packet* p, const char* msg, const Event& event)
     // print the packet header to the alert file
     LogPriorityData(fast_log, event);
     LogAppID(fast_log, p);
-    TextLog_Print(fast_log, "{%s} ", p->get_type());
+    TextLog_Putc(fast_log, '{');
+    TextLog_Puts(fast_log, p->get_type());
+    TextLog_Puts(fast_log, "} ");
     LogIpAddrs(fast_log, p);
 
     if ( packet || p->context->conf->output_app_data() )
@@ -150,13 +150,14 @@ void FullLogger::alert(Packet* p, const char* msg, const Event& event)
 {
     TextLog_Puts(full_log, "[**] ");
 
-    TextLog_Print(full_log, "[%u:%u:%u] ",
-        event.sig_info->gid, event.sig_info->sid, event.sig_info->rev);
+    LogRuleId(full_log, event);
 
     if (p->context->conf->alert_interface())
     {
         const char* iface = SFDAQ::get_input_spec();
-        TextLog_Print(full_log, " <%s> ", iface);
+        TextLog_Puts(full_log, " <");
+        TextLog_Puts(full_log, iface);
+        TextLog_Puts(full_log, "> ");
     }
 
     if (msg != nullptr)
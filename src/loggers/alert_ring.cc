@@ -0,0 +1,370 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// alert_ring.cc
+
+// fixed layout binary alerts in a memory mapped ring file, see log/alert_ring.h
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstring>
+
+#include "detection/ips_context.h"
+#include "detection/signature.h"
+#include "events/event.h"
+#include "framework/logger.h"
+#include "framework/module.h"
+#include "log/alert_ring.h"
+#include "log/messages.h"
+#include "packet_io/active.h"
+#include "protocols/packet.h"
+#include "utils/util.h"
+
+using namespace snort;
+
+#define S_NAME "alert_ring"
+#define F_NAME S_NAME ".bin"
+
+//-------------------------------------------------------------------------
+// record layout
+//-------------------------------------------------------------------------
+
+#define ALERT_RING_MSG_LEN 168
+
+struct AlertRecord
+{
+    uint64_t pkt_num;
+
+    uint32_t seconds;
+    uint32_t useconds;
+
+    uint32_t gid;
+    uint32_t sid;
+    uint32_t rev;
+    uint32_t class_id;
+    uint32_t priority;
+    uint32_t event_id;
+    uint32_t event_ref;
+    uint32_t pkt_len;
+
+    uint8_t src_addr[16];
+    uint8_t dst_addr[16];
+
+    uint16_t src_port;
+    uint16_t dst_port;
+
+    uint8_t ip_proto;
+    uint8_t action;
+    uint8_t dir;
+    uint8_t pad;
+
+    char msg[ALERT_RING_MSG_LEN];
+};
+
+static_assert(sizeof(AlertRecord) == 256, "keep records a power of 2");
+
+#define FIELD(n, t) { #n, t, offsetof(AlertRecord, n), sizeof(AlertRecord::n) }
+
+static const AlertRingField schema[] =
+{
+    FIELD(pkt_num, ART_U64),
+    FIELD(seconds, ART_U32),
+    FIELD(useconds, ART_U32),
+    FIELD(gid, ART_U32),
+    FIELD(sid, ART_U32),
+    FIELD(rev, ART_U32),
+    FIELD(class_id, ART_U32),
+    FIELD(priority, ART_U32),
+    FIELD(event_id, ART_U32),
+    FIELD(event_ref, ART_U32),
+    FIELD(pkt_len, ART_U32),
+    FIELD(src_addr, ART_IP),
+    FIELD(dst_addr, ART_IP),
+    FIELD(src_port, ART_U16),
+    FIELD(dst_port, ART_U16),
+    FIELD(ip_proto, ART_U8),
+    FIELD(action, ART_U8),
+    FIELD(dir, ART_U8),
+    FIELD(msg, ART_STR),
+};
+
+#undef FIELD
+
+enum AlertDir : uint8_t
+{ DIR_UNK, DIR_C2S, DIR_S2C };
+
+//-------------------------------------------------------------------------
+// ring file
+//-------------------------------------------------------------------------
+
+struct RingFile
+{
+    int fd;
+    uint8_t* base;
+    size_t len;
+    AlertRingHeader* hdr;
+    AlertRecord* slots;
+    uint64_t capacity;
+    uint64_t next;
+};
+
+static THREAD_LOCAL RingFile ring;
+
+// on failure the logger stays disabled for this thread
+static bool ring_open(RingFile& rf, const char* file, size_t size)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t hdr_size = sizeof(AlertRingHeader) + sizeof(schema);
+    hdr_size = (hdr_size + page - 1) / page * page;
+
+    rf.capacity = size / sizeof(AlertRecord);
+    rf.len = hdr_size + rf.capacity * sizeof(AlertRecord);
+
+    rf.fd = ::open(file, O_RDWR | O_CREAT | O_TRUNC, 0640);
+
+    if ( rf.fd < 0 )
+    {
+        ErrorMessage("%s: can't open %s: %s\n", S_NAME, file, get_error(errno));
+        return false;
+    }
+
+    void* map = MAP_FAILED;
+
+    if ( !ftruncate(rf.fd, rf.len) )
+        map = mmap(nullptr, rf.len, PROT_READ | PROT_WRITE, MAP_SHARED, rf.fd, 0);
+
+    if ( map == MAP_FAILED )
+    {
+        ErrorMessage("%s: can't map %s: %s\n", S_NAME, file, get_error(errno));
+        ::close(rf.fd);
+        return false;
+    }
+
+    rf.base = (uint8_t*)map;
+    rf.hdr = (AlertRingHeader*)rf.base;
+    rf.slots = (AlertRecord*)(rf.base + hdr_size);
+    rf.next = 0;
+
+    AlertRingHeader* h = rf.hdr;
+    h->version = ALERT_RING_VERSION;
+    h->header_size = hdr_size;
+    h->record_size = sizeof(AlertRecord);
+    h->capacity = rf.capacity;
+    h->num_fields = sizeof(schema) / sizeof(schema[0]);
+    h->schema_offset = sizeof(AlertRingHeader);
+    h->head.store(0, std::memory_order_relaxed);
+
+    memcpy(rf.base + h->schema_offset, schema, sizeof(schema));
+
+    // readers check the magic before anything else
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(h->magic, ALERT_RING_MAGIC, sizeof(h->magic));
+
+    return true;
+}
+
+static void ring_close(RingFile& rf)
+{
+    if ( !rf.base )
+        return;
+
+    munmap(rf.base, rf.len);
+    ::close(rf.fd);
+    rf = { };
+}
+
+//-------------------------------------------------------------------------
+// module stuff
+//-------------------------------------------------------------------------
+
+static const Parameter s_params[] =
+{
+    { "size", Parameter::PT_INT, "1:maxSZ", "16",
+      "size of each packet thread's ring in MB" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+#define s_help \
+    "output event in binary format to a memory mapped ring file"
+
+class RingModule : public Module
+{
+public:
+    RingModule() : Module(S_NAME, s_help, s_params) { }
+
+    bool set(const char*, Value&, SnortConfig*) override;
+    bool begin(const char*, int, SnortConfig*) override;
+
+    Usage get_usage() const override
+    { return GLOBAL; }
+
+public:
+    size_t size = 0;
+};
+
+bool RingModule::set(const char*, Value& v, SnortConfig*)
+{
+    if ( v.is("size") )
+        size = v.get_size() * 1024 * 1024;
+
+    return true;
+}
+
+bool RingModule::begin(const char*, int, SnortConfig*)
+{
+    size = 16 * 1024 * 1024;
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// logger stuff
+//-------------------------------------------------------------------------
+
+class RingLogger : public Logger
+{
+public:
+    RingLogger(RingModule* m) : size(m->size) { }
+
+    void open() override;
+    void close() override;
+
+    void alert(Packet*, const char* msg, const Event&) override;
+
+private:
+    size_t size;
+};
+
+void RingLogger::open()
+{
+    std::string file;
+    get_instance_file(file, F_NAME);
+
+    ring_open(ring, file.c_str(), size);
+}
+
+void RingLogger::close()
+{
+    ring_close(ring);
+}
+
+void RingLogger::alert(Packet* p, const char* msg, const Event& event)
+{
+    if ( !ring.slots )
+        return;
+
+    // publish the last head before the slot is reused, see log/alert_ring.h
+    std::atomic_thread_fence(std::memory_order_release);
+
+    AlertRecord& r = ring.slots[ring.next % ring.capacity];
+    memset(&r, 0, sizeof(r));
+
+    r.pkt_num = p->context->packet_number;
+    r.seconds = p->pkth->ts.tv_sec;
+    r.useconds = p->pkth->ts.tv_usec;
+
+    r.gid = event.sig_info->gid;
+    r.sid = event.sig_info->sid;
+    r.rev = event.sig_info->rev;
+    r.class_id = event.sig_info->class_id;
+    r.priority = event.sig_info->priority;
+    r.event_id = event.get_event_id();
+    r.event_ref = event.get_event_reference();
+
+    if ( p->has_ip() )
+        r.pkt_len = p->ptrs.ip_api.dgram_len();
+    else
+        r.pkt_len = p->dsize;
+
+    if ( p->has_ip() or p->is_data() )
+    {
+        memcpy(r.src_addr, p->ptrs.ip_api.get_src()->get_ip6_ptr(), sizeof(r.src_addr));
+        memcpy(r.dst_addr, p->ptrs.ip_api.get_dst()->get_ip6_ptr(), sizeof(r.dst_addr));
+        r.ip_proto = (uint8_t)p->get_ip_proto_next();
+    }
+
+    if ( p->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
+    {
+        r.src_port = p->ptrs.sp;
+        r.dst_port = p->ptrs.dp;
+    }
+
+    r.action = p->active->get_action();
+
+    if ( p->is_from_application_client() )
+        r.dir = DIR_C2S;
+    else if ( p->is_from_application_server() )
+        r.dir = DIR_S2C;
+
+    if ( msg )
+        strncpy(r.msg, msg, sizeof(r.msg) - 1);
+
+    ring.hdr->head.store(++ring.next, std::memory_order_release);
+}
+
+//-------------------------------------------------------------------------
+// api stuff
+//-------------------------------------------------------------------------
+
+static Module* mod_ctor()
+{ return new RingModule; }
+
+static void mod_dtor(Module* m)
+{ delete m; }
+
+static Logger* ring_ctor(Module* mod)
+{ return new RingLogger((RingModule*)mod); }
+
+static void ring_dtor(Logger* p)
+{ delete p; }
+
+static LogApi ring_api
+{
+    {
+        PT_LOGGER,
+        sizeof(LogApi),
+        LOGAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        S_NAME,
+        s_help,
+        mod_ctor,
+        mod_dtor
+    },
+    OUTPUT_TYPE_FLAG__ALERT,
+    ring_ctor,
+    ring_dtor
+};
+
+#ifdef BUILDING_SO
+SO_PUBLIC const BaseApi* snort_plugins[] =
+#else
+const BaseApi* alert_ring[] =
+#endif
+{
+    &ring_api.base,
+    nullptr
+};
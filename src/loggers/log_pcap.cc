@@ -24,9 +24,13 @@
 
 #include <pcap.h>
 
+#include <atomic>
+#include <cstdarg>
+
 #include "detection/ips_context.h"
 #include "framework/logger.h"
 #include "framework/module.h"
+#include "log/async_writer.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
 #include "packet_io/sfdaq.h"
@@ -52,20 +56,44 @@ struct LtdConfig
 {
     string file;
     size_t limit;
+    size_t async_buffer;
 };
 
+// everything needed to (re)open the file is resolved on the packet thread
+// so the writer thread can roll the file without the snort config
 struct LtdContext
 {
+    char* base;
     char* file;
     pcap_dumper_t* dumpd;
     time_t lastTime;
     size_t size;
     int log_cnt;
+    int dlt;
+    unsigned snaplen;
+
+    // with async_buffer the writer thread can't call FatalError(); it sets
+    // failed and leaves the error for the packet thread instead
+    bool async;
+    std::atomic<bool> failed;
+    char error[STD_BUF];
 };
 
 static THREAD_LOCAL LtdContext context;
 
-static void TcpdumpRollLogFile(LtdConfig*);
+// when async_buffer is configured, the writer thread owns the dump file
+static THREAD_LOCAL AsyncWriter* pcap_writer = nullptr;
+static THREAD_LOCAL AsyncWriterSink* pcap_sink = nullptr;
+static THREAD_LOCAL AsyncWriterStats pcap_stats;
+
+enum PcapRecord : uint32_t
+{
+    PCAP_REC_PACKET,  // pcap_pkthdr followed by caplen bytes
+    PCAP_REC_ROLL,    // no data
+};
+
+static void TcpdumpRollLogFile(LtdContext&);
+static void TcpdumpCheckWriter(LtdContext&);
 
 #define S_NAME "log_pcap"
 #define F_NAME "log.pcap"
@@ -79,6 +107,9 @@ static const Parameter s_params[] =
     { "limit", Parameter::PT_INT, "0:maxSZ", "0",
       "set maximum size in MB before rollover (0 is unlimited)" },
 
+    { "async_buffer", Parameter::PT_INT, "0:maxSZ", "0",
+      "size in MB of the queue for each packet thread's writer thread (0 writes synchronously)" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -93,23 +124,35 @@ public:
     bool set(const char*, Value&, SnortConfig*) override;
     bool begin(const char*, int, SnortConfig*) override;
 
+    const PegInfo* get_pegs() const override
+    { return async_writer_pegs; }
+
+    PegCount* get_counts() const override
+    { return (PegCount*)&pcap_stats; }
+
     Usage get_usage() const override
     { return GLOBAL; }
 
 public:
     size_t limit = 0;
+    size_t async_buffer = 0;
 };
 
 bool TcpdumpModule::set(const char*, Value& v, SnortConfig*)
 {
-    assert(v.is("limit"));
-    limit = v.get_size() * 1024 * 1024;
+    if ( v.is("limit") )
+        limit = v.get_size() * 1024 * 1024;
+
+    else if ( v.is("async_buffer") )
+        async_buffer = v.get_size() * 1024 * 1024;
+
     return true;
 }
 
 bool TcpdumpModule::begin(const char*, int, SnortConfig*)
 {
     limit = 0;
+    async_buffer = 0;
     return true;
 }
 
@@ -117,25 +160,39 @@ bool TcpdumpModule::begin(const char*, int, SnortConfig*)
 // api stuff
 //-------------------------------------------------------------------------
 
-static inline size_t SizeOf(const Packet* p)
+static void TcpdumpDump(
+    LtdContext& ctx, LtdConfig* data, const struct pcap_pkthdr& pcaphdr, const uint8_t* pkt)
 {
-    return PCAP_PKT_HDR_SZ + p->pktlen;
+    size_t dumpSize = PCAP_PKT_HDR_SZ + pcaphdr.caplen;
+
+    if ( data->limit && (ctx.size + dumpSize > data->limit) )
+        TcpdumpRollLogFile(ctx);
+
+    // the writer thread couldn't open a new file
+    if ( !ctx.dumpd )
+        return;
+
+    pcap_dump((uint8_t*)ctx.dumpd, &pcaphdr, pkt);
+    ctx.size += dumpSize;
+    ctx.log_cnt++;
 }
 
 static void LogTcpdumpSingle(
     LtdConfig* data, Packet* p, const char*, Event*)
 {
-    size_t dumpSize = SizeOf(p);
-
-    if ( data->limit && (context.size + dumpSize > data->limit) )
-        TcpdumpRollLogFile(data);
-
     struct pcap_pkthdr pcaphdr;
     pcaphdr.ts = p->pkth->ts;
     pcaphdr.caplen = p->pktlen;
     pcaphdr.len = p->pkth->pktlen;
-    pcap_dump((uint8_t*)context.dumpd, &pcaphdr, p->pkt);
-    context.size += dumpSize;
+
+    if ( pcap_writer )
+    {
+        TcpdumpCheckWriter(context);
+        pcap_writer->put(PCAP_REC_PACKET, &pcaphdr, sizeof(pcaphdr), p->pkt, p->pktlen);
+        return;
+    }
+
+    TcpdumpDump(context, data, pcaphdr, p->pkt);
 
     if (!p->context->conf->line_buffered_logging())  // FIXIT-L misnomer
     {
@@ -150,73 +207,143 @@ static void LogTcpdumpStream(
 // (take original packet headers and append reassembled data)
 }
 
-static void TcpdumpInitLogFile(LtdConfig*, bool no_timestamp)
+static void TcpdumpInitBase(LtdContext& ctx)
 {
     string file;
-    string filename = F_NAME;
+    get_instance_file(file, F_NAME);
+    ctx.base = snort_strdup(file.c_str());
 
-    context.lastTime = time(nullptr);
-    context.log_cnt = 0;
+    ctx.dlt = SFDAQ::get_base_protocol();
 
-    if(!no_timestamp)
+    // convert these flavors of raw to the generic
+    // for compatibility with libpcap 1.0.0
+    if ( ctx.dlt == DLT_IPV4 || ctx.dlt == DLT_IPV6 )
+        ctx.dlt = DLT_RAW;
+
+    ctx.snaplen = SnortConfig::get_conf()->daq_config->get_mru_size();
+}
+
+static void TcpdumpFatal(LtdContext& ctx, const char* format, ...)
+    __attribute__((format (printf, 2, 3)));
+
+static void TcpdumpFatal(LtdContext& ctx, const char* format, ...)
+{
+    char buf[STD_BUF];
+    va_list ap;
+
+    va_start(ap, format);
+    vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+
+    if ( !ctx.async )
+        FatalError("%s", buf);
+
+    if ( !ctx.failed.load(std::memory_order_acquire) )
     {
-        char timestamp[16];
-        snprintf(timestamp, sizeof(timestamp), ".%lu", (unsigned long)context.lastTime);
-        filename += timestamp;
+        memcpy(ctx.error, buf, sizeof(ctx.error));
+        ctx.failed.store(true, std::memory_order_release);
     }
+}
 
-    get_instance_file(file, filename.c_str());
+// called on the packet thread to report a failure of the writer thread
+static void TcpdumpCheckWriter(LtdContext& ctx)
+{
+    if ( ctx.failed.load(std::memory_order_acquire) )
+        FatalError("%s", ctx.error);
+}
 
-    int dlt = SFDAQ::get_base_protocol();
+static void TcpdumpInitLogFile(LtdContext& ctx, bool no_timestamp)
+{
+    string file = ctx.base;
 
-    // convert these flavors of raw to the generic
-    // for compatibility with libpcap 1.0.0
-    if ( dlt == DLT_IPV4 || dlt == DLT_IPV6 )
-        dlt = DLT_RAW;
+    ctx.lastTime = time(nullptr);
+    ctx.log_cnt = 0;
+
+    if(!no_timestamp)
+    {
+        char timestamp[16];
+        snprintf(timestamp, sizeof(timestamp), ".%lu", (unsigned long)ctx.lastTime);
+        file += timestamp;
+    }
 
     pcap_t* pcap;
-    pcap = pcap_open_dead(dlt, SnortConfig::get_conf()->daq_config->get_mru_size());
+    pcap = pcap_open_dead(ctx.dlt, ctx.snaplen);
 
     if ( !pcap )
-        FatalError("%s: can't get pcap context\n", S_NAME);
+    {
+        TcpdumpFatal(ctx, "%s: can't get pcap context\n", S_NAME);
+        return;
+    }
 
-    context.dumpd = pcap ? pcap_dump_open(pcap, file.c_str()) : nullptr;
+    ctx.dumpd = pcap_dump_open(pcap, file.c_str());
 
-    if (context.dumpd == nullptr)
+    if (ctx.dumpd == nullptr)
     {
-        FatalError("%s: can't open %s: %s\n",
+        TcpdumpFatal(ctx, "%s: can't open %s: %s\n",
             S_NAME, file.c_str(), pcap_geterr(pcap));
+        pcap_close(pcap);
+        return;
     }
     pcap_close(pcap);
 
-    context.file = snort_strdup(file.c_str());
-    context.size = PCAP_FILE_HDR_SZ;
+    ctx.file = snort_strdup(file.c_str());
+    ctx.size = PCAP_FILE_HDR_SZ;
 }
 
-static void TcpdumpRollLogFile(LtdConfig* data)
+static void TcpdumpRollLogFile(LtdContext& ctx)
 {
     time_t now = time(nullptr);
 
     /* don't roll over any sooner than resolution
      * of filename discriminator
      */
-    if ( now <= context.lastTime )
+    if ( now <= ctx.lastTime )
         return;
 
     /* close the output file */
-    if ( context.dumpd != nullptr )
+    if ( ctx.dumpd != nullptr )
     {
-        pcap_dump_close(context.dumpd);
-        context.dumpd = nullptr;
-        context.size = 0;
-        snort_free(context.file);
-        context.file = nullptr;
+        pcap_dump_close(ctx.dumpd);
+        ctx.dumpd = nullptr;
+        ctx.size = 0;
+        snort_free(ctx.file);
+        ctx.file = nullptr;
     }
 
     /* Have to add stamps now to distinguish files */
-    TcpdumpInitLogFile(data, false);
+    TcpdumpInitLogFile(ctx, false);
 }
 
+class PcapSink : public AsyncWriterSink
+{
+public:
+    PcapSink(LtdContext& c, LtdConfig* d) : ctx(c), data(d) { }
+
+    void write(uint32_t type, const uint8_t* buf, uint32_t len) override
+    {
+        if ( type == PCAP_REC_ROLL )
+        {
+            TcpdumpRollLogFile(ctx);
+            return;
+        }
+        assert(len >= sizeof(struct pcap_pkthdr));
+
+        struct pcap_pkthdr pcaphdr;
+        memcpy(&pcaphdr, buf, sizeof(pcaphdr));
+        TcpdumpDump(ctx, data, pcaphdr, buf + sizeof(pcaphdr));
+    }
+
+    void flush() override
+    {
+        if ( ctx.dumpd )
+            pcap_dump_flush(ctx.dumpd);
+    }
+
+private:
+    LtdContext& ctx;
+    LtdConfig* data;
+};
+
 static void SpoLogTcpdumpCleanup(LtdConfig*)
 {
     /*
@@ -260,6 +387,7 @@ PcapLogger::PcapLogger(TcpdumpModule* m)
 {
     config = new LtdConfig;
     config->limit = m->limit;
+    config->async_buffer = m->async_buffer;
 }
 
 PcapLogger::~PcapLogger()
@@ -269,11 +397,36 @@ PcapLogger::~PcapLogger()
 
 void PcapLogger::open()
 {
-    TcpdumpInitLogFile(config, SnortConfig::get_conf()->output_no_timestamp());
+    if ( !context.base )
+        TcpdumpInitBase(context);
+
+    TcpdumpInitLogFile(context, SnortConfig::get_conf()->output_no_timestamp());
+
+    if ( config->async_buffer and !pcap_writer )
+    {
+        // from here on the dump file belongs to the writer thread
+        context.async = true;
+        pcap_sink = new PcapSink(context, config);
+        pcap_writer = new AsyncWriter(*pcap_sink, config->async_buffer, pcap_stats);
+    }
 }
 
 void PcapLogger::close()
 {
+    // drains the queue so the writer thread is done with the context
+    delete pcap_writer;
+    delete pcap_sink;
+
+    pcap_writer = nullptr;
+    pcap_sink = nullptr;
+
+    // the writer thread is done so report anything it left behind
+    if ( context.async and context.failed )
+        ErrorMessage("%s", context.error);
+
+    context.async = false;
+    context.failed = false;
+
     SpoLogTcpdumpCleanup(nullptr);
 
     if ( context.dumpd )
@@ -282,15 +435,22 @@ void PcapLogger::close()
         context.dumpd = nullptr;
     }
     if ( context.file )
+    {
         snort_free(context.file);
+        context.file = nullptr;
+    }
+    if ( context.base )
+    {
+        snort_free(context.base);
+        context.base = nullptr;
+    }
 }
 
 void PcapLogger::log(Packet* p, const char* msg, Event* event)
 {
-    if(!context.dumpd)
+    if ( !pcap_writer and !context.dumpd )
         open();
 
-    context.log_cnt++;
     if (p->packet_flags & PKT_REBUILT_STREAM)
         LogTcpdumpStream(config, p, msg, event);
     else
@@ -299,10 +459,15 @@ void PcapLogger::log(Packet* p, const char* msg, Event* event)
 
 void PcapLogger::reset()
 {
-    if(!context.dumpd)
+    if ( pcap_writer )
+    {
+        TcpdumpCheckWriter(context);
+        pcap_writer->put(PCAP_REC_ROLL, nullptr, 0);
+    }
+    else if ( !context.dumpd )
         open();
     else
-        TcpdumpRollLogFile(config);
+        TcpdumpRollLogFile(context);
 }
 
 //-------------------------------------------------------------------------
@@ -29,7 +29,9 @@
 #include "config.h"
 #endif
 
+#include <atomic>
 #include <cassert>
+#include <cstdarg>
 
 #include "detection/signature.h"
 #include "detection/detection_util.h"
@@ -37,6 +39,7 @@
 #include "events/event.h"
 #include "framework/logger.h"
 #include "framework/module.h"
+#include "log/async_writer.h"
 #include "log/messages.h"
 #include "log/obfuscator.h"
 #include "log/unified2.h"
@@ -64,6 +67,7 @@ using namespace std;
 struct Unified2Config
 {
     size_t limit;
+    size_t async_buffer;
     int nostamp;
     bool legacy_events;
 };
@@ -71,16 +75,31 @@ struct Unified2Config
 struct U2
 {
     FILE* stream;
+    char* io_buffer;
     unsigned int current;
     int base_proto;
     uint32_t timestamp;
     char filepath[STD_BUF];
+
+    // with async_buffer the writer thread owns the file; it leaves errors
+    // in msg for the packet thread to report and sets failed instead of
+    // calling FatalError() itself
+    bool async;
+    std::atomic<bool> msg_ready;
+    std::atomic<bool> failed;
+    char msg[STD_BUF];
 };
 
 /* -------------------- Global Variables ----------------------*/
 
 static THREAD_LOCAL U2 u2;
 
+/* When async_buffer is configured, records are queued here and written by
+ * a separate thread which owns u2.stream until close(). */
+static THREAD_LOCAL AsyncWriter* u2_writer = nullptr;
+static THREAD_LOCAL AsyncWriterSink* u2_sink = nullptr;
+static THREAD_LOCAL AsyncWriterStats u2_stats;
+
 /* Used for buffering header and payload of unified records so only one
  * write is necessary. */
 constexpr unsigned u2_buf_sz =
@@ -92,19 +111,73 @@ static THREAD_LOCAL uint8_t* write_pkt_buffer = nullptr;
     (MAX_XFF_WRITE_BUF_LENGTH - \
     sizeof(struct in6_addr) + DECODE_BLEN)
 
-/* This buffer is used in lieu of the underlying default stream buf to
+/* u2.io_buffer is used in lieu of the underlying default stream buf to
  * prevent flushing in the middle of a record.  Every write is force
  * flushed to disk immediately after the entire record is written so
- * spoolers get an entire record */
-
-/* use the size of the buffer we copy record data into */
-static THREAD_LOCAL char* io_buffer = nullptr;
+ * spoolers get an entire record.  It is the size of the buffer we copy
+ * record data into and is kept with the file since a rotation may run on
+ * the async writer thread. */
 
 /* -------------------- Local Functions -----------------------*/
 
 static void Unified2Write(uint8_t*, uint32_t, Unified2Config*);
 
-static void Unified2InitFile(Unified2Config* config)
+/* Report an error with the file.  Fatal errors don't return unless the
+ * file is owned by the async writer thread, in which case the file is
+ * closed, further writes are skipped, and the packet thread calls
+ * FatalError() when it next queues a record. */
+static void Unified2Error(U2& u2, bool fatal, const char* format, ...)
+    __attribute__((format (printf, 3, 4)));
+
+static void Unified2Error(U2& u2, bool fatal, const char* format, ...)
+{
+    char buf[STD_BUF];
+    va_list ap;
+
+    va_start(ap, format);
+    vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+
+    if ( !u2.async )
+    {
+        if ( fatal )
+            FatalError("%s", buf);
+
+        ErrorMessage("%s", buf);
+        return;
+    }
+
+    // a pending message is kept rather than overwritten while it may be read
+    if ( !u2.msg_ready.load(std::memory_order_acquire) )
+    {
+        memcpy(u2.msg, buf, sizeof(u2.msg));
+        u2.msg_ready.store(true, std::memory_order_release);
+    }
+
+    if ( fatal )
+    {
+        if ( u2.stream )
+            fclose(u2.stream);
+
+        u2.stream = nullptr;
+        u2.failed.store(true, std::memory_order_release);
+    }
+}
+
+/* Called on the packet thread to report what the writer thread ran into */
+static void Unified2CheckWriter(U2& u2)
+{
+    if ( u2.msg_ready.load(std::memory_order_acquire) )
+    {
+        ErrorMessage("%s", u2.msg);
+        u2.msg_ready.store(false, std::memory_order_release);
+    }
+
+    if ( u2.failed.load(std::memory_order_acquire) )
+        FatalError("unified2 writer thread cannot write to device.\n");
+}
+
+static bool Unified2InitFile(U2& u2, Unified2Config* config)
 {
     assert(config);
 
@@ -118,7 +191,8 @@ static void Unified2InitFile(Unified2Config* config)
         if (SnortSnprintf(filepath, sizeof(filepath), "%s.%u",
             u2.filepath, u2.timestamp) != SNORT_SNPRINTF_SUCCESS)
         {
-            FatalError("unified2 failed to copy file path.\n");
+            Unified2Error(u2, true, "unified2 failed to copy file path.\n");
+            return false;
         }
 
         fname_ptr = filepath;
@@ -130,23 +204,26 @@ static void Unified2InitFile(Unified2Config* config)
 
     if ((u2.stream = fopen(fname_ptr, "wb")) == nullptr)
     {
-        FatalError("unified2 could not open %s: %s\n", fname_ptr, get_error(errno));
+        Unified2Error(u2, true, "unified2 could not open %s: %s\n", fname_ptr, get_error(errno));
+        return false;
     }
 
     /* Set buffer to size of record buffer so the system doesn't flush
      * part of a record if it's greater than BUFSIZ */
-    if (setvbuf(u2.stream, io_buffer, _IOFBF, u2_buf_sz) != 0)
+    if (setvbuf(u2.stream, u2.io_buffer, _IOFBF, u2_buf_sz) != 0)
     {
-        ErrorMessage("unified2 could not set I/O buffer: %s. "
+        Unified2Error(u2, false, "unified2 could not set I/O buffer: %s. "
             "Using system default.\n", get_error(errno));
     }
+    return true;
 }
 
-static inline void Unified2RotateFile(Unified2Config* config)
+static inline bool Unified2RotateFile(U2& u2, Unified2Config* config)
 {
     fclose(u2.stream);
+    u2.stream = nullptr;
     u2.current = 0;
-    Unified2InitFile(config);
+    return Unified2InitFile(u2, config);
 }
 
 static inline unsigned get_version(const SfIp& addr)
@@ -230,9 +307,6 @@ static void alert_event(Packet* p, const char*, Unified2Config* config, const Ev
     Serial_Unified2_Header hdr;
     uint32_t write_len = sizeof(hdr) + sizeof(u2_event);
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
-
     hdr.length = htonl(sizeof(Unified2Event));
     hdr.type = htonl(UNIFIED2_EVENT3);
 
@@ -299,9 +373,6 @@ static void _WriteExtraData(Unified2Config* config,
     if (write_len > sizeof(write_buffer))
         return;
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
-
     hdr.length = htonl(write_len - sizeof(hdr));
     hdr.type = htonl(UNIFIED2_EXTRA_DATA);
 
@@ -383,9 +454,6 @@ static void _Unified2LogPacketAlert(
     logheader.packet_length = htonl(pkt_length + u2h_len);
     write_len += pkt_length + u2h_len;
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
-
     hdr.length = htonl(sizeof(Serial_Unified2Packet) - 4 + pkt_length + u2h_len);
     hdr.type = htonl(u2_type);
 
@@ -428,9 +496,11 @@ static void _Unified2LogPacketAlert(
 }
 
 /******************************************************************************
- * Function: Unified2Write()
+ * Function: Unified2WriteFile()
  *
- * Main function for writing to the unified2 file.
+ * Main function for writing to the unified2 file.  Rolls the file over first
+ * if the record would exceed the configured limit.  The stream is flushed
+ * after the record unless the caller will flush a batch of records itself.
  *
  * For low level I/O errors, the current unified2 file is closed and a new
  * one created and a write to the new unified2 file is done.  It was found
@@ -448,17 +518,22 @@ static void _Unified2LogPacketAlert(
  * unified2 file.
  *
  * Arguments
- *  uint8_t *
+ *  U2 &
+ *      The file to write to
+ *  const uint8_t *
  *      The buffer containing the data to write
  *  uint32_t
  *      The length of the data to write
  *  Unified2Config *
  *      A pointer to the unified2 configuration data
+ *  bool
+ *      Flush the stream after the write
  *
  * Returns: None
  *
  ******************************************************************************/
-static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config)
+static void Unified2WriteFile(
+    U2& u2, const uint8_t* buf, uint32_t buf_len, Unified2Config* config, bool flush)
 {
     size_t fwcount = 0;
 
@@ -466,9 +541,15 @@ static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config
     if ((buf == nullptr) || (config == nullptr) || (u2.stream == nullptr))
         return;
 
+    if ( config->limit && (u2.current + buf_len) > config->limit )
+    {
+        if ( !Unified2RotateFile(u2, config) )
+            return;
+    }
+
     /* Don't use fsync().  It is a total performance killer */
     if (((fwcount = fwrite(buf, (size_t)buf_len, 1, u2.stream)) != 1) ||
-        (fflush(u2.stream) != 0))
+        (flush and fflush(u2.stream) != 0))
     {
         /* errno is saved just to avoid other intervening calls
          * (e.g. ErrorMessage) potentially resetting it to something else. */
@@ -483,12 +564,12 @@ static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config
         {
             if (config->nostamp)
             {
-                ErrorMessage("unified2 failed to write to file (%s): %s\n",
+                Unified2Error(u2, false, "unified2 failed to write to file (%s): %s\n",
                     u2.filepath, get_error(error));
             }
             else
             {
-                ErrorMessage("unified2 failed to write to file (%s.%u): %s\n",
+                Unified2Error(u2, false, "unified2 failed to write to file (%s.%u): %s\n",
                     u2.filepath, u2.timestamp, get_error(error));
             }
 
@@ -502,7 +583,7 @@ static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config
                 {
                     /* fwrite() failed.  Redo fwrite and fflush */
                     if (((fwcount = fwrite(buf, (size_t)buf_len, 1, u2.stream)) == 1) &&
-                        fflush(u2.stream) == 0)
+                        (!flush or fflush(u2.stream) == 0))
                     {
                         error = 0;
                         break;
@@ -528,22 +609,24 @@ static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config
                 break;
 
             case EIO:
-                ErrorMessage("unified2 file is possibly corrupt. "
+                Unified2Error(u2, false, "unified2 file is possibly corrupt. "
                     "Closing this unified2 file and creating a new one.\n");
 
-                Unified2RotateFile(config);
+                if ( !Unified2RotateFile(u2, config) )
+                    return;
 
                 if (config->nostamp)
                 {
-                    ErrorMessage("unified2 rotated file: %s\n", u2.filepath);
+                    Unified2Error(u2, false, "unified2 rotated file: %s\n", u2.filepath);
                 }
                 else
                 {
-                    ErrorMessage("unified2 rotated file: %s.%u\n", u2.filepath, u2.timestamp);
+                    Unified2Error(u2, false, "unified2 rotated file: %s.%u\n",
+                        u2.filepath, u2.timestamp);
                 }
 
                 if (((fwcount = fwrite(buf, (size_t)buf_len, 1, u2.stream)) == 1) &&
-                    fflush(u2.stream) == 0)
+                    (!flush or fflush(u2.stream) == 0))
                 {
                     error = 0;
                     break;
@@ -558,12 +641,12 @@ static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config
                 /* Write out error message again, then fall through and fatal */
                 if (config->nostamp)
                 {
-                    ErrorMessage("unified2 failed to write to file (%s): %s\n",
+                    Unified2Error(u2, false, "unified2 failed to write to file (%s): %s\n",
                         u2.filepath, get_error(error));
                 }
                 else
                 {
-                    ErrorMessage("unified2 failed to write to file (%s.%u): %s\n",
+                    Unified2Error(u2, false, "unified2 failed to write to file (%s.%u): %s\n",
                         u2.filepath, u2.timestamp, get_error(error));
                 }
 
@@ -577,20 +660,53 @@ static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config
             case ENOSPC:
             case EPIPE:
             default:
-                FatalError("unified2 cannot write to device.\n");
+                Unified2Error(u2, true, "unified2 cannot write to device.\n");
+                return;
             }
         }
 
         if ((max_retries == 0) && (error != 0))
         {
-            FatalError("unified2 cannot write to device. "
+            Unified2Error(u2, true, "unified2 cannot write to device. "
                 "Maximum number of interrupts exceeded.\n");
+            return;
         }
     }
 
     u2.current += buf_len;
 }
 
+class U2Sink : public AsyncWriterSink
+{
+public:
+    U2Sink(U2& f, Unified2Config* c) : u2(f), config(c) { }
+
+    void write(uint32_t, const uint8_t* buf, uint32_t len) override
+    { Unified2WriteFile(u2, buf, len, config, false); }
+
+    void flush() override
+    {
+        if ( u2.stream and fflush(u2.stream) != 0 )
+            Unified2Error(u2, false, "unified2 failed to flush file (%s): %s\n",
+                u2.filepath, get_error(errno));
+    }
+
+private:
+    U2& u2;
+    Unified2Config* config;
+};
+
+static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config)
+{
+    if ( u2_writer )
+    {
+        Unified2CheckWriter(u2);
+        u2_writer->put(0, buf, buf_len);
+    }
+    else
+        Unified2WriteFile(u2, buf, buf_len, config, true);
+}
+
 //--------------------------------------------------------------------------
 // legacy event support
 // FIXIT-L encode pseudo packets for buffers and extra data for out of date
@@ -694,9 +810,6 @@ static void _AlertIP4_v2(Packet* p, const char*, Unified2Config* config, const E
                 app_name, strlen(app_name) + 1);
     }
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
-
     hdr.length = htonl(sizeof(alertdata));
     hdr.type = htonl(UNIFIED2_IDS_EVENT_VLAN);
 
@@ -782,9 +895,6 @@ static void _AlertIP6_v2(Packet* p, const char*, Unified2Config* config, const E
                 app_name, strlen(app_name) + 1);
     }
 
-    if ( config->limit && (u2.current + write_len) > config->limit )
-        Unified2RotateFile(config);
-
     hdr.length = htonl(sizeof(Unified2IDSEventIPv6));
     hdr.type = htonl(UNIFIED2_IDS_EVENT_IPV6_VLAN);
 
@@ -809,6 +919,9 @@ static const Parameter s_params[] =
     { "limit", Parameter::PT_INT, "0:maxSZ", "0",
       "set maximum size in MB before rollover (0 is unlimited)" },
 
+    { "async_buffer", Parameter::PT_INT, "0:maxSZ", "0",
+      "size in MB of the queue for each packet thread's writer thread (0 writes synchronously)" },
+
     { "nostamp", Parameter::PT_BOOL, nullptr, "true",
       "append file creation time to name (in Unix Epoch format)" },
 
@@ -826,11 +939,18 @@ public:
     bool set(const char*, Value&, SnortConfig*) override;
     bool begin(const char*, int, SnortConfig*) override;
 
+    const PegInfo* get_pegs() const override
+    { return async_writer_pegs; }
+
+    PegCount* get_counts() const override
+    { return (PegCount*)&u2_stats; }
+
     Usage get_usage() const override
     { return GLOBAL; }
 
 public:
     size_t limit = 0;
+    size_t async_buffer = 0;
     bool nostamp = true;
     bool legacy_events = false;
 };
@@ -840,6 +960,9 @@ bool U2Module::set(const char*, Value& v, SnortConfig*)
     if ( v.is("limit") )
         limit = v.get_size() * 1024 * 1024;
 
+    else if ( v.is("async_buffer") )
+        async_buffer = v.get_size() * 1024 * 1024;
+
     else if ( v.is("nostamp") )
         nostamp = v.get_bool();
 
@@ -852,6 +975,7 @@ bool U2Module::set(const char*, Value& v, SnortConfig*)
 bool U2Module::begin(const char*, int, SnortConfig* sc)
 {
     limit = 0;
+    async_buffer = 0;
     nostamp = sc->output_no_timestamp();
     legacy_events = false;
     return true;
@@ -883,6 +1007,7 @@ private:
 U2Logger::U2Logger(U2Module* m)
 {
     config.limit = m->limit;
+    config.async_buffer = m->async_buffer;
     config.nostamp = m->nostamp;
     config.legacy_events = m->legacy_events;
 }
@@ -905,23 +1030,47 @@ void U2Logger::open()
     u2.base_proto = htonl(SFDAQ::get_base_protocol());
 
     write_pkt_buffer = new uint8_t[u2_buf_sz];
-    io_buffer = new char[u2_buf_sz];
+    u2.io_buffer = new char[u2_buf_sz];
+
+    Unified2InitFile(u2, &config);
 
-    Unified2InitFile(&config);
+    if ( config.async_buffer )
+    {
+        // from here on the file belongs to the writer thread
+        u2.async = true;
+        u2_sink = new U2Sink(u2, &config);
+        u2_writer = new AsyncWriter(*u2_sink, config.async_buffer, u2_stats);
+    }
 
     Stream::reg_xtra_data_log(AlertExtraData, &config);
 }
 
 void U2Logger::close()
 {
+    // drains the queue so the writer thread is done with u2
+    delete u2_writer;
+    delete u2_sink;
+
+    u2_writer = nullptr;
+    u2_sink = nullptr;
+
+    // the writer thread is done so report anything it left behind
+    if ( u2.async and u2.msg_ready.load(std::memory_order_acquire) )
+        ErrorMessage("%s", u2.msg);
+
+    u2.msg_ready = false;
+    u2.failed = false;
+
     if ( u2.stream )
         fclose(u2.stream);
 
     delete[] write_pkt_buffer;
-    delete[] io_buffer;
+    delete[] u2.io_buffer;
 
+    u2.stream = nullptr;
     write_pkt_buffer = nullptr;
-    io_buffer = nullptr;
+    u2.io_buffer = nullptr;
+    u2.async = false;
 }
 
 void U2Logger::alert_legacy(Packet* p, const char* msg, const Event& event)
@@ -54,6 +54,7 @@
 #include "trace/trace_api.h"
 #include "trace/trace_config.h"
 #include "trace/trace_logger.h"
+#include "utils/stats.h"
 #include "utils/util.h"
 #include "utils/safec.h"
 
@@ -337,6 +338,15 @@ int main_dump_stats(lua_State* L)
     return 0;
 }
 
+int main_peek_stats(lua_State* L)
+{
+    ControlConn* ctrlcon = ControlConn::query_from_lua(L);
+    const char* module = L ? luaL_optstring(L, 1, nullptr) : nullptr;
+    send_response(ctrlcon, "== peeking stats\n");
+    PeekStats(ctrlcon, module);
+    return 0;
+}
+
 
 int main_dump_heap_stats(lua_State* L)
 {
@@ -66,6 +66,7 @@
 #include "target_based/host_attributes.h"
 #include "time/packet_time.h"
 #include "trace/trace_api.h"
+#include "trace/trace_points.h"
 #include "utils/stats.h"
 
 #include "analyzer_command.h"
@@ -79,6 +80,19 @@ using namespace std;
 
 static MainHook_f main_hook = snort_ignore;
 
+// using dummy values until further integration
+// FIXIT-M max_contexts must be <= DAQ msg pool to avoid permanent stall (offload only)
+// condition (polling for packets that won't come to resume ready suspends)
+#ifdef REG_TEST
+static const unsigned max_contexts = 20;
+#else
+static const unsigned max_contexts = 255;
+#endif
+
+// staging stops short of this many idle contexts so that packets decoded
+// ahead of inspection can't starve pseudo packets and offloads
+static const unsigned min_idle_contexts = max_contexts / 2;
+
 THREAD_LOCAL ProfileStats daqPerfStats;
 static THREAD_LOCAL Analyzer* local_analyzer = nullptr;
 
@@ -164,6 +178,29 @@ void Analyzer::set_main_hook(MainHook_f f)
 // message processing
 //-------------------------------------------------------------------------
 
+// Prefetch the message headers and the leading packet bytes (enough for the
+// usual ethernet / ip / transport stack) of a received batch so the cache
+// misses for the whole batch overlap instead of stalling each packet at the
+// top of decode.  Nothing is consumed here.
+static void prefetch_daq_msgs(const SFDAQInstance* daq_instance, unsigned skip)
+{
+    DAQ_Msg_h msg;
+
+    for ( unsigned i = skip; (msg = daq_instance->peek_message(i)) != nullptr; ++i )
+    {
+        if ( daq_msg_get_type(msg) != DAQ_MSG_TYPE_PACKET )
+            continue;
+
+        const uint8_t* data = daq_msg_get_data(msg);
+
+        __builtin_prefetch(daq_msg_get_pkthdr(msg));
+        __builtin_prefetch(data);
+
+        if ( daq_msg_get_data_len(msg) > 64 )
+            __builtin_prefetch(data + 64);
+    }
+}
+
 static void process_daq_sof_eof_msg(DAQ_Msg_h msg, DAQ_Verdict& verdict)
 {
     const DAQ_FlowStats_t *stats = (const DAQ_FlowStats_t*) daq_msg_get_hdr(msg);
@@ -389,15 +426,12 @@ void Analyzer::post_process_daq_pkt_msg(Packet* p)
     }
 }
 
-void Analyzer::process_daq_pkt_msg(DAQ_Msg_h msg, bool retry)
+Packet* Analyzer::decode_daq_pkt_msg(DAQ_Msg_h msg, bool retry)
 {
     const DAQ_PktHdr_t* pkthdr = daq_msg_get_pkthdr(msg);
 
     pc.analyzed_pkts++;
 
-    if (!retry)
-        packet_time_update(&pkthdr->ts);
-
     DetectionEngine::wait_for_context();
     switcher->start();
 
@@ -406,6 +440,8 @@ void Analyzer::process_daq_pkt_msg(DAQ_Msg_h msg, bool retry)
     p->context->packet_number = get_packet_number();
     select_default_policy(*pkthdr, p->context->conf);
 
+    TracePoints::add(TP_DAQ_RECV, nullptr, daq_msg_get_data_len(msg));
+
     DetectionEngine::reset();
     sfthreshold_reset();
     Active::clear_queue(p);
@@ -415,6 +451,11 @@ void Analyzer::process_daq_pkt_msg(DAQ_Msg_h msg, bool retry)
 
     PacketManager::decode(p, pkthdr, daq_msg_get_data(msg), daq_msg_get_data_len(msg), false, retry);
 
+    return p;
+}
+
+void Analyzer::inspect_daq_pkt_msg(Packet* p)
+{
     if (process_packet(p))
     {
         post_process_daq_pkt_msg(p);
@@ -428,6 +469,59 @@ void Analyzer::process_daq_pkt_msg(DAQ_Msg_h msg, bool retry)
     HighAvailabilityManager::process_receive();
 }
 
+void Analyzer::process_daq_pkt_msg(DAQ_Msg_h msg, bool retry)
+{
+    if (!retry)
+        packet_time_update(&daq_msg_get_pkthdr(msg)->ts);
+
+    Packet* p = decode_daq_pkt_msg(msg, retry);
+    inspect_daq_pkt_msg(p);
+}
+
+// Decode stage of a staged batch.  The packet's context is parked, still
+// busy, until the inspection stage gets to it.  Packet time is not advanced
+// here so that each packet is inspected with the same time it would have
+// had without staging.
+void Analyzer::stage_daq_pkt_msg(DAQ_Msg_h msg)
+{
+    oops_handler->set_current_message(msg);
+
+    Packet* p = decode_daq_pkt_msg(msg, false);
+    switcher->park();
+
+    staged.emplace_back(p);
+    daq_stats.staged_packets++;
+}
+
+// Flow lookup and inspection stages of a staged batch.  The lookups only
+// warm the flow cache; stream still finds or creates the flow for each
+// packet in receive order so flows created, blocked, or pruned by earlier
+// packets are handled exactly as without staging.  Anything per packet
+// that inspection of the earlier packets changes is set up again here.
+void Analyzer::process_staged_pkt_msgs()
+{
+    for ( Packet* p : staged )
+        Stream::prefetch_flow(p);
+
+    for ( Packet* p : staged )
+    {
+        oops_handler->set_current_message(p->daq_msg);
+        memory::MemoryCap::free_space();
+
+        packet_time_update(&p->pkth->ts);
+        switcher->unpark(p->context);
+
+        select_default_policy(*p->pkth, p->context->conf);
+        sfthreshold_reset();
+
+        inspect_daq_pkt_msg(p);
+        DetectionEngine::onload();
+        process_retry_queue();
+    }
+
+    staged.clear();
+}
+
 void Analyzer::process_daq_msg(DAQ_Msg_h msg, bool retry)
 {
     oops_handler->set_current_message(msg);
@@ -581,6 +675,8 @@ void Analyzer::idle()
 
     handle_uncompleted_commands();
 
+    ModuleManager::publish_stats();
+
     idling = false;
 }
 
@@ -590,15 +686,6 @@ void Analyzer::idle()
  */
 void Analyzer::init_unprivileged()
 {
-    // using dummy values until further integration
-    // FIXIT-M max_contexts must be <= DAQ msg pool to avoid permanent stall (offload only)
-    // condition (polling for packets that won't come to resume ready suspends)
-#ifdef REG_TEST
-    const unsigned max_contexts = 20;
-#else
-    const unsigned max_contexts = 255;
-#endif
-
     switcher = new ContextSwitcher;
 
     for ( unsigned i = 0; i < max_contexts; ++i )
@@ -863,7 +950,13 @@ DAQ_RecvStatus Analyzer::process_messages()
     // This conveniently handles servicing offloads in the no messages received case as well.
     DetectionEngine::onload();
 
+    bool staged_batches = SnortConfig::get_conf()->daq_config->get_staged_batches();
+
+    if (staged_batches)
+        prefetch_daq_msgs(daq_instance, skip_cnt < max_recv ? (unsigned)skip_cnt : max_recv);
+
     unsigned num_recv = 0;
+    bool staged_batch = false;
     DAQ_Msg_h msg;
     while ((msg = daq_instance->next_message()) != nullptr)
     {
@@ -878,6 +971,29 @@ DAQ_RecvStatus Analyzer::process_messages()
         }
         // FIXIT-M reimplement fail-open capability?
         num_recv++;
+
+        if (staged_batches and daq_msg_get_type(msg) == DAQ_MSG_TYPE_PACKET)
+        {
+            if (switcher->idle_count() <= min_idle_contexts and !staged.empty())
+            {
+                process_staged_pkt_msgs();
+                handle_uncompleted_commands();
+            }
+            // contexts held by offloads may still be out; if so don't stage
+            if (switcher->idle_count() > min_idle_contexts)
+            {
+                stage_daq_pkt_msg(msg);
+                staged_batch = true;
+                continue;
+            }
+        }
+        // everything staged so far goes first to keep the receive order
+        else if (!staged.empty())
+        {
+            process_staged_pkt_msgs();
+            handle_uncompleted_commands();
+        }
+
         // IMPORTANT: process_daq_msg() is responsible for finalizing the messages.
         process_daq_msg(msg, false);
         DetectionEngine::onload();
@@ -885,6 +1001,17 @@ DAQ_RecvStatus Analyzer::process_messages()
         handle_uncompleted_commands();
     }
 
+    if (!staged.empty())
+    {
+        process_staged_pkt_msgs();
+        handle_uncompleted_commands();
+    }
+
+    if (staged_batch)
+        daq_stats.staged_batches++;
+
+    ModuleManager::publish_stats();
+
     if (exit_after_cnt && (exit_after_cnt -= num_recv) == 0)
         stop();
     if (pause_after_cnt && (pause_after_cnt -= num_recv) == 0)
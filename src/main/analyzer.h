@@ -31,6 +31,7 @@
 #include <mutex>
 #include <queue>
 #include <string>
+#include <vector>
 
 #include "main/snort_types.h"
 #include "thread.h"
@@ -122,6 +123,10 @@ private:
     DAQ_RecvStatus process_messages();
     void process_daq_msg(DAQ_Msg_h, bool retry);
     void process_daq_pkt_msg(DAQ_Msg_h, bool retry);
+    snort::Packet* decode_daq_pkt_msg(DAQ_Msg_h, bool retry);
+    void inspect_daq_pkt_msg(snort::Packet*);
+    void stage_daq_pkt_msg(DAQ_Msg_h);
+    void process_staged_pkt_msgs();
     void post_process_daq_pkt_msg(snort::Packet*);
     void process_retry_queue();
     void set_state(State);
@@ -153,6 +158,7 @@ private:
     ContextSwitcher* switcher = nullptr;
     std::mutex pending_work_queue_mutex;
     std::list<UncompletedAnalyzerCommand*> uncompleted_work_queue;
+    std::vector<snort::Packet*> staged;
 };
 
 extern THREAD_LOCAL snort::ProfileStats daqPerfStats;
@@ -26,7 +26,10 @@
 
 #include <sys/resource.h>
 
+#include <lua.hpp>
+
 #include "codecs/codec_module.h"
+#include "control/control.h"
 #include "detection/detection_module.h"
 #include "detection/fp_config.h"
 #include "detection/rules.h"
@@ -58,6 +61,7 @@
 #include "parser/vars.h"
 #include "payload_injector/payload_injector_module.h"
 #include "profiler/profiler.h"
+#include "profiler/profiler_dump.h"
 #include "search_engines/pat_stats.h"
 #include "side_channel/side_channel_module.h"
 #include "sfip/sf_ipvar.h"
@@ -372,6 +376,9 @@ static const Parameter profiler_rule_params[] =
       "avg_match | avg_no_match",
       "total_time", "sort by given field" },
 
+    { "sample", Parameter::PT_INT, "1:65535", "1",
+      "time 1 in sample rule tree evaluations per packet thread and extrapolate" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -389,6 +396,30 @@ static const Parameter profiler_params[] =
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
+static const Parameter profiler_dump_params[] =
+{
+    { "delta", Parameter::PT_BOOL, nullptr, "false",
+      "only report what changed since the last dump" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+static int profiler_dump(lua_State* L)
+{
+    bool delta = luaL_opt(L, lua_toboolean, 1, false);
+    ControlConn* ctrlcon = ControlConn::query_from_lua(L);
+    main_broadcast_command(new ProfilerDump(ctrlcon, delta), ctrlcon);
+    return 0;
+}
+
+static const Command profiler_cmds[] =
+{
+    { "dump", profiler_dump, profiler_dump_params,
+      "show live module and rule profiles as json" },
+
+    { nullptr, nullptr, nullptr, nullptr }
+};
+
 #define profiler_help \
     "configure profiling of rules and/or modules"
 
@@ -399,6 +430,13 @@ static bool s_profiler_module_set_max_depth(T& config, Value& v)
 static bool s_profiler_module_set_max_depth(RuleProfilerConfig&, Value&)
 { return false; }
 
+template<typename T>
+static bool s_profiler_module_set_sample(T&, Value&)
+{ return false; }
+
+static bool s_profiler_module_set_sample(RuleProfilerConfig& config, Value& v)
+{ config.sample = v.get_uint16(); return true; }
+
 template<typename T>
 static bool s_profiler_module_set(T& config, Value& v)
 {
@@ -414,6 +452,9 @@ static bool s_profiler_module_set(T& config, Value& v)
     else if ( v.is("max_depth") )
         return s_profiler_module_set_max_depth(config, v);
 
+    else if ( v.is("sample") )
+        return s_profiler_module_set_sample(config, v);
+
     else
         return false;
 
@@ -430,6 +471,9 @@ public:
 
     ProfileStats* get_profile(unsigned, const char*&, const char*&) const override;
 
+    const Command* get_commands() const override
+    { return profiler_cmds; }
+
     Usage get_usage() const override
     { return GLOBAL; }
 };
@@ -456,6 +500,7 @@ bool ProfilerModule::end(const char*, int, SnortConfig* sc)
 {
     TimeProfilerStats::set_enabled(sc->profiler->time.show);
     RuleContext::set_enabled(sc->profiler->rule.show);
+    RuleContext::set_sample_rate(sc->profiler->rule.sample);
     RuleContext::set_start_time(get_time_curr());
     return true;
 }
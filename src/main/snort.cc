@@ -171,6 +171,7 @@ void Snort::init(int argc, char** argv)
     memory::MemoryCap::init(sc->thread_config->get_instance_max());
 
     ModuleManager::reset_stats(sc);
+    ModuleManager::init_snapshots(sc->thread_config->get_instance_max());
 
     if (sc->alert_before_pass())
         sc->rule_order = Actions::get_default_priorities(true);
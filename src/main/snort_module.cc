@@ -34,6 +34,7 @@
 #include "log/messages.h"
 #include "main.h"
 #include "managers/codec_manager.h"
+#include "managers/inspector_manager.h"
 #include "packet_io/sfdaq_config.h"
 #include "packet_io/trough.h"
 #include "parser/config_file.h"
@@ -69,6 +70,14 @@ static const Parameter s_reload[] =
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
+static const Parameter s_module[] =
+{
+    { "module", Parameter::PT_STRING, nullptr, nullptr,
+      "name of module to show (default is all)" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 static const Parameter s_reload_w_path[] =
 {
     { "filename", Parameter::PT_STRING, "(optional)", nullptr,
@@ -127,6 +136,8 @@ static const Command snort_cmds[] =
       "delete an inspector from the default policy" },
 
     { "dump_stats", main_dump_stats, nullptr, "show summary statistics" },
+    { "peek_stats", main_peek_stats, s_module,
+      "show current module statistics without interrupting packet threads" },
     { "dump_heap_stats", main_dump_heap_stats, nullptr, "show heap statistics" },
     { "reset_stats", main_reset_stats, nullptr, "clear summary statistics" },
     { "rotate_stats", main_rotate_stats, nullptr, "roll perfmonitor log files" },
@@ -1248,6 +1259,11 @@ ProfileStats* SnortModule::get_profile(
         name = "eventq";
         parent = nullptr;
         return &eventqPerfStats;
+
+    case 5:
+        name = "inspector_dispatch";
+        parent = nullptr;
+        return &inspectorDispatchPerfStats;
     }
     return nullptr;
 }
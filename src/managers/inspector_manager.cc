@@ -40,6 +40,7 @@
 #include "main/snort_config.h"
 #include "main/snort_module.h"
 #include "main/thread_config.h"
+#include "profiler/profiler_defs.h"
 #include "protocols/packet.h"
 #include "pub_sub/intrinsic_event_ids.h"
 #include "search_engines/search_tool.h"
@@ -47,6 +48,7 @@
 #include "time/clock_defs.h"
 #include "time/stopwatch.h"
 #include "trace/trace_api.h"
+#include "trace/trace_points.h"
 
 #include "module_manager.h"
 
@@ -209,9 +211,27 @@ struct FrameworkConfig
     PHClassList clist;  // List of inspector module classes that have been configured
 };
 
+// the execution plan for one list of inspectors: everything needed to
+// dispatch a packet is copied from the instance when the policy is
+// vectorized so the packet path walks a flat array
+struct PHStep
+{
+    PHInstance* instance;
+    Inspector* handler;
+    uint32_t proto_bits;
+    bool service;
+
+    PHStep() = default;
+
+    PHStep(PHInstance* p) :
+        instance(p), handler(p->handler), proto_bits(p->pp_class.api.proto_bits),
+        service(p->pp_class.api.type == IT_SERVICE)
+    { }
+};
+
 struct PHVector
 {
-    PHInstance** vec = nullptr;
+    PHStep* vec = nullptr;
     unsigned num = 0;
     unsigned total_num = 0;
 
@@ -221,11 +241,11 @@ struct PHVector
     { if ( vec ) delete[] vec; }
 
     void alloc(unsigned max)
-    { vec = new PHInstance*[max]; }
+    { vec = new PHStep[max]; }
 
     void add(PHInstance* p)
     {
-        vec[num++] = p;
+        vec[num++] = PHStep(p);
         total_num = num;
     }
 
@@ -244,8 +264,8 @@ void PHVector::add_control(PHInstance* p)
         add(p);
     else
     {
-        add(vec[0]);
-        vec[0] = p;
+        add(vec[0].instance);
+        vec[0] = PHStep(p);
     }
 }
 
@@ -378,11 +398,11 @@ void InspectorList::allocate_thread_storage()
         p->handler->allocate_thread_storage();
 }
 
-static PHInstance* get_instance_from_vector(const char* key, PHInstance** vec, unsigned num)
+static PHInstance* get_instance_from_vector(const char* key, const PHStep* vec, unsigned num)
 {
     for (unsigned i = 0; i < num; ++i)
     {
-        PHInstance* ph = vec[i];
+        PHInstance* ph = vec[i].instance;
         if (ph->name == key)
             return ph;
     }
@@ -1686,7 +1706,7 @@ static void instantiate_default_binder(SnortConfig* sc, FrameworkPolicy* fp)
 
     for ( unsigned i = 0; i < fp->service.num; i++ )
     {
-        const InspectApi& api = fp->service.vec[i]->pp_class.api;
+        const InspectApi& api = fp->service.vec[i].instance->pp_class.api;
 
         const char* s = api.service;
         const char* t = api.base.name;
@@ -1834,31 +1854,31 @@ void InspectorManager::prepare_controls(SnortConfig* sc)
 {
     GlobalInspectorPolicy* gp = sc->policy_map->get_global_inspector_policy();
     unsigned g_c = 0;
-    std::vector<PHInstance*> g_disabled;
+    std::vector<PHStep> g_disabled;
     for ( unsigned i = 0; i < gp->control.num; ++i )
     {
-        if ( !gp->control.vec[i]->handler->disable(sc) )
+        if ( !gp->control.vec[i].handler->disable(sc) )
             gp->control.vec[g_c++] = gp->control.vec[i];
         else
             g_disabled.emplace_back(gp->control.vec[i]);
     }
     gp->control.num = g_c;
-    for (auto* ph : g_disabled)
+    for (const auto& ph : g_disabled)
         gp->control.vec[g_c++] = ph;
     for ( unsigned idx = 0; idx < sc->policy_map->network_policy_count(); ++idx )
     {
         TrafficPolicy* tp = sc->policy_map->get_network_policy(idx)->traffic_policy;
         unsigned c = 0;
-        std::vector<PHInstance*> disabled;
+        std::vector<PHStep> disabled;
         for ( unsigned i = 0; i < tp->control.num; ++i )
         {
-            if ( !tp->control.vec[i]->handler->disable(sc) )
+            if ( !tp->control.vec[i].handler->disable(sc) )
                 tp->control.vec[c++] = tp->control.vec[i];
             else
                 disabled.emplace_back(tp->control.vec[i]);
         }
         tp->control.num = c;
-        for (auto* ph : disabled)
+        for (const auto& ph : disabled)
             tp->control.vec[c++] = ph;
     }
 }
@@ -1949,42 +1969,59 @@ void InspectorManager::print_config(SnortConfig* sc)
 // packet handling
 //-------------------------------------------------------------------------
 
+// time spent walking the inspector lists, excluding the inspectors themselves
+THREAD_LOCAL ProfileStats inspectorDispatchPerfStats;
+
 template<bool T>
 static inline void execute(
-    Packet* p, PHInstance* const * prep, unsigned num, bool probe = false)
-{
+    Packet* p, const PHStep* step, unsigned num, bool probe = false)
+{
+    // not a Profile so nested inspector profiles don't pause it; it is
+    // paused around each eval instead.  eval can reenter dispatch (rebuilt
+    // PDUs) but only the outermost context is timed so the nested walk is
+    // not counted rather than subtracted twice.
+    TimeContext dispatch(inspectorDispatchPerfStats.time);
+    const bool timed = TimeProfilerStats::is_enabled();
     Stopwatch<SnortClock> timer;
-    for ( unsigned i = 0; i < num; ++i, ++prep )
+
+    for ( const PHStep* end = step + num; step < end; ++step )
     {
         if ( p->packet_flags & PKT_PASS_RULE )
             break;
 
-        const PHClass& ppc = (*prep)->pp_class;
-
         // FIXIT-P these checks can eventually be optimized
         // but they are required to ensure that session and app
         // handlers aren't called w/o a session pointer
-        if ( !p->flow && (ppc.api.type == IT_SERVICE) )
+        if ( !p->flow && step->service )
             break;
 
         const char* inspector_name = nullptr;
         if ( T )
         {
             timer.reset();
-            inspector_name = (*prep)->name.c_str();
+            inspector_name = step->instance->name.c_str();
             trace_ulogf(snort_trace, TRACE_INSPECTOR_MANAGER, p, "enter %s\n", inspector_name);
             timer.start();
         }
 
         // FIXIT-L ideally we could eliminate PktType and just use
         // proto_bits but things like teredo need to be fixed up.
-        if ( p->type() == PktType::NONE )
+        bool wanted = ( p->type() == PktType::NONE ) ?
+            (p->proto_bits & step->proto_bits) :
+            (BIT((unsigned)p->type()) & step->proto_bits);
+
+        if ( wanted )
         {
-            if ( p->proto_bits & ppc.api.proto_bits )
-                (*prep)->handler->eval(p);
+            if ( timed )
+                dispatch.pause();
+
+            uint64_t trace_start = TracePoints::start();
+            step->handler->eval(p);
+            TracePoints::add(TP_INSPECTOR_EVAL, p, 0, trace_start, step->instance->name.c_str());
+
+            if ( timed )
+                dispatch.resume();
         }
-        else if ( BIT((unsigned)p->type()) & ppc.api.proto_bits )
-            (*prep)->handler->eval(p);
 
         if ( T )
             trace_ulogf(snort_trace, TRACE_INSPECTOR_MANAGER, p,
@@ -2038,6 +2075,8 @@ void inline InspectorManager::full_inspection(Packet* p)
 
     else if ( flow->gadget && flow->gadget->likes(p) )
     {
+        uint64_t trace_start = TracePoints::start();
+
         if ( !T )
             flow->gadget->eval(p);
         else
@@ -2053,6 +2092,7 @@ void inline InspectorManager::full_inspection(Packet* p)
                 "exit %s, elapsed time: %" PRId64 "\n", inspector_name, TO_USECS(timer.get()));
         }
 
+        TracePoints::add(TP_INSPECTOR_EVAL, p, 0, trace_start, flow->gadget->get_alias_name());
         p->context->clear_inspectors = true;
     }
 }
@@ -2078,7 +2118,10 @@ inline void InspectorManager::internal_execute(Packet* p)
     {
         SingleInstanceInspectorPolicy* ft = sc->policy_map->get_flow_tracking();
         if (ft->instance )
-            ::execute<T>(p, &ft->instance, 1);
+        {
+            PHStep step(ft->instance);
+            ::execute<T>(p, &step, 1);
+        }
     }
 
     // must check between each ::execute()
@@ -39,6 +39,7 @@ struct GlobalInspectorPolicy;
 namespace snort
 {
 struct Packet;
+struct ProfileStats;
 struct SnortConfig;
 
 //-------------------------------------------------------------------------
@@ -121,5 +122,8 @@ private:
         std::map<const std::string, const PHInstance*>& sorted_ilist);
 };
 }
+
+extern THREAD_LOCAL snort::ProfileStats inspectorDispatchPerfStats;
+
 #endif
 
@@ -28,6 +28,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -43,11 +44,13 @@
 #include "main/shell.h"
 #include "main/snort.h"
 #include "main/snort_config.h"
+#include "main/thread.h"
 #include "managers/inspector_manager.h"
 #include "parser/parse_conf.h"
 #include "parser/parser.h"
 #include "profiler/profiler.h"
 #include "protocols/packet_manager.h"
+#include "utils/stats.h"
 #include "utils/util.h"
 
 #include "plugin_manager.h"
@@ -64,6 +67,9 @@ struct ModHook
     const BaseApi* api;
     luaL_Reg* reg;
 
+    PegSnapshot* snapshots = nullptr;  // one per packet thread
+    PegCount* folded = nullptr;        // per thread sums moved to globals
+
     ModHook(Module*, const BaseApi*);
     ~ModHook();
 
@@ -134,6 +140,9 @@ ModHook::~ModHook()
     if ( reg )
         delete[] reg;
 
+    delete[] snapshots;
+    delete[] folded;
+
     if ( api && api->mod_dtor )
         api->mod_dtor(mod);
     else
@@ -166,6 +175,74 @@ void ModHook::init()
     }
 }
 
+//-------------------------------------------------------------------------
+// stats snapshots
+//-------------------------------------------------------------------------
+
+// packet threads publish at most this often outside of accumulate / reset
+static const uint64_t s_publish_ms = 100;
+
+static unsigned s_snapshot_threads = 0;
+static vector<ModHook*> s_snapshot_hooks;
+static THREAD_LOCAL uint64_t s_next_publish = 0;
+
+static bool snapshot_thread()
+{ return is_packet_thread() and get_instance_id() < s_snapshot_threads; }
+
+// the published totals include whatever this thread already moved to the
+// globals so readers need not know how each module keeps its globals
+static void publish_counts(ModHook* mh)
+{
+    unsigned id = get_instance_id();
+    unsigned n = mh->snapshots[id].size();
+    mh->snapshots[id].publish(mh->mod->get_counts(), mh->folded + id * n);
+}
+
+static void sum_module(Module* mod, ModHook* mh, bool accumulate_now_stats)
+{
+    if ( !mh or !mh->snapshots or !snapshot_thread() )
+    {
+        mod->sum_stats(accumulate_now_stats);
+        return;
+    }
+
+    PegCount* p = mod->get_counts();
+    const PegInfo* pegs = mod->get_pegs();
+    unsigned id = get_instance_id();
+    unsigned n = mh->snapshots[id].size();
+    PegCount* folded = mh->folded + id * n;
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        if ( pegs[i].type == CountType::SUM )
+            folded[i] += p[i];
+    }
+
+    mod->sum_stats(accumulate_now_stats);
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        if ( pegs[i].type == CountType::SUM )
+            folded[i] -= p[i];
+    }
+
+    publish_counts(mh);
+}
+
+static void reset_module(ModHook* mh)
+{
+    mh->mod->reset_stats();
+
+    if ( !mh->snapshots or !snapshot_thread() )
+        return;
+
+    unsigned id = get_instance_id();
+    unsigned n = mh->snapshots[id].size();
+    std::fill(mh->folded + id * n, mh->folded + (id + 1) * n, 0);
+
+    publish_counts(mh);
+}
+
 //-------------------------------------------------------------------------
 // helper functions
 //-------------------------------------------------------------------------
@@ -933,6 +1010,9 @@ void ModuleManager::init()
 
 void ModuleManager::term()
 {
+    s_snapshot_hooks.clear();
+    s_snapshot_threads = 0;
+
     for ( auto& mh : s_modules )
         delete mh.second;
 
@@ -1465,7 +1545,7 @@ void ModuleManager::accumulate(const char* except)
 
         lock_guard<mutex> lock(stats_mutex);
         mh->mod->prep_counts();
-        mh->mod->sum_stats(true);
+        sum_module(mh->mod, mh, true);
     }
 }
 
@@ -1476,10 +1556,16 @@ void ModuleManager::accumulate_module(const char* name)
     {
         lock_guard<mutex> lock(stats_mutex);
         mh->mod->prep_counts();
-        mh->mod->sum_stats(true);
+        sum_module(mh->mod, mh, true);
     }
 }
 
+void ModuleManager::accumulate_module(Module* mod, bool accumulate_now_stats)
+{
+    lock_guard<mutex> lock(stats_mutex);
+    sum_module(mod, get_hook(mod->get_name()), accumulate_now_stats);
+}
+
 void ModuleManager::reset_stats(SnortConfig*)
 {
     auto mod_hooks = get_all_modhooks();
@@ -1510,7 +1596,7 @@ void ModuleManager::reset_stats(clear_counter_type_t type)
         if ( mh and mh->mod )
         {
             lock_guard<mutex> lock(stats_mutex);
-            mh->mod->reset_stats();
+            reset_module(mh);
         }
     }
     else
@@ -1534,7 +1620,7 @@ void ModuleManager::reset_stats(clear_counter_type_t type)
             if ( type == TYPE_UNKNOWN or !ignore )
             {
                 lock_guard<mutex> lock(stats_mutex);
-                mh->mod->reset_stats();
+                reset_module(mh);
             }
         }
     }
@@ -1545,6 +1631,92 @@ void ModuleManager::reset_stats(clear_counter_type_t type)
     }
 }
 
+void ModuleManager::init_snapshots(unsigned max_threads)
+{
+    auto mod_hooks = get_all_modhooks();
+    mod_hooks.sort(comp_mods);
+
+    for ( auto* mh : mod_hooks )
+    {
+        Module* m = mh->mod;
+
+        // global stats are already shared by all threads
+        if ( m->num_counts <= 0 or m->global_stats() )
+            continue;
+
+        unsigned n = m->num_counts;
+        mh->snapshots = new PegSnapshot[max_threads];
+        mh->folded = new PegCount[max_threads * n]();
+
+        for ( unsigned i = 0; i < max_threads; ++i )
+            mh->snapshots[i].init(n);
+
+        s_snapshot_hooks.emplace_back(mh);
+    }
+    s_snapshot_threads = max_threads;
+}
+
+void ModuleManager::publish_stats()
+{
+    if ( s_snapshot_hooks.empty() or !snapshot_thread() )
+        return;
+
+    uint64_t now = chrono::duration_cast<chrono::milliseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+
+    if ( now < s_next_publish )
+        return;
+
+    s_next_publish = now + s_publish_ms;
+
+    for ( auto* mh : s_snapshot_hooks )
+        publish_counts(mh);
+}
+
+bool ModuleManager::get_snapshot(const char* name, vector<PegCount>& counts)
+{
+    ModHook* mh = get_hook(name);
+
+    if ( !mh or !mh->snapshots )
+        return false;
+
+    const PegInfo* pegs = mh->mod->get_pegs();
+    unsigned n = mh->snapshots[0].size();
+    vector<PegCount> tmp(n);
+
+    counts.assign(n, 0);
+
+    for ( unsigned t = 0; t < s_snapshot_threads; ++t )
+    {
+        mh->snapshots[t].read(tmp.data());
+
+        for ( unsigned i = 0; i < n; ++i )
+        {
+            if ( pegs[i].type == CountType::MAX )
+                counts[i] = std::max(counts[i], tmp[i]);
+            else
+                counts[i] += tmp[i];
+        }
+    }
+    return true;
+}
+
+void ModuleManager::dump_snapshots(const char* name)
+{
+    vector<PegCount> counts;
+
+    for ( auto* mh : s_snapshot_hooks )
+    {
+        const char* mod_name = mh->mod->get_name();
+
+        if ( name and strcmp(name, mod_name) )
+            continue;
+
+        if ( get_snapshot(mod_name, counts) )
+            ::show_stats(counts.data(), mh->mod->get_pegs(), counts.size(), mod_name);
+    }
+}
+
 
 
 //-------------------------------------------------------------------------
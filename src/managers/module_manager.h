@@ -27,6 +27,7 @@
 #include <list>
 #include <mutex>
 #include <set>
+#include <vector>
 
 #include "framework/counts.h"
 #include "main/analyzer_command.h"
@@ -89,12 +90,19 @@ public:
 
     static void accumulate(const char* except = nullptr);
     static void accumulate_module(const char* name);
+    SO_PUBLIC static void accumulate_module(Module*, bool accumulate_now_stats);
 
     static void reset_stats(SnortConfig*);
     static void reset_stats(clear_counter_type_t);
 
     static void clear_global_active_counters();
 
+    // lock free snapshots of packet thread counts; packet threads publish
+    // between packets and any thread can get the current totals
+    static void init_snapshots(unsigned max_threads);
+    static void publish_stats();
+    SO_PUBLIC static bool get_snapshot(const char* name, std::vector<PegCount>&);
+    static void dump_snapshots(const char* name = nullptr);
 
     static std::set<uint32_t> gids;
     SO_PUBLIC static std::mutex stats_mutex;
@@ -26,6 +26,7 @@
 #include "managers/inspector_manager.h"
 #include "managers/module_manager.h"
 #include "network_inspectors/binder/bind_module.h"
+#include "profiler/profiler_defs.h"
 #include "search_engines/search_tool.h"
 #include "trace/trace.h"
 #include "trace/trace_api.h"
@@ -44,6 +45,11 @@ void update_buffer_map(const char**, const char*) { }
 namespace snort
 {
 unsigned THREAD_LOCAL Inspector::slot = 0;
+THREAD_LOCAL TimeContext* ProfileContext::curr_time = nullptr;
+bool TimeProfilerStats::enabled = false;
+bool TimeProfilerStats::exclusive = false;
+MemoryContext::MemoryContext(MemoryTracker&) : saved(nullptr) { }
+MemoryContext::~MemoryContext() = default;
 [[noreturn]] void FatalError(const char*,...) { exit(-1); }
 void LogMessage(const char*, ...) { }
 void LogLabel(const char*, FILE*) { }
@@ -435,6 +435,9 @@ static const PegInfo appid_pegs[] =
     { CountType::SUM, "service_cache_removes", "number of times an item was removed from the service cache" },
     { CountType::SUM, "odp_reload_ignored_pkts", "count of packets ignored after open detector package is reloaded" },
     { CountType::SUM, "tp_reload_ignored_pkts", "count of packets ignored after third-party module is reloaded" },
+    { CountType::SUM, "service_detectors_tried", "count of service detector validations attempted" },
+    { CountType::SUM, "service_brute_force_tried", "count of service detectors selected by brute force" },
+    { CountType::SUM, "service_signature_hits", "count of brute force selections ranked by the service signature index" },
     { CountType::NOW, "bytes_in_use", "number of bytes in use in the cache" },
     { CountType::NOW, "items_in_use", "items in use in the cache" },
     { CountType::END, nullptr, nullptr },
@@ -53,6 +53,9 @@ struct AppIdStats
     PegCount service_cache_removes;
     PegCount odp_reload_ignored_pkts;
     PegCount tp_reload_ignored_pkts;
+    PegCount service_detectors_tried;
+    PegCount service_brute_force_tried;
+    PegCount service_signature_hits;
     PegCount bytes_in_use;
     PegCount items_in_use;
 };
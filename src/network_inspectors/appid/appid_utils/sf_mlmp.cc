@@ -25,6 +25,8 @@
 
 #include "sf_mlmp.h"
 
+#include <cstring>
+
 #include "search_engines/search_tool.h"
 #include "utils/util.h"
 
@@ -56,6 +58,10 @@ struct tPatternPrimaryNode
 
     /*Tree node for next level. Present only in primary pattern node i.e.  */
     tMlmpTree* nextLevelMatcher;
+
+    /*Sum of the sizes of all parts. This is the precedence of the pattern when
+     * selecting among complete matches and is computed once when the pattern is added. */
+    uint32_t patternSizeTotal;
 };
 
 /*Node for mlmp tree */
@@ -67,12 +73,82 @@ struct tMlmpTree
 };
 
 /*Used to track matched patterns. */
-struct tMatchedPatternList
+struct tMatchedPattern
 {
     tPatternNode* patternNode;
     size_t match_start_pos;
-    /*uint32_t level; */
-    tMatchedPatternList* next;
+};
+
+/*Matches for one level are kept in a flat buffer ordered by <patternId, partNum>
+ * and resolved in a single pass once the search of that level is done. The buffer
+ * lives on the stack and only spills to the heap for unusually many matches. */
+class tMatchedPatternList
+{
+public:
+    tMatchedPatternList() = default;
+    ~tMatchedPatternList()
+    {
+        if (matches != local)
+            snort_free(matches);
+    }
+
+    void clear()
+    { count = 0; }
+
+    /*first occurrence of a part wins */
+    void add(tPatternNode* node, size_t start_pos)
+    {
+        unsigned i = count;
+
+        while (i and precedes(node, matches[i-1].patternNode))
+            --i;
+
+        if (i and matches[i-1].patternNode == node)
+            return;
+
+        if (count == capacity)
+            grow();
+
+        memmove(matches + i + 1, matches + i, (count - i) * sizeof(*matches));
+        matches[i].patternNode = node;
+        matches[i].match_start_pos = start_pos;
+        ++count;
+    }
+
+    const tMatchedPattern* begin() const
+    { return matches; }
+
+    const tMatchedPattern* end() const
+    { return matches + count; }
+
+private:
+    /*multipart patterns are ordered according to <patternId, partNum>.
+      Comparing multi-parts alphanumerically does not make sense. */
+    static bool precedes(const tPatternNode* p1, const tPatternNode* p2)
+    {
+        if (p1->patternId != p2->patternId)
+            return p1->patternId < p2->patternId;
+
+        return p1->partNum < p2->partNum;
+    }
+
+    void grow()
+    {
+        tMatchedPattern* tmp = (tMatchedPattern*)snort_alloc(2 * capacity * sizeof(*matches));
+        memcpy(tmp, matches, count * sizeof(*matches));
+
+        if (matches != local)
+            snort_free(matches);
+
+        matches = tmp;
+        capacity *= 2;
+    }
+
+    static constexpr unsigned local_max = 32;
+    tMatchedPattern local[local_max];
+    tMatchedPattern* matches = local;
+    unsigned capacity = local_max;
+    unsigned count = 0;
 };
 
 static int compareMlmpPatterns(const void* p1, const void* p2);
@@ -80,12 +156,10 @@ static int createTreesRecusively(tMlmpTree* root);
 static void destroyTreesRecursively(tMlmpTree* root);
 static int addPatternRecursively(tMlmpTree* root, const tMlmpPattern* inputPatternList,
     void* metaData, uint32_t level);
-static tPatternNode* urlPatternSelector(const tMatchedPatternList* matchList, const
-    uint8_t* payload);
-static tPatternNode* genericPatternSelector(const tMatchedPatternList* matchList, const
-    uint8_t* payload);
+static tPatternPrimaryNode* patternSelector(const tMatchedPatternList& matchList, const
+    uint8_t* payload, bool domain);
 static void* mlmpMatchPatternCustom(tMlmpTree* root, tMlmpPattern* inputPatternList,
-    tPatternNode* (*callback)(const tMatchedPatternList*, const uint8_t*));
+    bool domain);
 static int patternMatcherCallback(void* id, void* unused_tree, int match_end_pos, void* data,
     void* unused_neg);
 
@@ -122,55 +196,49 @@ void mlmp_reload_patterns(tMlmpTree& root)
 
 void* mlmpMatchPatternUrl(tMlmpTree* root, tMlmpPattern* inputPatternList)
 {
-    return mlmpMatchPatternCustom(root, inputPatternList, urlPatternSelector);
+    return mlmpMatchPatternCustom(root, inputPatternList, true);
 }
 
 void* mlmpMatchPatternGeneric(tMlmpTree* root, tMlmpPattern* inputPatternList)
 {
-    return mlmpMatchPatternCustom(root, inputPatternList, genericPatternSelector);
+    return mlmpMatchPatternCustom(root, inputPatternList, false);
 }
 
-static inline bool match_is_domain_pattern(const tMatchedPatternList* mp, const uint8_t* payload)
+static inline bool match_is_domain_pattern(const tMatchedPattern& mp, const uint8_t* payload)
 {
     if (!payload)
         return false;
 
-    return mp->patternNode->pattern.level != 0 or
-           mp->match_start_pos == 0 or
-           payload[mp->match_start_pos-1] == '.';
+    return mp.patternNode->pattern.level != 0 or
+           mp.match_start_pos == 0 or
+           payload[mp.match_start_pos-1] == '.';
 }
 
+/*Descend the levels iteratively. Each level is searched once and the best complete
+ * match selects the matcher for the next level; the deepest match with user data wins. */
 static void* mlmpMatchPatternCustom(tMlmpTree* rootNode, tMlmpPattern* inputPatternList,
-    tPatternNode* (*callback)(const tMatchedPatternList*, const uint8_t*))
+    bool domain)
 {
-    tMatchedPatternList* mp = nullptr;
     void* data = nullptr;
-    void* tmpData = nullptr;
-    tPatternPrimaryNode* primaryNode;
     tMlmpPattern* pattern = inputPatternList;
+    tMatchedPatternList mp;
 
-    if (!rootNode || !pattern || !pattern->pattern)
-        return nullptr;
+    while (rootNode && pattern && pattern->pattern)
+    {
+        mp.clear();
+        rootNode->patternTree->find_all((const char*)pattern->pattern, pattern->patternSize,
+            patternMatcherCallback, false, (void*)&mp);
 
-    rootNode->patternTree->find_all((const char*)pattern->pattern, pattern->patternSize,
-        patternMatcherCallback, false, (void*)&mp);
+        tPatternPrimaryNode* primaryNode = patternSelector(mp, pattern->pattern, domain);
 
-    primaryNode = (tPatternPrimaryNode*)callback(mp, pattern->pattern);
+        if (!primaryNode)
+            break;
 
-    while (mp)
-    {
-        tMatchedPatternList* tmpMp = mp;
-        mp = mp->next;
-        snort_free(tmpMp);
-    }
+        if (primaryNode->patternNode.userData)
+            data = primaryNode->patternNode.userData;
 
-    if (primaryNode)
-    {
-        data = primaryNode->patternNode.userData;
-        tmpData = mlmpMatchPatternCustom(primaryNode->nextLevelMatcher, ++inputPatternList,
-            callback);
-        if (tmpData)
-            data = tmpData;
+        rootNode = primaryNode->nextLevelMatcher;
+        ++pattern;
     }
 
     return data;
@@ -268,123 +336,51 @@ static void destroyTreesRecursively(tMlmpTree* rootNode)
     snort_free(rootNode);
 }
 
-/*compares multipart patterns, and orders then according to <patternId, partNum>.
-  Comparing multi-parts alphanumerically does not make sense. */
-static int compareMlmpPatternList(const tPatternNode* p1, const tPatternNode* p2)
-{
-    if (p1->patternId != p2->patternId)
-        return (p1->patternId - p2->patternId);
-
-    return (p1->partNum - p2->partNum);
-}
-
-static tPatternNode* patternSelector(const tMatchedPatternList* patternMatchList, const
+/*A pattern is complete when all of its parts are present. The largest complete
+  pattern is selected, the last one in patternId order on a tie. */
+static tPatternPrimaryNode* patternSelector(const tMatchedPatternList& matchList, const
     uint8_t* payload, bool domain)
 {
-    tPatternNode* bestNode = nullptr;
-    tPatternNode* currentPrimaryNode = nullptr;
-    const tMatchedPatternList* tmpList;
-    uint32_t partNum, patternId, patternSize, maxPatternSize;
-
-    /*partTotal = 0; */
-    partNum = 0;
-    patternId = 0;
-    patternSize = maxPatternSize = 0;
-
-    for (tmpList = patternMatchList;
-        tmpList;
-        tmpList = tmpList->next)
-    {
-        if (tmpList->patternNode->patternId != patternId)
-        {
-            /*first pattern */
-
-            /*skip incomplete pattern */
-            if (tmpList->patternNode->partNum != 1)
-                continue;
+    tPatternPrimaryNode* bestNode = nullptr;
+    uint32_t maxPatternSize = 0;
+    const tMatchedPattern* end = matchList.end();
 
-            /*new pattern started */
-            patternId = tmpList->patternNode->patternId;
-            currentPrimaryNode = tmpList->patternNode;
-            partNum = 0;
-            patternSize = 0;
-        }
+    for (const tMatchedPattern* mp = matchList.begin(); mp != end; )
+    {
+        const tMatchedPattern* first = mp;
+        uint32_t patternId = first->patternNode->patternId;
+        uint32_t partCount = 0;
 
-        if (tmpList->patternNode->partNum == (partNum+1))
-        {
-            partNum++;
-            patternSize += tmpList->patternNode->pattern.patternSize;
-        }
+        for ( ; mp != end and mp->patternNode->patternId == patternId; ++mp)
+            partCount++;
 
-        if (tmpList->patternNode->partTotal != partNum)
+        /*skip incomplete pattern */
+        if (first->patternNode->partNum != 1 or first->patternNode->partTotal != partCount)
             continue;
 
         /*backward compatibility */
-        if ((tmpList->patternNode->partTotal == 1)
-            && domain && !match_is_domain_pattern(tmpList, payload))
+        if ((partCount == 1) && domain && !match_is_domain_pattern(*first, payload))
             continue;
 
-        /*last pattern part is seen in sequence */
-        if (patternSize >= maxPatternSize)
+        /*the primary node always carries part 1 */
+        tPatternPrimaryNode* primaryNode = (tPatternPrimaryNode*)first->patternNode;
+
+        if (primaryNode->patternSizeTotal >= maxPatternSize)
         {
-            maxPatternSize = patternSize;
-            bestNode = currentPrimaryNode;
+            maxPatternSize = primaryNode->patternSizeTotal;
+            bestNode = primaryNode;
         }
     }
 
     return bestNode;
 }
 
-static tPatternNode* urlPatternSelector(const tMatchedPatternList* patternMatchList, const
-    uint8_t* payload)
-{
-    return patternSelector (patternMatchList, payload, true);
-}
-
-static tPatternNode* genericPatternSelector(const tMatchedPatternList* patternMatchList, const
-    uint8_t* payload)
-{
-    return patternSelector (patternMatchList, payload, false);
-}
-
 static int patternMatcherCallback(void* id, void*, int match_end_pos, void* data, void*)
 {
     tPatternNode* target = (tPatternNode*)id;
-    tMatchedPatternList** matchList = (tMatchedPatternList**)data;
-    tMatchedPatternList* prevNode;
-    tMatchedPatternList* tmpList;
-    tMatchedPatternList* newNode;
-
-    /*sort matches by patternId, and then by partId or pattern// */
-
-    for (prevNode = nullptr, tmpList = *matchList;
-        tmpList;
-        prevNode = tmpList, tmpList = tmpList->next)
-    {
-        int cmp = compareMlmpPatternList (target, tmpList->patternNode);
-        if (cmp > 0 )
-            continue;
-        if (cmp == 0)
-            return 0;
-        break;
-    }
-
-    newNode = (tMatchedPatternList*)snort_calloc(sizeof(tMatchedPatternList));
-    newNode->match_start_pos = match_end_pos - target->pattern.patternSize;
-    newNode->patternNode = target;
-
-    if (prevNode == nullptr)
-    {
-        /*first node */
-        newNode->next = *matchList;
-        *matchList = newNode;
-    }
-    else
-    {
-        newNode->next = prevNode->next;
-        prevNode->next = newNode;
-    }
+    tMatchedPatternList* matchList = (tMatchedPatternList*)data;
 
+    matchList->add(target, match_end_pos - target->pattern.patternSize);
     return 0;
 }
 
@@ -488,6 +484,7 @@ static int addPatternRecursively(tMlmpTree* rootNode, const tMlmpPattern* inputP
         tmpPrimaryNode->patternNode.partNum = 1;
         tmpPrimaryNode->patternNode.partTotal = partTotal;
         tmpPrimaryNode->patternNode.patternId = patternId;
+        tmpPrimaryNode->patternSizeTotal = patterns->patternSize;
 
         if (prevPrimaryPatternNode)
         {
@@ -515,6 +512,7 @@ static int addPatternRecursively(tMlmpTree* rootNode, const tMlmpPattern* inputP
             newNode->partNum = partNum;
             newNode->partTotal = partTotal;
             newNode->patternId = patternId;
+            tmpPrimaryNode->patternSizeTotal += patterns->patternSize;
             if (partNum < partTotal)
                 newNode->nextPattern = newNode+1;
             else
@@ -0,0 +1,124 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sf_mlmp_benchmark.cc
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "network_inspectors/appid/appid_utils/sf_mlmp.h"
+#include "search_engines/test/mpse_test_stubs.h"
+#include "utils/util.h"
+
+using namespace snort;
+
+const MpseApi* get_test_api()
+{ return (const MpseApi*) se_ac_full; }
+
+// sized like a full open detector package host/url pattern set
+static constexpr unsigned num_hosts = 20000;
+static constexpr unsigned paths_per_host = 2;
+
+static tMlmpPattern make_part(const std::string& s, uint32_t level)
+{
+    uint8_t* buf = (uint8_t*)snort_alloc(s.size());
+    memcpy(buf, s.c_str(), s.size());
+    return { buf, s.size(), level };
+}
+
+static std::string host_name(unsigned i)
+{ return "svc" + std::to_string(i) + ".cdn" + std::to_string(i % 97) + ".example.com"; }
+
+static tMlmpTree* build_tree(std::vector<unsigned>& ids)
+{
+    tMlmpTree* tree = mlmpCreate();
+    ids.resize(num_hosts * (paths_per_host + 1));
+    unsigned n = 0;
+
+    for ( unsigned i = 0; i < num_hosts; ++i )
+    {
+        tMlmpPattern patterns[3];
+        std::string host = host_name(i);
+
+        patterns[0] = make_part(host, 0);
+        patterns[1].pattern = nullptr;
+        mlmpAddPattern(tree, patterns, &ids[n++]);
+
+        for ( unsigned j = 0; j < paths_per_host; ++j )
+        {
+            patterns[0] = make_part(host, 0);
+            patterns[1] = make_part("/api" + std::to_string(j), 1);
+            patterns[2].pattern = nullptr;
+            mlmpAddPattern(tree, patterns, &ids[n++]);
+        }
+    }
+    mlmpProcessPatterns(tree);
+    return tree;
+}
+
+static void* match_url(tMlmpTree* tree, const std::string& host, const std::string& path)
+{
+    tMlmpPattern patterns[3];
+    patterns[0] = { (const uint8_t*)host.c_str(), host.size(), 0 };
+    patterns[1] = { (const uint8_t*)path.c_str(), path.size(), 1 };
+    patterns[2].pattern = nullptr;
+    return mlmpMatchPatternUrl(tree, patterns);
+}
+
+TEST_CASE("mlmp url patterns", "[sf_mlmp]")
+{
+    ((MpseApi*)se_ac_full)->init();
+
+    std::vector<unsigned> ids;
+    tMlmpTree* tree = build_tree(ids);
+
+    const std::string host_hit = "www." + host_name(num_hosts / 2);
+    const std::string host_miss = "www.svc.cdn.example.net";
+    const std::string path_hit = "/api1/v2/items?id=42";
+    const std::string path_miss = "/static/app.js";
+
+    REQUIRE(match_url(tree, host_hit, path_hit) != nullptr);
+    REQUIRE(match_url(tree, host_miss, path_miss) == nullptr);
+
+    BENCHMARK("host and path match")
+    {
+        return match_url(tree, host_hit, path_hit);
+    };
+
+    BENCHMARK("host match, path miss")
+    {
+        return match_url(tree, host_hit, path_miss);
+    };
+
+    BENCHMARK("host miss")
+    {
+        return match_url(tree, host_miss, path_miss);
+    };
+
+    mlmpDestroy(tree);
+}
+
+#endif
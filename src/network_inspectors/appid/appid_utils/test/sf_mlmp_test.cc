@@ -0,0 +1,168 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sf_mlmp_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/appid/appid_utils/sf_mlmp.h"
+
+#include <cstring>
+
+#include "search_engines/test/mpse_test_stubs.h"
+#include "utils/util.h"
+
+// must appear after snort_config.h to avoid broken c++ map include
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+const MpseApi* get_test_api()
+{ return (const MpseApi*) se_ac_full; }
+
+// the tree takes ownership of the pattern buffers
+static tMlmpPattern make_part(const char* s, uint32_t level)
+{
+    size_t len = strlen(s);
+    uint8_t* buf = (uint8_t*)snort_alloc(len);
+    memcpy(buf, s, len);
+    return { buf, len, level };
+}
+
+static void add_url(tMlmpTree* tree, const char* host, const char* path, void* data)
+{
+    tMlmpPattern patterns[3];
+    patterns[0] = make_part(host, 0);
+
+    if ( path )
+    {
+        patterns[1] = make_part(path, 1);
+        patterns[2].pattern = nullptr;
+    }
+    else
+        patterns[1].pattern = nullptr;
+
+    CHECK(mlmpAddPattern(tree, patterns, data) == 0);
+}
+
+static void* match_url(tMlmpTree* tree, const char* host, const char* path)
+{
+    tMlmpPattern patterns[3];
+    patterns[0] = { (const uint8_t*)host, strlen(host), 0 };
+    patterns[1] = { (const uint8_t*)path, strlen(path), 1 };
+    patterns[2].pattern = nullptr;
+    return mlmpMatchPatternUrl(tree, patterns);
+}
+
+static int app_host = 1;
+static int app_mail = 2;
+static int app_video = 3;
+static int app_multi = 4;
+
+TEST_GROUP(sf_mlmp_url)
+{
+    tMlmpTree* tree = nullptr;
+
+    void setup() override
+    {
+        tree = mlmpCreate();
+        add_url(tree, "example.com", nullptr, &app_host);
+        add_url(tree, "mail.example.com", nullptr, &app_mail);
+        add_url(tree, "example.com", "/video", &app_video);
+        CHECK(mlmpProcessPatterns(tree) == 0);
+    }
+
+    void teardown() override
+    {
+        mlmpDestroy(tree);
+    }
+};
+
+TEST(sf_mlmp_url, host_domain_boundary)
+{
+    POINTERS_EQUAL(&app_host, match_url(tree, "example.com", "/"));
+    POINTERS_EQUAL(&app_host, match_url(tree, "www.example.com", "/"));
+    POINTERS_EQUAL(nullptr, match_url(tree, "wwwexample.com", "/"));
+    POINTERS_EQUAL(nullptr, match_url(tree, "example.org", "/"));
+}
+
+TEST(sf_mlmp_url, longest_host_wins)
+{
+    POINTERS_EQUAL(&app_mail, match_url(tree, "mail.example.com", "/"));
+    POINTERS_EQUAL(&app_host, match_url(tree, "gmail.example.com", "/"));
+}
+
+TEST(sf_mlmp_url, path_level)
+{
+    POINTERS_EQUAL(&app_video, match_url(tree, "www.example.com", "/video/1"));
+    POINTERS_EQUAL(&app_host, match_url(tree, "www.example.com", "/audio/1"));
+    POINTERS_EQUAL(&app_mail, match_url(tree, "mail.example.com", "/video/1"));
+}
+
+TEST_GROUP(sf_mlmp_generic)
+{
+    tMlmpTree* tree = nullptr;
+
+    void setup() override
+    {
+        tree = mlmpCreate();
+
+        tMlmpPattern patterns[3];
+        patterns[0] = make_part("foo", 0);
+        patterns[1] = make_part("bar", 0);
+        patterns[2].pattern = nullptr;
+        CHECK(mlmpAddPattern(tree, patterns, &app_multi) == 0);
+
+        patterns[0] = make_part("fo", 0);
+        patterns[1].pattern = nullptr;
+        CHECK(mlmpAddPattern(tree, patterns, &app_host) == 0);
+
+        CHECK(mlmpProcessPatterns(tree) == 0);
+    }
+
+    void teardown() override
+    {
+        mlmpDestroy(tree);
+    }
+};
+
+TEST(sf_mlmp_generic, multipart)
+{
+    tMlmpPattern patterns[2];
+    patterns[1].pattern = nullptr;
+
+    const char* both = "xxbarfooyy";
+    patterns[0] = { (const uint8_t*)both, strlen(both), 0 };
+    POINTERS_EQUAL(&app_multi, mlmpMatchPatternGeneric(tree, patterns));
+
+    const char* part = "xxfooyyfoo";
+    patterns[0] = { (const uint8_t*)part, strlen(part), 0 };
+    POINTERS_EQUAL(&app_host, mlmpMatchPatternGeneric(tree, patterns));
+
+    const char* none = "xxbaryy";
+    patterns[0] = { (const uint8_t*)none, strlen(none), 0 };
+    POINTERS_EQUAL(nullptr, mlmpMatchPatternGeneric(tree, patterns));
+}
+
+int main(int argc, char** argv)
+{
+    ((MpseApi*)se_ac_full)->init();
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
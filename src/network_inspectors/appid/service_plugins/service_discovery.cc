@@ -226,44 +226,53 @@ static int pattern_match(void* id, void*, int match_end_pos, void* data, void*)
     return 0;
 }
 
-/**Perform pattern match of a packet and construct a list of services sorted in order of
- * precedence criteria. Criteria is count and then size. The first service in the list is
- * returned. The list itself is saved in ServiceDiscoveryState. If
- * appId is already identified, then use it instead of searching again. AppId has capability
- * to try out other inferior matches. If appId is unknown i.e. searched and not found by FRE then
- * don't do any pattern match. This is a way to degrade detector if FRE is running.
-*/
-void ServiceDiscovery::match_by_pattern(AppIdSession& asd, const Packet* pkt, IpProtocol proto)
+/* Search the payload once against the combined signature index of all service
+ * detectors for the protocol and return the matching detectors ranked by precedence.
+ * Criteria is count and then size. This is used both to build the candidate list
+ * and to reorder the brute force walk on ports without a port based detector.
+ */
+void ServiceDiscovery::match_signatures(const Packet* pkt, IpProtocol proto,
+    std::vector<ServiceDetector*>& ranked)
 {
-    SearchTool* patterns = nullptr;
+    SearchTool& patterns = (proto == IpProtocol::TCP) ? tcp_patterns : udp_patterns;
 
-    if (proto == IpProtocol::TCP)
-        patterns = &tcp_patterns;
-    else
-        patterns = &udp_patterns;
+    ServiceMatch* match_list = nullptr;
+    patterns.find_all((const char*)pkt->data, pkt->dsize, &pattern_match, false,
+        (void*)&match_list);
 
-    if (patterns)
+    std::vector<ServiceMatch*> smOrderedList;
+    for (ServiceMatch* sm = match_list; sm; sm = sm->next)
+        smOrderedList.emplace_back(sm);
+
+    if (!smOrderedList.empty() )
     {
-        ServiceMatch* match_list = nullptr;
-        patterns->find_all((const char*)pkt->data, pkt->dsize, &pattern_match, false,
-            (void*)&match_list);
+        std::sort(smOrderedList.begin(), smOrderedList.end(), AppIdPatternPrecedence);
+        for ( auto& sm : smOrderedList )
+        {
+            ranked.emplace_back(sm->service);
+            snort_free(sm);
+        }
+    }
+}
 
-        std::vector<ServiceMatch*> smOrderedList;
-        for (ServiceMatch* sm = match_list; sm; sm = sm->next)
-            smOrderedList.emplace_back(sm);
+/**Perform pattern match of a packet and construct a list of services sorted in order of
+ * precedence criteria. The first service in the list is returned. The list itself is saved
+ * in ServiceDiscoveryState. If appId is already identified, then use it instead of searching
+ * again. AppId has capability to try out other inferior matches. If appId is unknown i.e.
+ * searched and not found by FRE then don't do any pattern match. This is a way to degrade
+ * detector if FRE is running.
+*/
+void ServiceDiscovery::match_by_pattern(AppIdSession& asd, const Packet* pkt, IpProtocol proto)
+{
+    std::vector<ServiceDetector*> ranked;
+    match_signatures(pkt, proto, ranked);
 
-        if (!smOrderedList.empty() )
+    for ( auto service : ranked )
+    {
+        if ( std::find(asd.service_candidates.begin(), asd.service_candidates.end(),
+            service) == asd.service_candidates.end() )
         {
-            std::sort(smOrderedList.begin(), smOrderedList.end(), AppIdPatternPrecedence);
-            for ( auto& sm : smOrderedList )
-            {
-                if ( std::find(asd.service_candidates.begin(), asd.service_candidates.end(),
-                    sm->service) == asd.service_candidates.end() )
-                {
-                    asd.service_candidates.emplace_back(sm->service);
-                }
-                snort_free(sm);
-            }
+            asd.service_candidates.emplace_back(service);
         }
     }
 }
@@ -437,8 +446,16 @@ int ServiceDiscovery::identify_service(AppIdSession& asd, Packet* p,
             else if ( sds_state == ServiceState::SEARCHING_BRUTE_FORCE and
                 asd.service_candidates.empty() )
             {
-                asd.service_detector = sds->select_detector_by_brute_force(proto,
-                    asd.get_odp_ctxt().get_service_disco_mgr());
+                // rank the remaining detectors by this payload before walking them;
+                // service patterns are responder patterns so client data is only
+                // used where get_next_service() would match it too (udp initiator)
+                ServiceDiscovery& sd = asd.get_odp_ctxt().get_service_disco_mgr();
+                std::vector<ServiceDetector*> ranked;
+                if ( p->dsize and (dir == APP_ID_FROM_RESPONDER or
+                    (proto == IpProtocol::UDP and
+                    !asd.get_session_flags(APPID_SESSION_ADDITIONAL_PACKET))) )
+                    sd.match_signatures(p, proto, ranked);
+                asd.service_detector = sds->select_detector_by_brute_force(proto, sd, &ranked);
                 got_brute_force = true;
             }
         }
@@ -451,6 +468,7 @@ int ServiceDiscovery::identify_service(AppIdSession& asd, Packet* p,
     /* If we already have a service to try, then try it out. */
     if ( asd.service_detector )
     {
+        appid_stats.service_detectors_tried++;
         ret = asd.service_detector->validate(args);
         if (ret == APPID_NOMATCH)
             got_fail_service = true;
@@ -481,6 +499,7 @@ int ServiceDiscovery::identify_service(AppIdSession& asd, Packet* p,
             ServiceDetector* service = (ServiceDetector*)*it;
             int result;
 
+            appid_stats.service_detectors_tried++;
             result = service->validate(args);
             if ( appidDebug->is_active() )
                 LogMessage("AppIdDbg %s %s service candidate returned %s (%d)\n",
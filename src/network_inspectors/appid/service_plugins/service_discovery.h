@@ -69,6 +69,7 @@ public:
     void finalize_service_patterns();
     void reload_service_patterns();
     int add_service_port(AppIdDetector*, const ServiceDetectorPort&) override;
+    void match_signatures(const snort::Packet*, IpProtocol, std::vector<ServiceDetector*>& ranked);
 
     AppIdDetectorsIterator get_detector_iterator(IpProtocol);
     ServiceDetector* get_next_tcp_detector(AppIdDetectorsIterator&);
@@ -25,6 +25,7 @@
 
 #include "service_state.h"
 
+#include <algorithm>
 #include <list>
 #include <map>
 
@@ -58,13 +59,13 @@ ServiceDiscoveryState::~ServiceDiscoveryState()
 }
 
 ServiceDetector* ServiceDiscoveryState::select_detector_by_brute_force(IpProtocol proto,
-    ServiceDiscovery& sd)
+    ServiceDiscovery& sd, const std::vector<ServiceDetector*>* ranked)
 {
     if (proto == IpProtocol::TCP)
     {
         if ( !tcp_brute_force_mgr )
             tcp_brute_force_mgr = new AppIdDetectorList(IpProtocol::TCP, sd);
-        service = tcp_brute_force_mgr->next();
+        service = tcp_brute_force_mgr->next(ranked);
         if (appidDebug->is_active())
             LogMessage("AppIdDbg %s Brute-force state %s\n", appidDebug->get_debug_session(),
                 service? "" : "failed - no more TCP detectors");
@@ -73,7 +74,7 @@ ServiceDetector* ServiceDiscoveryState::select_detector_by_brute_force(IpProtoco
     {
         if ( !udp_brute_force_mgr )
             udp_brute_force_mgr = new AppIdDetectorList(IpProtocol::UDP, sd);
-        service = udp_brute_force_mgr->next();
+        service = udp_brute_force_mgr->next(ranked);
         if (appidDebug->is_active())
             LogMessage("AppIdDbg %s Brute-force state %s\n", appidDebug->get_debug_session(),
                 service? "" : "failed - no more UDP detectors");
@@ -83,6 +84,12 @@ ServiceDetector* ServiceDiscoveryState::select_detector_by_brute_force(IpProtoco
 
     if ( !service )
         state = ServiceState::FAILED;
+    else
+    {
+        appid_stats.service_brute_force_tried++;
+        if ( ranked and std::find(ranked->begin(), ranked->end(), service) != ranked->end() )
+            appid_stats.service_signature_hits++;
+    }
 
     return service;
 }
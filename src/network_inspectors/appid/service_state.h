@@ -24,6 +24,8 @@
 
 #include <list>
 #include <map>
+#include <unordered_set>
+#include <vector>
 
 #include "protocols/protocol_ids.h"
 #include "sfip/sf_ip.h"
@@ -61,23 +63,38 @@ public:
         dit = detectors->begin();
     }
 
-    ServiceDetector* next()
+    // detectors ranked by the signature index for the current payload are
+    // tried ahead of the ordered walk; each detector is tried at most once
+    ServiceDetector* next(const std::vector<ServiceDetector*>* ranked = nullptr)
     {
-        ServiceDetector* detector = nullptr;
+        if ( ranked )
+        {
+            for ( auto detector : *ranked )
+            {
+                if ( tried.insert(detector).second )
+                    return detector;
+            }
+        }
 
-        if ( dit != detectors->end())
-            detector = (ServiceDetector*)(dit++)->second;
-        return detector;
+        while ( dit != detectors->end() )
+        {
+            ServiceDetector* detector = (ServiceDetector*)(dit++)->second;
+            if ( tried.insert(detector).second )
+                return detector;
+        }
+        return nullptr;
     }
 
     void reset()
     {
         dit = detectors->begin();
+        tried.clear();
     }
 
 private:
     AppIdDetectors* detectors;
     AppIdDetectorsIterator dit;
+    std::unordered_set<ServiceDetector*> tried;
 };
 
 class ServiceDiscoveryState
@@ -85,7 +102,8 @@ class ServiceDiscoveryState
 public:
     ServiceDiscoveryState();
     ~ServiceDiscoveryState();
-    ServiceDetector* select_detector_by_brute_force(IpProtocol proto, ServiceDiscovery& sd);
+    ServiceDetector* select_detector_by_brute_force(IpProtocol proto, ServiceDiscovery& sd,
+        const std::vector<ServiceDetector*>* ranked = nullptr);
     void set_service_id_valid(ServiceDetector* sd);
     void set_service_id_failed(AppIdSession& asd, const snort::SfIp* client_ip,
         unsigned invalid_delta = 0);
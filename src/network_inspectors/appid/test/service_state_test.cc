@@ -165,6 +165,30 @@ TEST(service_state_tests, select_detector_by_brute_force)
     STRCMP_EQUAL(test_log, "");
 }
 
+TEST(service_state_tests, select_detector_by_brute_force_ranked)
+{
+    ServiceDiscovery sd;
+    ServiceDiscoveryState sds;
+
+    // The brute-force walk never dereferences detectors, so placeholders will do
+    ServiceDetector* first = reinterpret_cast<ServiceDetector*>(0x10);
+    ServiceDetector* second = reinterpret_cast<ServiceDetector*>(0x20);
+    sd.get_tcp_detectors()->emplace("first", reinterpret_cast<AppIdDetector*>(first));
+    sd.get_tcp_detectors()->emplace("second", reinterpret_cast<AppIdDetector*>(second));
+
+    // Signature ranked detectors are tried first and only once
+    std::vector<ServiceDetector*> ranked = { second };
+    memset(&appid_stats, 0, sizeof(appid_stats));
+    CHECK(sds.select_detector_by_brute_force(IpProtocol::TCP, sd, &ranked) == second);
+    CHECK(sds.select_detector_by_brute_force(IpProtocol::TCP, sd, &ranked) == first);
+    CHECK(sds.select_detector_by_brute_force(IpProtocol::TCP, sd, &ranked) == nullptr);
+    CHECK(sds.get_state() == ServiceState::FAILED);
+    CHECK(appid_stats.service_brute_force_tried == 2);
+    CHECK(appid_stats.service_signature_hits == 1);
+
+    sd.get_tcp_detectors()->clear();
+}
+
 TEST(service_state_tests, set_service_id_failed)
 {
     ServiceDiscoveryState sds;
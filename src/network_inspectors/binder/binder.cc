@@ -37,6 +37,7 @@
 
 #include "bind_module.h"
 #include "binding.h"
+#include "binding_index.h"
 
 using namespace snort;
 
@@ -501,6 +502,8 @@ private:
 private:
     std::vector<Binding> bindings;
     std::vector<Binding> policy_bindings;
+    BindingIndex index;
+    BindingIndex policy_index;
     Inspector* default_ssn_inspectors[to_utype(PktType::MAX)]{};
 };
 
@@ -614,6 +617,9 @@ bool Binder::configure(SnortConfig* sc)
     for (Binding& b : policy_bindings)
         b.configure(sc);
 
+    index.build(bindings);
+    policy_index.build(policy_bindings);
+
     // Grab default session inspectors if they exist for this policy
     for (int proto = to_utype(PktType::NONE); proto < to_utype(PktType::MAX); proto++)
     {
@@ -689,6 +695,7 @@ void Binder::remove_inspector_binding(SnortConfig*, const char* name)
         if (!strcmp(key, name))
         {
             bindings.erase(it);
+            index.build(bindings);
             return;
         }
     }
@@ -864,21 +871,25 @@ void Binder::get_policy_bindings(Flow& flow, const char* service)
     // FIXIT-L This will select the first policy ID of each type that it finds and ignore the rest.
     //          It gets potentially hairy if people start specifying overlapping policy types in
     //          overlapping rules.
-    for (const Binding& b : policy_bindings)
+    policy_index.find(BindKey(flow, service), [&](unsigned i)
     {
+        const Binding& b = policy_bindings[i];
+
         // Skip any rules that don't contain an ID for a policy type we haven't set yet.
         if ((!b.use.inspection_index || inspection_index) && (!b.use.ips_index || ips_index))
-            continue;
+            return false;
 
         if (!b.check_all(flow, service))
-            continue;
+            return false;
 
         if (b.use.inspection_index && !inspection_index)
             inspection_index = b.use.inspection_index;
 
         if (b.use.ips_index && !ips_index)
             ips_index = b.use.ips_index;
-    }
+
+        return inspection_index && ips_index;
+    });
 
     if (inspection_index)
     {
@@ -904,21 +915,25 @@ void Binder::get_policy_bindings(Packet* p)
     // FIXIT-L This will select the first policy ID of each type that it finds and ignore the rest.
     //          It gets potentially hairy if people start specifying overlapping policy types in
     //          overlapping rules.
-    for (const Binding& b : policy_bindings)
+    policy_index.find(BindKey(p), [&](unsigned i)
     {
+        const Binding& b = policy_bindings[i];
+
         // Skip any rules that don't contain an ID for a policy type we haven't set yet.
         if ((!b.use.inspection_index || inspection_index) && (!b.use.ips_index || ips_index))
-            continue;
+            return false;
 
         if (!b.check_all(p))
-            continue;
+            return false;
 
         if (b.use.inspection_index && !inspection_index)
             inspection_index = b.use.inspection_index;
 
         if (b.use.ips_index && !ips_index)
             ips_index = b.use.ips_index;
-    }
+
+        return inspection_index && ips_index;
+    });
 
     if (inspection_index)
     {
@@ -934,8 +949,6 @@ void Binder::get_policy_bindings(Packet* p)
     }
 }
 
-// FIXIT-P this is a simple linear search until functionality is nailed
-// down.  performance should be the focus of the next iteration.
 void Binder::get_bindings(Flow& flow, Stuff& stuff, const char* service)
 {
     // Evaluate policy ID bindings first
@@ -955,14 +968,14 @@ void Binder::get_bindings(Flow& flow, Stuff& stuff, const char* service)
     // Initialize the session inspector for both client and server to the default for this policy.
     stuff.client = stuff.server = default_ssn_inspectors[to_utype(flow.pkt_type)];
 
-    for (const Binding& b : bindings)
+    auto check = [&](unsigned i)
     {
-        if (!b.check_all(flow, service))
-            continue;
+        const Binding& b = bindings[i];
+        return b.check_all(flow, service) && stuff.update(b);
+    };
 
-        if (stuff.update(b))
-            return;
-    }
+    if (index.find(BindKey(flow, service), check))
+        return;
 
     bstats.no_match++;
 }
@@ -986,14 +999,14 @@ void Binder::get_bindings(Packet* p, Stuff& stuff)
     // Initialize the session inspector for both client and server to the default for this policy.
     stuff.client = stuff.server = default_ssn_inspectors[to_utype(p->type())];
 
-    for (const Binding& b : bindings)
+    auto check = [&](unsigned i)
     {
-        if (!b.check_all(p))
-            continue;
+        const Binding& b = bindings[i];
+        return b.check_all(p) && stuff.update(b);
+    };
 
-        if (stuff.update(b))
-            return;
-    }
+    if (index.find(BindKey(p), check))
+        return;
 
     bstats.no_match++;
 }
@@ -0,0 +1,608 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// binding_index.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "binding_index.h"
+
+#include "flow/flow.h"
+#include "flow/flow_key.h"
+#include "protocols/packet.h"
+#include "sfip/sf_ipvar.h"
+
+#include "binding.h"
+
+using namespace snort;
+
+// larger port and vlan sets are left to check_all
+static constexpr unsigned max_keys = 256;
+
+//-------------------------------------------------------------------------
+// keys
+//-------------------------------------------------------------------------
+
+BindKey::BindKey(const Flow& flow, const char* svc)
+{
+    cli_ip = &flow.client_ip;
+    srv_ip = &flow.server_ip;
+    service = svc ? svc : flow.service;
+    explicit_service = svc != nullptr;
+
+    tenant = flow.tenant;
+    addr_space = flow.key->addressSpaceId;
+
+    cli_intf = flow.client_intf;
+    srv_intf = flow.server_intf;
+
+    vlan = flow.key->vlan_tag;
+    cli_port = flow.client_port;
+    srv_port = flow.server_port;
+
+    cli_group = flow.client_group;
+    srv_group = flow.server_group;
+
+    proto = flow.pkt_type;
+}
+
+BindKey::BindKey(const Packet* p)
+{
+    cli_ip = p->ptrs.ip_api.get_src();
+    srv_ip = p->ptrs.ip_api.get_dst();
+    service = nullptr;
+    explicit_service = false;
+
+    tenant = p->pkth->tenant_id;
+    addr_space = p->pkth->address_space_id;
+
+    cli_intf = p->pkth->ingress_index;
+    srv_intf = p->pkth->egress_index;
+
+    vlan = p->get_flow_vlan_id();
+    cli_port = p->ptrs.sp;
+    srv_port = p->ptrs.dp;
+
+    cli_group = p->pkth->ingress_group;
+    srv_group = p->pkth->egress_group;
+
+    proto = p->type();
+}
+
+//-------------------------------------------------------------------------
+// bitmaps
+//-------------------------------------------------------------------------
+
+static inline void set_bit(std::vector<uint64_t>& v, unsigned idx)
+{ v[idx >> 6] |= (uint64_t)1 << (idx & 63); }
+
+// bindings are added in order so buckets stay sorted
+static inline void set_bit(BindBucket& b, unsigned idx)
+{
+    uint32_t word = idx >> 6;
+    uint64_t bit = (uint64_t)1 << (idx & 63);
+
+    if ( b.empty() || b.back().first != word )
+        b.emplace_back(word, bit);
+    else
+        b.back().second |= bit;
+}
+
+static void merge(BindBucket& to, const BindBucket& from)
+{
+    BindBucket out;
+    out.reserve(to.size() + from.size());
+
+    auto a = to.cbegin();
+    auto b = from.cbegin();
+
+    while ( a != to.cend() || b != from.cend() )
+    {
+        if ( b == from.cend() || (a != to.cend() && a->first < b->first) )
+            out.emplace_back(*a++);
+
+        else if ( a == to.cend() || b->first < a->first )
+            out.emplace_back(*b++);
+
+        else
+        {
+            out.emplace_back(a->first, a->second | b->second);
+            ++a;
+            ++b;
+        }
+    }
+    to.swap(out);
+}
+
+template<typename K>
+void BindingIndex::KeyMap<K>::add(const K& key, unsigned idx)
+{
+    set_bit(keys[key], idx);
+    used = true;
+}
+
+template<typename K>
+void BindingIndex::KeyMap<K>::add(const std::unordered_set<K>& set, unsigned idx)
+{
+    for ( const K& key : set )
+        add(key, idx);
+}
+
+template<typename K>
+const BindBucket* BindingIndex::KeyMap<K>::get(const K& key) const
+{
+    auto it = keys.find(key);
+    return it == keys.end() ? nullptr : &it->second;
+}
+
+void BindingIndex::Cursor::set(const uint64_t* w, const BindBucket* a, const BindBucket* b)
+{
+    wild = w;
+
+    const BindBucket* hits[2] = { a, b };
+
+    for ( unsigned k = 0; k < 2; ++k )
+    {
+        if ( hits[k] )
+        {
+            pos[k] = hits[k]->data();
+            end[k] = pos[k] + hits[k]->size();
+        }
+        else
+            pos[k] = end[k] = nullptr;
+    }
+}
+
+//-------------------------------------------------------------------------
+// networks
+//-------------------------------------------------------------------------
+
+// binary trie of the positive cidrs; each node's bucket includes the
+// bindings of its ancestors so a lookup only needs the deepest match
+
+static inline unsigned get_bit(const uint64_t* addr, unsigned depth)
+{ return (addr[depth >> 6] >> (63 - (depth & 63))) & 1; }
+
+void BindingIndex::NetTrie::add(const uint64_t* addr, unsigned len, unsigned idx)
+{
+    if ( nodes.empty() )
+        nodes.push_back({ { -1, -1 }, -1 });
+
+    unsigned n = 0;
+
+    for ( unsigned depth = 0; depth < len; ++depth )
+    {
+        unsigned bit = get_bit(addr, depth);
+
+        if ( nodes[n].child[bit] < 0 )
+        {
+            nodes[n].child[bit] = nodes.size();
+            nodes.push_back({ { -1, -1 }, -1 });
+        }
+        n = nodes[n].child[bit];
+    }
+
+    if ( nodes[n].bucket < 0 )
+    {
+        nodes[n].bucket = buckets.size();
+        buckets.emplace_back();
+    }
+    set_bit(buckets[nodes[n].bucket], idx);
+}
+
+void BindingIndex::NetTrie::finish()
+{
+    // children are always created after their parents
+    for ( const Node& n : nodes )
+    {
+        if ( n.bucket < 0 )
+            continue;
+
+        for ( int32_t c : n.child )
+        {
+            if ( c < 0 )
+                continue;
+
+            if ( nodes[c].bucket < 0 )
+                nodes[c].bucket = n.bucket;
+            else
+                merge(buckets[nodes[c].bucket], buckets[n.bucket]);
+        }
+    }
+}
+
+const BindBucket* BindingIndex::NetTrie::get(const uint64_t* addr, unsigned len) const
+{
+    if ( nodes.empty() )
+        return nullptr;
+
+    const Node* n = &nodes[0];
+    int32_t bucket = n->bucket;
+
+    for ( unsigned depth = 0; depth < len; ++depth )
+    {
+        int32_t c = n->child[get_bit(addr, depth)];
+
+        if ( c < 0 )
+            break;
+
+        n = &nodes[c];
+
+        if ( n->bucket >= 0 )
+            bucket = n->bucket;
+    }
+    return bucket < 0 ? nullptr : &buckets[bucket];
+}
+
+// mirrors the positive list checks of sfvar_ip_in(); a binding can only
+// match if its positive list is empty or has an entry containing the ip.
+// negated entries only remove matches and are left to check_all.
+void BindingIndex::add_nets(NetMap& nm, const sfip_var_t* var, unsigned idx)
+{
+    if ( !var || !var->head )
+    {
+        set_bit(nm.wild4, idx);
+        set_bit(nm.wild6, idx);
+        return;
+    }
+
+    for ( const sfip_node_t* node = var->head; node; node = node->next )
+    {
+        const SfCidr* cidr = node->ip;
+
+        if ( !cidr->is_set() )
+        {
+            set_bit(nm.wild4, idx);
+            set_bit(nm.wild6, idx);
+            continue;
+        }
+
+        const SfIp* addr = cidr->get_addr();
+        unsigned bits = cidr->get_bits();
+        uint64_t w[2] = { 0, 0 };
+
+        if ( addr->get_family() == AF_INET )
+        {
+            uint32_t a = ntohl(addr->get_ip4_value());
+            w[0] = (uint64_t)a << 32;
+
+            // 0.0.0.0 contains all IPv4 addresses regardless of the mask
+            nm.v4.add(w, (a && bits > 96) ? bits - 96 : 0, idx);
+        }
+        else if ( addr->get_family() == AF_INET6 )
+        {
+            const uint32_t* p = addr->get_ip6_ptr();
+            w[0] = ((uint64_t)ntohl(p[0]) << 32) | ntohl(p[1]);
+            w[1] = ((uint64_t)ntohl(p[2]) << 32) | ntohl(p[3]);
+            nm.v6.add(w, bits > 128 ? 128 : bits, idx);
+        }
+    }
+    nm.used = true;
+}
+
+bool BindingIndex::get_net(const NetMap& nm, const SfIp* ip, Cursor& c) const
+{
+    if ( !ip )
+        return false;
+
+    uint64_t w[2] = { 0, 0 };
+
+    if ( ip->get_family() == AF_INET )
+    {
+        w[0] = (uint64_t)ntohl(ip->get_ip4_value()) << 32;
+        c.set(nm.wild4.data(), nm.v4.get(w, 32));
+    }
+    else
+    {
+        const uint32_t* p = ip->get_ip6_ptr();
+        w[0] = ((uint64_t)ntohl(p[0]) << 32) | ntohl(p[1]);
+        w[1] = ((uint64_t)ntohl(p[2]) << 32) | ntohl(p[3]);
+        c.set(nm.wild6.data(), nm.v6.get(w, 128));
+    }
+    return true;
+}
+
+bool BindingIndex::get_nets(const NetMap& nm, const SfIp* a, const SfIp* b, Cursor& c) const
+{
+    Cursor ca, cb;
+
+    if ( !get_net(nm, a, ca) || !get_net(nm, b, cb) )
+        return false;
+
+    // the two lookups share wild when the families agree; otherwise the
+    // union of the wilds would be needed so don't filter
+    if ( ca.wild != cb.wild )
+        return false;
+
+    c.wild = ca.wild;
+    c.pos[0] = ca.pos[0];
+    c.end[0] = ca.end[0];
+    c.pos[1] = cb.pos[0];
+    c.end[1] = cb.end[0];
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// build
+//-------------------------------------------------------------------------
+
+void BindingIndex::clear()
+{
+    *this = BindingIndex();
+}
+
+void BindingIndex::build(const std::vector<Binding>& bindings)
+{
+    clear();
+
+    num_bindings = bindings.size();
+    num_words = (num_bindings + 63) / 64;
+
+    protos.assign(to_utype(PktType::MAX), std::vector<uint64_t>(num_words, 0));
+    no_service.assign(num_words, 0);
+    none.assign(num_words, 0);
+
+    for ( auto* km : { &vlans, &cli_ports, &srv_ports, &any_ports } )
+        km->wild.assign(num_words, 0);
+
+    for ( auto* km : { &tenants, &addr_spaces } )
+        km->wild.assign(num_words, 0);
+
+    for ( auto* km : { &cli_groups, &srv_groups, &any_groups } )
+        km->wild.assign(num_words, 0);
+
+    for ( auto* km : { &cli_intfs, &srv_intfs, &any_intfs } )
+        km->wild.assign(num_words, 0);
+
+    for ( auto* nm : { &cli_nets, &srv_nets, &any_nets } )
+    {
+        nm->wild4.assign(num_words, 0);
+        nm->wild6.assign(num_words, 0);
+    }
+
+    for ( unsigned idx = 0; idx < num_bindings; ++idx )
+    {
+        const BindWhen& when = bindings[idx].when;
+
+        // protocol; port criteria only match tcp and udp
+        bool ports = (when.criteria_flags &
+            (BindWhen::Criteria::BWC_PORTS | BindWhen::Criteria::BWC_SPLIT_PORTS)) != 0;
+        bool proto = when.has_criteria(BindWhen::Criteria::BWC_PROTO);
+
+        for ( unsigned t = 0; t < protos.size(); ++t )
+        {
+            PktType type = static_cast<PktType>(t);
+
+            if ( ports && type != PktType::TCP && type != PktType::UDP )
+                continue;
+
+            if ( proto && t && !(when.protos & (1 << (t - 1))) )
+                continue;
+
+            set_bit(protos[t], idx);
+        }
+        proto_used = proto_used || proto || ports;
+
+        // service
+        if ( when.has_criteria(BindWhen::Criteria::BWC_SVC) )
+        {
+            set_bit(services[when.svc], idx);
+            service_used = true;
+        }
+        else
+            set_bit(no_service, idx);
+
+        // vlan
+        if ( when.has_criteria(BindWhen::Criteria::BWC_VLANS) && when.vlans.count() <= max_keys )
+        {
+            for ( unsigned v = 0; v < when.vlans.size(); ++v )
+                if ( when.vlans.test(v) )
+                    vlans.add(v, idx);
+        }
+        else
+            set_bit(vlans.wild, idx);
+
+        // tenants and address spaces
+        if ( when.has_criteria(BindWhen::Criteria::BWC_TENANTS) )
+            tenants.add(when.tenants, idx);
+        else
+            set_bit(tenants.wild, idx);
+
+        if ( when.has_criteria(BindWhen::Criteria::BWC_ADDR_SPACES) )
+            addr_spaces.add(when.addr_spaces, idx);
+        else
+            set_bit(addr_spaces.wild, idx);
+
+        // ports
+        KeyMap<uint16_t>* src_ports = nullptr;
+        KeyMap<uint16_t>* dst_ports = nullptr;
+
+        if ( when.has_criteria(BindWhen::Criteria::BWC_PORTS) )
+        {
+            switch ( when.role )
+            {
+            case BindWhen::BR_CLIENT: src_ports = &cli_ports; break;
+            case BindWhen::BR_SERVER: src_ports = &srv_ports; break;
+            case BindWhen::BR_EITHER: src_ports = &any_ports; break;
+            default: break;
+            }
+        }
+        else if ( when.has_criteria(BindWhen::Criteria::BWC_SPLIT_PORTS) )
+        {
+            src_ports = &cli_ports;
+            dst_ports = &srv_ports;
+        }
+
+        for ( auto* km : { &cli_ports, &srv_ports, &any_ports } )
+        {
+            const PortBitSet* set = (km == src_ports) ? &when.src_ports :
+                (km == dst_ports) ? &when.dst_ports : nullptr;
+
+            if ( !set || set->count() > max_keys )
+            {
+                set_bit(km->wild, idx);
+                continue;
+            }
+
+            for ( unsigned port = 0; port < set->size(); ++port )
+                if ( set->test(port) )
+                    km->add(port, idx);
+        }
+
+        // groups, interfaces and networks
+        bool either = when.has_criteria(BindWhen::Criteria::BWC_GROUPS);
+        bool split = when.has_criteria(BindWhen::Criteria::BWC_SPLIT_GROUPS);
+
+        if ( split && !when.src_groups.empty() )
+            cli_groups.add(when.src_groups, idx);
+        else if ( either && when.role == BindWhen::BR_CLIENT )
+            cli_groups.add(when.src_groups, idx);
+        else
+            set_bit(cli_groups.wild, idx);
+
+        if ( split && !when.dst_groups.empty() )
+            srv_groups.add(when.dst_groups, idx);
+        else if ( either && when.role == BindWhen::BR_SERVER )
+            srv_groups.add(when.src_groups, idx);
+        else
+            set_bit(srv_groups.wild, idx);
+
+        if ( either && when.role == BindWhen::BR_EITHER )
+            any_groups.add(when.src_groups, idx);
+        else
+            set_bit(any_groups.wild, idx);
+
+        either = when.has_criteria(BindWhen::Criteria::BWC_INTFS);
+        split = when.has_criteria(BindWhen::Criteria::BWC_SPLIT_INTFS);
+
+        if ( split && !when.src_intfs.empty() )
+            cli_intfs.add(when.src_intfs, idx);
+        else if ( either && when.role == BindWhen::BR_CLIENT )
+            cli_intfs.add(when.src_intfs, idx);
+        else
+            set_bit(cli_intfs.wild, idx);
+
+        if ( split && !when.dst_intfs.empty() )
+            srv_intfs.add(when.dst_intfs, idx);
+        else if ( either && when.role == BindWhen::BR_SERVER )
+            srv_intfs.add(when.src_intfs, idx);
+        else
+            set_bit(srv_intfs.wild, idx);
+
+        if ( either && when.role == BindWhen::BR_EITHER )
+            any_intfs.add(when.src_intfs, idx);
+        else
+            set_bit(any_intfs.wild, idx);
+
+        either = when.has_criteria(BindWhen::Criteria::BWC_NETS);
+        split = when.has_criteria(BindWhen::Criteria::BWC_SPLIT_NETS);
+
+        add_nets(cli_nets, split ? when.src_nets :
+            (either && when.role == BindWhen::BR_CLIENT) ? when.src_nets : nullptr, idx);
+
+        add_nets(srv_nets, split ? when.dst_nets :
+            (either && when.role == BindWhen::BR_SERVER) ? when.src_nets : nullptr, idx);
+
+        add_nets(any_nets,
+            (either && when.role == BindWhen::BR_EITHER) ? when.src_nets : nullptr, idx);
+    }
+
+    for ( auto* nm : { &cli_nets, &srv_nets, &any_nets } )
+    {
+        nm->v4.finish();
+        nm->v6.finish();
+    }
+}
+
+//-------------------------------------------------------------------------
+// lookup
+//-------------------------------------------------------------------------
+
+unsigned BindingIndex::get_cursors(const BindKey& key, Cursor* c) const
+{
+    unsigned num = 0;
+
+    if ( proto_used )
+        c[num++].set(protos[to_utype(key.proto)].data());
+
+    if ( key.explicit_service )
+    {
+        auto it = services.find(key.service);
+        c[num++].set(none.data(), it == services.end() ? nullptr : &it->second);
+    }
+    else if ( service_used )
+    {
+        const BindBucket* b = nullptr;
+
+        if ( key.service )
+        {
+            auto it = services.find(key.service);
+            if ( it != services.end() )
+                b = &it->second;
+        }
+        c[num++].set(no_service.data(), b);
+    }
+
+    if ( vlans.used )
+        c[num++].set(vlans.wild.data(), vlans.get(key.vlan));
+
+    if ( tenants.used )
+        c[num++].set(tenants.wild.data(), tenants.get(key.tenant));
+
+    if ( addr_spaces.used )
+        c[num++].set(addr_spaces.wild.data(), addr_spaces.get(key.addr_space));
+
+    if ( cli_ports.used )
+        c[num++].set(cli_ports.wild.data(), cli_ports.get(key.cli_port));
+
+    if ( srv_ports.used )
+        c[num++].set(srv_ports.wild.data(), srv_ports.get(key.srv_port));
+
+    if ( any_ports.used )
+        c[num++].set(any_ports.wild.data(), any_ports.get(key.cli_port), any_ports.get(key.srv_port));
+
+    if ( cli_groups.used )
+        c[num++].set(cli_groups.wild.data(), cli_groups.get(key.cli_group));
+
+    if ( srv_groups.used )
+        c[num++].set(srv_groups.wild.data(), srv_groups.get(key.srv_group));
+
+    if ( any_groups.used )
+        c[num++].set(any_groups.wild.data(), any_groups.get(key.cli_group), any_groups.get(key.srv_group));
+
+    if ( cli_intfs.used )
+        c[num++].set(cli_intfs.wild.data(), cli_intfs.get(key.cli_intf));
+
+    if ( srv_intfs.used )
+        c[num++].set(srv_intfs.wild.data(), srv_intfs.get(key.srv_intf));
+
+    if ( any_intfs.used )
+        c[num++].set(any_intfs.wild.data(), any_intfs.get(key.cli_intf), any_intfs.get(key.srv_intf));
+
+    if ( cli_nets.used && get_net(cli_nets, key.cli_ip, c[num]) )
+        ++num;
+
+    if ( srv_nets.used && get_net(srv_nets, key.srv_ip, c[num]) )
+        ++num;
+
+    if ( any_nets.used && get_nets(any_nets, key.cli_ip, key.srv_ip, c[num]) )
+        ++num;
+
+    return num;
+}
@@ -0,0 +1,218 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// binding_index.h
+
+#ifndef BINDING_INDEX_H
+#define BINDING_INDEX_H
+
+// BindingIndex narrows the bindings that can match a flow or packet down to
+// a few candidates so the binder only runs the full when checks on those.
+// Each indexed criterion maps a key (protocol, service, vlan, tenant,
+// address space, port, group, interface or network) to the bindings that
+// require that key plus a bitmap of the bindings that don't constrain the
+// criterion.  A lookup ANDs the per criterion bitmaps one word at a time
+// and visits the surviving bindings in binding order, so first match
+// priority is unchanged.  The index is a superset filter; anything it can't
+// represent compactly (huge port ranges, negated networks, etc.) is simply
+// left to Binding::check_all().
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "framework/decode_data.h"
+
+namespace snort
+{
+class Flow;
+struct Packet;
+struct SfIp;
+}
+
+struct Binding;
+struct sfip_var_t;
+
+// the attributes of a flow or packet that the index looks at
+// packets are treated like flows with the source as the client
+struct BindKey
+{
+    BindKey(const snort::Flow&, const char* service = nullptr);
+    BindKey(const snort::Packet*);
+
+    const snort::SfIp* cli_ip;
+    const snort::SfIp* srv_ip;
+    const char* service;
+
+    uint32_t tenant;
+    uint32_t addr_space;
+
+    int32_t cli_intf;
+    int32_t srv_intf;
+
+    uint16_t vlan;
+    uint16_t cli_port;
+    uint16_t srv_port;
+
+    int16_t cli_group;
+    int16_t srv_group;
+
+    PktType proto;
+    bool explicit_service;
+};
+
+// set bits of a sparse bitmap as (word index, word) in ascending word order
+typedef std::vector<std::pair<uint32_t, uint64_t>> BindBucket;
+
+class BindingIndex
+{
+public:
+    void build(const std::vector<Binding>&);
+    void clear();
+
+    // calls f(binding index) for the candidates in binding order until f
+    // returns true; returns true if f did
+    template<typename F>
+    bool find(const BindKey&, F) const;
+
+private:
+    template<typename K>
+    struct KeyMap
+    {
+        std::unordered_map<K, BindBucket> keys;
+        std::vector<uint64_t> wild;
+        bool used = false;
+
+        void add(const K&, unsigned);
+        void add(const std::unordered_set<K>&, unsigned);
+        const BindBucket* get(const K&) const;
+    };
+
+    class NetTrie
+    {
+    public:
+        void add(const uint64_t* addr, unsigned len, unsigned idx);
+        void finish();
+        const BindBucket* get(const uint64_t* addr, unsigned len) const;
+
+    private:
+        struct Node
+        {
+            int32_t child[2];
+            int32_t bucket;
+        };
+        std::vector<Node> nodes;
+        std::vector<BindBucket> buckets;
+    };
+
+    struct NetMap
+    {
+        NetTrie v4;
+        NetTrie v6;
+        std::vector<uint64_t> wild4;
+        std::vector<uint64_t> wild6;
+        bool used = false;
+    };
+
+    struct Cursor
+    {
+        // nullptr wild means unconstrained
+        const uint64_t* wild;
+        const std::pair<uint32_t, uint64_t>* pos[2];
+        const std::pair<uint32_t, uint64_t>* end[2];
+
+        void set(const uint64_t*, const BindBucket* = nullptr, const BindBucket* = nullptr);
+        uint64_t get(unsigned word);
+    };
+
+    // proto, service, vlan, tenant, address space and 3 each for
+    // ports, groups, interfaces and networks
+    static constexpr unsigned max_cursors = 17;
+
+    unsigned get_cursors(const BindKey&, Cursor*) const;
+    void add_nets(NetMap&, const sfip_var_t*, unsigned idx);
+    bool get_net(const NetMap&, const snort::SfIp*, Cursor&) const;
+    bool get_nets(const NetMap&, const snort::SfIp*, const snort::SfIp*, Cursor&) const;
+
+    unsigned num_bindings = 0;
+    unsigned num_words = 0;
+
+    std::vector<std::vector<uint64_t>> protos;
+    bool proto_used = false;
+
+    std::unordered_map<std::string, BindBucket> services;
+    std::vector<uint64_t> no_service;
+    std::vector<uint64_t> none;
+    bool service_used = false;
+
+    KeyMap<uint16_t> vlans;
+    KeyMap<uint32_t> tenants;
+    KeyMap<uint32_t> addr_spaces;
+
+    KeyMap<uint16_t> cli_ports, srv_ports, any_ports;
+    KeyMap<int16_t> cli_groups, srv_groups, any_groups;
+    KeyMap<int32_t> cli_intfs, srv_intfs, any_intfs;
+    NetMap cli_nets, srv_nets, any_nets;
+};
+
+inline uint64_t BindingIndex::Cursor::get(unsigned word)
+{
+    uint64_t bits = wild ? wild[word] : ~(uint64_t)0;
+
+    for ( unsigned k = 0; k < 2; ++k )
+    {
+        while ( pos[k] != end[k] && pos[k]->first < word )
+            ++pos[k];
+
+        if ( pos[k] != end[k] && pos[k]->first == word )
+            bits |= pos[k]->second;
+    }
+    return bits;
+}
+
+template<typename F>
+bool BindingIndex::find(const BindKey& key, F f) const
+{
+    Cursor cursors[max_cursors];
+    unsigned num = get_cursors(key, cursors);
+
+    for ( unsigned w = 0; w < num_words; ++w )
+    {
+        uint64_t bits = ~(uint64_t)0;
+
+        if ( w == num_words - 1 && (num_bindings & 63) )
+            bits >>= 64 - (num_bindings & 63);
+
+        for ( unsigned c = 0; c < num && bits; ++c )
+            bits &= cursors[c].get(w);
+
+        while ( bits )
+        {
+            if ( f((w << 6) + __builtin_ctzll(bits)) )
+                return true;
+
+            bits &= bits - 1;
+        }
+    }
+    return false;
+}
+
+#endif
+
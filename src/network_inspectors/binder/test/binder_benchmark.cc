@@ -0,0 +1,245 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// binder_benchmark.cc
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "flow/flow.h"
+#include "flow/flow_key.h"
+#include "log/messages.h"
+#include "main/policy.h"
+#include "managers/inspector_manager.h"
+#include "parser/parse_ip.h"
+#include "protocols/packet.h"
+
+#include "network_inspectors/binder/binding.h"
+#include "network_inspectors/binder/binding_index.h"
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+namespace snort
+{
+Flow::Flow() = default;
+Flow::~Flow() = default;
+
+uint16_t Packet::get_flow_vlan_id() const
+{ return 0; }
+
+Inspector* InspectorManager::get_inspector(const char*, bool, const SnortConfig*)
+{ return nullptr; }
+
+IpsPolicy* get_ips_policy()
+{ return nullptr; }
+
+void ParseError(const char*, ...) { }
+
+char* snort_strdup(const char* s)
+{ return strdup(s); }
+
+char* snort_strndup(const char* s, size_t n)
+{ return strndup(s, n); }
+
+int SnortSnprintf(char* buf, size_t len, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, len, fmt, ap);
+    va_end(ap);
+    return 0;
+}
+}
+
+//--------------------------------------------------------------------------
+// bindings
+//--------------------------------------------------------------------------
+
+// sized like a multi-tenant deployment with a few bindings per tenant
+static constexpr unsigned num_tenants = 2000;
+static constexpr unsigned num_flows = 4096;
+
+static const char* const services[] = { "http", "ssl", "dns", "smtp" };
+
+static std::string tenant_net(unsigned t)
+{ return "10." + std::to_string(t >> 8) + "." + std::to_string(t & 255) + ".0/24"; }
+
+static void build_bindings(std::vector<Binding>& bv)
+{
+    bv.resize(4 + 2 * num_tenants + 1);
+    unsigned n = 0;
+
+    // a few global service bindings
+    for ( auto svc : services )
+    {
+        Binding& b = bv[n++];
+        b.when.svc = svc;
+        b.when.add_criteria(BindWhen::Criteria::BWC_SVC);
+    }
+
+    for ( unsigned t = 0; t < num_tenants; ++t )
+    {
+        // tenant web servers
+        Binding& web = bv[n++];
+        web.when.tenants.insert(t);
+        web.when.add_criteria(BindWhen::Criteria::BWC_TENANTS);
+        web.when.src_nets = sfip_var_from_string(tenant_net(t).c_str(), "binder_benchmark");
+        web.when.add_criteria(BindWhen::Criteria::BWC_NETS);
+        web.when.src_ports.reset();
+        web.when.src_ports.set(80);
+        web.when.src_ports.set(443);
+        web.when.add_criteria(BindWhen::Criteria::BWC_PORTS);
+        web.when.protos = PROTO_BIT__TCP;
+        web.when.add_criteria(BindWhen::Criteria::BWC_PROTO);
+
+        // tenant dns to the shared resolvers
+        Binding& dns = bv[n++];
+        dns.when.tenants.insert(t);
+        dns.when.add_criteria(BindWhen::Criteria::BWC_TENANTS);
+        dns.when.dst_nets = sfip_var_from_string("192.168.0.0/16", "binder_benchmark");
+        dns.when.dst_ports.reset();
+        dns.when.dst_ports.set(53);
+        dns.when.add_criteria(BindWhen::Criteria::BWC_SPLIT_NETS);
+        dns.when.add_criteria(BindWhen::Criteria::BWC_SPLIT_PORTS);
+        dns.when.vlans.set(t % 4096);
+        dns.when.add_criteria(BindWhen::Criteria::BWC_VLANS);
+    }
+
+    // default
+    n++;
+}
+
+//--------------------------------------------------------------------------
+// flows
+//--------------------------------------------------------------------------
+
+struct TestFlow
+{
+    Flow flow;
+    FlowKey key;
+};
+
+static void build_flows(std::vector<TestFlow>& fv)
+{
+    std::mt19937 rng(42);
+
+    for ( TestFlow& tf : fv )
+    {
+        Flow& f = tf.flow;
+        memset(&tf.key, 0, sizeof(tf.key));
+        f.key = &tf.key;
+
+        unsigned t = rng() % num_tenants;
+        f.tenant = t;
+        tf.key.vlan_tag = (rng() % 2) ? t % 4096 : 0;
+
+        // mostly tenant traffic with some strays
+        unsigned host = (rng() % 8) ? t : rng() % (num_tenants * 2);
+        uint32_t cli = htonl((10u << 24) | (host << 8) | (rng() & 255));
+        uint32_t srv = htonl((rng() % 2) ? ((192u << 24) | (168u << 16) | (rng() & 0xffff)) :
+            ((10u << 24) | (t << 8) | (rng() & 255)));
+
+        f.client_ip.set(&cli, AF_INET);
+        f.server_ip.set(&srv, AF_INET);
+
+        static const uint16_t ports[] = { 53, 80, 443, 8080 };
+        f.client_port = 1024 + rng() % 60000;
+        f.server_port = ports[rng() % 4];
+        f.pkt_type = (f.server_port == 53) ? PktType::UDP : PktType::TCP;
+        f.service = (rng() % 4) ? nullptr : services[rng() % 4];
+
+        f.client_intf = f.server_intf = 0;
+        f.client_group = f.server_group = 0;
+    }
+}
+
+//--------------------------------------------------------------------------
+// lookups
+//--------------------------------------------------------------------------
+
+static unsigned linear_match(const std::vector<Binding>& bv, const Flow& f)
+{
+    for ( unsigned i = 0; i < bv.size(); ++i )
+        if ( bv[i].check_all(f) )
+            return i;
+
+    return bv.size();
+}
+
+static unsigned indexed_match(const std::vector<Binding>& bv, const BindingIndex& index, const Flow& f)
+{
+    unsigned match = bv.size();
+
+    index.find(BindKey(f), [&](unsigned i)
+    {
+        if ( !bv[i].check_all(f) )
+            return false;
+
+        match = i;
+        return true;
+    });
+
+    return match;
+}
+
+TEST_CASE("binder bindings", "[binder]")
+{
+    std::vector<Binding> bv;
+    build_bindings(bv);
+
+    BindingIndex index;
+    index.build(bv);
+
+    std::vector<TestFlow> fv(num_flows);
+    build_flows(fv);
+
+    unsigned next = 0;
+
+    BENCHMARK("linear scan")
+    {
+        return linear_match(bv, fv[next++ % num_flows].flow);
+    };
+
+    next = 0;
+
+    BENCHMARK("indexed")
+    {
+        return indexed_match(bv, index, fv[next++ % num_flows].flow);
+    };
+
+    for ( Binding& b : bv )
+        b.clear();
+}
+
+#endif
+
@@ -0,0 +1,338 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// binding_index_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "flow/flow.h"
+#include "flow/flow_key.h"
+#include "log/messages.h"
+#include "main/policy.h"
+#include "managers/inspector_manager.h"
+#include "parser/parse_ip.h"
+#include "protocols/packet.h"
+
+#include "network_inspectors/binder/binding.h"
+#include "network_inspectors/binder/binding_index.h"
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+namespace snort
+{
+Flow::Flow() = default;
+Flow::~Flow() = default;
+
+uint16_t Packet::get_flow_vlan_id() const
+{ return 0; }
+
+Inspector* InspectorManager::get_inspector(const char*, bool, const SnortConfig*)
+{ return nullptr; }
+
+IpsPolicy* get_ips_policy()
+{ return nullptr; }
+
+void ParseError(const char*, ...) { }
+
+char* snort_strdup(const char* s)
+{ return strdup(s); }
+
+char* snort_strndup(const char* s, size_t n)
+{ return strndup(s, n); }
+
+int SnortSnprintf(char* buf, size_t len, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, len, fmt, ap);
+    va_end(ap);
+    return 0;
+}
+}
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+// small key spaces so that bindings and flows overlap often
+static const char* const services[] = { "http", "ssl", "dns" };
+
+// includes negations, mixed families, and the 0.0.0.0 special case
+static const char* const nets[] =
+{
+    "10.0.0.0/8", "10.1.0.0/16", "!10.1.2.0/24", "[10.0.0.0/8,!10.2.0.0/16]", "any",
+    "0.0.0.0/0", "0.0.0.0/8", "192.168.1.0/24", "10.1.2.3", "::/0", "fe80::/10",
+    "[10.1.0.0/16,fe80::/64]"
+};
+
+static const char* const ip4s[] =
+{ "10.1.2.3", "10.1.2.9", "10.2.3.4", "10.1.9.9", "192.168.1.1", "1.2.3.4", "0.0.0.0" };
+
+static const char* const ip6s[] = { "fe80::1", "::1", "2001::5" };
+
+template <typename T, size_t N>
+static const T& pick(std::mt19937& rng, const T (&a)[N])
+{ return a[rng() % N]; }
+
+static void set_ports(std::mt19937& rng, PortBitSet& ports)
+{
+    ports.reset();
+    ports.set(1 + rng() % 4);
+
+    // more than the index keeps so some go to the wild list
+    if ( !(rng() % 8) )
+        ports.set();
+}
+
+static void build_binding(std::mt19937& rng, BindWhen& when)
+{
+    when.role = static_cast<BindWhen::Role>(rng() % 3);
+
+    if ( !(rng() % 3) )
+    {
+        when.protos = 1u << (rng() % 6);
+        when.add_criteria(BindWhen::Criteria::BWC_PROTO);
+    }
+
+    if ( !(rng() % 3) )
+    {
+        when.svc = pick(rng, services);
+        when.add_criteria(BindWhen::Criteria::BWC_SVC);
+    }
+
+    if ( !(rng() % 4) )
+    {
+        when.vlans.set(rng() % 4);
+
+        if ( !(rng() % 5) )
+            when.vlans.set();
+
+        when.add_criteria(BindWhen::Criteria::BWC_VLANS);
+    }
+
+    if ( !(rng() % 3) )
+    {
+        when.tenants.insert(rng() % 5);
+        when.add_criteria(BindWhen::Criteria::BWC_TENANTS);
+    }
+
+    if ( !(rng() % 4) )
+    {
+        when.addr_spaces.insert(rng() % 3);
+        when.add_criteria(BindWhen::Criteria::BWC_ADDR_SPACES);
+    }
+
+    switch ( rng() % 4 )
+    {
+    case 1:
+        set_ports(rng, when.src_ports);
+        when.add_criteria(BindWhen::Criteria::BWC_PORTS);
+        break;
+    case 2:
+        set_ports(rng, when.src_ports);
+        if ( rng() % 2 )
+            set_ports(rng, when.dst_ports);
+        when.add_criteria(BindWhen::Criteria::BWC_SPLIT_PORTS);
+        break;
+    default:
+        break;
+    }
+
+    switch ( rng() % 4 )
+    {
+    case 1:
+        when.src_groups.insert(rng() % 3);
+        when.add_criteria(BindWhen::Criteria::BWC_GROUPS);
+        break;
+    case 2:
+        if ( rng() % 2 )
+            when.src_groups.insert(rng() % 3);
+        if ( rng() % 2 )
+            when.dst_groups.insert(rng() % 3);
+        when.add_criteria(BindWhen::Criteria::BWC_SPLIT_GROUPS);
+        break;
+    default:
+        break;
+    }
+
+    switch ( rng() % 4 )
+    {
+    case 1:
+        when.src_intfs.insert(rng() % 3);
+        when.add_criteria(BindWhen::Criteria::BWC_INTFS);
+        break;
+    case 2:
+        if ( rng() % 2 )
+            when.src_intfs.insert(rng() % 3);
+        if ( rng() % 2 )
+            when.dst_intfs.insert(rng() % 3);
+        when.add_criteria(BindWhen::Criteria::BWC_SPLIT_INTFS);
+        break;
+    default:
+        break;
+    }
+
+    switch ( rng() % 3 )
+    {
+    case 1:
+        when.src_nets = sfip_var_from_string(pick(rng, nets), "binding_index_test");
+        when.add_criteria(BindWhen::Criteria::BWC_NETS);
+        break;
+    case 2:
+        if ( rng() % 2 )
+            when.src_nets = sfip_var_from_string(pick(rng, nets), "binding_index_test");
+        if ( rng() % 2 )
+            when.dst_nets = sfip_var_from_string(pick(rng, nets), "binding_index_test");
+        when.add_criteria(BindWhen::Criteria::BWC_SPLIT_NETS);
+        break;
+    default:
+        break;
+    }
+}
+
+struct TestFlow
+{
+    Flow flow;
+    FlowKey key;
+};
+
+static void build_flow(std::mt19937& rng, TestFlow& tf)
+{
+    Flow& f = tf.flow;
+    memset(&tf.key, 0, sizeof(tf.key));
+    f.key = &tf.key;
+
+    tf.key.vlan_tag = rng() % 5;
+    tf.key.addressSpaceId = rng() % 3;
+    f.tenant = rng() % 5;
+
+    if ( rng() % 4 )
+    {
+        f.client_ip.set(pick(rng, ip4s));
+        f.server_ip.set(pick(rng, ip4s));
+    }
+    else
+    {
+        f.client_ip.set(pick(rng, ip6s));
+        f.server_ip.set(pick(rng, ip6s));
+    }
+
+    f.client_port = rng() % 5;
+    f.server_port = rng() % 5;
+    f.pkt_type = static_cast<PktType>(1 + rng() % 6);
+    f.service = (rng() % 2) ? nullptr : pick(rng, services);
+
+    f.client_group = rng() % 3;
+    f.server_group = rng() % 3;
+    f.client_intf = rng() % 3;
+    f.server_intf = rng() % 3;
+}
+
+// all matches, not just the first, so a candidate missing after an
+// earlier match is still caught
+static std::vector<unsigned> linear_matches(
+    const std::vector<Binding>& bv, const Flow& f, const char* svc)
+{
+    std::vector<unsigned> matches;
+
+    for ( unsigned i = 0; i < bv.size(); ++i )
+        if ( bv[i].check_all(f, svc) )
+            matches.emplace_back(i);
+
+    return matches;
+}
+
+static std::vector<unsigned> indexed_matches(
+    const std::vector<Binding>& bv, const BindingIndex& index, const Flow& f, const char* svc)
+{
+    std::vector<unsigned> matches;
+
+    index.find(BindKey(f, svc), [&](unsigned i)
+    {
+        if ( bv[i].check_all(f, svc) )
+            matches.emplace_back(i);
+
+        return false;
+    });
+
+    return matches;
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_CASE("index matches linear walk", "[binder]")
+{
+    std::mt19937 rng(7);
+
+    for ( unsigned round = 0; round < 20; ++round )
+    {
+        std::vector<Binding> bv(300);
+
+        for ( Binding& b : bv )
+            build_binding(rng, b.when);
+
+        BindingIndex index;
+        index.build(bv);
+
+        for ( unsigned n = 0; n < 1000; ++n )
+        {
+            TestFlow tf;
+            build_flow(rng, tf);
+
+            // flow service and an explicit service from a service change
+            CHECK(indexed_matches(bv, index, tf.flow, nullptr) ==
+                linear_matches(bv, tf.flow, nullptr));
+
+            const char* svc = pick(rng, services);
+
+            CHECK(indexed_matches(bv, index, tf.flow, svc) ==
+                linear_matches(bv, tf.flow, svc));
+        }
+
+        for ( Binding& b : bv )
+            b.clear();
+    }
+}
+
+TEST_CASE("no bindings", "[binder]")
+{
+    std::vector<Binding> bv;
+    BindingIndex index;
+    index.build(bv);
+
+    std::mt19937 rng(7);
+    TestFlow tf;
+    build_flow(rng, tf);
+
+    CHECK(indexed_matches(bv, index, tf.flow, nullptr).empty());
+}
@@ -49,6 +49,9 @@ static const Parameter s_capture[] =
     { "group", Parameter::PT_INT, "-1:32767", "-1",
       "group filter to use for the packet dump" },
 
+    { "ring_size", Parameter::PT_INT, "1:1024", "8",
+      "per thread buffer for packets waiting to be written in megabytes" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -74,6 +77,7 @@ static const PegInfo cap_names[] =
 {
     { CountType::SUM, "processed", "packets processed against filter" },
     { CountType::SUM, "captured", "packets matching dumped after matching filter" },
+    { CountType::SUM, "dropped", "packets not captured because the capture ring was full" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -140,6 +144,7 @@ CaptureModule::CaptureModule() :
 {
     config.enabled = false;
     config.group = -1;
+    config.ring_size = 8 * 1024 * 1024;
 }
 
 bool CaptureModule::set(const char*, Value& v, SnortConfig*)
@@ -153,6 +158,9 @@ bool CaptureModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("group") )
         config.group = v.get_int16();
 
+    else if ( v.is("ring_size") )
+        config.ring_size = v.get_size() * 1024 * 1024;
+
     return true;
 }
 
@@ -30,6 +30,7 @@ struct CaptureConfig
 {
     bool enabled;
     int16_t group;
+    size_t ring_size;
     std::string filter;
 };
 
@@ -37,6 +38,7 @@ struct CaptureStats
 {
     PegCount checked;
     PegCount matched;
+    PegCount dropped;
 };
 
 class CaptureModule : public snort::Module
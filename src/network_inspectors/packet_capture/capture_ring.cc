@@ -0,0 +1,434 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// capture_ring.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "capture_ring.h"
+
+#include <pcap.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include "log/messages.h"
+
+#ifdef UNIT_TEST
+#include <unistd.h>
+#include "catch/snort_catch.h"
+#endif
+
+// pcapng block types
+#define PCAPNG_SHB 0x0A0D0D0A
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+
+#define PCAPNG_BOM 0x1A2B3C4D
+
+static inline uint32_t align(uint32_t n, uint32_t a)
+{ return (n + a - 1) & ~(a - 1); }
+
+//-------------------------------------------------------------------------
+// ring
+//-------------------------------------------------------------------------
+
+CaptureRing::CaptureRing(size_t sz, uint32_t snap) : snap_len(snap)
+{
+    size_t min = 4 * align(sizeof(CaptureRecord) + snap_len, 8);
+    size = 4096;
+
+    while ( size < sz or size < min )
+        size <<= 1;
+
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if ( map != MAP_FAILED )
+        buf = (uint8_t*)map;
+}
+
+CaptureRing::~CaptureRing()
+{
+    close();
+
+    if ( buf )
+        munmap(buf, size);
+}
+
+bool CaptureRing::open(const std::string& file)
+{
+    if ( !buf or fh )
+        return false;
+
+    fh = fopen(file.c_str(), "w");
+
+    if ( !fh )
+        return false;
+
+    file_name = file;
+    write_failed = false;
+
+    const uint32_t shb[] =
+    {
+        PCAPNG_SHB, 28, PCAPNG_BOM, 1,   // version 1.0
+        0xFFFFFFFF, 0xFFFFFFFF,          // section length unspecified
+        28
+    };
+    write_block(shb, sizeof(shb));
+
+    // link type is 16 bits followed by 16 reserved bits
+    // FIXIT-L use the DLT from DAQ rather then hard coding DLT_EN10MB
+    const struct
+    {
+        uint32_t type;
+        uint32_t len;
+        uint16_t linktype;
+        uint16_t reserved;
+        uint32_t snap_len;
+        uint32_t trailer;
+    } idb = { PCAPNG_IDB, 20, DLT_EN10MB, 0, snap_len, 20 };
+
+    static_assert(sizeof(idb) == 20, "pcapng idb must not be padded");
+    write_block(&idb, sizeof(idb));
+
+    fflush(fh);
+    return true;
+}
+
+void CaptureRing::close()
+{
+    if ( !fh )
+        return;
+
+    drain();
+    fclose(fh);
+    fh = nullptr;
+}
+
+void CaptureRing::write_block(const void* data, size_t len)
+{
+    // write errors are not recoverable here; the ring keeps draining regardless
+    // so packet threads don't stall but the first failure is reported
+    if ( fwrite(data, len, 1, fh) == 1 or write_failed )
+        return;
+
+    write_failed = true;
+    snort::WarningMessage("packet_capture: failed to write %s: %s\n",
+        file_name.c_str(), strerror(errno));
+}
+
+bool CaptureRing::put(const DAQ_PktHdr_t* pkth, const uint8_t* data, uint32_t caplen)
+{
+    if ( caplen > snap_len )
+        caplen = snap_len;
+
+    uint32_t need = align(sizeof(CaptureRecord) + caplen, 8);
+    uint64_t h = head.load(std::memory_order_relaxed);
+    uint64_t t = tail.load(std::memory_order_acquire);
+
+    size_t pos = h & (size - 1);
+    size_t skip = (pos + need > size) ? size - pos : 0;
+
+    if ( (h - t) + skip + need > size )
+        return false;
+
+    if ( skip )
+    {
+        // record sizes are 8 byte multiples so there is always room for the marker
+        ((CaptureRecord*)(buf + pos))->size = 0;
+        pos = 0;
+    }
+
+    CaptureRecord* rec = (CaptureRecord*)(buf + pos);
+    rec->size = need;
+    rec->caplen = caplen;
+    rec->pktlen = pkth->pktlen;
+    rec->reserved = 0;
+    rec->ts_usec = (uint64_t)pkth->ts.tv_sec * 1000000 + pkth->ts.tv_usec;
+
+    memcpy(rec + 1, data, caplen);
+
+    head.store(h + skip + need, std::memory_order_release);
+    return true;
+}
+
+unsigned CaptureRing::drain()
+{
+    uint64_t h = head.load(std::memory_order_acquire);
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    unsigned n = 0;
+
+    while ( t < h )
+    {
+        size_t pos = t & (size - 1);
+        const CaptureRecord* rec = (const CaptureRecord*)(buf + pos);
+
+        if ( !rec->size )
+        {
+            t += size - pos;
+            continue;
+        }
+
+        if ( fh )
+        {
+            uint32_t dlen = align(rec->caplen, 4);
+            uint32_t blen = 32 + dlen;
+
+            const uint32_t epb[] =
+            {
+                PCAPNG_EPB, blen, 0,   // interface 0
+                (uint32_t)(rec->ts_usec >> 32), (uint32_t)rec->ts_usec,
+                rec->caplen, rec->pktlen
+            };
+            static const uint8_t zero[4] = { };
+
+            write_block(epb, sizeof(epb));
+            write_block(rec + 1, rec->caplen);
+
+            if ( dlen > rec->caplen )
+                write_block(zero, dlen - rec->caplen);
+
+            write_block(&blen, sizeof(blen));
+        }
+        t += rec->size;
+        tail.store(t, std::memory_order_release);
+        ++n;
+    }
+
+    if ( n and fh )
+        fflush(fh);
+
+    return n;
+}
+
+//-------------------------------------------------------------------------
+// writer
+//-------------------------------------------------------------------------
+
+std::mutex CaptureWriter::ring_mutex;
+std::mutex CaptureWriter::drain_mutex;
+std::condition_variable CaptureWriter::ring_cv;
+std::thread* CaptureWriter::writer = nullptr;
+std::vector<CaptureRing*> CaptureWriter::rings;
+bool CaptureWriter::running = false;
+
+void CaptureWriter::writer_thread()
+{
+    std::vector<CaptureRing*> snap;
+    std::unique_lock<std::mutex> lk(ring_mutex);
+
+    while ( running )
+    {
+        snap = rings;
+        lk.unlock();
+
+        unsigned n = 0;
+
+        for ( auto* r : snap )
+        {
+            std::lock_guard<std::mutex> dlk(drain_mutex);
+
+            // skip rings removed since the snapshot
+            {
+                std::lock_guard<std::mutex> rlk(ring_mutex);
+
+                if ( std::find(rings.begin(), rings.end(), r) == rings.end() )
+                    continue;
+            }
+            n += r->drain();
+        }
+
+        lk.lock();
+
+        // poll rather than signal from packet threads to keep put() lock free
+        if ( !n and running )
+            ring_cv.wait_for(lk, std::chrono::milliseconds(10));
+    }
+}
+
+void CaptureWriter::add(CaptureRing* r)
+{
+    std::lock_guard<std::mutex> lk(ring_mutex);
+    rings.emplace_back(r);
+
+    if ( !writer )
+    {
+        running = true;
+        writer = new std::thread(writer_thread);
+    }
+}
+
+void CaptureWriter::remove(CaptureRing* r)
+{
+    {
+        std::lock_guard<std::mutex> lk(ring_mutex);
+        auto it = std::find(rings.begin(), rings.end(), r);
+
+        if ( it != rings.end() )
+            rings.erase(it);
+    }
+
+    // wait out a drain that started before the ring was removed; later
+    // drains see it is gone
+    std::lock_guard<std::mutex> dlk(drain_mutex);
+}
+
+void CaptureWriter::term()
+{
+    {
+        std::lock_guard<std::mutex> lk(ring_mutex);
+        running = false;
+    }
+    ring_cv.notify_one();
+
+    if ( writer )
+    {
+        writer->join();
+        delete writer;
+        writer = nullptr;
+    }
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+static unsigned count_epbs(const char* name)
+{
+    FILE* fh = fopen(name, "r");
+    REQUIRE(fh);
+
+    unsigned n = 0;
+    uint32_t hdr[2];
+
+    while ( fread(hdr, sizeof(hdr), 1, fh) == 1 )
+    {
+        if ( hdr[0] == PCAPNG_EPB )
+            ++n;
+
+        fseek(fh, hdr[1] - sizeof(hdr), SEEK_CUR);
+    }
+    fclose(fh);
+    return n;
+}
+
+TEST_CASE("capture ring", "[PacketCapture]")
+{
+    char name[] = "/tmp/capture_ring_XXXXXX";
+    int fd = mkstemp(name);
+    REQUIRE(fd >= 0);
+    ::close(fd);
+
+    uint8_t data[1000];
+    memset(data, 0xa5, sizeof(data));
+
+    DAQ_PktHdr_t pkth = { };
+    pkth.pktlen = sizeof(data);
+
+    CaptureRing ring(0, sizeof(data));
+    REQUIRE(ring.open(name));
+
+    unsigned slots = ring.get_size() / align(sizeof(CaptureRecord) + sizeof(data), 8);
+    REQUIRE(slots >= 4);
+
+    SECTION("full ring drops")
+    {
+        for ( unsigned i = 0; i < slots; ++i )
+            CHECK(ring.put(&pkth, data, sizeof(data)));
+
+        CHECK(!ring.put(&pkth, data, sizeof(data)));
+        CHECK(ring.drain() == slots);
+        CHECK(ring.put(&pkth, data, sizeof(data)));
+        ring.close();
+        CHECK(count_epbs(name) == slots + 1);
+    }
+    SECTION("wrap")
+    {
+        unsigned total = 0;
+
+        for ( unsigned i = 0; i < 3 * slots; ++i )
+        {
+            // odd lengths exercise padding and wrap markers
+            uint32_t len = 1 + (i * 37) % sizeof(data);
+
+            if ( !ring.put(&pkth, data, len) )
+            {
+                total += ring.drain();
+                CHECK(ring.put(&pkth, data, len));
+            }
+        }
+        total += ring.drain();
+        CHECK(total == 3 * slots);
+        ring.close();
+        CHECK(count_epbs(name) == 3 * slots);
+    }
+    SECTION("snap length")
+    {
+        CHECK(ring.put(&pkth, data, sizeof(data) + 1));
+        CHECK(ring.drain() == 1);
+    }
+    SECTION("interface block")
+    {
+        ring.close();
+
+        FILE* fh = fopen(name, "r");
+        REQUIRE(fh);
+
+        // skip the section header block
+        uint8_t idb[20];
+        REQUIRE(fseek(fh, 28, SEEK_SET) == 0);
+        REQUIRE(fread(idb, sizeof(idb), 1, fh) == 1);
+        fclose(fh);
+
+        uint32_t type;
+        uint16_t link[2];
+        memcpy(&type, idb, sizeof(type));
+        memcpy(link, idb + 8, sizeof(link));
+
+        CHECK(type == PCAPNG_IDB);
+        CHECK(link[0] == DLT_EN10MB);
+        CHECK(link[1] == 0);
+    }
+    SECTION("writer")
+    {
+        CaptureWriter::add(&ring);
+
+        unsigned n = 0;
+
+        for ( unsigned i = 0; i < 4 * slots; ++i )
+            if ( ring.put(&pkth, data, sizeof(data)) )
+                ++n;
+
+        CaptureWriter::remove(&ring);
+
+        // the ring is ours again so whatever the writer left is drained here
+        ring.close();
+        CaptureWriter::term();
+        CHECK(count_epbs(name) == n);
+    }
+    unlink(name);
+}
+#endif
+
@@ -0,0 +1,109 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// capture_ring.h
+
+#ifndef CAPTURE_RING_H
+#define CAPTURE_RING_H
+
+// Each packet thread copies captured packets into its own single producer,
+// single consumer ring.  A background writer thread drains all rings to
+// per thread pcapng files so that file I/O never stalls packet processing.
+// When a ring is full the packet is dropped from the capture instead.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <daq_common.h>
+
+struct CaptureRecord
+{
+    uint32_t size;      // including this header, 8 byte aligned; 0 => skip to ring start
+    uint32_t caplen;
+    uint32_t pktlen;
+    uint32_t reserved;
+    uint64_t ts_usec;
+};
+
+class CaptureRing
+{
+public:
+    // size is rounded up to a power of 2 large enough for a few snap_len packets
+    CaptureRing(size_t size, uint32_t snap_len);
+    ~CaptureRing();
+
+    bool open(const std::string& file);
+    void close();
+
+    // packet thread only
+    bool put(const DAQ_PktHdr_t*, const uint8_t* data, uint32_t caplen);
+
+    // writer thread only, or the packet thread after the ring was removed from the writer
+    unsigned drain();
+
+    size_t get_size() const
+    { return size; }
+
+private:
+    void write_block(const void*, size_t);
+
+private:
+    uint8_t* buf = nullptr;
+    size_t size = 0;
+    uint32_t snap_len;
+    FILE* fh = nullptr;
+    std::string file_name;
+    bool write_failed = false;
+
+    std::atomic<uint64_t> head { 0 };    // advanced by producer
+    uint8_t pad[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t> tail { 0 };    // advanced by consumer
+};
+
+class CaptureWriter
+{
+public:
+    // the writer thread is started with the first ring
+    static void add(CaptureRing*);
+
+    // on return the ring is no longer accessed by the writer thread
+    static void remove(CaptureRing*);
+
+    static void term();
+
+private:
+    static void writer_thread();
+
+    // ring_mutex guards the ring list and is never held across file I/O;
+    // drain_mutex is held while a ring is drained so remove() can wait for it
+    static std::mutex ring_mutex;
+    static std::mutex drain_mutex;
+    static std::condition_variable ring_cv;
+    static std::thread* writer;
+    static std::vector<CaptureRing*> rings;
+    static bool running;
+};
+
+#endif
+
@@ -35,11 +35,12 @@
 #endif
 
 #include "capture_module.h"
+#include "capture_ring.h"
 
 using namespace snort;
 using namespace std;
 
-#define FILE_NAME "packet_capture.pcap"
+#define FILE_NAME "packet_capture.pcapng"
 #define SNAP_LEN 65535
 
 // -----------------------------------------------------------------------------
@@ -48,8 +49,7 @@ using namespace std;
 
 static CaptureConfig config;
 
-static THREAD_LOCAL pcap_t* pcap = nullptr;
-static THREAD_LOCAL pcap_dumper_t* dumper = nullptr;
+static THREAD_LOCAL CaptureRing* ring = nullptr;
 static THREAD_LOCAL struct bpf_program bpf;
 
 // -----------------------------------------------------------------------------
@@ -57,19 +57,16 @@ static THREAD_LOCAL struct bpf_program bpf;
 // -----------------------------------------------------------------------------
 
 static inline bool capture_initialized()
-{ return dumper != nullptr; }
+{ return ring != nullptr; }
 
 static void _capture_term()
 {
-    if ( dumper )
+    if ( ring )
     {
-        pcap_dump_close(dumper);
-        dumper = nullptr;
-    }
-    if ( pcap )
-    {
-        free(pcap);
-        pcap = nullptr;
+        // remaining packets are written by this thread
+        CaptureWriter::remove(ring);
+        delete ring;
+        ring = nullptr;
     }
     pcap_freecode(&bpf);
 }
@@ -91,19 +88,22 @@ static bool bpf_compile_and_validate()
     return false;
 }
 
-static bool open_pcap_dumper()
+static bool open_capture_ring()
 {
     string fname;
     get_instance_file(fname, FILE_NAME);
 
-    pcap = pcap_open_dead(DLT_EN10MB, SNAP_LEN);
-    dumper = pcap ? pcap_dump_open(pcap, fname.c_str()) : nullptr;
+    ring = new CaptureRing(config.ring_size, SNAP_LEN);
 
-    if (dumper)
+    if ( ring->open(fname) )
+    {
+        CaptureWriter::add(ring);
         return true;
-    else
-        WarningMessage("Could not initialize dump file\n");
+    }
+    WarningMessage("Could not initialize dump file\n");
 
+    delete ring;
+    ring = nullptr;
     return false;
 }
 
@@ -139,7 +139,7 @@ void packet_capture_enable(const string& f, const int16_t g)
     {
         if (bpf_compile_and_validate())
         {
-            if (open_pcap_dumper())
+            if (open_capture_ring())
             {
                 LogMessage("Packet capture enabled\n");
                 return;
@@ -177,7 +177,7 @@ public:
 protected:
     virtual bool capture_init();
     virtual void capture_term();
-    virtual void write_packet(Packet* p);
+    virtual bool write_packet(Packet* p);
 };
 
 PacketCapture::PacketCapture(CaptureModule* m)
@@ -189,7 +189,7 @@ bool PacketCapture::capture_init()
 {
     if (bpf_compile_and_validate())
     {
-        if (open_pcap_dumper())
+        if (open_capture_ring())
         {
             LogMessage("Packet capture enabled\n");
             return true;
@@ -204,6 +204,7 @@ void PacketCapture::show(const SnortConfig*) const
     ConfigLogger::log_flag("enable", config.enabled);
     if ( config.enabled )
         ConfigLogger::log_value("filter", config.filter.c_str());
+    ConfigLogger::log_value("ring_size", config.ring_size);
 }
 
 void PacketCapture::eval(Packet* p)
@@ -226,8 +227,8 @@ void PacketCapture::eval(Packet* p)
         if ( !bpf.bf_insns || bpf_filter(bpf.bf_insns, p->pkt,
                 p->pktlen, p->pkth->pktlen) )
         {
-            write_packet(p);
-            cap_count_stats.matched++;
+            if ( write_packet(p) )
+                cap_count_stats.matched++;
         }
 
         cap_count_stats.checked++;
@@ -236,14 +237,14 @@ void PacketCapture::eval(Packet* p)
         capture_term();
 }
 
-void PacketCapture::write_packet(Packet* p)
+bool PacketCapture::write_packet(Packet* p)
 {
-    struct pcap_pkthdr pcaphdr;
-    pcaphdr.ts = p->pkth->ts;
-    pcaphdr.caplen = p->pktlen;
-    pcaphdr.len = p->pkth->pktlen;
-    pcap_dump((unsigned char*)dumper, &pcaphdr, p->pkt);
-    pcap_dump_flush(dumper);
+    // the packet is copied since DAQ buffers are released when the packet is finalized
+    if ( ring->put(p->pkth, p->pkt, p->pktlen) )
+        return true;
+
+    cap_count_stats.dropped++;
+    return false;
 }
 
 //-------------------------------------------------------------------------
@@ -262,6 +263,9 @@ static Inspector* pc_ctor(Module* m)
 static void pc_dtor(Inspector* p)
 { delete p; }
 
+static void pc_term()
+{ CaptureWriter::term(); }
+
 static const InspectApi pc_api =
 {
     {
@@ -281,7 +285,7 @@ static const InspectApi pc_api =
     nullptr, // buffers
     nullptr, // service
     nullptr, // pinit
-    nullptr, // pterm
+    pc_term,
     nullptr, // tinit
     nullptr, // tterm
     pc_ctor,
@@ -322,22 +326,28 @@ class MockPacketCapture : public PacketCapture
 {
 public:
     bool write_packet_called = false;
+    bool full = false;
     vector<Packet*> pcap;
 
     MockPacketCapture(CaptureModule* m) : PacketCapture(m) {}
 
 protected:
-    void write_packet(Packet* p) override
+    bool write_packet(Packet* p) override
     {
-        pcap.emplace_back(p);
         write_packet_called = true;
+
+        if ( full )
+            return false;
+
+        pcap.emplace_back(p);
+        return true;
     }
 
     bool capture_init() override
     {
         if (bpf_compile_and_validate())
         {
-            dumper = (pcap_dumper_t*)1;
+            ring = (CaptureRing*)1;
             return true;
         }
         _packet_capture_disable();
@@ -347,7 +357,7 @@ protected:
 
     void capture_term() override
     {
-        dumper = nullptr;
+        ring = nullptr;
         PacketCapture::capture_term();
     }
 };
@@ -526,7 +536,14 @@ TEST_CASE("bpf filter", "[PacketCapture]")
     cap.eval(&p_match);
     CHECK ( cap.write_packet_called );
 
-    CHECK ( (cap_count_stats.checked == 3) );
+    // a packet that is not queued is not counted as captured
+    cap.full = true;
+    cap.write_packet_called = false;
+    cap.eval(&p_match);
+    CHECK ( cap.write_packet_called );
+    cap.full = false;
+
+    CHECK ( (cap_count_stats.checked == 4) );
     CHECK ( (cap_count_stats.matched == 2) );
 
     REQUIRE ( (cap.pcap.size() >= 2) );
@@ -0,0 +1,300 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// latency_tracker.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "latency_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "profiler/profiler.h"
+#include "time/clock_defs.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+#define TRACKER_NAME PERF_NAME "_latency"
+
+using namespace snort;
+
+static const char* const stage_names[LatencyTracker::MAX_STAGE] =
+{ "decode", "stream", "inspectors", "detection", "logging", "packet" };
+
+//-------------------------------------------------------------------------
+// histogram
+//-------------------------------------------------------------------------
+
+void LatencyHistogram::reset()
+{
+    memset(counts, 0, sizeof(counts));
+    count = 0;
+    max = 0;
+}
+
+uint64_t LatencyHistogram::get_upper(unsigned index)
+{
+    unsigned group = index >> sub_bits;
+    uint64_t sub = index & ((1u << sub_bits) - 1);
+
+    if ( !group )
+        return sub;
+
+    return (((1ull << sub_bits) + sub + 1) << (group - 1)) - 1;
+}
+
+uint64_t LatencyHistogram::get_percentile(double fraction) const
+{
+    if ( !count )
+        return 0;
+
+    uint64_t target = std::ceil(fraction * count);
+    uint64_t sum = 0;
+
+    if ( !target )
+        target = 1;
+
+    for ( unsigned i = 0; i < num_buckets; ++i )
+    {
+        sum += counts[i];
+
+        if ( sum >= target )
+            return std::min(get_upper(i), max);
+    }
+    return max;
+}
+
+//-------------------------------------------------------------------------
+// tracker
+//-------------------------------------------------------------------------
+
+// top level profiler nodes by stage; the daq node is time spent waiting
+// for packets and other is time outside any node so neither is included
+static LatencyTracker::Stage get_stage(const std::string& name)
+{
+    if ( name == "decode" )
+        return LatencyTracker::DECODE;
+
+    if ( name == "stream" )
+        return LatencyTracker::STREAM;
+
+    if ( name == "mpse" or name == "rule_eval" )
+        return LatencyTracker::DETECTION;
+
+    if ( name == "eventq" )
+        return LatencyTracker::LOGGING;
+
+    if ( name == "daq" or name == ROOT_NODE or name == FLEX_NODE )
+        return LatencyTracker::MAX_STAGE;
+
+    return LatencyTracker::INSPECTORS;
+}
+
+static inline uint64_t get_nsecs(uint64_t ticks)
+{
+#ifdef USE_TSC_CLOCK
+    return ticks * 1000 / clock_scale();
+#else
+    return TO_NSECS(hr_duration(ticks));
+#endif
+}
+
+LatencyTracker::LatencyTracker(PerfConfig* perf) : PerfTracker(perf, TRACKER_NAME)
+{
+    ProfilerSubtrees trees;
+    Profiler::get_thread_subtrees(trees);
+
+    for ( const auto& tree : trees )
+    {
+        Stage stage = get_stage(tree.first);
+
+        if ( stage < PACKET )
+            stage_stats[stage].insert(stage_stats[stage].end(),
+                tree.second.begin(), tree.second.end());
+    }
+
+    for ( unsigned i = 0; i < MAX_STAGE; ++i )
+    {
+        formatter->register_section(stage_names[i]);
+        formatter->register_field("p50", &fields[i].p50);
+        formatter->register_field("p99", &fields[i].p99);
+        formatter->register_field("p99.9", &fields[i].p999);
+        formatter->register_field("max", &fields[i].max);
+    }
+    formatter->finalize_fields();
+}
+
+// profiles are exclusive so each node only has its own time and the nodes
+// of a stage can be summed without counting nested work twice
+void LatencyTracker::get_stage_times(uint64_t* times)
+{
+    for ( unsigned i = 0; i < PACKET; ++i )
+    {
+        hr_duration sum = CLOCK_ZERO;
+
+        for ( const auto* ps : stage_stats[i] )
+            sum += ps->time.elapsed;
+
+        times[i] = TO_TICKS(sum);
+    }
+}
+
+void LatencyTracker::reset()
+{
+    get_stage_times(last);
+}
+
+void LatencyTracker::update(Packet*)
+{
+    uint64_t now[PACKET];
+    uint64_t total = 0;
+
+    get_stage_times(now);
+
+    for ( unsigned i = 0; i < PACKET; ++i )
+    {
+        // profiler stats may have been reset under us
+        uint64_t delta = (now[i] >= last[i]) ? get_nsecs(now[i] - last[i]) : 0;
+
+        hist[i].add(delta);
+        total += delta;
+        last[i] = now[i];
+    }
+    hist[PACKET].add(total);
+}
+
+void LatencyTracker::process(bool summary)
+{
+    for ( unsigned i = 0; i < MAX_STAGE; ++i )
+    {
+        fields[i].p50 = hist[i].get_percentile(0.5);
+        fields[i].p99 = hist[i].get_percentile(0.99);
+        fields[i].p999 = hist[i].get_percentile(0.999);
+        fields[i].max = hist[i].get_max();
+    }
+
+    write();
+
+    if ( !summary )
+    {
+        for ( auto& h : hist )
+            h.reset();
+    }
+}
+
+#ifdef UNIT_TEST
+
+class TestLatencyTracker : public LatencyTracker
+{
+public:
+    uint64_t times[PACKET] = { };
+    PerfFormatter* output;
+
+    TestLatencyTracker(PerfConfig* perf) : LatencyTracker(perf)
+    { output = formatter; }
+
+protected:
+    void get_stage_times(uint64_t* t) override
+    { memcpy(t, times, sizeof(times)); }
+};
+
+TEST_CASE("histogram buckets", "[latency_tracker]")
+{
+    for ( uint64_t v : { 0ull, 1ull, 31ull, 32ull, 33ull, 63ull, 64ull, 1000ull, 123456789ull } )
+    {
+        unsigned i = LatencyHistogram::get_index(v);
+        INFO("value " << v);
+        CHECK(v <= LatencyHistogram::get_upper(i));
+
+        if ( i )
+            CHECK(v > LatencyHistogram::get_upper(i - 1));
+    }
+
+    CHECK(LatencyHistogram::get_index(1ull << 50) == LatencyHistogram::num_buckets - 1);
+}
+
+TEST_CASE("histogram percentiles", "[latency_tracker]")
+{
+    LatencyHistogram* h = new LatencyHistogram;
+
+    CHECK(h->get_percentile(0.5) == 0);
+
+    for ( uint64_t v = 1; v <= 10000; ++v )
+        h->add(v);
+
+    CHECK(h->get_count() == 10000);
+    CHECK(h->get_max() == 10000);
+
+    // within the 1/32 bucket width
+    CHECK(h->get_percentile(0.5) >= 5000);
+    CHECK(h->get_percentile(0.5) <= 5000 + 5000 / 32);
+    CHECK(h->get_percentile(0.99) >= 9900);
+    CHECK(h->get_percentile(0.99) <= 9900 + 9900 / 32);
+    CHECK(h->get_percentile(1.0) == 10000);
+
+    h->reset();
+    CHECK(h->get_count() == 0);
+    CHECK(h->get_max() == 0);
+
+    delete h;
+}
+
+TEST_CASE("latency process and output", "[latency_tracker]")
+{
+    PerfConfig config;
+    config.format = PerfFormat::MOCK;
+    TestLatencyTracker tracker(&config);
+    MockFormatter* formatter = (MockFormatter*)tracker.output;
+
+    const uint64_t fast = get_nsecs(1000);
+    const uint64_t slow = get_nsecs(100000);
+
+    tracker.reset();
+
+    for ( unsigned n = 1; n <= 100; ++n )
+    {
+        tracker.times[LatencyTracker::DECODE] += 1000;
+        tracker.times[LatencyTracker::DETECTION] += (n == 100) ? 100000 : 0;
+        tracker.update(nullptr);
+    }
+    tracker.process(false);
+
+    CHECK(*formatter->public_values["decode.p50"].pc == fast);
+    CHECK(*formatter->public_values["decode.max"].pc == fast);
+    CHECK(*formatter->public_values["detection.p50"].pc == 0);
+    CHECK(*formatter->public_values["detection.p99"].pc == 0);
+    CHECK(*formatter->public_values["detection.p99.9"].pc == slow);
+    CHECK(*formatter->public_values["stream.max"].pc == 0);
+
+    unsigned idx = LatencyHistogram::get_index(fast);
+    CHECK(*formatter->public_values["packet.p50"].pc == LatencyHistogram::get_upper(idx));
+    CHECK(*formatter->public_values["packet.max"].pc == fast + slow);
+
+    // the histograms start over each interval
+    tracker.process(false);
+    CHECK(*formatter->public_values["packet.max"].pc == 0);
+}
+
+#endif
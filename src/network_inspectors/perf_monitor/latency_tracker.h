@@ -0,0 +1,130 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// latency_tracker.h
+
+#ifndef LATENCY_TRACKER_H
+#define LATENCY_TRACKER_H
+
+// LatencyTracker keeps a per packet latency distribution for each stage of
+// processing and reports the tail percentiles at each interval. Stage times
+// come from the thread local profiler stats so exclusive time profiling is
+// enabled when this tracker is configured.
+
+#include <vector>
+
+#include "perf_tracker.h"
+
+namespace snort
+{
+struct ProfileStats;
+}
+
+// log-linear buckets in the style of HdrHistogram: each power of two range
+// is split into 2^sub_bits buckets so the relative error is below 1/32
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned sub_bits = 5;
+    static constexpr unsigned max_bits = 40;
+    static constexpr unsigned num_buckets = (max_bits - sub_bits + 1) << sub_bits;
+
+    LatencyHistogram()
+    { reset(); }
+
+    void add(uint64_t v)
+    {
+        ++counts[get_index(v)];
+        ++count;
+
+        if ( v > max )
+            max = v;
+    }
+
+    void reset();
+
+    // the upper bound of the bucket holding the given fraction of values
+    uint64_t get_percentile(double) const;
+
+    uint64_t get_count() const
+    { return count; }
+
+    uint64_t get_max() const
+    { return max; }
+
+    static unsigned get_index(uint64_t v)
+    {
+        if ( v < (1ull << sub_bits) )
+            return v;
+
+        unsigned msb = 63 - __builtin_clzll(v);
+
+        if ( msb >= max_bits )
+            return num_buckets - 1;
+
+        unsigned group = msb - sub_bits + 1;
+        unsigned sub = (v >> (msb - sub_bits)) - (1u << sub_bits);
+
+        return (group << sub_bits) + sub;
+    }
+
+    static uint64_t get_upper(unsigned index);
+
+private:
+    uint64_t counts[num_buckets];
+    uint64_t count;
+    uint64_t max;
+};
+
+class LatencyTracker : public PerfTracker
+{
+public:
+    enum Stage
+    {
+        DECODE, STREAM, INSPECTORS, DETECTION, LOGGING, PACKET, MAX_STAGE
+    };
+
+    LatencyTracker(PerfConfig*);
+
+    void reset() override;
+    void update(snort::Packet*) override;
+    void process(bool) override;
+
+protected:
+    // the current profiled ticks for each stage except the packet total,
+    // which is the sum of the other stages
+    virtual void get_stage_times(uint64_t*);
+
+private:
+    struct Fields
+    {
+        PegCount p50;
+        PegCount p99;
+        PegCount p999;
+        PegCount max;
+    };
+
+    std::vector<const snort::ProfileStats*> stage_stats[PACKET];
+    uint64_t last[PACKET] = { };
+
+    LatencyHistogram hist[MAX_STAGE];
+    Fields fields[MAX_STAGE] = { };
+};
+
+#endif
+
@@ -67,6 +67,10 @@ static const Parameter s_params[] =
     { "flow_ip", Parameter::PT_BOOL, nullptr, "false",
       "enable statistics on host pairs" },
 
+    { "latency", Parameter::PT_BOOL, nullptr, "false",
+      "enable per packet latency percentiles by processing stage (ns); "
+      "also enables exclusive time profiling of all modules until restart" },
+
     { "packets", Parameter::PT_INT, "0:max32", "10000",
       "minimum packets to report" },
 
@@ -261,6 +265,11 @@ bool PerfMonModule::set(const char*, Value& v, SnortConfig*)
         if ( v.get_bool() )
             config->perf_flags |= PERF_FLOWIP;
     }
+    else if ( v.is("latency") )
+    {
+        if ( v.get_bool() )
+            config->perf_flags |= PERF_LATENCY;
+    }
     else if ( v.is("packets") )
     {
         config->pkt_cnt = v.get_uint32();
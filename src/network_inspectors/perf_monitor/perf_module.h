@@ -37,6 +37,7 @@
 #define PERF_FLOW       0x00000004
 #define PERF_FLOWIP     0x00000008
 #define PERF_SUMMARY    0x00000010
+#define PERF_LATENCY    0x00000020
 
 #define ROLLOVER_THRESH     512
 #define MAX_PERF_FILE_SIZE  UINT64_MAX
@@ -166,6 +166,8 @@ void PerfMonitor::show(const SnortConfig*) const
     if ( ConfigLogger::log_flag("flow_ip", config->perf_flags & PERF_FLOWIP) )
         ConfigLogger::log_value("flow_ip_memcap", config->flowip_memcap);
 
+    ConfigLogger::log_flag("latency", config->perf_flags & PERF_LATENCY);
+
     ConfigLogger::log_value("packets", config->pkt_cnt);
     ConfigLogger::log_value("seconds", config->sample_interval);
     ConfigLogger::log_value("max_file_size", config->max_file_size);
@@ -197,6 +199,16 @@ bool PerfMonitor::configure(SnortConfig*)
     new PerfRotateHandler(*this);
     new FlowIPDataHandler(*this);
 
+    // stage latencies are derived from the module time profiles, which must
+    // not include nested modules or stages would be counted more than once.
+    // this is global and also applies to the profiler output; it is not
+    // undone if a reload removes latency.
+    if ( config->perf_flags & PERF_LATENCY )
+    {
+        TimeProfilerStats::set_enabled(true);
+        TimeProfilerStats::set_exclusive(true);
+    }
+
     return config->resolve();
 }
 
@@ -219,6 +231,9 @@ void PerfMonitor::tinit()
     if (config->perf_flags & PERF_CPU )
         trackers->emplace_back(new CPUTracker(config));
 
+    if (config->perf_flags & PERF_LATENCY)
+        trackers->emplace_back(new LatencyTracker(config));
+
     for (unsigned i = 0; i < trackers->size(); i++)
     {
         if (!(*trackers)[i]->open(true))
@@ -24,9 +24,11 @@
 
 #include "rna_fingerprint_tcp.h"
 
+#include <algorithm>
 #include <sstream>
 
 #ifdef UNIT_TEST
+#include <random>
 #include "catch/snort_catch.h"
 #endif
 
@@ -105,27 +107,126 @@ bool TcpFpProcessor::push(const TcpFingerprint& tfp)
     return result.second;
 }
 
+// A layout is the number of options in the low 3 bits followed by 2 bits
+// per option.  Only the options a key can report are encodable; anything
+// else can't match a client layout and is rejected.
+static inline bool add_layout_opt(uint32_t& layout, int pos, int opt)
+{
+    uint32_t code;
+
+    switch (opt)
+    {
+    case (int) tcp::TcpOptCode::MAXSEG:
+        code = 0;
+        break;
+    case (int) tcp::TcpOptCode::WSCALE:
+        code = 1;
+        break;
+    case (int) tcp::TcpOptCode::SACKOK:
+        code = 2;
+        break;
+    case (int) tcp::TcpOptCode::TIMESTAMP:
+        code = 3;
+        break;
+    default:
+        return false;
+    }
+    layout = ((layout & ~0x7u) | (pos + 1)) | (code << (3 + 2 * pos));
+    return true;
+}
+
+static inline uint32_t get_subkey(bool ipv6, bool df, uint32_t layout)
+{
+    return (layout << 2) | (ipv6 ? 2 : 0) | (!ipv6 and df ? 1 : 0);
+}
+
+// index blocks are 256 tcp windows
+static constexpr unsigned block_bits = 8;
+
+static inline uint32_t get_block_key(uint32_t subkey, int block)
+{
+    return (subkey << (16 - block_bits)) | block;
+}
+
+// fingerprints match at most 4 options, in the order seen in the packet
+static int get_optorder(const FpTcpKey& key, uint8_t* optorder)
+{
+    int i, optpos;
+
+    for (i=0, optpos=0; i<TCP_OPTLENMAX && optpos<4; i++)
+    {
+        if (i == key.ws_pos)
+            optorder[optpos++] = (uint8_t) tcp::TcpOptCode::WSCALE;
+        else if (i == key.mss_pos)
+            optorder[optpos++] = (uint8_t) tcp::TcpOptCode::MAXSEG;
+        else if (i == key.sackok_pos)
+            optorder[optpos++] = (uint8_t) tcp::TcpOptCode::SACKOK;
+        else if (i == key.timestamp_pos)
+            optorder[optpos++] = (uint8_t) tcp::TcpOptCode::TIMESTAMP;
+    }
+    return optpos;
+}
+
 void TcpFpProcessor::make_tcp_fp_tables(TCP_FP_MODE mode)
 {
-    auto* fptable = (mode == TCP_FP_MODE::SERVER ?
-        table_tcp_server : table_tcp_client);
+    auto& index = (mode == TCP_FP_MODE::SERVER ?
+        index_tcp_server : index_tcp_client);
+
+    const uint32_t fptype = (mode == TCP_FP_MODE::SERVER ?
+        FpFingerprint::FpType::FP_TYPE_SERVER :
+        FpFingerprint::FpType::FP_TYPE_CLIENT);
+
+    const uint32_t fptype6 = (mode == TCP_FP_MODE::SERVER ?
+        FpFingerprint::FpType::FP_TYPE_SERVER6 :
+        FpFingerprint::FpType::FP_TYPE_CLIENT6);
 
-    for (size_t i = 0; i < table_size; i++)
-        fptable[i].clear();
+    index.blocks.clear();
 
+    // entries are added in container order so each block stays in that order
     for (const auto& tfpit : tcp_fps)
     {
         const auto& tfp = tfpit.second;
+
+        if (tfp.fp_type != fptype and tfp.fp_type != fptype6)
+            continue;
+
+        uint32_t layout = 0;
+
+        if (mode == TCP_FP_MODE::CLIENT)
+        {
+            // client options must match the packet exactly
+            if (tfp.topts.size() > 4)
+                continue;
+
+            int pos = 0;
+            bool good = true;
+
+            for (const auto& fpe_topts : tfp.topts)
+            {
+                if (!add_layout_opt(layout, pos++, fpe_topts.d.range.min))
+                {
+                    good = false;
+                    break;
+                }
+            }
+            if (!good)
+                continue;
+        }
+
+        uint32_t subkey = get_subkey(tfp.fp_type == fptype6, tfp.df, layout);
+
         for (const auto& fpe : tfp.tcp_window)
         {
-            switch (fpe.type)
+            if (fpe.type != FpElementType::RANGE)
+                continue;
+
+            int min = std::max(fpe.d.range.min, 0);
+            int max = std::min(fpe.d.range.max, (int) TCP_MAXWIN);
+
+            for (int b = min >> block_bits; b <= max >> block_bits; b++)
             {
-            case FpElementType::RANGE:
-                for (int i = fpe.d.range.min; i <= fpe.d.range.max; i++)
-                    fptable[i].emplace_back(&tfp);
-                break;
-            default:
-                break;
+                index.blocks[get_block_key(subkey, b)].push_back(
+                    { (uint16_t) min, (uint16_t) max, tfp.ttl, &tfp });
             }
         }
     }
@@ -234,118 +335,80 @@ static inline bool is_ts_good(const FpTcpKey& key, const vector<FpElement>& topt
     return true;
 }
 
-const TcpFingerprint* TcpFpProcessor::get_tcp_fp(const FpTcpKey& key, uint8_t ttl,
-    TCP_FP_MODE mode) const
+static bool is_tcp_fp_good(const FpTcpKey& key, const TcpFingerprint* tfp,
+    TcpFpProcessor::TCP_FP_MODE mode, int optpos, uint8_t* optorder)
 {
-    uint8_t optorder[4];
     uint8_t fp_optorder[4];
-    int optpos;
     int fp_optpos;
     int i;
-    uint32_t fptype;
 
-    const vector<const snort::TcpFingerprint*>* fptable;
+    if (!is_mss_good(key, tfp->mss) or !is_ws_good(key, tfp->ws))
+        return false;
 
-    if (mode == TCP_FP_MODE::SERVER)
-    {
-        fptable = table_tcp_server;
-        fptype = key.isIpv6 ?
-            FpFingerprint::FpType::FP_TYPE_SERVER6 :
-            FpFingerprint::FpType::FP_TYPE_SERVER;
-    }
-    else
+    if (mode == TcpFpProcessor::TCP_FP_MODE::CLIENT)
+        return true;
+
+    //create array of options from fingerprint that were present in client packet.
+    //Ordered by fingerprint option order
+    fp_optpos = 0;
+    for (const auto& fpe_topts : tfp->topts)
     {
-        fptable = table_tcp_client;
-        fptype = key.isIpv6 ?
-            FpFingerprint::FpType::FP_TYPE_CLIENT6 :
-            FpFingerprint::FpType::FP_TYPE_CLIENT;
+        for (i=0; i<key.num_syn_tcpopts; i++)
+        {
+            if (key.syn_tcpopts[i] == fpe_topts.d.range.min)
+            {
+                fp_optorder[fp_optpos++] = key.syn_tcpopts[i];
+                break;
+            }
+        }
     }
 
-    const auto& tfpvec = fptable[key.tcp_window];
-    for (const auto& tfp : tfpvec)
-    {
-        if (tfp->fp_type != fptype or !is_mss_good(key, tfp->mss))
-            continue;
+    //if number, type, or order of option in SYN mismatch those in FP,
+    //goto next check.
+    if (is_option_good(optpos, fp_optpos, optorder, fp_optorder))
+        return true;
 
-        if ( (key.isIpv6 || key.df == tfp->df) &&  // don't check df for ipv6
-            ttl <= tfp->ttl &&
-            (tfp->ttl < MAXIMUM_FP_HOPS || ttl >= (tfp->ttl - MAXIMUM_FP_HOPS)))
-        {
-            if (!is_ws_good(key, tfp->ws))
-                continue;
+    //number and type of options didn't match between SYN and fingerprint.
+    //Ignore Timestamp option if present in SYN.
+    return is_ts_good(key, tfp->topts, optpos, optorder, fp_optorder);
+}
 
-            if (mode == TCP_FP_MODE::SERVER)
-            {
-                //create array of options in the order seen in server packet
-                for (i=0, optpos=0; i<TCP_OPTLENMAX && optpos<4; i++)
-                {
-                    if (i == key.ws_pos)
-                        optorder[optpos++] = (uint8_t) tcp::TcpOptCode::WSCALE;
-                    else if (i == key.mss_pos)
-                        optorder[optpos++] = (uint8_t) tcp::TcpOptCode::MAXSEG;
-                    else if (i == key.sackok_pos)
-                        optorder[optpos++] = (uint8_t) tcp::TcpOptCode::SACKOK;
-                    else if (i == key.timestamp_pos)
-                        optorder[optpos++] = (uint8_t) tcp::TcpOptCode::TIMESTAMP;
-                }
+const TcpFingerprint* TcpFpProcessor::get_tcp_fp(const FpTcpKey& key, uint8_t ttl,
+    TCP_FP_MODE mode) const
+{
+    const auto& index = (mode == TCP_FP_MODE::SERVER ?
+        index_tcp_server : index_tcp_client);
 
-                //create array of options from fingerprint that were present in client packet.
-                //Ordered by fingerprint option order
-                fp_optpos = 0;
-                for (const auto& fpe_topts : tfp->topts)
-                {
-                    for (i=0; i<key.num_syn_tcpopts; i++)
-                    {
-                        if (key.syn_tcpopts[i] == fpe_topts.d.range.min)
-                        {
-                            fp_optorder[fp_optpos++] = key.syn_tcpopts[i];
-                            break;
-                        }
-                    }
-                }
+    if (key.tcp_window < 0 or key.tcp_window > (int) TCP_MAXWIN)
+        return nullptr;
 
-                //if number, type, or order of option in SYN mismatch those in FP,
-                //goto next check.
-                if (is_option_good(optpos, fp_optpos, optorder, fp_optorder))
-                    return tfp;
+    uint8_t optorder[4];
+    int optpos = get_optorder(key, optorder);
+    uint32_t layout = 0;
 
-                //number and type of options didn't match between SYN and fingerprint.
-                //Ignore Timestamp option if present in SYN.
-                if (!is_ts_good(key, tfp->topts, optpos, optorder, fp_optorder))
-                    continue;
+    if (mode == TCP_FP_MODE::CLIENT)
+    {
+        for (int i = 0; i < optpos; i++)
+            add_layout_opt(layout, i, optorder[i]);
+    }
 
-                return tfp;
-            }
-            else
-            {
-                for (i=0, optpos=0; i<TCP_OPTLENMAX && optpos<4; i++)
-                {
-                    if (i == key.ws_pos)
-                        optorder[optpos++] = (uint8_t) tcp::TcpOptCode::WSCALE;
-                    else if (i == key.mss_pos)
-                        optorder[optpos++] = (uint8_t) tcp::TcpOptCode::MAXSEG;
-                    else if (i == key.sackok_pos)
-                        optorder[optpos++] = (uint8_t) tcp::TcpOptCode::SACKOK;
-                    else if (i == key.timestamp_pos)
-                        optorder[optpos++] = (uint8_t) tcp::TcpOptCode::TIMESTAMP;
-                }
+    auto it = index.blocks.find(get_block_key(get_subkey(key.isIpv6, key.df, layout),
+        key.tcp_window >> block_bits));
 
-                auto fpe_topts = tfp->topts.begin();
-                for (i = 0; i<optpos && fpe_topts != tfp->topts.end(); i++, fpe_topts++)
-                {
-                    if (optorder[i] != fpe_topts->d.range.min)
-                        break;
-                }
+    if (it == index.blocks.end())
+        return nullptr;
 
-                // if there were more elements in this fingerprint or
-                // there was a mismatch between this fingerprint and the
-                // key, go to the next fingerprint in the store
-                if (fpe_topts != tfp->topts.end() || i < optpos)
-                    continue;
+    // address family, df, and client options already match
+    for (const auto& e : it->second)
+    {
+        if (key.tcp_window < e.min or key.tcp_window > e.max)
+            continue;
 
-                return tfp;
-            }
-        }
+        if (ttl > e.ttl or (e.ttl >= MAXIMUM_FP_HOPS and ttl < (e.ttl - MAXIMUM_FP_HOPS)))
+            continue;
+
+        if (is_tcp_fp_good(key, e.fp, mode, optpos, optorder))
+            return e.fp;
     }
     return nullptr;
 }
@@ -721,6 +784,231 @@ TEST_CASE("get_tcp_fp", "[rna_fingerprint_tcp]")
     set_tcp_fp_processor(nullptr);
 }
 
+// the lookup as it was before the index: walk the container in order and
+// take the first fingerprint that has a window range containing the key
+static const TcpFingerprint* get_tcp_fp_linear(const TcpFpProcessor& processor,
+    const FpTcpKey& key, uint8_t ttl, TcpFpProcessor::TCP_FP_MODE mode)
+{
+    const uint32_t fptype = (mode == TcpFpProcessor::TCP_FP_MODE::SERVER) ?
+        (key.isIpv6 ? FpFingerprint::FpType::FP_TYPE_SERVER6 : FpFingerprint::FpType::FP_TYPE_SERVER) :
+        (key.isIpv6 ? FpFingerprint::FpType::FP_TYPE_CLIENT6 : FpFingerprint::FpType::FP_TYPE_CLIENT);
+
+    uint8_t optorder[4];
+    int optpos = get_optorder(key, optorder);
+
+    for (const auto& tfpit : processor.get_tcp_fps())
+    {
+        const TcpFingerprint* tfp = &tfpit.second;
+
+        if (tfp->fp_type != fptype)
+            continue;
+
+        bool win = false;
+
+        for (const auto& fpe : tfp->tcp_window)
+        {
+            if (fpe.type == FpElementType::RANGE and
+                key.tcp_window >= fpe.d.range.min and key.tcp_window <= fpe.d.range.max)
+                win = true;
+        }
+
+        if (!win or (!key.isIpv6 and key.df != tfp->df))
+            continue;
+
+        if (ttl > tfp->ttl or (tfp->ttl >= MAXIMUM_FP_HOPS and ttl < (tfp->ttl - MAXIMUM_FP_HOPS)))
+            continue;
+
+        if (!is_mss_good(key, tfp->mss) or !is_ws_good(key, tfp->ws))
+            continue;
+
+        if (mode == TcpFpProcessor::TCP_FP_MODE::CLIENT)
+        {
+            // exactly the fingerprint's options in the fingerprint's order
+            bool same = ((int)tfp->topts.size() == optpos);
+
+            for (int i = 0; same and i < optpos; i++)
+                same = (optorder[i] == tfp->topts[i].d.range.min);
+
+            if (same)
+                return tfp;
+
+            continue;
+        }
+
+        uint8_t fp_optorder[4];
+        int fp_optpos = 0;
+
+        for (const auto& fpe_topts : tfp->topts)
+        {
+            for (int i = 0; i < key.num_syn_tcpopts; i++)
+            {
+                if (key.syn_tcpopts[i] == fpe_topts.d.range.min)
+                {
+                    fp_optorder[fp_optpos++] = key.syn_tcpopts[i];
+                    break;
+                }
+            }
+        }
+
+        if (is_option_good(optpos, fp_optpos, optorder, fp_optorder) or
+            is_ts_good(key, tfp->topts, optpos, optorder, fp_optorder))
+            return tfp;
+    }
+    return nullptr;
+}
+
+// option layouts are digits; 1 is a nop, which keys never report
+static int set_opts(const char* layout, uint8_t* opts)
+{
+    int n = 0;
+
+    for (; *layout and n < 4; ++layout)
+    {
+        if (*layout != ' ')
+            opts[n++] = *layout - '0';
+    }
+    return n;
+}
+
+TEST_CASE("get_tcp_fp matches linear walk", "[rna_fingerprint_tcp]")
+{
+    // windows around index block boundaries and the ends of the window space
+    static const int wins[] = { 0, 1, 255, 256, 257, 511, 512, 1460, 65279, 65280, 65535 };
+    static const unsigned num_wins = sizeof(wins) / sizeof(wins[0]);
+
+    // ttls below, at, and above MAXIMUM_FP_HOPS
+    static const uint8_t ttls[] = { 10, 32, 33, 64, 128, 255 };
+
+    static const char* const layouts[] =
+    { "2 4 8 3", "2 3 4 8", "2 4 3", "2 3 4", "2 4 8", "2 3", "2 4", "2", "2 1 3", "" };
+    static const unsigned num_layouts = sizeof(layouts) / sizeof(layouts[0]);
+
+    static const char* const mss[] = { "X", "SYN", "SYN-1400", "1460", "1300-1460" };
+    static const char* const ws[] = { "X", "0-2", "7", "8" };
+
+    static const uint32_t fp_types[] =
+    {
+        FpFingerprint::FpType::FP_TYPE_SERVER, FpFingerprint::FpType::FP_TYPE_CLIENT,
+        FpFingerprint::FpType::FP_TYPE_SERVER6, FpFingerprint::FpType::FP_TYPE_CLIENT6
+    };
+
+    std::mt19937 rng(46);
+    unsigned hits = 0;
+
+    for (unsigned round = 0; round < 8; ++round)
+    {
+        TcpFpProcessor processor;
+
+        // few distinct attributes so that many fingerprints overlap a key
+        // and the first one in container order decides
+        for (unsigned i = 0; i < 300; ++i)
+        {
+            RawFingerprint rawfp;
+            rawfp.fpid = i + 1;
+            rawfp.fp_type = fp_types[rng() % 4];
+            rawfp.fpuuid = to_string(i);
+            rawfp.ttl = ttls[rng() % sizeof(ttls)];
+
+            unsigned num = 1 + rng() % 3;
+
+            for (unsigned w = 0; w < num; ++w)
+            {
+                int a = wins[rng() % num_wins];
+                int b = wins[rng() % num_wins];
+
+                if (!rawfp.tcp_window.empty())
+                    rawfp.tcp_window += " ";
+
+                if (rng() % 2)
+                    rawfp.tcp_window += to_string(a);
+                else
+                    rawfp.tcp_window += to_string(min(a, b)) + "-" + to_string(max(a, b));
+            }
+
+            rawfp.mss = mss[rng() % (sizeof(mss) / sizeof(mss[0]))];
+            rawfp.id = "X";
+            rawfp.topts = layouts[rng() % num_layouts];
+            rawfp.ws = ws[rng() % 4];
+            rawfp.df = rng() % 2;
+
+            processor.push(TcpFingerprint(rawfp));
+        }
+
+        processor.make_tcp_fp_tables(TcpFpProcessor::TCP_FP_MODE::SERVER);
+        processor.make_tcp_fp_tables(TcpFpProcessor::TCP_FP_MODE::CLIENT);
+
+        vector<const TcpFingerprint*> fps;
+
+        for (const auto& it : processor.get_tcp_fps())
+            fps.emplace_back(&it.second);
+
+        for (unsigned n = 0; n < 5000; ++n)
+        {
+            // aim at a fingerprint so that most keys get past the window
+            const TcpFingerprint* tfp = fps[rng() % fps.size()];
+
+            uint8_t opts[4];
+            int num_opts = set_opts(layouts[rng() % num_layouts], opts);
+
+            FpTcpKey key;
+            key.mss_pos = key.ws_pos = key.sackok_pos = key.timestamp_pos = -1;
+
+            for (int i = 0; i < num_opts; i++)
+            {
+                switch (opts[i])
+                {
+                case (int) tcp::TcpOptCode::MAXSEG: key.mss_pos = i; break;
+                case (int) tcp::TcpOptCode::WSCALE: key.ws_pos = i; break;
+                case (int) tcp::TcpOptCode::SACKOK: key.sackok_pos = i; break;
+                case (int) tcp::TcpOptCode::TIMESTAMP: key.timestamp_pos = i; break;
+                default: break;
+                }
+            }
+
+            // the client's syn options, only used in server mode
+            uint8_t syn_opts[4];
+            key.syn_tcpopts = syn_opts;
+            key.num_syn_tcpopts = set_opts(layouts[rng() % num_layouts], syn_opts);
+            key.syn_timestamp = rng() % 2;
+
+            const FpElement& fpe = tfp->tcp_window[rng() % tfp->tcp_window.size()];
+            int win = (fpe.type == FpElementType::RANGE and rng() % 4) ?
+                ((rng() % 2) ? fpe.d.range.min : fpe.d.range.max) : wins[rng() % num_wins];
+            key.tcp_window = max(0, min(win + (int)(rng() % 3) - 1, (int) TCP_MAXWIN));
+
+            key.synmss = (rng() % 4) ? 1460 : -1;
+            key.mss = (rng() % 2) ? 1460 : 1400;
+            key.ws = rng() % 9;
+            key.df = (rng() % 4) ? tfp->df : !tfp->df;
+            key.isIpv6 = (rng() % 2);
+
+            int ttl = tfp->ttl;
+
+            switch (rng() % 6)
+            {
+            case 0: ttl += 1; break;
+            case 1: ttl -= MAXIMUM_FP_HOPS; break;
+            case 2: ttl -= MAXIMUM_FP_HOPS + 1; break;
+            case 3: ttl = rng() % 256; break;
+            default: break;
+            }
+            ttl = max(0, min(ttl, 255));
+
+            for (auto mode : { TcpFpProcessor::TCP_FP_MODE::SERVER, TcpFpProcessor::TCP_FP_MODE::CLIENT })
+            {
+                const TcpFingerprint* linear = get_tcp_fp_linear(processor, key, ttl, mode);
+                CHECK(processor.get_tcp_fp(key, ttl, mode) == linear);
+
+                if (linear)
+                    ++hits;
+            }
+        }
+    }
+
+    // enough keys match for the comparison to mean something
+    CHECK(hits > 8000);
+}
+
 TEST_CASE("is_mss_good", "[rna_fingerprint_tcp]")
 {
     vector<FpElement> tfp_mss;
@@ -112,14 +112,32 @@ public:
 
 private:
 
+    // Fingerprints are hashed on a subkey of the exact match attributes
+    // (address family, df, and for clients the option layout) and each
+    // block of 256 tcp windows their window ranges overlap.  A lookup only
+    // visits entries with its subkey and block, checks the window range
+    // from the entry, and then checks the range attributes (mss, ws, ttl)
+    // and the server side option order on the fingerprint.  Entries are
+    // kept in container order so the result is the same fingerprint a
+    // linear walk would find.
+    struct TcpFpIndex
+    {
+        struct Entry
+        {
+            uint16_t min;
+            uint16_t max;
+            uint8_t ttl;
+            const snort::TcpFingerprint* fp;
+        };
+
+        std::unordered_map<uint32_t, std::vector<Entry>> blocks;
+    };
+
     // underlying container for input fingerprints
     TcpFpContainer tcp_fps;
 
-    // table_tcp_xxx[i] contains pointers into tcp_fps to all fingerprints
-    // whose tcp window range contains i
-    static constexpr uint32_t table_size = TCP_MAXWIN + 1;
-    std::vector<const snort::TcpFingerprint*> table_tcp_server[table_size];
-    std::vector<const snort::TcpFingerprint*> table_tcp_client[table_size];
+    TcpFpIndex index_tcp_server;
+    TcpFpIndex index_tcp_client;
 };
 
 }
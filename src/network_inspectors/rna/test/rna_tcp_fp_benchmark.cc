@@ -0,0 +1,267 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// rna_tcp_fp_benchmark.cc
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "flow/flow_data.h"
+#include "protocols/tcp_options.h"
+
+#include "network_inspectors/rna/rna_fingerprint_tcp.h"
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+namespace snort
+{
+unsigned FlowData::flow_data_id = 0;
+
+void WarningMessage(const char*, ...) { }
+
+namespace ip
+{
+uint8_t IpApi::ttl() const
+{ return 0; }
+}
+
+namespace tcp
+{
+TcpOptIteratorIter::TcpOptIteratorIter(const TcpOption* opt, const TcpOptIterator* iter) :
+    opt(opt), iter(iter) { }
+
+const TcpOptIteratorIter& TcpOptIteratorIter::operator++()
+{ return *this; }
+
+const TcpOption& TcpOptIteratorIter::operator*() const
+{ return *opt; }
+
+TcpOptIterator::TcpOptIterator(const TCPHdr* const, const Packet* const) :
+    start_ptr(nullptr), end_ptr(nullptr) { }
+
+TcpOptIteratorIter TcpOptIterator::begin() const
+{ return TcpOptIteratorIter(nullptr, this); }
+
+TcpOptIteratorIter TcpOptIterator::end() const
+{ return TcpOptIteratorIter(nullptr, this); }
+}
+}
+
+//--------------------------------------------------------------------------
+// fingerprints
+//--------------------------------------------------------------------------
+
+// the option layouts seen most often in fingerprint databases
+static const char* const layouts[] =
+{ "2 4 8 3", "2 3 4 8", "2 4 3", "2 3 4", "2 4 8", "2 3", "2 4", "2" };
+
+static constexpr unsigned num_layouts = sizeof(layouts) / sizeof(layouts[0]);
+static constexpr unsigned num_keys = 4096;
+
+static const uint32_t fp_types[] =
+{
+    FpFingerprint::FpType::FP_TYPE_SERVER, FpFingerprint::FpType::FP_TYPE_CLIENT,
+    FpFingerprint::FpType::FP_TYPE_SERVER6, FpFingerprint::FpType::FP_TYPE_CLIENT6
+};
+
+static void build_fps(TcpFpProcessor& processor, unsigned num_fps, std::mt19937& rng)
+{
+    static const char* const mss[] = { "X", "SYN", "1460", "1300-1460" };
+    static const char* const ws[] = { "X", "0-2", "7", "8" };
+
+    for ( unsigned i = 0; i < num_fps; ++i )
+    {
+        RawFingerprint rawfp;
+        rawfp.fpid = i + 1;
+        rawfp.fp_type = fp_types[rng() % 4];
+        rawfp.fpuuid = std::to_string(i);
+        rawfp.ttl = (rng() % 2) ? 64 : 128;
+
+        // mostly exact windows with some ranges, a few of them wide
+        unsigned win = rng() % 65536;
+
+        switch ( rng() % 8 )
+        {
+        case 0:
+            rawfp.tcp_window = std::to_string(win & ~0xfff) + "-" + std::to_string(win | 0xfff);
+            break;
+        case 1:
+        case 2:
+            rawfp.tcp_window = std::to_string(win & ~0x3f) + "-" + std::to_string(win | 0x3f);
+            break;
+        default:
+            rawfp.tcp_window = std::to_string(win) + " " + std::to_string(rng() % 65536);
+            break;
+        }
+
+        rawfp.mss = mss[rng() % 4];
+        rawfp.id = "X";
+        rawfp.topts = layouts[rng() % num_layouts];
+        rawfp.ws = ws[rng() % 4];
+        rawfp.df = rng() % 2;
+
+        processor.push(TcpFingerprint(rawfp));
+    }
+
+    processor.make_tcp_fp_tables(TcpFpProcessor::TCP_FP_MODE::SERVER);
+    processor.make_tcp_fp_tables(TcpFpProcessor::TCP_FP_MODE::CLIENT);
+}
+
+//--------------------------------------------------------------------------
+// keys
+//--------------------------------------------------------------------------
+
+struct TestKey
+{
+    FpTcpKey key;
+    uint8_t syn_tcpopts[4];
+    uint8_t ttl;
+    TcpFpProcessor::TCP_FP_MODE mode;
+};
+
+// half the keys are built from a fingerprint so they should match, the
+// rest are random and mostly miss, like scans and unknown stacks
+static void build_keys(const TcpFpProcessor& processor, std::vector<TestKey>& kv,
+    std::mt19937& rng)
+{
+    std::vector<const TcpFingerprint*> fps;
+
+    for ( const auto& it : processor.get_tcp_fps() )
+        fps.emplace_back(&it.second);
+
+    for ( TestKey& tk : kv )
+    {
+        FpTcpKey& key = tk.key;
+        const TcpFingerprint* tfp = fps[rng() % fps.size()];
+        bool hit = rng() % 2;
+
+        const char* layout = hit ? nullptr : layouts[rng() % num_layouts];
+        std::vector<int> opts;
+
+        if ( layout )
+        {
+            for ( ; *layout; ++layout )
+            {
+                if ( *layout != ' ' )
+                    opts.emplace_back(*layout - '0');
+            }
+        }
+        else
+        {
+            for ( const auto& fpe : tfp->topts )
+                opts.emplace_back(fpe.d.range.min);
+        }
+
+        key.mss_pos = key.ws_pos = key.sackok_pos = key.timestamp_pos = -1;
+        key.num_syn_tcpopts = 0;
+        key.syn_tcpopts = tk.syn_tcpopts;
+
+        for ( int opt : opts )
+        {
+            int pos = key.num_syn_tcpopts++;
+            tk.syn_tcpopts[pos] = opt;
+
+            switch ( opt )
+            {
+            case (int) tcp::TcpOptCode::MAXSEG:
+                key.mss_pos = pos;
+                break;
+            case (int) tcp::TcpOptCode::WSCALE:
+                key.ws_pos = pos;
+                break;
+            case (int) tcp::TcpOptCode::SACKOK:
+                key.sackok_pos = pos;
+                break;
+            default:
+                key.timestamp_pos = pos;
+                break;
+            }
+        }
+
+        const FpElement& win = tfp->tcp_window[0];
+        key.tcp_window = hit ? win.d.range.min : rng() % 65536;
+        key.synmss = key.mss = 1460;
+        key.ws = tfp->ws[0].type == FpElementType::RANGE ? tfp->ws[0].d.range.min : 7;
+        key.syn_timestamp = 0;
+        key.df = hit ? tfp->df : rng() % 2;
+        key.isIpv6 = tfp->fp_type == FpFingerprint::FpType::FP_TYPE_SERVER6 or
+            tfp->fp_type == FpFingerprint::FpType::FP_TYPE_CLIENT6;
+
+        tk.ttl = hit ? tfp->ttl : rng() % 256;
+        tk.mode = (tfp->fp_type == FpFingerprint::FpType::FP_TYPE_SERVER or
+            tfp->fp_type == FpFingerprint::FpType::FP_TYPE_SERVER6) ?
+            TcpFpProcessor::TCP_FP_MODE::SERVER : TcpFpProcessor::TCP_FP_MODE::CLIENT;
+    }
+}
+
+//--------------------------------------------------------------------------
+// lookups
+//--------------------------------------------------------------------------
+
+static void run_lookups(unsigned num_fps)
+{
+    std::mt19937 rng(num_fps);
+
+    TcpFpProcessor processor;
+    build_fps(processor, num_fps, rng);
+
+    std::vector<TestKey> kv(num_keys);
+    build_keys(processor, kv, rng);
+
+    unsigned hits = 0;
+
+    for ( const TestKey& tk : kv )
+    {
+        if ( processor.get_tcp_fp(tk.key, tk.ttl, tk.mode) )
+            ++hits;
+    }
+
+    // the keys built from fingerprints should find at least that many
+    CHECK(hits >= num_keys / 4);
+    CHECK(hits < num_keys);
+
+    unsigned next = 0;
+
+    BENCHMARK("get_tcp_fp " + std::to_string(num_fps))
+    {
+        const TestKey& tk = kv[next++ % num_keys];
+        return processor.get_tcp_fp(tk.key, tk.ttl, tk.mode);
+    };
+}
+
+TEST_CASE("rna tcp fingerprint lookup", "[rna_fingerprint_tcp]")
+{
+    // from a typical vulnerability database up to a large custom one
+    for ( unsigned num_fps : { 1000, 5000, 20000 } )
+        run_lookups(num_fps);
+}
+
+#endif
+
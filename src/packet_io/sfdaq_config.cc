@@ -68,6 +68,7 @@ SFDAQConfig::SFDAQConfig()
     batch_size = BATCH_SIZE_UNSET;
     mru_size = SNAPLEN_UNSET;
     timeout = TIMEOUT_DEFAULT;
+    staged_batches = STAGED_UNSET;
 }
 
 SFDAQConfig::~SFDAQConfig()
@@ -106,6 +107,11 @@ void SFDAQConfig::set_mru_size(int mru_size_value)
     mru_size = mru_size_value;
 }
 
+void SFDAQConfig::set_staged_batches(bool staged)
+{
+    staged_batches = staged ? STAGED_ON : STAGED_OFF;
+}
+
 void SFDAQConfig::overlay(const SFDAQConfig* other)
 {
     if (!other->module_dirs.empty())
@@ -128,4 +134,6 @@ void SFDAQConfig::overlay(const SFDAQConfig* other)
     if (other->mru_size != SNAPLEN_UNSET)
         mru_size = other->mru_size;
     timeout = other->timeout;
+    if (other->staged_batches != STAGED_UNSET)
+        staged_batches = other->staged_batches;
 }
@@ -58,9 +58,11 @@ struct SFDAQConfig
     void add_module_dir(const char*);
     void set_batch_size(uint32_t);
     void set_mru_size(int);
+    void set_staged_batches(bool);
 
     uint32_t get_batch_size() const { return (batch_size == BATCH_SIZE_UNSET) ? BATCH_SIZE_DEFAULT : batch_size; }
     uint32_t get_mru_size() const { return (mru_size == SNAPLEN_UNSET) ? SNAPLEN_DEFAULT : mru_size; }
+    bool get_staged_batches() const { return staged_batches == STAGED_ON; }
 
     void overlay(const SFDAQConfig*);
 
@@ -71,11 +73,15 @@ struct SFDAQConfig
     uint32_t batch_size;
     int mru_size;
     unsigned int timeout;
+    int staged_batches;
     std::vector<SFDAQModuleConfig*> module_configs;
 
     /* Constants */
     static constexpr uint32_t BATCH_SIZE_UNSET = 0;
     static constexpr int SNAPLEN_UNSET = -1;
+    static constexpr int STAGED_UNSET = -1;
+    static constexpr int STAGED_OFF = 0;
+    static constexpr int STAGED_ON = 1;
     static constexpr uint32_t BATCH_SIZE_DEFAULT = 64;
     static constexpr int SNAPLEN_DEFAULT = 1518;
     static constexpr unsigned TIMEOUT_DEFAULT = 1000;
@@ -56,6 +56,13 @@ public:
             return daq_msgs[curr_batch_idx++];
         return nullptr;
     }
+    // look ahead in the current batch without consuming; i is relative to the next message
+    DAQ_Msg_h peek_message(unsigned i) const
+    {
+        if (i < curr_batch_size - curr_batch_idx)
+            return daq_msgs[curr_batch_idx + i];
+        return nullptr;
+    }
     int finalize_message(DAQ_Msg_h msg, DAQ_Verdict verdict);
     const char* get_error();
 
@@ -83,6 +90,16 @@ public:
             unsigned flags);
     bool get_tunnel_bypass(uint16_t proto);
 
+#ifdef UNIT_TEST
+    void set_batch(const DAQ_Msg_h* msgs, unsigned n)
+    {
+        for (unsigned i = 0; i < n and i < batch_size; i++)
+            daq_msgs[i] = msgs[i];
+        curr_batch_size = n < batch_size ? n : batch_size;
+        curr_batch_idx = 0;
+    }
+#endif
+
 private:
     void get_tunnel_capabilities();
 
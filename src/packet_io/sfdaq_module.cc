@@ -78,6 +78,7 @@ static const Parameter s_params[] =
     { "inputs", Parameter::PT_LIST, input_list_param, nullptr, "input sources" },
     { "snaplen", Parameter::PT_INT, "0:65535", "1518", "set snap length (same as -s)" },
     { "batch_size", Parameter::PT_INT, "1:", "64", "set receive batch size (same as --daq-batch-size)" },
+    { "staged_batches", Parameter::PT_BOOL, nullptr, "false", "decode each run of received packets, then look up their flows, then inspect them in order" },
     { "modules", Parameter::PT_LIST, daq_module_param, nullptr, "DAQ modules to use" },
 
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
@@ -122,6 +123,10 @@ bool SFDAQModule::set(const char* fqn, Value& v, SnortConfig*)
     {
         config->set_batch_size(v.get_uint32());
     }
+    else if (!strcmp(fqn, "daq.staged_batches"))
+    {
+        config->set_staged_batches(v.get_bool());
+    }
     else if (!strcmp(fqn, "daq.modules.name"))
     {
         module_config->name = v.get_string();
@@ -205,6 +210,8 @@ const PegInfo daq_names[] =
     { CountType::SUM, "sof_messages", "start of flow messages received from DAQ" },
     { CountType::SUM, "eof_messages", "end of flow messages received from DAQ" },
     { CountType::SUM, "other_messages", "messages received from DAQ with unrecognized message type" },
+    { CountType::SUM, "staged_batches", "received batches processed in stages" },
+    { CountType::SUM, "staged_packets", "packets decoded ahead of inspection" },
     { CountType::END, nullptr, nullptr }
 };
 
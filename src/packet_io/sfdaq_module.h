@@ -78,6 +78,8 @@ struct DAQStats
     PegCount sof_messages;
     PegCount eof_messages;
     PegCount other_messages;
+    PegCount staged_batches;
+    PegCount staged_packets;
 };
 
 extern THREAD_LOCAL DAQStats daq_stats;
@@ -0,0 +1,79 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// sfdaq_instance_test.cc
+
+// -----------------------------------------------------------------------------
+// unit tests
+// -----------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/snort_catch.h"
+#include "packet_io/sfdaq_config.h"
+#include "packet_io/sfdaq_instance.h"
+
+using namespace snort;
+
+// the messages are never dereferenced so any distinct handles will do
+static DAQ_Msg_h msg(uintptr_t i)
+{ return reinterpret_cast<DAQ_Msg_h>(i + 1); }
+
+TEST_CASE("peek message", "[SFDAQInstance]")
+{
+    SFDAQConfig cfg;
+    cfg.set_batch_size(4);
+
+    SFDAQInstance inst(nullptr, 0, &cfg);
+    const DAQ_Msg_h batch[] = { msg(0), msg(1), msg(2) };
+
+    SECTION("empty batch")
+    {
+        CHECK(inst.peek_message(0) == nullptr);
+        CHECK(inst.next_message() == nullptr);
+    }
+
+    SECTION("peek does not consume")
+    {
+        inst.set_batch(batch, 3);
+
+        CHECK(inst.peek_message(0) == msg(0));
+        CHECK(inst.peek_message(2) == msg(2));
+        CHECK(inst.peek_message(3) == nullptr);
+        CHECK(inst.peek_message(4) == nullptr);
+
+        CHECK(inst.next_message() == msg(0));
+    }
+
+    SECTION("peek is relative to the next message")
+    {
+        inst.set_batch(batch, 3);
+
+        CHECK(inst.next_message() == msg(0));
+        CHECK(inst.peek_message(0) == msg(1));
+        CHECK(inst.peek_message(1) == msg(2));
+        CHECK(inst.peek_message(2) == nullptr);
+
+        CHECK(inst.next_message() == msg(1));
+        CHECK(inst.next_message() == msg(2));
+        CHECK(inst.peek_message(0) == nullptr);
+        CHECK(inst.next_message() == nullptr);
+    }
+}
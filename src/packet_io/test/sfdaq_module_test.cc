@@ -63,6 +63,9 @@ TEST_CASE("parse sfdaq config", "[SFDAQModule]")
     Value batch_size(static_cast<double>(10));
     CHECK(sfdm.set("daq.batch_size", batch_size, &sc));
 
+    Value staged_batches(true);
+    CHECK(sfdm.set("daq.staged_batches", staged_batches, &sc));
+
     CHECK(sfdm.begin("daq.modules", 0, &sc));
 
     SECTION("empty module config")
@@ -107,6 +110,7 @@ TEST_CASE("parse sfdaq config", "[SFDAQModule]")
 
         CHECK((cfg->mru_size == 6666));
         CHECK((cfg->batch_size == 10));
+        CHECK(cfg->get_staged_batches());
 
         REQUIRE(cfg->module_configs.size() == 1);
         for (auto it : cfg->module_configs)
@@ -155,6 +159,7 @@ TEST_CASE("parse sfdaq config", "[SFDAQModule]")
 
         CHECK((cfg->mru_size == 3333));
         CHECK((cfg->batch_size == 12));
+        CHECK(cfg->get_staged_batches());
 
         REQUIRE(cfg->module_configs.size() == 2);
         for (auto it : cfg->module_configs)
@@ -181,4 +186,21 @@ TEST_CASE("parse sfdaq config", "[SFDAQModule]")
             }
         }
     }
+
+    SECTION("staged overlay")
+    {
+        SFDAQConfig* cfg = sc.daq_config;
+        SFDAQConfig overlay_cfg;
+
+        cfg->overlay(&overlay_cfg);
+        CHECK(cfg->get_staged_batches());
+
+        overlay_cfg.set_staged_batches(false);
+        cfg->overlay(&overlay_cfg);
+        CHECK(!cfg->get_staged_batches());
+
+        overlay_cfg.set_staged_batches(true);
+        cfg->overlay(&overlay_cfg);
+        CHECK(cfg->get_staged_batches());
+    }
 }
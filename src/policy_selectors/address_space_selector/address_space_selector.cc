@@ -22,13 +22,13 @@
 #endif
 
 #include <algorithm>
-#include <unordered_map>
 #include <vector>
 
 #include "detection/ips_context.h"
 #include "framework/policy_selector.h"
 #include "log/messages.h"
 #include "policy_selectors/int_set_to_string.h"
+#include "policy_selectors/policy_select_table.h"
 #include "profiler/profiler.h"
 
 #include "address_space_selector_module.h"
@@ -73,19 +73,20 @@ public:
 protected:
     bool select_default_policies(uint32_t key, const SnortConfig*);
     std::vector<AddressSpaceSelection> policy_selections;
-    std::unordered_map<uint32_t, snort::PolicySelectUse*> policy_map;
+    PolicySelectTable policy_map;
 };
 
 AddressSpaceSelector::AddressSpaceSelector(const PolicySelectorApi* api_in,
     std::vector<AddressSpaceSelection>& psv) : PolicySelector(api_in)
 {
     policy_selections = std::move(psv);
-    for (auto i = policy_selections.rbegin(); i != policy_selections.rend(); ++i)
+    for (auto& s : policy_selections)
     {
-        std::sort((*i).addr_spaces.begin(), (*i).addr_spaces.end());
-        for(auto j = (*i).addr_spaces.begin(); j != (*i).addr_spaces.end(); ++j)
-            policy_map[*j] = &(*i).use;
+        std::sort(s.addr_spaces.begin(), s.addr_spaces.end());
+        for (auto key : s.addr_spaces)
+            policy_map.add(key, &s.use);
     }
+    policy_map.compile();
 }
 
 AddressSpaceSelector::~AddressSpaceSelector()
@@ -121,10 +122,9 @@ bool AddressSpaceSelector::select_default_policies(uint32_t key, const SnortConf
 
     address_space_select_stats.packets++;
 
-    auto i = policy_map.find(key);
-    if (i != policy_map.end())
+    auto use = policy_map.find(key);
+    if (use)
     {
-        auto use = (*i).second;
         set_network_policy(use->network_index);
         set_inspection_policy(use->inspection_index);
         set_ips_policy(sc, use->ips_index);
@@ -0,0 +1,180 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// policy_select_table.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "policy_select_table.h"
+
+#include <algorithm>
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+// the direct array covers the largest low range that is at least 1/16
+// populated, up to 64K keys; everything above that is hashed
+static constexpr uint32_t min_direct = 1024;
+static constexpr uint32_t max_direct = 65536;
+static constexpr uint32_t min_density = 16;
+
+void PolicySelectTable::add(uint32_t key, PolicySelectUse* use)
+{
+    keys.emplace_back(key, use);
+}
+
+void PolicySelectTable::compile()
+{
+    // stable so that the first use added for a duplicate key sorts first
+    std::stable_sort(keys.begin(), keys.end(),
+        [](const std::pair<uint32_t, PolicySelectUse*>& a,
+            const std::pair<uint32_t, PolicySelectUse*>& b)
+        { return a.first < b.first; });
+
+    keys.erase(std::unique(keys.begin(), keys.end(),
+        [](const std::pair<uint32_t, PolicySelectUse*>& a,
+            const std::pair<uint32_t, PolicySelectUse*>& b)
+        { return a.first == b.first; }), keys.end());
+
+    uint32_t size = 0;
+
+    for ( unsigned i = 0; i < keys.size() && keys[i].first < max_direct; ++i )
+    {
+        uint32_t end = keys[i].first + 1;
+
+        if ( end <= min_direct || (i + 1) * min_density >= end )
+            size = end;
+    }
+
+    direct.assign(size, nullptr);
+
+    unsigned num_hashed = 0;
+
+    for ( const auto& k : keys )
+    {
+        if ( k.first < size )
+            direct[k.first] = k.second;
+        else
+            ++num_hashed;
+    }
+
+    slots.clear();
+    shift = 32;
+
+    if ( num_hashed )
+    {
+        // at most half full
+        unsigned bits = 1;
+
+        while ( (1u << bits) < 2 * num_hashed )
+            ++bits;
+
+        slots.assign(1u << bits, { 0, nullptr });
+        shift = 32 - bits;
+
+        const uint32_t mask = slots.size() - 1;
+
+        for ( const auto& k : keys )
+        {
+            if ( k.first < size )
+                continue;
+
+            uint32_t i = hash(k.first);
+
+            while ( slots[i].use )
+                i = (i + 1) & mask;
+
+            slots[i] = { k.first, k.second };
+        }
+    }
+
+    keys.clear();
+    keys.shrink_to_fit();
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE("policy select table direct", "[policy_selectors]")
+{
+    PolicySelectUse* a = (PolicySelectUse*)0x10;
+    PolicySelectUse* b = (PolicySelectUse*)0x20;
+
+    PolicySelectTable t;
+    t.add(1, a);
+    t.add(7, b);
+    t.add(1, b);
+    t.compile();
+
+    CHECK(t.get_hashed_size() == 0);
+    CHECK(t.find(0) == nullptr);
+    CHECK(t.find(1) == a);
+    CHECK(t.find(7) == b);
+    CHECK(t.find(8) == nullptr);
+    CHECK(t.find(0xFFFFFFFF) == nullptr);
+}
+
+TEST_CASE("policy select table sparse", "[policy_selectors]")
+{
+    PolicySelectTable t;
+
+    for ( uint32_t k = 0; k < 100; ++k )
+        t.add(k, (PolicySelectUse*)(uintptr_t)(k + 1));
+
+    for ( uint32_t k = 0; k < 5000; ++k )
+    {
+        uint32_t key = 0x10000000 + k * 7919;
+        t.add(key, (PolicySelectUse*)(uintptr_t)(key + 1));
+    }
+    t.add(0xFFFFFFFF, (PolicySelectUse*)1);
+    t.compile();
+
+    CHECK(t.get_direct_size() == 100);
+    CHECK(t.get_hashed_size() >= 2 * 5001);
+
+    for ( uint32_t k = 0; k < 100; ++k )
+        CHECK(t.find(k) == (PolicySelectUse*)(uintptr_t)(k + 1));
+
+    for ( uint32_t k = 0; k < 5000; ++k )
+    {
+        uint32_t key = 0x10000000 + k * 7919;
+        CHECK(t.find(key) == (PolicySelectUse*)(uintptr_t)(key + 1));
+        CHECK(t.find(key + 1) == nullptr);
+    }
+    CHECK(t.find(0xFFFFFFFF) == (PolicySelectUse*)1);
+    CHECK(t.find(100) == nullptr);
+}
+
+TEST_CASE("policy select table empty", "[policy_selectors]")
+{
+    PolicySelectTable t;
+    t.compile();
+
+    CHECK(t.find(0) == nullptr);
+    CHECK(t.find(12345) == nullptr);
+}
+
+#endif
+
@@ -0,0 +1,94 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// policy_select_table.h
+
+#ifndef POLICY_SELECT_TABLE_H
+#define POLICY_SELECT_TABLE_H
+
+// PolicySelectTable maps a 32-bit selector key (tenant or address space ID)
+// to its PolicySelectUse with a constant time lookup.  Keys in the dense
+// low range are looked up directly in an array and the rest go into an
+// open addressed hash table.  The table is compiled when the selector is
+// constructed and is read only after that; reload builds a new selector
+// with a new table which is swapped in along with the rest of the config.
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace snort
+{
+struct PolicySelectUse;
+}
+
+class PolicySelectTable
+{
+public:
+    // the first use added for a key wins
+    void add(uint32_t key, snort::PolicySelectUse*);
+    void compile();
+
+    snort::PolicySelectUse* find(uint32_t key) const;
+
+    size_t get_direct_size() const
+    { return direct.size(); }
+
+    size_t get_hashed_size() const
+    { return slots.size(); }
+
+private:
+    struct Slot
+    {
+        uint32_t key;
+        snort::PolicySelectUse* use;
+    };
+
+    uint32_t hash(uint32_t key) const
+    { return (key * 0x9E3779B1) >> shift; }
+
+    std::vector<std::pair<uint32_t, snort::PolicySelectUse*>> keys;
+    std::vector<snort::PolicySelectUse*> direct;
+    std::vector<Slot> slots;
+    unsigned shift = 32;
+};
+
+inline snort::PolicySelectUse* PolicySelectTable::find(uint32_t key) const
+{
+    if ( key < direct.size() )
+        return direct[key];
+
+    if ( slots.empty() )
+        return nullptr;
+
+    const uint32_t mask = slots.size() - 1;
+
+    for ( uint32_t i = hash(key); ; i = (i + 1) & mask )
+    {
+        const Slot& s = slots[i];
+
+        if ( !s.use )
+            return nullptr;
+
+        if ( s.key == key )
+            return s.use;
+    }
+}
+
+#endif
+
@@ -23,18 +23,30 @@
 
 #include "port_table.h"
 
+#include <algorithm>
 #include <memory>
+#include <set>
+#include <vector>
 
 #include "hash/ghash.h"
 #include "hash/hash_defs.h"
 #include "hash/hash_key_operations.h"
 #include "log/messages.h"
+#include "time/clock_defs.h"
+#include "time/stopwatch.h"
 #include "trace/trace_api.h"
 #include "utils/util.h"
 #include "utils/util_cstring.h"
 
 #include "port_utils.h"
 
+#ifdef UNIT_TEST
+#include <map>
+#include <random>
+
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 #define PTBL_LRC_DEFAULT 10
@@ -357,74 +369,112 @@ static PortObject2* PortTableCompileMergePortObjectList2(
     return ponew;
 }
 
-static inline void add_port_object(Port port, PortObject* po, SF_LIST** parray)
+// Port lists change only where an input port object's ranges start or end,
+// so the ports are swept in order and each run of ports touched by the same
+// port objects is merged once.
+class PortSweep
 {
-    if ( !parray[port] )
+public:
+    PortSweep(PortTable*);
+
+    // advance to the next port; true if the port objects touching it changed
+    bool next(int port);
+
+    // the port objects touching the current port in pt_polist order
+    int get_list(PortObject* pol[], int max) const;
+
+private:
+    struct PortEvent
     {
-        parray[port] = sflist_new();
-        assert(parray[port]);
-    }
+        int port;
+        unsigned ord;   // position in pt_polist
+        int delta;
 
-    if ( parray[port]->tail && parray[port]->tail->ndata == po )
-        return;
+        bool operator<(const PortEvent& rhs) const
+        { return port < rhs.port; }
+    };
 
-    sflist_add_tail(parray[port], po);
-}
+    std::vector<PortObject*> pos;
+    std::vector<PortEvent> events;
+    std::vector<PortEvent>::const_iterator ev;
+
+    // active[ord] counts the ranges of pos[ord] covering the current port
+    std::vector<unsigned> active;
+    std::set<unsigned> touching;
+};
 
-// Update port object lists
-static inline void update_port_lists(PortObject* po, SF_LIST** parray)
+PortSweep::PortSweep(PortTable* p)
 {
-    PortObjectItem* poi;
+    PortObject* po;
     SF_LNODE* lpos;
-    for ( poi = (PortObjectItem*)sflist_first(po->item_list, &lpos);
-          poi;
-          poi = (PortObjectItem*)sflist_next(&lpos) )
+
+    for ( po = (PortObject*)sflist_first(p->pt_polist, &lpos);
+          po;
+          po = (PortObject*)sflist_next(&lpos) )
     {
-        assert(!poi->negate);
+        unsigned ord = pos.size();
+        pos.emplace_back(po);
 
-        if( poi->any())
-            return;
+        PortObjectItem* poi;
+        SF_LNODE* ipos;
 
-        else if( poi->one() )
-            add_port_object(poi->lport, po, parray);
+        for ( poi = (PortObjectItem*)sflist_first(po->item_list, &ipos);
+              poi;
+              poi = (PortObjectItem*)sflist_next(&ipos) )
+        {
+            assert(!poi->negate);
 
-        else
-            for( int port = poi->lport; port <= poi->hport; port++ )
-                add_port_object(port, po, parray);
+            // any port objects are handled by the caller; ports listed
+            // before any still count
+            if ( poi->any() )
+                break;
 
-        add_port_object(poi->lport, po, parray);
+            events.push_back({ poi->lport, ord, 1 });
+            events.push_back({ poi->hport + 1, ord, -1 });
+        }
     }
+    std::stable_sort(events.begin(), events.end());
+    ev = events.begin();
+    active.assign(pos.size(), 0);
 }
 
-// Create optimized port lists per port
-static inline SF_LIST** create_port_lists(PortTable* p)
+bool PortSweep::next(int port)
 {
-    SF_LIST** parray = (SF_LIST**)snort_calloc(sizeof(SF_LIST*), SFPO_MAX_PORTS);
-    assert(parray);
+    bool changed = false;
 
-    PortObject* po;
-    SF_LNODE* lpos;
-    for ( po = (PortObject*)sflist_first(p->pt_polist, &lpos);
-          po;
-          po = (PortObject*)sflist_next(&lpos) )
+    for ( ; ev != events.end() and ev->port == port; ++ev )
     {
-        update_port_lists(po, parray);
-    }
+        unsigned& n = active[ev->ord];
+        bool was = n > 0;
+        n += ev->delta;
+
+        if ( was != (n > 0) )
+        {
+            if ( n )
+                touching.insert(ev->ord);
+            else
+                touching.erase(ev->ord);
 
-    return parray;
+            changed = true;
+        }
+    }
+    return changed;
 }
 
-static inline void delete_port_lists(SF_LIST** parray)
+int PortSweep::get_list(PortObject* pol[], int max) const
 {
-    for ( int port = 0; port < SFPO_MAX_PORTS; port++ )
+    int pol_cnt = 0;
+
+    for ( auto ord : touching )
     {
-        SF_LIST* list = parray[port];
-        if (list)
-            sflist_free(list);
+        if ( pol_cnt == max )
+            break;
+
+        pol[ pol_cnt++ ] = pos[ord];
     }
+    return pol_cnt;
 }
 
-
 static void PortTableCompileMergePortObjects(PortTable* p)
 {
     std::unique_ptr<PortObject*[]> upA(new PortObject*[SFPO_MAX_LPORTS]);
@@ -441,42 +491,38 @@ static void PortTableCompileMergePortObjects(PortTable* p)
 
     p->pt_mpxo_hash = mhashx;
     SF_LIST* plx_list = sflist_new();
-    SF_LIST** optimized_pl = create_port_lists(p);
+
+    PortSweep sweep(p);
 
     // For each port, merge rules from all port objects that touch the port
     // into an optimal object, that may be shared with other ports.
     int id = PO_INIT_ID;
+    PortObject2* last = nullptr;
 
     for ( int i = 0; i < SFPO_MAX_PORTS; i++ )
     {
-        /* Build a list of port objects touching port 'i' */
-        int pol_cnt = 0;
-        PortObject* po;
-        SF_LNODE* lpos;
-
-        for (po = (PortObject*)sflist_first(optimized_pl[i], &lpos);
-             po;
-             po = (PortObject*)sflist_next(&lpos) )
+        if ( sweep.next(i) )
         {
-            if (pol_cnt < SFPO_MAX_LPORTS )
-                pol[ pol_cnt++ ] = po;
+            /* Build a list of port objects touching port 'i' */
+            int pol_cnt = sweep.get_list(pol, SFPO_MAX_LPORTS);
+
+            /* merge the rules into an optimal port object */
+            if ( pol_cnt )
+            {
+                last = PortTableCompileMergePortObjectList2(
+                    mhash, mhashx, plx_list, pol, pol_cnt, p->pt_lrc);
+                assert(last);
+            }
+            else
+                last = nullptr;   //port not contained in any PortObject
         }
-        p->pt_port_object[i] = nullptr;
 
-        if ( !pol_cnt )
-            continue;            //port not contained in any PortObject
+        p->pt_port_object[i] = last;
 
-        /* merge the rules into an optimal port object */
-        p->pt_port_object[i] =
-            PortTableCompileMergePortObjectList2(
-                mhash, mhashx, plx_list, pol, pol_cnt, p->pt_lrc);
-        assert( p->pt_port_object[i] );
-        p->pt_port_object[i]->id = id++;  // set the port object id
+        if ( last )
+            last->id = id++;  // set the port object id
     }
 
-    delete_port_lists(optimized_pl);
-    snort_free(optimized_pl);
-
     /*
      * Normalize the Ports so they indicate only the ports that
      * reference the composite port object
@@ -733,8 +779,13 @@ int PortTableCompile(PortTable* p)
     if ( !p->pt_optimize )
         return 0;
 
+    Stopwatch<SnortClock> timer;
+    timer.start();
+
     PortTableCompileMergePortObjects(p);
 
+    p->compile_usecs = TO_USECS(timer.get());
+
 #ifdef DEBUG
     PortTableConsistencyCheck(p);
     PortTableConsistencyCheck2(p);
@@ -878,3 +929,112 @@ void PortTableSortUniqRules(PortTable* p)
         RuleListSortUniq(po->rule_list);
     }
 }
+
+#ifdef UNIT_TEST
+
+// the port object lists that were built for each port before the sweep
+static std::vector<std::vector<PortObject*>> get_port_lists(PortTable* p)
+{
+    std::vector<std::vector<PortObject*>> lists(SFPO_MAX_PORTS);
+    SF_LNODE* lpos;
+
+    for ( PortObject* po = (PortObject*)sflist_first(p->pt_polist, &lpos);
+          po;
+          po = (PortObject*)sflist_next(&lpos) )
+    {
+        SF_LNODE* ipos;
+
+        for ( PortObjectItem* poi = (PortObjectItem*)sflist_first(po->item_list, &ipos);
+              poi;
+              poi = (PortObjectItem*)sflist_next(&ipos) )
+        {
+            if ( poi->any() )
+                break;
+
+            for ( int port = poi->lport; port <= poi->hport; port++ )
+            {
+                if ( lists[port].empty() or lists[port].back() != po )
+                    lists[port].emplace_back(po);
+            }
+        }
+    }
+    return lists;
+}
+
+// a mix of single ports, short and long ranges, clustered and spread out
+static PortTable* make_table(std::mt19937& rng)
+{
+    PortTable* pt = PortTableNew();
+    unsigned nobj = 5 + rng() % 60;
+    int rule = 0;
+
+    for ( unsigned i = 0; i < nobj; ++i )
+    {
+        PortObject* po = PortObjectNew();
+        unsigned nitems = 1 + rng() % 4;
+
+        for ( unsigned j = 0; j < nitems; ++j )
+        {
+            unsigned k = rng() % 10;
+            int scale = (rng() % 2) ? SFPO_MAX_PORTS : 2000;
+            int lport = rng() % scale;
+
+            if ( k < 5 )
+                PortObjectAddPort(po, lport);
+            else
+            {
+                int hport = lport + rng() % (k == 9 ? 30000 : 300);
+                PortObjectAddRange(po, lport, std::min(hport, SFPO_MAX_PORTS - 1));
+            }
+        }
+        unsigned nrules = 1 + rng() % 30;
+
+        for ( unsigned r = 0; r < nrules; ++r )
+            PortObjectAddRule(po, rule++);
+
+        PortTableAddObject(pt, po);
+    }
+    return pt;
+}
+
+TEST_CASE("sweep matches per port lists", "[PortTable]")
+{
+    std::mt19937 rng(47);
+    std::vector<PortObject*> pol(SFPO_MAX_LPORTS);
+
+    for ( unsigned t = 0; t < 20; ++t )
+    {
+        PortTable* pt = make_table(rng);
+        auto lists = get_port_lists(pt);
+        PortSweep sweep(pt);
+
+        for ( int port = 0; port < SFPO_MAX_PORTS; ++port )
+        {
+            bool changed = sweep.next(port);
+            int n = sweep.get_list(pol.data(), pol.size());
+            std::vector<PortObject*> list(pol.begin(), pol.begin() + n);
+
+            CHECK(list == lists[port]);
+
+            // an unchanged list is not merged again
+            if ( !changed )
+                CHECK(list == (port ? lists[port - 1] : std::vector<PortObject*>()));
+        }
+
+        // ports with the same list share one merged object
+        REQUIRE(PortTableCompile(pt) == 0);
+        std::map<std::vector<PortObject*>, PortObject2*> merged;
+
+        for ( int port = 0; port < SFPO_MAX_PORTS; ++port )
+        {
+            PortObject2* po = pt->pt_port_object[port];
+            CHECK(!po == lists[port].empty());
+
+            if ( po )
+                CHECK(merged.emplace(lists[port], po).first->second == po);
+        }
+        PortTableFree(pt);
+    }
+}
+
+#endif
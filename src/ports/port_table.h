@@ -69,6 +69,7 @@ struct PortTable
     int large_single_merges; /* 1 large + some small objects */
     int large_multi_merges; /* >1 large object merged + some small objects */
     int non_opt_merges;
+    uint64_t compile_usecs; /* time spent in PortTableCompile */
 };
 
 PortTable* PortTableNew();
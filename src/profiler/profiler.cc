@@ -27,6 +27,7 @@
 #include <cassert>
 
 #include "framework/module.h"
+#include "helpers/json_stream.h"
 #include "main/snort_config.h"
 #include "main/thread_config.h"
 #include "time/stopwatch.h"
@@ -38,6 +39,9 @@
 #include "time_profiler.h"
 
 #ifdef UNIT_TEST
+#include <chrono>
+#include <thread>
+
 #include "catch/snort_catch.h"
 #endif
 
@@ -126,6 +130,93 @@ void Profiler::show_stats()
     show_rule_profiler_stats(config->rule);
 }
 
+void Profiler::snapshot_stats(ProfilerStatsMap& snap)
+{
+    s_profiler_nodes.accumulate_nodes(snap);
+
+    // the run time is only set in totalPerfStats when the thread stops
+    if ( run_timer )
+        snap[ROOT_NODE].time.elapsed += run_timer->get();
+}
+
+static const ProfileStats& get_snapshot(const ProfilerStatsMap& snap, const std::string& name)
+{
+    static const ProfileStats none;
+    auto it = snap.find(name);
+    return it != snap.end() ? it->second : none;
+}
+
+static void dump_node(JsonStream& js, const char* key, const ProfilerNode& node,
+    const ProfilerStatsMap& snap)
+{
+    const ProfileStats& ps = get_snapshot(snap, node.name);
+
+    js.open(key);
+    js.put("name", node.name);
+    js.put("checks", ps.time.checks);
+    js.put("time_us", clock_usecs(TO_USECS(ps.time.elapsed)));
+
+#ifdef ENABLE_MEMORY_PROFILER
+    const auto& mem = ps.memory.stats.runtime;
+    js.put("allocs", mem.allocs);
+    js.put("deallocs", mem.deallocs);
+    js.put("allocated", mem.allocated);
+    js.put("deallocated", mem.deallocated);
+#endif
+
+    auto children = node.get_children();
+
+    if ( !children.empty() )
+    {
+        js.open_array("children");
+
+        for ( auto pn : children )
+            dump_node(js, nullptr, *pn, snap);
+
+        js.close_array();
+    }
+    js.close();
+}
+
+void Profiler::dump_stats(JsonStream& js, const ProfilerStatsMap& snap)
+{
+    const ProfilerNode& root = s_profiler_nodes.get_root();
+    ProfilerStatsMap tree = snap;
+
+    // other is whatever the top level modules don't account for
+    hr_duration runtime = get_snapshot(snap, ROOT_NODE).time.elapsed;
+    hr_duration sum = 0_ticks;
+
+    for ( auto pn : root.get_children() )
+    {
+        if ( pn->name != FLEX_NODE )
+            sum += get_snapshot(snap, pn->name).time.elapsed;
+    }
+
+    auto& other = tree[FLEX_NODE];
+    other.time.checks = get_snapshot(snap, ROOT_NODE).time.checks;
+    other.time.elapsed = (runtime > sum) ? (runtime - sum) : 0_ticks;
+
+    dump_node(js, "modules", root, tree);
+}
+
+static void get_subtree(const ProfilerNode& node, std::vector<const ProfileStats*>& list)
+{
+    if ( const auto* ps = node.get_thread_stats() )
+        list.emplace_back(ps);
+
+    for ( auto pn : node.get_children() )
+        get_subtree(*pn, list);
+}
+
+void Profiler::get_thread_subtrees(ProfilerSubtrees& trees)
+{
+    const ProfilerNode& root = s_profiler_nodes.get_root();
+
+    for ( auto pn : root.get_children() )
+        get_subtree(*pn, trees[pn->name]);
+}
+
 #ifdef UNIT_TEST
 
 TEST_CASE( "profile stats", "[profiler]" )
@@ -203,4 +294,47 @@ TEST_CASE( "profile stats", "[profiler]" )
     }
 }
 
+TEST_CASE( "nested profiles", "[profiler]" )
+{
+    TimeProfilerStats::set_enabled(true);
+
+    ProfileStats outer;
+    ProfileStats inner;
+
+    auto run = [&]()
+    {
+        NoMemContext o(outer);
+        {
+            NoMemContext i(inner);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    };
+
+    SECTION( "inclusive" )
+    {
+        TimeProfilerStats::set_exclusive(false);
+        run();
+
+        CHECK( outer.time.elapsed >= inner.time.elapsed );
+    }
+
+    SECTION( "exclusive" )
+    {
+        TimeProfilerStats::set_exclusive(true);
+        run();
+
+        // outer only has the time outside the sleep
+        CHECK( outer.time.elapsed < inner.time.elapsed / 2 );
+        CHECK( outer.time.checks == 1 );
+
+        // the chain is unwound
+        run();
+        CHECK( outer.time.elapsed < inner.time.elapsed / 2 );
+        CHECK( outer.time.checks == 2 );
+    }
+
+    TimeProfilerStats::set_exclusive(false);
+    TimeProfilerStats::set_enabled(false);
+}
+
 #endif
@@ -21,14 +21,22 @@
 #ifndef PROFILER_H
 #define PROFILER_H
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "main/thread.h"
 #include "profiler_defs.h"
 
 namespace snort
 {
+class JsonStream;
 class Module;
 }
 
+using ProfilerStatsMap = std::unordered_map<std::string, snort::ProfileStats>;
+using ProfilerSubtrees = std::unordered_map<std::string, std::vector<const snort::ProfileStats*>>;
+
 class Profiler
 {
 public:
@@ -42,6 +50,15 @@ public:
 
     static void reset_stats();
     static void show_stats();
+
+    // live dumps: snapshot adds this packet thread's stats to the map
+    // and dump writes the module tree for the map from the main thread
+    static void snapshot_stats(ProfilerStatsMap&);
+    static void dump_stats(snort::JsonStream&, const ProfilerStatsMap&);
+
+    // packet thread call; gets the calling thread's stats for each top
+    // level node and every node below it, keyed by the top level name
+    static void get_thread_subtrees(ProfilerSubtrees&);
 };
 
 extern THREAD_LOCAL snort::ProfileStats totalPerfStats;
@@ -96,18 +96,41 @@ private:
     MemoryContext memory;
     TimeContext* prev_time;
     static THREAD_LOCAL TimeContext* curr_time;
+
+    friend class NoMemContext;
 };
 
 using get_profile_stats_fn = ProfileStats* (*)(const char*);
 
-class NoMemContext
+// time is inclusive of nested profiles unless exclusive timing is enabled,
+// which ProfileContext always does
+class SO_PUBLIC NoMemContext
 {
 public:
-    NoMemContext(ProfileStats& stats) :
-        time(stats.time) { }
+    NoMemContext(ProfileStats& stats) : time(stats.time)
+    {
+        if ( !TimeProfilerStats::is_exclusive() )
+            return;
+
+        prev_time = ProfileContext::curr_time;
+        if ( prev_time )
+            prev_time->pause();
+        ProfileContext::curr_time = &time;
+    }
+
+    ~NoMemContext()
+    {
+        if ( ProfileContext::curr_time != &time )
+            return;
+
+        if ( prev_time )
+            prev_time->resume();
+        ProfileContext::curr_time = prev_time;
+    }
 
 private:
     TimeContext time;
+    TimeContext* prev_time = nullptr;
 };
 
 class ProfileDisabled
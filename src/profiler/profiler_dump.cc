@@ -0,0 +1,326 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// profiler_dump.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "profiler_dump.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include "control/control.h"
+#include "helpers/json_stream.h"
+#include "log/messages.h"
+#include "main/snort_config.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+// main thread only; the previous dump for deltas
+static ProfilerStatsMap s_last_modules;
+static ProfilerDump::RuleStatsMap s_last_rules;
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+// counters that went backwards were reset (or reloaded) since the
+// last dump so all of the current count is new
+template<typename T>
+static inline void sub(T& now, const T& then)
+{ now = (now >= then) ? now - then : now; }
+
+static void sub(MemoryStats& now, const MemoryStats& then)
+{
+    sub(now.allocs, then.allocs);
+    sub(now.deallocs, then.deallocs);
+    sub(now.allocated, then.allocated);
+    sub(now.deallocated, then.deallocated);
+}
+
+static void get_delta(ProfilerStatsMap& now, const ProfilerStatsMap& then)
+{
+    for ( auto& it : now )
+    {
+        auto prev = then.find(it.first);
+
+        if ( prev == then.end() )
+            continue;
+
+        auto& ps = it.second;
+        const auto& pp = prev->second;
+
+        sub(ps.time.elapsed, pp.time.elapsed);
+        sub(ps.time.checks, pp.time.checks);
+        sub(ps.memory.stats.startup, pp.memory.stats.startup);
+        sub(ps.memory.stats.runtime, pp.memory.stats.runtime);
+    }
+}
+
+static void get_delta(ProfilerDump::RuleStatsMap& now, const ProfilerDump::RuleStatsMap& then)
+{
+    for ( auto& it : now )
+    {
+        auto prev = then.find(it.first);
+
+        if ( prev == then.end() )
+            continue;
+
+        auto& os = it.second;
+        const auto& op = prev->second;
+
+        sub(os.elapsed, op.elapsed);
+        sub(os.elapsed_match, op.elapsed_match);
+        sub(os.elapsed_no_match, op.elapsed_no_match);
+        sub(os.elapsed_var, op.elapsed_var);
+        sub(os.checks, op.checks);
+        sub(os.matches, op.matches);
+        sub(os.alerts, op.alerts);
+        sub(os.latency_timeouts, op.latency_timeouts);
+        sub(os.latency_suspends, op.latency_suspends);
+    }
+}
+
+static void add(OtnState& lhs, const OtnState& rhs)
+{
+    lhs.elapsed += rhs.elapsed;
+    lhs.elapsed_match += rhs.elapsed_match;
+    lhs.elapsed_no_match += rhs.elapsed_no_match;
+    lhs.elapsed_var += rhs.elapsed_var;
+    lhs.checks += rhs.checks;
+    lhs.matches += rhs.matches;
+    lhs.alerts += rhs.alerts;
+    lhs.latency_timeouts += rhs.latency_timeouts;
+    lhs.latency_suspends += rhs.latency_suspends;
+}
+
+static void dump_rules(JsonStream& js, const ProfilerDump::RuleStatsMap& rules)
+{
+    using Entry = ProfilerDump::RuleStatsMap::const_iterator;
+    std::vector<Entry> entries;
+
+    for ( auto it = rules.cbegin(); it != rules.cend(); ++it )
+    {
+        if ( it->second )
+            entries.emplace_back(it);
+    }
+
+    std::sort(entries.begin(), entries.end(),
+        [](const Entry& lhs, const Entry& rhs)
+        { return lhs->second.elapsed > rhs->second.elapsed; });
+
+    js.open_array("rules");
+
+    for ( const auto& e : entries )
+    {
+        const auto& os = e->second;
+
+        js.open();
+        js.put("gid", std::get<0>(e->first));
+        js.put("sid", std::get<1>(e->first));
+        js.put("rev", std::get<2>(e->first));
+        js.put("checks", os.checks);
+        js.put("matches", os.matches);
+        js.put("alerts", os.alerts);
+        js.put("time_us", clock_usecs(TO_USECS(os.elapsed)));
+        js.put("match_time_us", clock_usecs(TO_USECS(os.elapsed_match)));
+
+        // 95% confidence bound when rule profiling is sampled
+        if ( os.elapsed_var > 0 )
+        {
+            hr_duration bound(static_cast<uint64_t>(1.96 * std::sqrt(os.elapsed_var)));
+            js.put("time_bound_us", clock_usecs(TO_USECS(bound)));
+        }
+        js.put("timeouts", os.latency_timeouts);
+        js.put("suspends", os.latency_suspends);
+        js.close();
+    }
+    js.close_array();
+}
+
+// responses are formatted into STD_BUF sized buffers
+static void respond(ControlConn* ctrlcon, const std::string& s)
+{
+    const size_t max = STD_BUF / 2;
+
+    for ( size_t pos = 0; pos < s.size(); pos += max )
+    {
+        std::string chunk = s.substr(pos, max);
+        LogRespond(ctrlcon, "%s", chunk.c_str());
+    }
+}
+
+//-------------------------------------------------------------------------
+// command
+//-------------------------------------------------------------------------
+
+ProfilerDump::ProfilerDump(ControlConn* conn, bool delta) :
+    AnalyzerCommand(conn), sc(SnortConfig::get_conf()), delta(delta)
+{
+    // the option tree hash can't be walked by several threads at once
+    if ( sc->get_profiler()->rule.show )
+        detection_option_tree_get_nodes(sc->detection_option_tree_hash_table, dot_nodes);
+}
+
+bool ProfilerDump::execute(Analyzer&, void**)
+{
+    ProfilerStatsMap thread_modules;
+    Profiler::snapshot_stats(thread_modules);
+
+    // skip the rules if this thread hasn't been swapped to the config
+    // the node list was taken from
+    OtnStateMap thread_rules;
+
+    if ( SnortConfig::get_conf() == sc )
+        detection_option_tree_get_otn_stats(dot_nodes, thread_rules);
+
+    std::lock_guard<std::mutex> lock(stats_mutex);
+
+    for ( const auto& it : thread_modules )
+        modules[it.first] += it.second;
+
+    for ( const auto& it : thread_rules )
+    {
+        const auto& si = it.first->sigInfo;
+        add(rules[RuleKey(si.gid, si.sid, si.rev)], it.second);
+    }
+    return true;
+}
+
+ProfilerDump::~ProfilerDump()
+{
+    ProfilerStatsMap module_stats = modules;
+    RuleStatsMap rule_stats = rules;
+
+    if ( delta )
+    {
+        get_delta(module_stats, s_last_modules);
+        get_delta(rule_stats, s_last_rules);
+    }
+
+    s_last_modules = std::move(modules);
+    s_last_rules = std::move(rules);
+
+    std::ostringstream ss;
+    {
+        JsonStream js(ss);
+        js.open();
+
+        if ( delta )
+            js.put_true("delta");
+        else
+            js.put_false("delta");
+
+        Profiler::dump_stats(js, module_stats);
+        dump_rules(js, rule_stats);
+        js.close();
+    }
+    respond(ctrlcon, ss.str());
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE( "profiler dump module delta", "[profiler]" )
+{
+    ProfilerStatsMap then;
+    then["foo"].time = { 10_ticks, 2 };
+    then["bar"].time = { 5_ticks, 5 };
+
+    ProfilerStatsMap now;
+    now["foo"].time = { 15_ticks, 3 };
+    now["bar"].time = { 2_ticks, 1 };   // reset since then
+    now["baz"].time = { 7_ticks, 7 };   // new since then
+
+    get_delta(now, then);
+
+    CHECK( (now["foo"].time == TimeProfilerStats(5_ticks, 1)) );
+    CHECK( (now["bar"].time == TimeProfilerStats(2_ticks, 1)) );
+    CHECK( (now["baz"].time == TimeProfilerStats(7_ticks, 7)) );
+}
+
+TEST_CASE( "profiler dump rule delta", "[profiler]" )
+{
+    ProfilerDump::RuleKey key(1, 1000, 2);
+
+    OtnState os;
+    os.elapsed = 4_ticks;
+    os.checks = 10;
+    os.matches = 3;
+    os.alerts = 1;
+
+    ProfilerDump::RuleStatsMap then;
+    add(then[key], os);
+
+    ProfilerDump::RuleStatsMap now;
+    add(now[key], os);
+    add(now[key], os);
+
+    get_delta(now, then);
+
+    const auto& d = now[key];
+    CHECK( (d.elapsed == 4_ticks) );
+    CHECK( d.checks == 10 );
+    CHECK( d.matches == 3 );
+    CHECK( d.alerts == 1 );
+}
+
+TEST_CASE( "profiler dump rules json", "[profiler]" )
+{
+    OtnState slow;
+    slow.elapsed = 100_ticks;
+    slow.checks = 1;
+
+    OtnState fast;
+    fast.elapsed = 1_ticks;
+    fast.checks = 1;
+
+    ProfilerDump::RuleStatsMap rules;
+    add(rules[ProfilerDump::RuleKey(1, 1, 1)], fast);
+    add(rules[ProfilerDump::RuleKey(1, 2, 1)], slow);
+    rules[ProfilerDump::RuleKey(1, 3, 1)];  // never checked
+
+    std::ostringstream ss;
+    JsonStream js(ss);
+    js.open();
+    dump_rules(js, rules);
+    js.close();
+
+    std::string s = ss.str();
+    auto p1 = s.find("\"sid\": 1,");
+    auto p2 = s.find("\"sid\": 2,");
+
+    CHECK( p1 != std::string::npos );
+    CHECK( p2 != std::string::npos );
+    CHECK( p2 < p1 );
+    CHECK( s.find("\"sid\": 3,") == std::string::npos );
+}
+
+#endif
@@ -0,0 +1,67 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// profiler_dump.h
+
+#ifndef PROFILER_DUMP_H
+#define PROFILER_DUMP_H
+
+// profiler.dump() takes a live snapshot of the module and rule profiles.
+// Each packet thread adds its own counts between packets so nothing is
+// stopped or reset and the shutdown totals are not disturbed.
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include "detection/detection_options.h"
+#include "detection/treenodes.h"
+#include "main/analyzer_command.h"
+
+#include "profiler.h"
+
+namespace snort
+{
+struct SnortConfig;
+}
+
+class ProfilerDump : public snort::AnalyzerCommand
+{
+public:
+    using RuleKey = std::tuple<uint32_t, uint32_t, uint32_t>;  // gid, sid, rev
+    using RuleStatsMap = std::map<RuleKey, OtnState>;
+
+    ProfilerDump(ControlConn*, bool delta);
+    ~ProfilerDump() override;
+
+    bool execute(Analyzer&, void**) override;
+    const char* stringify() override { return "PROFILER_DUMP"; }
+
+private:
+    const snort::SnortConfig* sc;
+    DotNodeList dot_nodes;
+    bool delta;
+
+    std::mutex stats_mutex;
+    ProfilerStatsMap modules;
+    RuleStatsMap rules;
+};
+
+#endif
+
@@ -122,6 +122,15 @@ void ProfilerNode::accumulate()
     }
 }
 
+void ProfilerNode::accumulate(ProfileStats& ps) const
+{
+    if ( const auto* local_stats = get_thread_stats() )
+        ps += *local_stats;
+}
+
+const ProfileStats* ProfilerNode::get_thread_stats() const
+{ return is_set() ? (*getter)() : nullptr; }
+
 void ProfilerNodeMap::register_node(const std::string &n, const char* pn, Module* m)
 { setup_node(get_node(n), get_node(pn ? pn : ROOT_NODE), m); }
 
@@ -134,6 +143,12 @@ void ProfilerNodeMap::accumulate_nodes()
         it->second.accumulate();
 }
 
+void ProfilerNodeMap::accumulate_nodes(ProfilerStatsMap& snap) const
+{
+    for ( const auto& it : nodes )
+        it.second.accumulate(snap[it.first]);
+}
+
 void ProfilerNodeMap::accumulate_flex()
 {
     auto it = nodes.find(FLEX_NODE);
@@ -271,6 +286,19 @@ TEST_CASE( "profiler node", "[profiler]" )
         CHECK( (result.time.checks == 2) );
     }
 
+    SECTION( "snapshot" )
+    {
+        the_stats.time = { 3_ticks, 2 };
+
+        ProfileStats snap;
+        node.accumulate(snap);
+        node.accumulate(snap);
+
+        CHECK( (snap.time.elapsed == 6_ticks) );
+        CHECK( (snap.time.checks == 4) );
+        CHECK( node.get_stats() == ProfileStats() );
+    }
+
     SECTION( "reset" )
     {
         the_stats.time = { 1_ticks, 1 };
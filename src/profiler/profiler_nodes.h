@@ -26,6 +26,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "profiler.h"
 #include "profiler_defs.h"
 
 namespace snort
@@ -49,6 +50,12 @@ public:
     // thread local call
     void accumulate();
 
+    // thread local call; adds to the given stats, node stats are unchanged
+    void accumulate(snort::ProfileStats&) const;
+
+    // thread local call; the calling thread's stats or nullptr
+    const snort::ProfileStats* get_thread_stats() const;
+
     const snort::ProfileStats& get_stats() const
     { return stats; }
 
@@ -92,6 +99,7 @@ public:
     void register_node(const std::string&, const char*, snort::Module*);
 
     void accumulate_nodes();
+    void accumulate_nodes(ProfilerStatsMap&) const;
     void accumulate_flex();
     void reset_nodes();
 
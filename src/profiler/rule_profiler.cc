@@ -25,6 +25,7 @@
 #include "rule_profiler.h"
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <iostream>
 #include <sstream>
@@ -58,6 +59,9 @@ using namespace snort;
 #define s_rule_table_title "rule profile"
 
 bool RuleContext::enabled = false;
+unsigned RuleContext::sample_rate = 1;
+THREAD_LOCAL bool RuleContext::sampled = true;
+THREAD_LOCAL unsigned RuleContext::countdown = 1;
 struct timeval RuleContext::start_time = {0, 0};
 struct timeval RuleContext::end_time = {0, 0};
 struct timeval RuleContext::total_time = {0, 0};
@@ -66,6 +70,7 @@ static inline OtnState& operator+=(OtnState& lhs, const OtnState& rhs)
 {
     lhs.elapsed += rhs.elapsed;
     lhs.elapsed_match += rhs.elapsed_match;
+    lhs.elapsed_var += rhs.elapsed_var;
     lhs.checks += rhs.checks;
     lhs.matches += rhs.matches;
     lhs.alerts += rhs.alerts;
@@ -94,6 +99,30 @@ static const StatsTable::Field fields[] =
     { nullptr, 0, '\0', 0, std::ios_base::fmtflags() }
 };
 
+// sampled times are estimates so the 95% confidence bound is added
+static const StatsTable::Field sampled_fields[] =
+{
+    { "#", 5, '\0', 0, std::ios_base::left },
+    { "gid", 6, '\0', 0, std::ios_base::fmtflags() },
+    { "sid", 6, '\0', 0, std::ios_base::fmtflags() },
+    { "rev", 4, '\0', 0, std::ios_base::fmtflags() },
+    { "checks", 10, '\0', 0, std::ios_base::fmtflags() },
+    { "matches", 8, '\0', 0, std::ios_base::fmtflags() },
+    { "alerts", 7, '\0', 0, std::ios_base::fmtflags() },
+    { "time (us)", 10, '\0', 0, std::ios_base::fmtflags() },
+    { "+/- (us)", 9, '\0', 0, std::ios_base::fmtflags() },
+    { "avg/check", 10, '\0', 1, std::ios_base::fmtflags() },
+    { "avg/match", 10, '\0', 1, std::ios_base::fmtflags() },
+    { "avg/non-match", 14, '\0', 1, std::ios_base::fmtflags() },
+    { "timeouts", 9, '\0', 0, std::ios_base::fmtflags() },
+    { "suspends", 9, '\0', 0, std::ios_base::fmtflags() },
+    { "rule_time (%)", 14, '\0', 5, std::ios_base::fmtflags() },
+    { nullptr, 0, '\0', 0, std::ios_base::fmtflags() }
+};
+
+static const StatsTable::Field* get_fields()
+{ return RuleContext::get_sample_rate() > 1 ? sampled_fields : fields; }
+
 struct View
 {
     OtnState state;
@@ -108,6 +137,10 @@ struct View
     hr_duration elapsed_no_match() const
     { return elapsed() - elapsed_match(); }
 
+    // 95% confidence bound on the extrapolated elapsed time
+    hr_duration elapsed_bound() const
+    { return hr_duration(static_cast<uint64_t>(1.96 * std::sqrt(state.elapsed_var))); }
+
     uint64_t checks() const
     { return state.checks; }
 
@@ -244,7 +277,7 @@ static void print_single_entry(const View& v, unsigned n, double total_time_usec
     std::ostringstream ss;
 
     {
-        StatsTable table(fields, ss);
+        StatsTable table(get_fields(), ss);
 
         table << StatsTable::ROW;
 
@@ -259,6 +292,10 @@ static void print_single_entry(const View& v, unsigned n, double total_time_usec
         table << v.alerts();
 
         table << clock_usecs(TO_USECS(v.elapsed()));
+
+        if ( RuleContext::get_sample_rate() > 1 )
+            table << clock_usecs(TO_USECS(v.elapsed_bound()));
+
         table << clock_usecs(TO_USECS(v.avg_check()));
         table << clock_usecs(TO_USECS(v.avg_match()));
         table << clock_usecs(TO_USECS(v.avg_no_match()));
@@ -282,7 +319,7 @@ static void print_entries(std::vector<View>& entries, ProfilerSorter<View>& sort
         RuleContext::get_total_time()->tv_sec * 1000000.0 + RuleContext::get_total_time()->tv_usec;
 
     {
-        StatsTable table(fields, ss);
+        StatsTable table(get_fields(), ss);
 
         table << StatsTable::SEP;
 
@@ -295,6 +332,9 @@ static void print_entries(std::vector<View>& entries, ProfilerSorter<View>& sort
         if ( sort )
             table << ", sorted by " << sort.name;
 
+        if ( RuleContext::get_sample_rate() > 1 )
+            table << ", sampled 1 in " << RuleContext::get_sample_rate();
+
         table << ")\n";
 
         table << StatsTable::HEADER;
@@ -362,7 +402,27 @@ void RuleContext::stop(bool match)
         return;
 
     finished = true;
-    stats.update(sw.get(), match);
+
+    if ( timed )
+        stats.update(sw.get(), match);
+    else
+        stats.count();
+}
+
+// the gap to the next timed evaluation is uniform over [1, 2n - 1] so the
+// mean is n but periodic traffic can't line up with the samples
+unsigned RuleContext::next_gap()
+{
+    if ( sample_rate == 1 )
+        return 1;
+
+    static THREAD_LOCAL uint32_t seed = 2463534242;
+
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    return 1 + seed % (2 * sample_rate - 1);
 }
 
 void RuleContext::set_start_time(const struct timeval &time)
@@ -811,6 +871,42 @@ TEST_CASE( "rule profiler time context", "[profiler][rule_profiler]" )
     RuleContext::set_enabled(false);
 }
 
+TEST_CASE( "rule profiler sampling", "[profiler][rule_profiler]" )
+{
+    dot_node_state_t stats { };
+    RuleContext::set_enabled(true);
+    RuleContext::set_sample_rate(4);
+
+    for ( int i = 0; i < 4000; ++i )
+    {
+        RuleContext::sample();
+        RuleContext ctx(stats);
+        avoid_optimization();
+    }
+
+    CHECK( stats.checks == 4000 );
+    CHECK( stats.timed > 500 );
+    CHECK( stats.timed < 1500 );
+    CHECK( (stats.elapsed > 0_ticks) );
+    CHECK( stats.elapsed_sq > 0 );
+
+    // let the last gap run out so everything is timed again
+    RuleContext::set_sample_rate(1);
+
+    for ( int i = 0; i < 8; ++i )
+        RuleContext::sample();
+
+    stats = { };
+    {
+        RuleContext::sample();
+        RuleContext ctx(stats);
+    }
+    CHECK( stats.checks == 1 );
+    CHECK( stats.timed == 1 );
+
+    RuleContext::set_enabled(false);
+}
+
 TEST_CASE( "rule pause", "[profiler][rule_profiler]" )
 {
     dot_node_state_t stats;
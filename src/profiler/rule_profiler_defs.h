@@ -21,6 +21,7 @@
 #ifndef RULE_PROFILER_DEFS_H
 #define RULE_PROFILER_DEFS_H
 
+#include "main/thread.h"
 #include "time/clock_defs.h"
 #include "time/stopwatch.h"
 
@@ -42,32 +43,53 @@ struct RuleProfilerConfig
 
     bool show = false;
     unsigned count = 0;
+    unsigned sample = 1;
 };
 
 class RuleContext
 {
 public:
     RuleContext(dot_node_state_t& stats) :
-        stats(stats)
+        stats(stats), timed(sampled)
     { start(); }
 
     ~RuleContext()
     { stop(); }
 
     void start()
-    { if ( enabled ) sw.start(); }
+    { if ( enabled and timed ) sw.start(); }
 
     void pause()
-    { if ( enabled ) sw.stop(); }
+    { if ( enabled and timed ) sw.stop(); }
 
     void stop(bool = false);
 
     bool active() const
-    { return enabled and sw.active(); }
+    { return enabled and timed and sw.active(); }
 
     static void set_enabled(bool b)
     { enabled = b; }
 
+    // time 1 in n rule tree evaluations per packet thread; the rest are
+    // only counted and the times are extrapolated at shutdown
+    static void set_sample_rate(unsigned n)
+    { sample_rate = n ? n : 1; }
+
+    static unsigned get_sample_rate()
+    { return sample_rate; }
+
+    // call once per rule tree evaluation
+    static void sample()
+    {
+        if ( --countdown )
+            sampled = false;
+        else
+        {
+            sampled = true;
+            countdown = next_gap();
+        }
+    }
+
     static const struct timeval *get_start_time()
     { return &start_time; }
 
@@ -86,14 +108,19 @@ public:
 private:
     dot_node_state_t& stats;
     Stopwatch<SnortClock> sw;
+    bool timed;
     bool finished = false;
     static bool enabled;
+    static unsigned sample_rate;
+    static THREAD_LOCAL bool sampled;
+    static THREAD_LOCAL unsigned countdown;
     static struct timeval start_time;
     static struct timeval end_time;
     static struct timeval total_time;
 
     static void valid_start_time();
     static void valid_end_time();
+    static unsigned next_gap();
 };
 
 class RulePause
@@ -42,6 +42,7 @@ using namespace snort;
 // enabled is not in TimeContext because declaring it SO_PUBLIC made TimeContext visible
 // putting enabled in TimeProfilerStats seems to be the best solution
 bool TimeProfilerStats::enabled = false;
+bool TimeProfilerStats::exclusive = false;
 
 namespace time_stats
 {
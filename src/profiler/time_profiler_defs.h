@@ -48,6 +48,7 @@ struct SO_PUBLIC TimeProfilerStats
     uint64_t checks;
     mutable unsigned int ref_count;
     static bool enabled;
+    static bool exclusive;
 
     static void set_enabled(bool b)
     { enabled = b; }
@@ -55,6 +56,13 @@ struct SO_PUBLIC TimeProfilerStats
     static bool is_enabled()
     { return enabled; }
 
+    // exclude nested module profiles from their callers' time
+    static void set_exclusive(bool b)
+    { exclusive = b; }
+
+    static bool is_exclusive()
+    { return exclusive; }
+
     void update(hr_duration delta)
     { elapsed += delta; ++checks; }
 
@@ -41,6 +41,13 @@
 #include "icmp4.h"
 #include "icmp6.h"
 
+#ifdef UNIT_TEST
+#include <vector>
+
+#include "catch/snort_catch.h"
+#include "detection/ips_context.h"
+#endif
+
 using namespace snort;
 
 THREAD_LOCAL ProfileStats decodePerfStats;
@@ -64,7 +71,9 @@ const std::array<const char*, PacketManager::stat_offset> PacketManager::stat_na
         "total",
         "other",
         "discards",
-        "depth_exceeded"
+        "depth_exceeded",
+        "fast_path",
+        "fast_path_exits"
     }
 };
 
@@ -211,151 +220,298 @@ static_assert(CODEC_ENCAP_LAYER == (CODEC_UNSURE_ENCAP | CODEC_SAVE_LAYER),
 //-------------------------------------------------------------------------
 // Encode/Decode functions
 //-------------------------------------------------------------------------
-void PacketManager::decode(
-    Packet* p, const DAQ_PktHdr_t* pkthdr, const uint8_t* pkt, uint32_t pktlen, bool cooked, bool retry)
-{
-    Profile profile(decodePerfStats);
-
-    DecodeData unsure_encap_ptrs;
-
-    ProtocolIndex mapped_prot = CodecManager::grinder;
-    ProtocolId prev_prot_id = CodecManager::grinder_id;
-
-    RawData raw(p->daq_msg, pkt, pktlen);
-    CodecData codec_data(p->context->conf, ProtocolId::FINISHED_DECODE);
 
-    if (cooked)
-        codec_data.codec_flags |= CODEC_STREAM_REBUILT;
-
-    // initialize all Packet information
-    p->reset();
-    p->pkth = pkthdr;
-    p->pkt = pkt;
-    p->pktlen = pktlen;
-    if (retry)
-        p->packet_flags |= PKT_RETRY;
-    layer::set_packet_pointer(p);
-
-    s_stats[total_processed]++;
+static inline void trace_layer(const Packet* p, const RawData& raw, const CodecData& codec_data,
+    ProtocolIndex mapped_prot, ProtocolId prev_prot_id)
+{
+    debug_logf(decode_trace, nullptr,
+        "Codec %s (0x%0*hx) starts at %u, length is %hu\n",
+        CodecManager::s_protocols[mapped_prot]->get_name(),
+        (static_cast<uint16_t>(prev_prot_id) < 0xFF) ? 2 : 4,
+        static_cast<uint16_t>(prev_prot_id),
+        p->pktlen - raw.len, codec_data.lyr_len);
+
+#ifndef DEBUG_MSGS
+    UNUSED(p);
+    UNUSED(raw);
+    UNUSED(codec_data);
+    UNUSED(mapped_prot);
+    UNUSED(prev_prot_id);
+#endif
+}
 
-    // loop until the protocol id is no longer valid
-    while (CodecManager::s_protocols[mapped_prot]->decode(raw, codec_data, p->ptrs))
+// record the layer just decoded and advance to the next one.  returns false
+// if decoding must stop here.
+bool PacketManager::finish_layer(Packet* p, RawData& raw, CodecData& codec_data,
+    DecodeData& unsure_encap_ptrs, ProtocolIndex& mapped_prot, ProtocolId& prev_prot_id)
+{
+    if (codec_data.codec_flags & CODEC_COMPOUND)
     {
-        debug_logf(decode_trace, nullptr,
-            "Codec %s (0x%0*hx) starts at %u, length is %hu\n",
-            CodecManager::s_protocols[mapped_prot]->get_name(),
-            (static_cast<uint16_t>(prev_prot_id) < 0xFF) ? 2 : 4,
-            static_cast<uint16_t>(prev_prot_id),
-            pktlen - raw.len, codec_data.lyr_len);
-
-        if (codec_data.codec_flags & CODEC_COMPOUND)
+        for (int idx = 0; idx < codec_data.compound_layer_cnt; idx++)
         {
-            for (int idx = 0; idx < codec_data.compound_layer_cnt; idx++)
-            {
-                CompoundLayer* clyr = &codec_data.compound_layers[idx];
+            CompoundLayer* clyr = &codec_data.compound_layers[idx];
 
-                // If this was an IP layer, stash the next protocol in the Packet for later
-                if (clyr->proto_bits & (PROTO_BIT__IP | PROTO_BIT__IP6_EXT) &&
-                    idx + 1 < codec_data.compound_layer_cnt)
-                {
-                    CompoundLayer* nclyr = &codec_data.compound_layers[idx + 1];
-                    p->ip_proto_next = convert_protocolid_to_ipprotocol(nclyr->layer.prot_id);
-                }
-                p->proto_bits |= clyr->proto_bits;
+            // If this was an IP layer, stash the next protocol in the Packet for later
+            if (clyr->proto_bits & (PROTO_BIT__IP | PROTO_BIT__IP6_EXT) &&
+                idx + 1 < codec_data.compound_layer_cnt)
+            {
+                CompoundLayer* nclyr = &codec_data.compound_layers[idx + 1];
+                p->ip_proto_next = convert_protocolid_to_ipprotocol(nclyr->layer.prot_id);
+            }
+            p->proto_bits |= clyr->proto_bits;
 
-                // If we have reached the MAX_LAYERS, we keep decoding
-                // but no longer keep track of the layers.
-                if (!push_layer(p, codec_data, clyr->layer.prot_id, clyr->layer.start, clyr->layer.length))
-                    continue;
+            // If we have reached the MAX_LAYERS, we keep decoding
+            // but no longer keep track of the layers.
+            if (!push_layer(p, codec_data, clyr->layer.prot_id, clyr->layer.start, clyr->layer.length))
+                continue;
 
-                // Cache the index of the vlan layer for quick access.
-                if (clyr->proto_bits == PROTO_BIT__VLAN)
-                    p->vlan_idx = p->num_layers - 1;
-            }
-            codec_data.codec_flags &= ~CODEC_COMPOUND;
+            // Cache the index of the vlan layer for quick access.
+            if (clyr->proto_bits == PROTO_BIT__VLAN)
+                p->vlan_idx = p->num_layers - 1;
         }
-        else
+        codec_data.codec_flags &= ~CODEC_COMPOUND;
+    }
+    else
+    {
+        // If this was an IP layer, stash the next protocol in the Packet for later
+        if (codec_data.proto_bits & (PROTO_BIT__IP | PROTO_BIT__IP6_EXT))
         {
-            // If this was an IP layer, stash the next protocol in the Packet for later
-            if (codec_data.proto_bits & (PROTO_BIT__IP | PROTO_BIT__IP6_EXT))
+            // FIXIT-M refactor when ip_proto's become an array
+            if (p->is_fragment())
             {
-                // FIXIT-M refactor when ip_proto's become an array
-                if (p->is_fragment())
+                if (prev_prot_id == ProtocolId::FRAGMENT)
                 {
-                    if (prev_prot_id == ProtocolId::FRAGMENT)
-                    {
-                        const ip::IP6Frag* const fragh = reinterpret_cast<const ip::IP6Frag*>(raw.data);
-                        p->ip_proto_next = fragh->next();
-                    }
-                    else
-                        p->ip_proto_next = p->ptrs.ip_api.get_ip4h()->proto();
+                    const ip::IP6Frag* const fragh = reinterpret_cast<const ip::IP6Frag*>(raw.data);
+                    p->ip_proto_next = fragh->next();
                 }
                 else
-                {
-                    if (codec_data.next_prot_id != ProtocolId::FINISHED_DECODE)
-                        p->ip_proto_next = convert_protocolid_to_ipprotocol(codec_data.next_prot_id);
-                }
+                    p->ip_proto_next = p->ptrs.ip_api.get_ip4h()->proto();
             }
-
-            // If we have reached the MAX_LAYERS, we keep decoding
-            // but no longer keep track of the layers.
-            if (push_layer(p, codec_data, prev_prot_id, raw.data, codec_data.lyr_len))
+            else
             {
-                // Cache the index of the vlan layer for quick access.
-                if (codec_data.proto_bits == PROTO_BIT__VLAN)
-                    p->vlan_idx = p->num_layers - 1;
+                if (codec_data.next_prot_id != ProtocolId::FINISHED_DECODE)
+                    p->ip_proto_next = convert_protocolid_to_ipprotocol(codec_data.next_prot_id);
             }
         }
 
-        if (codec_data.tunnel_bypass)
+        // If we have reached the MAX_LAYERS, we keep decoding
+        // but no longer keep track of the layers.
+        if (push_layer(p, codec_data, prev_prot_id, raw.data, codec_data.lyr_len))
         {
-            p->active->set_tunnel_bypass();
-            codec_data.tunnel_bypass = false;
+            // Cache the index of the vlan layer for quick access.
+            if (codec_data.proto_bits == PROTO_BIT__VLAN)
+                p->vlan_idx = p->num_layers - 1;
         }
+    }
 
-        // Sanity check the next protocol ID is a valid ethertype
-        if (codec_data.codec_flags & CODEC_ETHER_NEXT)
+    if (codec_data.tunnel_bypass)
+    {
+        p->active->set_tunnel_bypass();
+        codec_data.tunnel_bypass = false;
+    }
+
+    // Sanity check the next protocol ID is a valid ethertype
+    if (codec_data.codec_flags & CODEC_ETHER_NEXT)
+    {
+        if (codec_data.next_prot_id < ProtocolId::ETHERTYPE_MINIMUM)
         {
-            if (codec_data.next_prot_id < ProtocolId::ETHERTYPE_MINIMUM)
-            {
-                DetectionEngine::queue_event(GID_DECODE, DECODE_BAD_ETHER_TYPE);
-                break;
-            }
-            codec_data.codec_flags &= ~CODEC_ETHER_NEXT;
+            DetectionEngine::queue_event(GID_DECODE, DECODE_BAD_ETHER_TYPE);
+            return false;
         }
+        codec_data.codec_flags &= ~CODEC_ETHER_NEXT;
+    }
 
-        /*
-         * We only want the layer immediately following SAVE_LAYER to have the
-         * UNSURE_ENCAP flag set.  So, if this is a SAVE_LAYER, zero out the
-         * bit and the next time around, when this is no longer SAVE_LAYER,
-         * we will zero out the UNSURE_ENCAP flag.
-         */
-        if (codec_data.codec_flags & CODEC_SAVE_LAYER)
+    /*
+     * We only want the layer immediately following SAVE_LAYER to have the
+     * UNSURE_ENCAP flag set.  So, if this is a SAVE_LAYER, zero out the
+     * bit and the next time around, when this is no longer SAVE_LAYER,
+     * we will zero out the UNSURE_ENCAP flag.
+     */
+    if (codec_data.codec_flags & CODEC_SAVE_LAYER)
+    {
+        codec_data.codec_flags &= ~CODEC_SAVE_LAYER;
+        unsure_encap_ptrs = p->ptrs;
+    }
+    else if (codec_data.codec_flags & CODEC_UNSURE_ENCAP)
+        codec_data.codec_flags &= ~CODEC_UNSURE_ENCAP;
+
+    next_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+    return true;
+}
+
+inline void PacketManager::next_layer(Packet* p, RawData& raw, CodecData& codec_data,
+    ProtocolIndex& mapped_prot, ProtocolId& prev_prot_id)
+{
+    // internal statistics and record keeping
+    s_stats[mapped_prot + stat_offset]++; // add correct decode for previous layer
+    mapped_prot = CodecManager::s_proto_map[to_utype(codec_data.next_prot_id)];
+    prev_prot_id = codec_data.next_prot_id;
+
+    // Shrink the buffer of undecoded data
+    const uint16_t curr_lyr_len = codec_data.lyr_len + codec_data.invalid_bytes;
+    assert(curr_lyr_len <= raw.len);
+    raw.len -= curr_lyr_len;
+    raw.data += curr_lyr_len;
+
+    p->proto_bits |= codec_data.proto_bits;
+
+    // Reset the volatile part of the codec data for the next codec to decode into
+    codec_data.next_prot_id = ProtocolId::FINISHED_DECODE;
+    codec_data.lyr_len = 0;
+    codec_data.invalid_bytes = 0;
+    codec_data.proto_bits = 0;
+}
+
+//-------------------------------------------------------------------------
+// Fast path
+//
+// Most traffic is plain Ethernet / IP / TCP, UDP or ICMP.  For those
+// stacks, picked by a quick look at the first bytes, Ethernet is decoded
+// inline and the IP and transport codecs are called back to back with
+// only the bookkeeping that a plain layer needs.  The codecs still do all
+// of the validation, so events, DecodeData and layers are identical to the
+// generic loop.  As soon as a layer needs more (compound layers, saved
+// encapsulations, fragments, tunnel bypass, etc.) finish_layer() takes
+// over and the generic loop continues from the next layer.
+//-------------------------------------------------------------------------
+
+// unit tests compare the fast path with the generic loop
+#ifdef UNIT_TEST
+static bool s_fast_path = true;
+#else
+static constexpr bool s_fast_path = true;
+#endif
+
+static inline bool fast_path_transport(uint8_t proto)
+{
+    switch (static_cast<IpProtocol>(proto))
+    {
+        case IpProtocol::TCP:
+        case IpProtocol::UDP:
+        case IpProtocol::ICMPV4:
+        case IpProtocol::ICMPV6:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static inline bool fast_path_candidate(const uint8_t* pkt, uint32_t len)
+{
+    if (len < eth::ETH_HEADER_LEN + ip::IP4_HEADER_LEN)
+        return false;
+
+    const eth::EtherHdr* eh = reinterpret_cast<const eth::EtherHdr*>(pkt);
+    const uint8_t* iph = pkt + eth::ETH_HEADER_LEN;
+
+    switch (eh->ethertype())
+    {
+        case ProtocolId::ETHERTYPE_IPV4:
+            // not a fragment
+            if ((iph[0] >> 4) != 4 || (iph[6] & 0x3F) || iph[7])
+                return false;
+            return fast_path_transport(iph[9]);
+
+        case ProtocolId::ETHERTYPE_IPV6:
+            if (len < eth::ETH_HEADER_LEN + ip::IP6_HEADER_LEN || (iph[0] >> 4) != 6)
+                return false;
+            return fast_path_transport(iph[6]);
+
+        default:
+            return false;
+    }
+}
+
+// returns false if decoding must stop without trying the next layer
+bool PacketManager::fast_decode(Packet* p, RawData& raw, CodecData& codec_data,
+    DecodeData& unsure_encap_ptrs, ProtocolIndex& mapped_prot, ProtocolId& prev_prot_id)
+{
+    // Ethernet, as done by EthCodec::decode() for an IP ethertype
+    const eth::EtherHdr* eh = reinterpret_cast<const eth::EtherHdr*>(raw.data);
+
+    codec_data.next_prot_id = eh->ethertype();
+    codec_data.lyr_len = eth::ETH_HEADER_LEN;
+    codec_data.proto_bits = PROTO_BIT__ETH;
+
+    trace_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+    push_layer(p, codec_data, prev_prot_id, raw.data, codec_data.lyr_len);
+    next_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+
+    // IP then transport
+    constexpr uint16_t slow_flags =
+        CODEC_COMPOUND | CODEC_ETHER_NEXT | CODEC_SAVE_LAYER | CODEC_UNSURE_ENCAP;
+
+    for (int i = 0; i < 2 && prev_prot_id != ProtocolId::FINISHED_DECODE; i++)
+    {
+        if (!CodecManager::s_protocols[mapped_prot]->decode(raw, codec_data, p->ptrs))
+        {
+            s_stats[fast_path_exits]++;
+            return false;
+        }
+
+        trace_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+
+        if ((codec_data.codec_flags & slow_flags) || codec_data.tunnel_bypass || p->is_fragment())
+        {
+            s_stats[fast_path_exits]++;
+            return finish_layer(p, raw, codec_data, unsure_encap_ptrs, mapped_prot, prev_prot_id);
+        }
+
+        // If this was an IP layer, stash the next protocol in the Packet for later
+        if ((codec_data.proto_bits & (PROTO_BIT__IP | PROTO_BIT__IP6_EXT)) &&
+            codec_data.next_prot_id != ProtocolId::FINISHED_DECODE)
         {
-            codec_data.codec_flags &= ~CODEC_SAVE_LAYER;
-            unsure_encap_ptrs = p->ptrs;
+            p->ip_proto_next = convert_protocolid_to_ipprotocol(codec_data.next_prot_id);
         }
-        else if (codec_data.codec_flags & CODEC_UNSURE_ENCAP)
-            codec_data.codec_flags &= ~CODEC_UNSURE_ENCAP;
 
-        // internal statistics and record keeping
-        s_stats[mapped_prot + stat_offset]++; // add correct decode for previous layer
-        mapped_prot = CodecManager::s_proto_map[to_utype(codec_data.next_prot_id)];
-        prev_prot_id = codec_data.next_prot_id;
+        push_layer(p, codec_data, prev_prot_id, raw.data, codec_data.lyr_len);
+        next_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+    }
+
+    s_stats[fast_path]++;
+    return true;
+}
+
+void PacketManager::decode(
+    Packet* p, const DAQ_PktHdr_t* pkthdr, const uint8_t* pkt, uint32_t pktlen, bool cooked, bool retry)
+{
+    Profile profile(decodePerfStats);
+
+    DecodeData unsure_encap_ptrs;
+
+    ProtocolIndex mapped_prot = CodecManager::grinder;
+    ProtocolId prev_prot_id = CodecManager::grinder_id;
+
+    RawData raw(p->daq_msg, pkt, pktlen);
+    CodecData codec_data(p->context->conf, ProtocolId::FINISHED_DECODE);
+
+    if (cooked)
+        codec_data.codec_flags |= CODEC_STREAM_REBUILT;
+
+    // initialize all Packet information
+    p->reset();
+    p->pkth = pkthdr;
+    p->pkt = pkt;
+    p->pktlen = pktlen;
+    if (retry)
+        p->packet_flags |= PKT_RETRY;
+    layer::set_packet_pointer(p);
+
+    s_stats[total_processed]++;
 
-        // Shrink the buffer of undecoded data
-        const uint16_t curr_lyr_len = codec_data.lyr_len + codec_data.invalid_bytes;
-        assert(curr_lyr_len <= raw.len);
-        raw.len -= curr_lyr_len;
-        raw.data += curr_lyr_len;
+    bool more = true;
 
-        p->proto_bits |= codec_data.proto_bits;
+    if (s_fast_path && prev_prot_id == ProtocolId::ETHERNET_802_3 &&
+        fast_path_candidate(pkt, pktlen))
+        more = fast_decode(p, raw, codec_data, unsure_encap_ptrs, mapped_prot, prev_prot_id);
 
-        // Reset the volatile part of the codec data for the next codec to decode into
-        codec_data.next_prot_id = ProtocolId::FINISHED_DECODE;
-        codec_data.lyr_len = 0;
-        codec_data.invalid_bytes = 0;
-        codec_data.proto_bits = 0;
+    // loop until the protocol id is no longer valid
+    while (more && CodecManager::s_protocols[mapped_prot]->decode(raw, codec_data, p->ptrs))
+    {
+        trace_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+
+        if (!finish_layer(p, raw, codec_data, unsure_encap_ptrs, mapped_prot, prev_prot_id))
+            break;
     }
 
     debug_logf(decode_trace, nullptr, "Payload starts at %u, length is %u\n", pktlen - raw.len, raw.len);
@@ -972,3 +1128,265 @@ void PacketManager::log_protocols(TextLog* const text_log,
         }
     }
 }
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+bool PacketManager::test_decode(Packet* p, const DAQ_PktHdr_t* pkthdr, const uint8_t* pkt,
+    uint32_t pktlen, bool use_fast_path)
+{
+    ProtocolId grinder_id = CodecManager::grinder_id;
+    ProtocolIndex grinder = CodecManager::grinder;
+
+    CodecManager::grinder_id = ProtocolId::ETHERNET_802_3;
+    CodecManager::grinder = CodecManager::s_proto_map[to_utype(ProtocolId::ETHERNET_802_3)];
+    s_fast_path = use_fast_path;
+
+    PegCount fast = s_stats[fast_path];
+    decode(p, pkthdr, pkt, pktlen);
+
+    s_fast_path = true;
+    CodecManager::grinder_id = grinder_id;
+    CodecManager::grinder = grinder;
+
+    return s_stats[fast_path] > fast;
+}
+
+typedef std::vector<uint8_t> Bytes;
+
+static const uint8_t ip4_src[] = { 10, 1, 1, 1 };
+static const uint8_t ip4_dst[] = { 10, 1, 1, 2 };
+static const uint8_t ip6_src[] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+static const uint8_t ip6_dst[] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2 };
+
+static void put16(Bytes& b, size_t off, uint16_t v)
+{
+    b[off] = v >> 8;
+    b[off + 1] = v & 0xff;
+}
+
+static void append(Bytes& b, const uint8_t* data, size_t len)
+{ b.insert(b.end(), data, data + len); }
+
+static uint16_t cksum(const Bytes& b, uint32_t sum = 0)
+{
+    for ( size_t i = 0; i < b.size(); i += 2 )
+        sum += (b[i] << 8) | (i + 1 < b.size() ? b[i + 1] : 0);
+
+    while ( sum >> 16 )
+        sum = (sum & 0xffff) + (sum >> 16);
+
+    return ~sum;
+}
+
+static Bytes tcp(const Bytes& opts = { })
+{
+    Bytes b = { 0x9c, 0x40, 0, 80, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0x18, 0x20, 0, 0, 0, 0, 0 };
+    b[12] = ((20 + opts.size()) / 4) << 4;
+    b.insert(b.end(), opts.begin(), opts.end());
+    b.insert(b.end(), 8, 'x');
+    return b;
+}
+
+static Bytes udp()
+{
+    Bytes b = { 0x9c, 0x40, 0, 53, 0, 0, 0, 0 };
+    b.insert(b.end(), 8, 'x');
+    put16(b, 4, b.size());
+    return b;
+}
+
+static Bytes icmp(uint8_t type, const Bytes& data = Bytes(8, 'x'))
+{
+    Bytes b = { type, 0, 0, 0, 0, 1, 0, 1 };
+    b.insert(b.end(), data.begin(), data.end());
+    return b;
+}
+
+static size_t cksum_offset(IpProtocol proto)
+{
+    switch ( proto )
+    {
+    case IpProtocol::TCP: return 16;
+    case IpProtocol::UDP: return 6;
+    default: return 2;
+    }
+}
+
+static Bytes ip4(IpProtocol proto, Bytes l4, const Bytes& opts = { }, uint16_t frag = 0,
+    bool valid = true)
+{
+    if ( proto == IpProtocol::ICMPV4 )
+        put16(l4, 2, cksum(l4));
+    else
+    {
+        Bytes ph;
+        append(ph, ip4_src, sizeof(ip4_src));
+        append(ph, ip4_dst, sizeof(ip4_dst));
+        ph.insert(ph.end(), { 0, (uint8_t)proto, 0, 0 });
+        put16(ph, 10, l4.size());
+        ph.insert(ph.end(), l4.begin(), l4.end());
+        put16(l4, cksum_offset(proto), cksum(ph));
+    }
+
+    Bytes b = { 0, 0, 0, 0, 0x12, 0x34, 0, 0, 64, (uint8_t)proto, 0, 0 };
+    b[0] = 0x40 | (5 + opts.size() / 4);
+    put16(b, 2, 20 + opts.size() + l4.size());
+    put16(b, 6, frag);
+    append(b, ip4_src, sizeof(ip4_src));
+    append(b, ip4_dst, sizeof(ip4_dst));
+    b.insert(b.end(), opts.begin(), opts.end());
+    put16(b, 10, cksum(b) ^ (valid ? 0 : 1));
+
+    b.insert(b.end(), l4.begin(), l4.end());
+    return b;
+}
+
+// ext is any extension headers before the upper layer
+static Bytes ip6(IpProtocol proto, Bytes l4, const Bytes& ext = { }, uint8_t next = 0)
+{
+    Bytes ph;
+    append(ph, ip6_src, sizeof(ip6_src));
+    append(ph, ip6_dst, sizeof(ip6_dst));
+    ph.insert(ph.end(), { 0, 0, 0, 0, 0, 0, 0, (uint8_t)proto });
+    put16(ph, 34, l4.size());
+    ph.insert(ph.end(), l4.begin(), l4.end());
+    put16(l4, cksum_offset(proto), cksum(ph));
+
+    Bytes b = { 0x60, 0, 0, 0, 0, 0, (uint8_t)(ext.empty() ? proto : (IpProtocol)next), 64 };
+    put16(b, 4, ext.size() + l4.size());
+    append(b, ip6_src, sizeof(ip6_src));
+    append(b, ip6_dst, sizeof(ip6_dst));
+    b.insert(b.end(), ext.begin(), ext.end());
+    b.insert(b.end(), l4.begin(), l4.end());
+    return b;
+}
+
+static Bytes eth(uint16_t type, const Bytes& payload)
+{
+    Bytes b = { 0, 1, 2, 3, 4, 5, 0, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0, 0 };
+    put16(b, 12, type);
+    b.insert(b.end(), payload.begin(), payload.end());
+    return b;
+}
+
+static Bytes vlan(uint16_t type, const Bytes& payload)
+{
+    Bytes b = { 0, 100, 0, 0 };
+    put16(b, 2, type);
+    b.insert(b.end(), payload.begin(), payload.end());
+    return eth(0x8100, b);
+}
+
+static void check_same(const Packet& a, const Packet& b)
+{
+    REQUIRE(a.num_layers == b.num_layers);
+
+    for ( unsigned i = 0; i < a.num_layers; i++ )
+    {
+        CHECK(a.layers[i].prot_id == b.layers[i].prot_id);
+        CHECK(a.layers[i].start == b.layers[i].start);
+        CHECK(a.layers[i].length == b.layers[i].length);
+    }
+
+    CHECK(a.proto_bits == b.proto_bits);
+    CHECK(a.packet_flags == b.packet_flags);
+    CHECK(a.ip_proto_next == b.ip_proto_next);
+    CHECK(a.vlan_idx == b.vlan_idx);
+    CHECK(a.data == b.data);
+    CHECK(a.dsize == b.dsize);
+
+    CHECK(a.ptrs.tcph == b.ptrs.tcph);
+    CHECK(a.ptrs.udph == b.ptrs.udph);
+    CHECK(a.ptrs.icmph == b.ptrs.icmph);
+    CHECK(a.ptrs.sp == b.ptrs.sp);
+    CHECK(a.ptrs.dp == b.ptrs.dp);
+    CHECK(a.ptrs.decode_flags == b.ptrs.decode_flags);
+    CHECK(a.ptrs.type == b.ptrs.type);
+
+    CHECK(a.ptrs.ip_api.is_ip4() == b.ptrs.ip_api.is_ip4());
+    CHECK(a.ptrs.ip_api.is_ip6() == b.ptrs.ip_api.is_ip6());
+    CHECK(a.ptrs.ip_api.get_ip4h() == b.ptrs.ip_api.get_ip4h());
+    CHECK(a.ptrs.ip_api.get_ip6h() == b.ptrs.ip_api.get_ip6h());
+
+    if ( a.ptrs.ip_api.is_ip() and b.ptrs.ip_api.is_ip() )
+    {
+        CHECK(*a.ptrs.ip_api.get_src() == *b.ptrs.ip_api.get_src());
+        CHECK(*a.ptrs.ip_api.get_dst() == *b.ptrs.ip_api.get_dst());
+    }
+}
+
+TEST_CASE("fast path decode", "[PacketManager]")
+{
+    struct TestPacket
+    {
+        const char* name;
+        Bytes pkt;
+        bool fast;  // decoded through the transport layer by the fast path
+    };
+
+    const Bytes ip4_opts = { 1, 1, 1, 0 };
+    const Bytes tcp_opts = { 2, 4, 0x05, 0xb4, 1, 3, 3, 7 };
+    const Bytes ip6_frag = { 17, 0, 0, 1, 0, 0, 0x12, 0x34 };
+    const Bytes ip6_hop = { 6, 0, 1, 4, 0, 0, 0, 0 };
+
+    // the first 8 bytes of a udp datagram in an ip4 header
+    Bytes embedded = ip4(IpProtocol::UDP, udp());
+    embedded.resize(28);
+
+    Bytes truncated = eth(0x0800, ip4(IpProtocol::TCP, tcp()));
+    truncated.resize(eth::ETH_HEADER_LEN + 20 + 10);
+
+    const TestPacket packets[] =
+    {
+        { "ip4 tcp", eth(0x0800, ip4(IpProtocol::TCP, tcp())), true },
+        { "ip4 tcp options", eth(0x0800, ip4(IpProtocol::TCP, tcp(tcp_opts))), true },
+        { "ip4 udp", eth(0x0800, ip4(IpProtocol::UDP, udp())), true },
+        { "ip4 icmp", eth(0x0800, ip4(IpProtocol::ICMPV4, icmp(8))), true },
+        { "ip4 icmp error", eth(0x0800, ip4(IpProtocol::ICMPV4, icmp(3, embedded))), true },
+        { "ip4 options", eth(0x0800, ip4(IpProtocol::TCP, tcp(), ip4_opts)), true },
+        { "ip4 first fragment", eth(0x0800, ip4(IpProtocol::UDP, udp(), { }, 0x2000)), false },
+        { "ip4 last fragment", eth(0x0800, ip4(IpProtocol::UDP, udp(), { }, 0x0010)), false },
+        { "ip4 bad checksum", eth(0x0800, ip4(IpProtocol::TCP, tcp(), { }, 0, false)), false },
+        { "ip4 truncated", truncated, false },
+        { "ip6 tcp", eth(0x86dd, ip6(IpProtocol::TCP, tcp(tcp_opts))), true },
+        { "ip6 udp", eth(0x86dd, ip6(IpProtocol::UDP, udp())), true },
+        { "ip6 icmp", eth(0x86dd, ip6(IpProtocol::ICMPV6, icmp(128))), true },
+        { "ip6 fragment", eth(0x86dd, ip6(IpProtocol::UDP, udp(), ip6_frag, 44)), false },
+        { "ip6 hop options", eth(0x86dd, ip6(IpProtocol::TCP, tcp(), ip6_hop, 0)), false },
+        { "vlan ip4 tcp", vlan(0x0800, ip4(IpProtocol::TCP, tcp())), false },
+        { "vlan ip6 udp", vlan(0x86dd, ip6(IpProtocol::UDP, udp())), false },
+    };
+
+    const SnortConfig* sc = SnortConfig::get_conf();
+    REQUIRE(sc);
+
+    IpsContext ctx;
+    ctx.conf = sc;
+
+    DAQ_PktHdr_t pkth = { };
+    DAQ_Msg_t msg = { };
+
+    Packet slow(false);
+    Packet fast(false);
+
+    slow.context = fast.context = &ctx;
+    slow.daq_msg = fast.daq_msg = &msg;
+
+    for ( const auto& tp : packets )
+    {
+        INFO(tp.name);
+        const uint8_t* pkt = tp.pkt.data();
+        uint32_t len = tp.pkt.size();
+
+        CHECK(!PacketManager::test_decode(&slow, &pkth, pkt, len, false));
+        CHECK(PacketManager::test_decode(&fast, &pkth, pkt, len, true) == tp.fast);
+
+        check_same(slow, fast);
+    }
+}
+
+#endif
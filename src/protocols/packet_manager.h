@@ -133,11 +133,21 @@ public:
 
     static void accumulate();
 
+#ifdef UNIT_TEST
+    // decode an Ethernet frame with or without the fast path on a thread
+    // without a DAQ instance; returns true if the fast path decoded it
+    static bool test_decode(Packet*, const struct _daq_pkt_hdr*, const uint8_t* pkt,
+        uint32_t pktlen, bool fast_path);
+#endif
+
 private:
     static bool push_layer(Packet*, CodecData&, ProtocolId, const uint8_t* hdr_start, uint32_t len);
     static Codec* get_layer_codec(const Layer&, int idx);
     static void pop_teredo(Packet*, RawData&);
     static void handle_decode_failure(Packet*, RawData&, const CodecData&, const DecodeData&, ProtocolId);
+    static bool fast_decode(Packet*, RawData&, CodecData&, DecodeData&, ProtocolIndex&, ProtocolId&);
+    static bool finish_layer(Packet*, RawData&, CodecData&, DecodeData&, ProtocolIndex&, ProtocolId&);
+    static void next_layer(Packet*, RawData&, CodecData&, ProtocolIndex&, ProtocolId&);
 
     static bool encode(const Packet*, EncodeFlags,
         uint8_t lyr_start, IpProtocol next_prot, Buffer& buf);
@@ -148,7 +158,9 @@ private:
     static const uint8_t other_codecs = 1;
     static const uint8_t discards = 2;
     static const uint8_t depth_exceeded = 3;
-    static const uint8_t stat_offset = 4;
+    static const uint8_t fast_path = 4;
+    static const uint8_t fast_path_exits = 5;
+    static const uint8_t stat_offset = 6;
 
     // declared in header so it can access s_protocols
     static THREAD_LOCAL std::array<PegCount, stat_offset +
@@ -200,7 +200,7 @@ static bool dce_smb_curse(const uint8_t* data, unsigned len, CurseTracker* track
     const uint32_t dce_smb_id = 0xff534d42;  /* \xffSMB */
     const uint32_t dce_smb2_id = 0xfe534d42;  /* \xfeSMB */
     const uint8_t session_request = 0x81, session_response = 0x82, session_message = 0x00;
-    CurseTracker::DCE& dce = tracker->dce;
+    CurseTracker::DCE& dce = tracker->dce_smb;
 
     uint32_t n = 0;
     while ( n < len )
@@ -881,16 +881,31 @@ static bool ssl_v2_curse(const uint8_t* data, unsigned len, CurseTracker* tracke
 }
 
 
+// first byte filters; each rejects exactly the bytes that send its curse
+// straight to the no match state
+
+static bool dce_udp_filter(uint8_t b)
+{ return b == DCERPC_PROTO_MAJOR_VERS__4; }
+
+static bool dce_tcp_filter(uint8_t b)
+{ return b == DCERPC_PROTO_MAJOR_VERS__5; }
+
+static bool dce_smb_filter(uint8_t b)
+{ return b == 0x00 or b == 0x81 or b == 0x82; }
+
+static bool ssl_v2_filter(uint8_t b)
+{ return (b & SSL_Const::sslv2_msb_set) != 0; }
+
 // map between service and curse details
 static vector<CurseDetails> curse_map
 {
-    // name         service        alg               is_tcp
-    { "dce_udp"   , "dcerpc"     , dce_udp_curse   , false },
-    { "dce_tcp"   , "dcerpc"     , dce_tcp_curse   , true  },
-    { "mms"       , "mms"        , mms_curse       , true  },
-    { "s7commplus", "s7commplus" , s7commplus_curse, true  },
-    { "dce_smb"   , "netbios-ssn", dce_smb_curse   , true  },
-    { "sslv2"     , "ssl"        , ssl_v2_curse    , true  }
+    // name         service        alg               is_tcp  filter
+    { "dce_udp"   , "dcerpc"     , dce_udp_curse   , false , dce_udp_filter },
+    { "dce_tcp"   , "dcerpc"     , dce_tcp_curse   , true  , dce_tcp_filter },
+    { "mms"       , "mms"        , mms_curse       , true  , nullptr        },
+    { "s7commplus", "s7commplus" , s7commplus_curse, true  , nullptr        },
+    { "dce_smb"   , "netbios-ssn", dce_smb_curse   , true  , dce_smb_filter },
+    { "sslv2"     , "ssl"        , ssl_v2_curse    , true  , ssl_v2_filter  }
 };
 
 bool CurseBook::add_curse(const char* key)
@@ -1037,4 +1052,65 @@ TEST_CASE("sslv2 not found", "[SslV2Curse]")
     SECTION("byte 10"){ test(10);}
 }
 
+TEST_CASE("first byte filters", "[curses]")
+{
+    // connectionless header, little endian, 16 bytes of body
+    uint8_t dce_udp[96] = { 0x04, 0x00, 0x00, 0x00, 0x10 };
+    dce_udp[74] = 16;
+
+    // bind with a 72 byte fragment
+    const uint8_t dce_tcp[] = { 0x05, 0x00, 0x0b, 0x03, 0x10, 0x00, 0x00, 0x00, 0x48, 0x00 };
+
+    // session message carrying smb
+    const uint8_t dce_smb[] = { 0x00, 0x00, 0x00, 0x2f, 0xff, 'S', 'M', 'B' };
+
+    struct Sample
+    {
+        const char* name;
+        const uint8_t* data;
+        unsigned len;
+    };
+
+    const Sample samples[] =
+    {
+        { "dce_udp", dce_udp, sizeof(dce_udp) },
+        { "dce_tcp", dce_tcp, sizeof(dce_tcp) },
+        { "dce_smb", dce_smb, sizeof(dce_smb) },
+        { "sslv2", ssl_v2_ch, sizeof(ssl_v2_ch) },
+    };
+
+    for ( const Sample& s : samples )
+    {
+        const CurseDetails* curse = nullptr;
+
+        for ( const CurseDetails& cd : curse_map )
+            if ( cd.name == s.name )
+                curse = &cd;
+
+        REQUIRE(curse);
+        REQUIRE(curse->filter);
+
+        CurseTracker good;
+        CHECK(curse->filter(s.data[0]));
+        CHECK(curse->alg(s.data, s.len, &good));
+
+        // a rejected first byte must leave the curse unable to match
+        uint8_t data[sizeof(dce_udp)];
+        memcpy(data, s.data, s.len);
+
+        for ( unsigned b = 0; b < 256; ++b )
+        {
+            if ( curse->filter((uint8_t)b) )
+                continue;
+
+            data[0] = (uint8_t)b;
+            CurseTracker bad;
+            CHECK_FALSE(curse->alg(data, s.len, &bad));
+
+            if ( curse->is_tcp )
+                CHECK_FALSE(curse->alg(s.data, s.len, &bad));
+        }
+    }
+}
+
 #endif
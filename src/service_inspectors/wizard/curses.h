@@ -59,6 +59,8 @@ enum SSL_State
     SSL_NOT_FOUND
 };
 
+// state of all curses for one direction of a flow; each curse only
+// touches its own member so a single tracker is shared by the curses
 class CurseTracker
 {
 public:
@@ -66,7 +68,7 @@ public:
     {
         DCE_State state;
         uint32_t helper;
-    } dce;
+    } dce, dce_smb;
 
     struct MMS
     {
@@ -93,6 +95,7 @@ public:
     CurseTracker()
     {
         dce.state = DCE_State::STATE_0;
+        dce_smb.state = DCE_State::STATE_0;
         mms.state = MMS_State::MMS_STATE__TPKT_VER;
         mms.last_state = mms.state;
         s7commplus.state = S7commplus_State::S7COMMPLUS_STATE__TPKT_VER;
@@ -104,12 +107,17 @@ public:
 
 typedef bool (* curse_alg)(const uint8_t* data, unsigned len, CurseTracker*);
 
+// cheap check of the first byte of the stream or datagram; false means the
+// curse can't match so it need not be cast at all
+typedef bool (* curse_filter)(uint8_t first);
+
 struct CurseDetails
 {
     std::string name;
     const char* service;
     curse_alg alg;
     bool is_tcp;
+    curse_filter filter;  // null if any first byte is possible
 };
 
 class CurseBook
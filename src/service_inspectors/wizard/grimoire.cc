@@ -0,0 +1,544 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// grimoire.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "grimoire.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+#include "curses.h"
+
+using namespace std;
+
+//-------------------------------------------------------------------------
+// the tries are walked as an nfa with one node per page.  spell pages
+// match case insensitively and a spell glob page loops on any byte; a hex
+// wild page is entered on any one byte.  the dfa is built from that with
+// the usual subset construction over byte classes.
+//-------------------------------------------------------------------------
+
+class GrimoireBuilder
+{
+public:
+    GrimoireBuilder(Grimoire& g) : gm(g) { }
+
+    void add_done();
+    uint32_t add_root(const MagicPage*, bool fold);
+    void add_start(bool c2s, bool tcp, const vector<uint32_t>& roots);
+    void build();
+
+private:
+    struct Node
+    {
+        const MagicPage* page;
+        bool fold;
+        bool loop;
+    };
+
+    // nfa node set, curses still possible, first byte pending, tcp
+    typedef tuple<vector<uint32_t>, uint32_t, bool, bool> Key;
+
+    uint32_t add_page(const MagicPage*, bool fold, bool loop);
+
+    const MagicPage* edge(const Node& n, uint8_t b) const
+    { return n.page->next[n.fold ? toupper(b) : b]; }
+
+    void close(uint32_t id, vector<uint32_t>& set) const;
+    uint32_t intern(Key&);
+    void set_classes();
+    uint32_t filter_mask(const Grimoire::CurseList&, uint8_t) const;
+
+private:
+    Grimoire& gm;
+    vector<Node> nodes;
+    unordered_map<const MagicPage*, uint32_t> ids;
+    map<Key, uint32_t> lookup;
+    vector<Key> keys;
+    uint8_t reps[256];
+};
+
+uint32_t GrimoireBuilder::add_page(const MagicPage* p, bool fold, bool loop)
+{
+    auto it = ids.find(p);
+
+    if ( it != ids.end() )
+        return it->second;
+
+    uint32_t id = nodes.size();
+    nodes.push_back({ p, fold, loop });
+    ids[p] = id;
+
+    for ( int c = 0; c < 256; ++c )
+    {
+        if ( p->next[c] and p->next[c] != p )
+            add_page(p->next[c], fold, false);
+    }
+
+    if ( p->any )
+        add_page(p->any, fold, fold);
+
+    return id;
+}
+
+void GrimoireBuilder::add_done()
+{
+    Key k { { }, 0, false, false };
+    intern(k);
+    assert(gm.states.size() == Grimoire::done + 1);
+}
+
+uint32_t GrimoireBuilder::add_root(const MagicPage* p, bool fold)
+{ return add_page(p, fold, false); }
+
+// a spell glob also matches nothing so its page is entered with the page
+// that leads to it
+void GrimoireBuilder::close(uint32_t id, vector<uint32_t>& set) const
+{
+    set.emplace_back(id);
+    const Node& n = nodes[id];
+
+    if ( n.fold and n.page->any )
+        close(ids.at(n.page->any), set);
+}
+
+uint32_t GrimoireBuilder::filter_mask(const Grimoire::CurseList& list, uint8_t b) const
+{
+    uint32_t mask = 0;
+
+    for ( unsigned i = 0; i < list.size(); ++i )
+    {
+        if ( !list[i]->filter or list[i]->filter(b) )
+            mask |= 1u << i;
+    }
+    return mask;
+}
+
+uint32_t GrimoireBuilder::intern(Key& k)
+{
+    vector<uint32_t>& set = get<0>(k);
+    sort(set.begin(), set.end());
+    set.erase(unique(set.begin(), set.end()), set.end());
+
+    // there is only one state that can't do anything
+    if ( set.empty() and !get<1>(k) and !get<2>(k) )
+        get<3>(k) = false;
+
+    auto it = lookup.find(k);
+
+    if ( it != lookup.end() )
+        return it->second;
+
+    if ( gm.states.size() == Grimoire::max_states )
+    {
+        gm.truncated = true;
+        return Grimoire::done;
+    }
+
+    uint32_t s = gm.states.size();
+    lookup[k] = s;
+    keys.emplace_back(k);
+
+    Grimoire::State st { nullptr, get<1>(k), set.empty() and !get<2>(k), get<3>(k) };
+
+    // lowest node wins so hexes, which are added first, beat spells of
+    // the same length
+    for ( uint32_t id : set )
+    {
+        if ( nodes[id].page->value )
+        {
+            st.service = nodes[id].page->value;
+            break;
+        }
+    }
+
+    gm.states.emplace_back(st);
+    return s;
+}
+
+void GrimoireBuilder::add_start(bool c2s, bool tcp, const vector<uint32_t>& roots)
+{
+    const Grimoire::CurseList& list = tcp ? gm.tcp_curses : gm.udp_curses;
+    assert(list.size() <= 32);
+
+    Key k;
+    get<1>(k) = list.size() < 32 ? (1u << list.size()) - 1 : ~0u;
+    get<2>(k) = true;
+    get<3>(k) = tcp;
+
+    for ( uint32_t id : roots )
+        close(id, get<0>(k));
+
+    gm.starts[c2s][tcp] = intern(k);
+}
+
+// bytes that take every node and curse filter to the same place share a class
+void GrimoireBuilder::set_classes()
+{
+    map<vector<uint32_t>, uint8_t> sigs;
+
+    for ( int b = 0; b < 256; ++b )
+    {
+        vector<uint32_t> sig;
+        sig.reserve(nodes.size() + 2);
+
+        for ( const Node& n : nodes )
+        {
+            const MagicPage* p = edge(n, b);
+            sig.emplace_back(p ? ids.at(p) : ~0u);
+        }
+
+        sig.emplace_back(filter_mask(gm.tcp_curses, b));
+        sig.emplace_back(filter_mask(gm.udp_curses, b));
+
+        auto it = sigs.find(sig);
+
+        if ( it == sigs.end() )
+        {
+            uint8_t c = sigs.size();
+            sigs[sig] = c;
+            reps[c] = b;
+            gm.classes[b] = c;
+        }
+        else
+            gm.classes[b] = it->second;
+    }
+
+    gm.num_classes = sigs.size();
+}
+
+void GrimoireBuilder::build()
+{
+    set_classes();
+
+    const unsigned nc = gm.num_classes;
+
+    for ( uint32_t s = 0; s < gm.states.size(); ++s )
+    {
+        gm.trans.resize((s + 1) * nc, s);
+
+        // spent states stay put
+        if ( gm.states[s].spent )
+            continue;
+
+        // interning may grow keys so take a copy
+        const Key from = keys[s];
+
+        for ( unsigned c = 0; c < nc; ++c )
+        {
+            uint8_t b = reps[c];
+
+            Key to;
+            get<1>(to) = get<1>(from);
+            get<3>(to) = get<3>(from);
+
+            if ( get<2>(from) )
+                get<1>(to) &= filter_mask(get<3>(from) ? gm.tcp_curses : gm.udp_curses, b);
+
+            for ( uint32_t id : get<0>(from) )
+            {
+                const Node& n = nodes[id];
+
+                if ( const MagicPage* p = edge(n, b) )
+                    close(ids.at(p), get<0>(to));
+
+                if ( n.fold )
+                {
+                    if ( n.loop )
+                        get<0>(to).emplace_back(id);
+                }
+                else if ( n.page->any )
+                    get<0>(to).emplace_back(ids.at(n.page->any));
+            }
+
+            gm.trans[s * nc + c] = intern(to);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+// grimoire
+//-------------------------------------------------------------------------
+
+constexpr uint32_t Grimoire::done;
+constexpr uint32_t Grimoire::max_states;
+
+Grimoire::Grimoire(const MagicBook& c2s_hexes, const MagicBook& s2c_hexes,
+    const MagicBook& c2s_spells, const MagicBook& s2c_spells,
+    const CurseList& tcp, const CurseList& udp) : tcp_curses(tcp), udp_curses(udp)
+{
+    GrimoireBuilder gb(*this);
+    gb.add_done();
+
+    const MagicBook* hexes[2] = { &s2c_hexes, &c2s_hexes };
+    const MagicBook* spells[2] = { &s2c_spells, &c2s_spells };
+    const MagicBook::ArcaneType protos[2] = { MagicBook::ArcaneType::UDP, MagicBook::ArcaneType::TCP };
+
+    vector<uint32_t> roots[2][2];
+
+    // all hexes first so they take precedence over spells
+    for ( int c2s = 0; c2s < 2; ++c2s )
+        for ( int tcp = 0; tcp < 2; ++tcp )
+            roots[c2s][tcp].emplace_back(gb.add_root(hexes[c2s]->page1(protos[tcp]), false));
+
+    for ( int c2s = 0; c2s < 2; ++c2s )
+        for ( int tcp = 0; tcp < 2; ++tcp )
+            roots[c2s][tcp].emplace_back(gb.add_root(spells[c2s]->page1(protos[tcp]), true));
+
+    for ( int c2s = 0; c2s < 2; ++c2s )
+        for ( int tcp = 0; tcp < 2; ++tcp )
+            gb.add_start(c2s, tcp, roots[c2s][tcp]);
+
+    gb.build();
+}
+
+uint32_t Grimoire::start(bool c2s, MagicBook::ArcaneType proto) const
+{
+    assert(proto < MagicBook::ArcaneType::MAX);
+    return starts[c2s][proto == MagicBook::ArcaneType::TCP];
+}
+
+const char* Grimoire::cast(uint32_t& state, const uint8_t* data, unsigned len) const
+{
+    uint32_t s = state;
+    const char* service = nullptr;
+
+    // keep going after a match in case a longer one follows
+    for ( unsigned i = 0; i < len and !states[s].spent; ++i )
+    {
+        s = trans[s * num_classes + classes[data[i]]];
+
+        if ( states[s].service )
+            service = states[s].service;
+    }
+
+    state = s;
+    return service;
+}
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+#ifdef CATCH_TEST_BUILD
+
+#include "catch/catch.hpp"
+#include <cstring>
+
+#include "main/snort_config.h"
+
+const char* snort::SnortConfig::get_static_name(const char* name)
+{ return name; }
+
+static bool five(uint8_t b)
+{ return b == 5; }
+
+static const CurseDetails five_curse { "five", "five", nullptr, true, five };
+static const CurseDetails any_curse { "any", "any", nullptr, true, nullptr };
+
+struct Books
+{
+    HexBook c2s_hexes, s2c_hexes;
+    SpellBook c2s_spells, s2c_spells;
+
+    void hex(bool c2s, const char* key, const char* val,
+        MagicBook::ArcaneType proto = MagicBook::ArcaneType::TCP)
+    { (c2s ? c2s_hexes : s2c_hexes).add_spell(key, val, proto); }
+
+    void spell(bool c2s, const char* key, const char* val,
+        MagicBook::ArcaneType proto = MagicBook::ArcaneType::TCP)
+    { (c2s ? c2s_spells : s2c_spells).add_spell(key, val, proto); }
+
+    Grimoire* compile(const Grimoire::CurseList& tcp = { }, const Grimoire::CurseList& udp = { })
+    { return new Grimoire(c2s_hexes, s2c_hexes, c2s_spells, s2c_spells, tcp, udp); }
+};
+
+static const char* cast(const Grimoire& g, uint32_t& s, const char* text)
+{ return g.cast(s, (const uint8_t*)text, strlen(text)); }
+
+TEST_CASE("spells", "[grimoire]")
+{
+    Books b;
+    b.spell(true, "GET", "http");
+    b.spell(false, "220*FTP", "ftp");
+    b.spell(true, "foobar", "bar");
+    b.spell(true, "foo*z", "baz");
+    b.spell(true, "a**b", "star");
+    Grimoire* g = b.compile();
+
+    SECTION("case and leading whitespace")
+    {
+        uint32_t s = g->start(true, MagicBook::ArcaneType::TCP);
+        CHECK(!strcmp(cast(*g, s, " \r\n\tget /"), "http"));
+    }
+    SECTION("glob across packets")
+    {
+        uint32_t s = g->start(false, MagicBook::ArcaneType::TCP);
+        CHECK(!cast(*g, s, "220 "));
+        CHECK(!g->spent(s));
+        CHECK(!cast(*g, s, "welcome "));
+        CHECK(!strcmp(cast(*g, s, "to ftp"), "ftp"));
+    }
+    SECTION("glob after a partial literal")
+    {
+        uint32_t s = g->start(true, MagicBook::ArcaneType::TCP);
+        CHECK(!strcmp(cast(*g, s, "foobaz"), "baz"));
+    }
+    SECTION("literal star")
+    {
+        uint32_t s = g->start(true, MagicBook::ArcaneType::TCP);
+        CHECK(!strcmp(cast(*g, s, "a*b"), "star"));
+
+        s = g->start(true, MagicBook::ArcaneType::TCP);
+        CHECK(!cast(*g, s, "axb"));
+        CHECK(s == Grimoire::done);
+    }
+    SECTION("direction and protocol")
+    {
+        uint32_t s = g->start(false, MagicBook::ArcaneType::TCP);
+        CHECK(!cast(*g, s, "GET"));
+        CHECK(s == Grimoire::done);
+
+        s = g->start(true, MagicBook::ArcaneType::UDP);
+        CHECK(!cast(*g, s, "GET"));
+        CHECK(s == Grimoire::done);
+    }
+    delete g;
+}
+
+TEST_CASE("longest match", "[grimoire]")
+{
+    Books b;
+    b.spell(true, "foo", "first");
+    b.spell(true, "bar", "second");
+    b.spell(true, "foobar", "third");
+    Grimoire* g = b.compile();
+
+    SECTION("more specific")
+    {
+        uint32_t s = g->start(true, MagicBook::ArcaneType::TCP);
+        CHECK(!strcmp(cast(*g, s, "foobar"), "third"));
+    }
+    SECTION("shorter after a partial longer")
+    {
+        uint32_t s = g->start(true, MagicBook::ArcaneType::TCP);
+        CHECK(!strcmp(cast(*g, s, "foobaz"), "first"));
+    }
+    SECTION("shorter at end of packet")
+    {
+        uint32_t s = g->start(true, MagicBook::ArcaneType::TCP);
+        CHECK(!strcmp(cast(*g, s, "foo"), "first"));
+    }
+    SECTION("anchored")
+    {
+        uint32_t s = g->start(true, MagicBook::ArcaneType::TCP);
+        CHECK(!cast(*g, s, "xbar"));
+        CHECK(s == Grimoire::done);
+    }
+    delete g;
+}
+
+TEST_CASE("hexes", "[grimoire]")
+{
+    Books b;
+    b.hex(true, "|16 03|", "ssl");
+    b.hex(true, "???|04 00|", "wild");
+    b.hex(true, "GET", "hex");
+    b.spell(true, "GET", "spell");
+    b.hex(false, "|00 05|", "netflow", MagicBook::ArcaneType::UDP);
+    Grimoire* g = b.compile();
+
+    SECTION("exact bytes")
+    {
+        uint32_t s = g->start(true, MagicBook::ArcaneType::TCP);
+        CHECK(!strcmp(cast(*g, s, "\x16\x03"), "ssl"));
+
+        s = g->start(true, MagicBook::ArcaneType::TCP);
+        CHECK(!strcmp(cast(*g, s, "get"), "spell"));
+    }
+    SECTION("single byte wild")
+    {
+        uint32_t s = g->start(true, MagicBook::ArcaneType::TCP);
+        const uint8_t data[] = { 'x', 0x16, 0xff, 0x04, 0x00 };
+        CHECK(!strcmp(g->cast(s, data, sizeof(data)), "wild"));
+    }
+    SECTION("hexes beat spells")
+    {
+        uint32_t s = g->start(true, MagicBook::ArcaneType::TCP);
+        CHECK(!strcmp(cast(*g, s, "GET"), "hex"));
+    }
+    SECTION("udp")
+    {
+        uint32_t s = g->start(false, MagicBook::ArcaneType::UDP);
+        const uint8_t data[] = { 0x00, 0x05, 0x00 };
+        CHECK(!strcmp(g->cast(s, data, sizeof(data)), "netflow"));
+    }
+    delete g;
+}
+
+TEST_CASE("curse masks", "[grimoire]")
+{
+    Books b;
+    b.spell(true, "HELO", "smtp");
+    Grimoire* g = b.compile({ &five_curse, &any_curse });
+
+    uint32_t s = g->start(true, MagicBook::ArcaneType::TCP);
+    CHECK(g->get_curse_mask(s) == 3);
+    CHECK(g->get_curses(s).size() == 2);
+
+    SECTION("first byte passes")
+    {
+        const uint8_t data[] = { 0x05, 0x00 };
+        CHECK(!g->cast(s, data, sizeof(data)));
+        CHECK(g->spent(s));
+        CHECK(g->get_curse_mask(s) == 3);
+    }
+    SECTION("first byte fails")
+    {
+        CHECK(!cast(*g, s, "HEL"));
+        CHECK(!g->spent(s));
+        CHECK(g->get_curse_mask(s) == 2);
+        CHECK(!cast(*g, s, "P"));
+        CHECK(g->spent(s));
+        CHECK(g->get_curse_mask(s) == 2);
+    }
+    SECTION("mask is kept across packets")
+    {
+        CHECK(!cast(*g, s, "H"));
+        CHECK(!strcmp(cast(*g, s, "ELO"), "smtp"));
+    }
+    SECTION("udp has no curses")
+    {
+        s = g->start(true, MagicBook::ArcaneType::UDP);
+        CHECK(g->get_curse_mask(s) == 0);
+        CHECK(g->get_curses(s).empty());
+        CHECK(!cast(*g, s, "x"));
+        CHECK(s == Grimoire::done);
+    }
+    delete g;
+}
+
+#endif
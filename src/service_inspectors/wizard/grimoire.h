@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// grimoire.h
+
+#ifndef GRIMOIRE_H
+#define GRIMOIRE_H
+
+// Grimoire compiles the hex and spell tries of both directions and both
+// protocols, plus the curse first byte filters, into one deterministic
+// automaton.  A flow direction keeps a single state number which is
+// advanced across packets; the state says whether a pattern has matched,
+// whether any pattern can still match, and which curses are still
+// possible.
+
+#include <cstdint>
+#include <vector>
+
+#include "magic.h"
+
+struct CurseDetails;
+
+class Grimoire
+{
+public:
+    typedef std::vector<const CurseDetails*> CurseList;
+
+    Grimoire(const MagicBook& c2s_hexes, const MagicBook& s2c_hexes,
+        const MagicBook& c2s_spells, const MagicBook& s2c_spells,
+        const CurseList& tcp_curses, const CurseList& udp_curses);
+
+    Grimoire(const Grimoire&) = delete;
+    Grimoire& operator=(const Grimoire&) = delete;
+
+    // nothing can match and no curse is possible
+    static constexpr uint32_t done = 0;
+
+    uint32_t start(bool c2s, MagicBook::ArcaneType proto) const;
+
+    // advance state over data; returns the service of the longest hex or
+    // spell match in data, preferring hexes when both end on the same byte
+    const char* cast(uint32_t& state, const uint8_t* data, unsigned len) const;
+
+    // no hex or spell can match from this state
+    bool spent(uint32_t state) const
+    { return states[state].spent; }
+
+    // curses still possible from this state, one bit per get_curses() entry
+    uint32_t get_curse_mask(uint32_t state) const
+    { return states[state].curses; }
+
+    const CurseList& get_curses(uint32_t state) const
+    { return states[state].tcp ? tcp_curses : udp_curses; }
+
+    // patterns that would need more states are cut off at done
+    static constexpr uint32_t max_states = 1 << 16;
+
+    bool is_truncated() const
+    { return truncated; }
+
+    unsigned get_state_count() const
+    { return states.size(); }
+
+    unsigned get_class_count() const
+    { return num_classes; }
+
+private:
+    struct State
+    {
+        const char* service;
+        uint32_t curses;
+        bool spent;
+        bool tcp;
+    };
+
+    std::vector<State> states;
+    std::vector<uint32_t> trans;     // states x byte classes
+    uint8_t classes[256];
+    unsigned num_classes;
+    bool truncated = false;
+
+    uint32_t starts[2][2];           // [c2s][tcp]
+
+    CurseList tcp_curses;
+    CurseList udp_curses;
+
+    friend class GrimoireBuilder;
+};
+
+#endif
+
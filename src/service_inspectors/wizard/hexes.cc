@@ -152,36 +152,3 @@ bool HexBook::add_spell(const char* key, const char*& val, ArcaneType proto)
 
     return true;
 }
-
-const MagicPage* HexBook::find_spell(
-    const uint8_t* s, unsigned n, const MagicPage* p, unsigned i, const MagicPage*& bookmark) const
-{
-    while ( i < n )
-    {
-        int c = s[i];
-
-        if ( p->next[c] )
-        {
-            if ( p->any )
-            {
-                if ( const MagicPage* q = find_spell(s, n, p->next[c], i+1, bookmark) )
-                    return q;
-            }
-            else
-            {
-                p = p->next[c];
-                ++i;
-                continue;
-            }
-        }
-        if ( p->any )
-        {
-            if ( const MagicPage* q = find_spell(s, n, p->any, i+1, bookmark) )
-                return q;
-        }
-
-        return p->value ? p : nullptr;
-    }
-
-    return p;
-}
@@ -60,8 +60,6 @@ public:
     };
 
     virtual bool add_spell(const char* key, const char*& val, ArcaneType proto) = 0;
-    virtual const char* find_spell(const uint8_t* data, unsigned len, const MagicPage*& p,
-        const MagicPage*& bookmark) const;
 
     const MagicPage* page1(ArcaneType proto) const
     {
@@ -78,9 +76,6 @@ protected:
         assert(proto < ArcaneType::MAX);
         return &root[(int)proto];
     }
-
-    virtual const MagicPage* find_spell(const uint8_t*, unsigned,
-        const MagicPage*, unsigned, const MagicPage*&) const = 0;
 };
 
 //-------------------------------------------------------------------------
@@ -98,8 +93,6 @@ public:
 private:
     bool translate(const char*, HexVector&);
     void add_spell(const char*, const char*, HexVector&, unsigned, MagicPage*);
-    const MagicPage* find_spell(const uint8_t*, unsigned, const MagicPage*, unsigned,
-        const MagicPage*&) const override;
 };
 
 //-------------------------------------------------------------------------
@@ -117,8 +110,6 @@ public:
 private:
     bool translate(const char*, HexVector&);
     void add_spell(const char*, const char*, HexVector&, unsigned, MagicPage*);
-    const MagicPage* find_spell(const uint8_t*, unsigned, const MagicPage*, unsigned,
-        const MagicPage*&) const override;
 };
 
 #endif
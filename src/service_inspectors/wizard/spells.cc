@@ -150,56 +150,3 @@ bool SpellBook::add_spell(const char* key, const char*& val, ArcaneType proto)
 
     return true;
 }
-
-const MagicPage* SpellBook::find_spell(
-    const uint8_t* s, unsigned n, const MagicPage* p, unsigned i, const MagicPage*& bookmark) const
-{
-    while ( i < n )
-    {
-        int c = toupper(s[i]);
-
-        if ( p->next[c] )
-        {
-            if ( p->any )
-            {
-                if ( const MagicPage* q = find_spell(s, n, p->next[c], i+1, bookmark) )
-                    return q;
-            }
-            else
-            {
-                p = p->next[c];
-                ++i;
-                continue;
-            }
-        }
-        if ( p->any )
-        {
-            while ( i < n )
-            {
-                if ( const MagicPage* q = find_spell(s, n, p->any, i, bookmark) )
-                {
-                    bookmark = q->any ? q : p;
-
-                    return q;
-                }
-
-                ++i;
-            }
-
-            return p;
-        }
-
-        // If no match but has bookmark, continue lookup from bookmark
-        if ( !p->value and bookmark )
-        {
-            p = bookmark;
-            bookmark = nullptr;
-
-            return find_spell(s, n, p, i, bookmark);
-        }
-
-        return p->value ? p : nullptr;
-    }
-
-    return p;
-}
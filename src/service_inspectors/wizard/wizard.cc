@@ -30,6 +30,7 @@
 #include "trace/trace_api.h"
 
 #include "curses.h"
+#include "grimoire.h"
 #include "magic.h"
 #include "wiz_module.h"
 
@@ -71,18 +72,13 @@ THREAD_LOCAL WizStats tstats;
 // configuration
 //-------------------------------------------------------------------------
 
-struct CurseServiceTracker
-{
-    const CurseDetails* curse;
-    CurseTracker* tracker;
-};
-
 struct Wand
 {
-    const MagicPage* hex;
-    const MagicPage* spell;
-    const MagicPage* bookmark;
-    vector<CurseServiceTracker> curse_tracker;
+    // grimoire state, which also tells which curses are still possible
+    uint32_t state = Grimoire::done;
+
+    // curse state is only allocated once a tcp curse actually sees data
+    CurseTracker* curse_tracker = nullptr;
 };
 
 class Wizard;
@@ -140,22 +136,15 @@ public:
     StreamSplitter* get_splitter(bool) override;
 
     inline bool finished(Wand& w)
-    { return !w.hex and !w.spell and w.curse_tracker.empty(); }
+    { return grimoire->spent(w.state) and !grimoire->get_curse_mask(w.state); }
 
     void reset(Wand&, bool, MagicBook::MagicBook::ArcaneType);
 
     bool cast_spell(Wand&, Flow*, const uint8_t*, unsigned, uint16_t&);
-    bool spellbind(const MagicPage*&, Flow*, const uint8_t*, unsigned, const MagicPage*&);
-    bool cursebind(const vector<CurseServiceTracker>&, Flow*, const uint8_t*, unsigned);
+    bool cursebind(Wand&, Flow*, const uint8_t*, unsigned);
 
 public:
-    MagicBook* c2s_hexes;
-    MagicBook* s2c_hexes;
-
-    MagicBook* c2s_spells;
-    MagicBook* s2c_spells;
-
-    CurseBook* curses;
+    Grimoire* grimoire;
 
     uint16_t max_search_depth;
 };
@@ -180,9 +169,7 @@ MagicSplitter::MagicSplitter(bool c2s, class Wizard* w) :
 MagicSplitter::~MagicSplitter()
 {
     wizard->rem_ref();
-    // release trackers
-    for ( unsigned i = 0; i < wand.curse_tracker.size(); i++ )
-        delete wand.curse_tracker[i].tracker;
+    delete wand.curse_tracker;
 }
 
 StreamSplitter::Status MagicSplitter::scan(
@@ -241,18 +228,22 @@ StreamSplitter::Status MagicSplitter::scan(
 
 Wizard::Wizard(WizardModule* m)
 {
-    c2s_hexes = m->get_book(true, true);
-    s2c_hexes = m->get_book(false, true);
+    MagicBook* c2s_hexes = m->get_book(true, true);
+    MagicBook* s2c_hexes = m->get_book(false, true);
 
-    c2s_spells = m->get_book(true, false);
-    s2c_spells = m->get_book(false, false);
+    MagicBook* c2s_spells = m->get_book(true, false);
+    MagicBook* s2c_spells = m->get_book(false, false);
 
-    curses = m->get_curse_book();
-    max_search_depth = m->get_max_search_depth();
-}
+    CurseBook* curses = m->get_curse_book();
+
+    // the books are only needed to compile the grimoire
+    grimoire = new Grimoire(*c2s_hexes, *s2c_hexes, *c2s_spells, *s2c_spells,
+        curses->get_curses(true), curses->get_curses(false));
+
+    if ( grimoire->is_truncated() )
+        ParseWarning(WARN_CONF, "wizard patterns need more than %u states; some will not match",
+            Grimoire::max_states);
 
-Wizard::~Wizard()
-{
     delete c2s_hexes;
     delete s2c_hexes;
 
@@ -260,35 +251,18 @@ Wizard::~Wizard()
     delete s2c_spells;
 
     delete curses;
+
+    max_search_depth = m->get_max_search_depth();
 }
 
-void Wizard::reset(Wand& w, bool c2s, MagicBook::ArcaneType proto)
+Wizard::~Wizard()
 {
-    w.bookmark = nullptr;
-
-    if ( c2s )
-    {
-        w.hex = c2s_hexes->page1(proto);
-        w.spell = c2s_spells->page1(proto);
-    }
-    else
-    {
-        w.hex = s2c_hexes->page1(proto);
-        w.spell = s2c_spells->page1(proto);
-    }
-
-    bool tcp = MagicBook::ArcaneType::TCP == proto;
+    delete grimoire;
+}
 
-    if ( w.curse_tracker.empty() )
-    {
-        for ( const CurseDetails* curse : curses->get_curses(tcp) )
-        {
-            if ( tcp )
-                w.curse_tracker.emplace_back( CurseServiceTracker{ curse, new CurseTracker } );
-            else
-                w.curse_tracker.emplace_back( CurseServiceTracker{ curse, nullptr } );
-        }
-    }
+void Wizard::reset(Wand& w, bool c2s, MagicBook::ArcaneType proto)
+{
+    w.state = grimoire->start(c2s, proto);
 }
 
 void Wizard::eval(Packet* p)
@@ -327,22 +301,30 @@ StreamSplitter* Wizard::get_splitter(bool c2s)
     return new MagicSplitter(c2s, this);
 }
 
-bool Wizard::spellbind(
-    const MagicPage*& m, Flow* f, const uint8_t* data, unsigned len, const MagicPage*& bookmark)
+bool Wizard::cursebind(Wand& w, Flow* f, const uint8_t* data, unsigned len)
 {
-    f->service = m->book.find_spell(data, len, m, bookmark);
+    uint32_t mask = grimoire->get_curse_mask(w.state);
 
-    return f->service != nullptr;
-}
+    if ( !mask )
+        return false;
 
-bool Wizard::cursebind(const vector<CurseServiceTracker>& curse_tracker, Flow* f,
-        const uint8_t* data, unsigned len)
-{
-    for ( const CurseServiceTracker& cst : curse_tracker )
+    const Grimoire::CurseList& list = grimoire->get_curses(w.state);
+
+    for ( unsigned i = 0; i < list.size(); ++i )
     {
-        if ( cst.curse->alg(data, len, cst.tracker) )
+        // this curse was ruled out by the first byte
+        if ( !(mask & (1u << i)) )
+            continue;
+
+        const CurseDetails* curse = list[i];
+
+        // udp curses are stateless and get no tracker
+        if ( curse->is_tcp and !w.curse_tracker )
+            w.curse_tracker = new CurseTracker;
+
+        if ( curse->alg(data, len, curse->is_tcp ? w.curse_tracker : nullptr) )
         {
-            f->service = cst.curse->service;
+            f->service = curse->service;
 
             if ( f->service )
                 return true;
@@ -359,26 +341,22 @@ bool Wizard::cast_spell(
     len = std::min(len, static_cast<unsigned>(max_search_depth - wizard_processed_bytes));
     wizard_processed_bytes += len;
 
-    if ( w.hex and spellbind(w.hex, f, data, len, w.bookmark) )
-        return true;
+    f->service = grimoire->cast(w.state, data, len);
 
-    if ( w.spell and spellbind(w.spell, f, data, len, w.bookmark) )
+    if ( f->service )
         return true;
 
-    if ( cursebind(w.curse_tracker, f, data, curse_len) )
+    if ( cursebind(w, f, data, curse_len) )
         return true;
 
     // If we reach max value of wizard_processed_bytes,
     // but not assign any inspector - raise tcp_miss and stop
     if ( !f->service and wizard_processed_bytes >= max_search_depth )
     {
-        w.spell = nullptr;
-        w.hex = nullptr;
-
-        for ( const CurseServiceTracker& cst : w.curse_tracker )
-            delete cst.tracker;
+        w.state = Grimoire::done;
 
-        w.curse_tracker.clear();
+        delete w.curse_tracker;
+        w.curse_tracker = nullptr;
     }
 
     return false;
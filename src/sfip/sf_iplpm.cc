@@ -0,0 +1,291 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// sf_iplpm.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "sf_iplpm.h"
+
+#include <arpa/inet.h>
+
+#include "sf_cidr.h"
+#include "sf_ip.h"
+#include "sf_ipvar.h"
+
+using namespace snort;
+
+#define STRIDE 6
+#define FANOUT (1 << STRIDE)
+
+//--------------------------------------------------------------------------
+// binary trie of the configured prefixes, only used to compile
+//--------------------------------------------------------------------------
+
+// addresses are 2 host order words, most significant bit first;
+// IPv4 addresses are in the top 32 bits
+static inline unsigned get_bit(const uint64_t* w, unsigned i)
+{ return (w[i / 64] >> (63 - i % 64)) & 1; }
+
+// bits beyond the address are zero
+static inline unsigned get_chunk(const uint64_t* w, unsigned off)
+{
+    unsigned i = off / 64;
+    unsigned s = off % 64;
+    uint64_t x = w[i] << s;
+
+    if ( !i and s > 64 - STRIDE )
+        x |= w[1] >> (64 - s);
+
+    return x >> (64 - STRIDE);
+}
+
+namespace
+{
+struct BitNode
+{
+    int32_t child[2] = { -1, -1 };
+    bool pos = false;
+    bool neg = false;
+};
+
+class Compiler
+{
+public:
+    Compiler(bool has_pos) : nodes(1), pos_empty(!has_pos) { }
+
+    void add(const uint64_t* w, unsigned len, bool neg);
+    void build(std::vector<SfIpLpm::Node>&);
+
+private:
+    bool value(bool pos, bool neg) const
+    { return !neg and (pos or pos_empty); }
+
+    int uniform(int32_t idx, bool pos, bool neg) const
+    { return (neg or idx < 0) ? value(pos, neg) : below[2 * idx + pos]; }
+
+    void set_below();
+    void build(std::vector<SfIpLpm::Node>&, uint32_t at, int32_t idx, bool pos, bool neg);
+
+private:
+    std::vector<BitNode> nodes;
+    std::vector<int8_t> below;
+    bool pos_empty;
+};
+}
+
+void Compiler::add(const uint64_t* w, unsigned len, bool neg)
+{
+    int32_t idx = 0;
+
+    for ( unsigned i = 0; i < len; ++i )
+    {
+        unsigned b = get_bit(w, i);
+        int32_t c = nodes[idx].child[b];
+
+        if ( c < 0 )
+        {
+            c = nodes.size();
+            nodes.emplace_back();
+            nodes[idx].child[b] = c;
+        }
+        idx = c;
+    }
+
+    if ( neg )
+        nodes[idx].neg = true;
+    else
+        nodes[idx].pos = true;
+}
+
+// below[2 * idx + pos] is the value of every address under idx, or -1 if
+// they differ, given that idx and its ancestors are not negated and pos is
+// set if any of them are positive.  children always follow their parent.
+void Compiler::set_below()
+{
+    below.resize(2 * nodes.size());
+
+    for ( int32_t idx = nodes.size() - 1; idx >= 0; --idx )
+    {
+        for ( unsigned pos = 0; pos < 2; ++pos )
+        {
+            int v[2];
+
+            for ( unsigned b = 0; b < 2; ++b )
+            {
+                int32_t c = nodes[idx].child[b];
+                v[b] = (c < 0) ? value(pos, false) : uniform(c, pos or nodes[c].pos, nodes[c].neg);
+            }
+            below[2 * idx + pos] = (v[0] == v[1]) ? v[0] : -1;
+        }
+    }
+}
+
+void Compiler::build(std::vector<SfIpLpm::Node>& out, uint32_t at, int32_t idx, bool pos, bool neg)
+{
+    struct Child
+    {
+        int32_t idx;
+        bool pos;
+        bool neg;
+    };
+    Child inner[FANOUT];
+    unsigned num_inner = 0;
+
+    SfIpLpm::Node node = { 0, 0, 0 };
+
+    for ( unsigned c = 0; c < FANOUT; ++c )
+    {
+        int32_t cur = idx;
+        bool p = pos;
+        bool n = neg;
+
+        for ( unsigned b = 0; b < STRIDE and cur >= 0; ++b )
+        {
+            cur = nodes[cur].child[(c >> (STRIDE - 1 - b)) & 1];
+
+            if ( cur >= 0 )
+            {
+                p = p or nodes[cur].pos;
+                n = n or nodes[cur].neg;
+            }
+        }
+
+        int u = uniform(cur, p, n);
+
+        if ( u < 0 )
+        {
+            node.inner |= 1ULL << c;
+            inner[num_inner++] = { cur, p, n };
+        }
+        else if ( u )
+            node.leaf |= 1ULL << c;
+    }
+
+    // children are contiguous so they can be indexed by popcount
+    node.base = out.size();
+    out[at] = node;
+    out.resize(out.size() + num_inner);
+
+    for ( unsigned i = 0; i < num_inner; ++i )
+        build(out, node.base + i, inner[i].idx, inner[i].pos, inner[i].neg);
+}
+
+void Compiler::build(std::vector<SfIpLpm::Node>& out)
+{
+    set_below();
+    out.resize(1);
+    build(out, 0, 0, nodes[0].pos, nodes[0].neg);
+    out.shrink_to_fit();
+}
+
+//--------------------------------------------------------------------------
+// compiled var
+//--------------------------------------------------------------------------
+
+// mirrors the containment checks of the list walk in sf_ipvar.cc
+static void add_cidr(Compiler& c4, Compiler& c6, const SfCidr* cidr, bool neg)
+{
+    uint64_t w[2] = { 0, 0 };
+
+    if ( !neg and !cidr->is_set() )
+    {
+        c4.add(w, 0, false);
+        c6.add(w, 0, false);
+        return;
+    }
+
+    const SfIp* addr = cidr->get_addr();
+    unsigned bits = cidr->get_bits();
+
+    if ( addr->get_family() == AF_INET )
+    {
+        uint32_t a = ntohl(addr->get_ip4_value());
+        w[0] = (uint64_t)a << 32;
+
+        // 0.0.0.0 contains all IPv4 addresses regardless of the mask
+        unsigned len = (a and bits > 96) ? bits - 96 : 0;
+        c4.add(w, len, neg);
+    }
+    else if ( addr->get_family() == AF_INET6 )
+    {
+        const uint32_t* p = addr->get_ip6_ptr();
+        w[0] = ((uint64_t)ntohl(p[0]) << 32) | ntohl(p[1]);
+        w[1] = ((uint64_t)ntohl(p[2]) << 32) | ntohl(p[3]);
+        c6.add(w, bits > 128 ? 128 : bits, neg);
+    }
+}
+
+SfIpLpm* SfIpLpm::compile(const sfip_var_t* var)
+{
+    Compiler c4(var->head != nullptr);
+    Compiler c6(var->head != nullptr);
+
+    for ( const sfip_node_t* n = var->head; n; n = n->next )
+        add_cidr(c4, c6, n->ip, false);
+
+    for ( const sfip_node_t* n = var->neg_head; n; n = n->next )
+        add_cidr(c4, c6, n->ip, true);
+
+    SfIpLpm* lpm = new SfIpLpm;
+    c4.build(lpm->v4);
+    c6.build(lpm->v6);
+
+    return lpm;
+}
+
+void SfIpLpm::release(SfIpLpm* lpm)
+{
+    if ( lpm and !--lpm->refs )
+        delete lpm;
+}
+
+bool SfIpLpm::contains(const SfIp* ip) const
+{
+    uint64_t w[2];
+    const Node* nodes;
+
+    if ( ip->get_family() == AF_INET )
+    {
+        w[0] = (uint64_t)ntohl(ip->get_ip4_value()) << 32;
+        w[1] = 0;
+        nodes = v4.data();
+    }
+    else
+    {
+        const uint32_t* p = ip->get_ip6_ptr();
+        w[0] = ((uint64_t)ntohl(p[0]) << 32) | ntohl(p[1]);
+        w[1] = ((uint64_t)ntohl(p[2]) << 32) | ntohl(p[3]);
+        nodes = v6.data();
+    }
+
+    const Node* n = nodes;
+
+    for ( unsigned off = 0; ; off += STRIDE )
+    {
+        uint64_t bit = 1ULL << get_chunk(w, off);
+
+        if ( !(n->inner & bit) )
+            return n->leaf & bit;
+
+        n = nodes + n->base + __builtin_popcountll(n->inner & (bit - 1));
+    }
+}
+
@@ -0,0 +1,71 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// sf_iplpm.h
+
+#ifndef SF_IPLPM_H
+#define SF_IPLPM_H
+
+// Compiled form of an sfip_var_t for fast containment checks.  The positive
+// and negated lists are folded into a single set of addresses which is stored
+// as a multibit trie per address family.  Each node covers 6 bits of address
+// with a bitmap of child nodes and a bitmap of leaf values; children are
+// stored contiguously and indexed by popcount as in poptrie.  A lookup takes
+// at most 6 (IPv4) or 22 (IPv6) steps regardless of the size of the lists.
+// Copies of a var share its compiled form, which is reference counted.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct sfip_var_t;
+
+namespace snort
+{
+struct SfIp;
+}
+
+class SfIpLpm
+{
+public:
+    static SfIpLpm* compile(const sfip_var_t*);
+    static void release(SfIpLpm*);
+
+    SfIpLpm* acquire()
+    { ++refs; return this; }
+
+    bool contains(const snort::SfIp*) const;
+
+    size_t get_node_count() const
+    { return v4.size() + v6.size(); }
+
+    struct Node
+    {
+        uint64_t inner;   // child i is a node
+        uint64_t leaf;    // value of child i if it is not a node
+        uint32_t base;    // index of first child node
+    };
+
+private:
+    std::vector<Node> v4;
+    std::vector<Node> v6;
+    unsigned refs = 1;
+};
+
+#endif
+
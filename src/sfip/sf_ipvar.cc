@@ -35,6 +35,7 @@
 #include "utils/util.h"
 
 #include "sf_cidr.h"
+#include "sf_iplpm.h"
 #include "sf_vartable.h"
 
 #ifdef UNIT_TEST
@@ -67,6 +68,8 @@ void sfvar_free(sfip_var_t* var)
     if (var->value)
         snort_free(var->value);
 
+    SfIpLpm::release(var->lpm);
+
     if (var->mode == SFIP_LIST)
     {
         sfip_node_freelist(var->head);
@@ -268,8 +271,15 @@ static inline bool list_contains_node(sfip_node_t*& head, sfip_node_t*& tail, ui
     return false;
 }
 
+// rebuild the compiled form after the lists change
+static void sfvar_compile(sfip_var_t* var)
+{
+    SfIpLpm::release(var->lpm);
+    var->lpm = SfIpLpm::compile(var);
+}
+
 /* Deep copy. Returns identical, new, linked list of sfipnodes. */
-sfip_var_t* sfvar_deep_copy(const sfip_var_t* var)
+static sfip_var_t* copy_lists(const sfip_var_t* var)
 {
     sfip_var_t* ret;
 
@@ -287,6 +297,16 @@ sfip_var_t* sfvar_deep_copy(const sfip_var_t* var)
     return ret;
 }
 
+sfip_var_t* sfvar_deep_copy(const sfip_var_t* var)
+{
+    sfip_var_t* ret = copy_lists(var);
+
+    if (ret && var->lpm)
+        ret->lpm = var->lpm->acquire();
+
+    return ret;
+}
+
 static sfip_node_t* merge_lists(sfip_node_t* list1, sfip_node_t* list2, uint16_t list1_len,
     uint16_t list2_len, uint32_t& merge_len)
 {
@@ -418,13 +438,13 @@ static sfip_node_t* merge_lists(sfip_node_t* list1, sfip_node_t* list2, uint16_t
     return listHead;
 }
 
-SfIpRet sfvar_add(sfip_var_t* dst, sfip_var_t* src)
+static SfIpRet add_lists(sfip_var_t* dst, const sfip_var_t* src)
 {
     sfip_var_t* copiedvar;
 
     assert(dst and src);
 
-    if ((copiedvar = sfvar_deep_copy(src)) == nullptr)
+    if ((copiedvar = copy_lists(src)) == nullptr)
     {
         return SFIP_ALLOC_ERR;
     }
@@ -439,6 +459,13 @@ SfIpRet sfvar_add(sfip_var_t* dst, sfip_var_t* src)
     return SFIP_SUCCESS;
 }
 
+SfIpRet sfvar_add(sfip_var_t* dst, sfip_var_t* src)
+{
+    SfIpRet ret = add_lists(dst, src);
+    sfvar_compile(dst);
+    return ret;
+}
+
 // Adds the nodes in 'src' to the variable 'dst'
 // The mismatch of types is for ease-of-supporting Snort4 and
 // Snort6 simultaneously
@@ -689,7 +716,7 @@ static void _negate_lists(sfip_var_t* var)
     var->head_count = temp_count;
 }
 
-SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
+static SfIpRet parse_iplist(vartable_t* table, sfip_var_t* var,
     const char* str, int negation)
 {
     const char* end;
@@ -744,7 +771,7 @@ SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
             str++;
             list_tok = snort_strndup(str, end - str);
 
-            if ((ret = sfvar_parse_iplist(table, var, list_tok,
+            if ((ret = parse_iplist(table, var, list_tok,
                     negation ^ neg_ip)) != SFIP_SUCCESS)
             {
                 snort_free(list_tok);
@@ -771,7 +798,7 @@ SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
                 return SFIP_LOOKUP_FAILURE;
             }
 
-            copy_var = sfvar_deep_copy(tmp_var);
+            copy_var = copy_lists(tmp_var);
             /* Apply the negation */
             if (negation ^ neg_ip)
             {
@@ -794,7 +821,7 @@ SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
                 _negate_lists(copy_var);
             }
 
-            sfvar_add(var, copy_var);
+            add_lists(var, copy_var);
             sfvar_free(copy_var);
         }
         else if (*str == LIST_CLOSE)
@@ -861,6 +888,17 @@ SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
     return SFIP_SUCCESS;
 }
 
+SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
+    const char* str, int negation)
+{
+    SfIpRet ret = parse_iplist(table, var, str, negation);
+
+    if (var)
+        sfvar_compile(var);
+
+    return ret;
+}
+
 SfIpRet sfvar_validate(sfip_var_t* var)
 {
     sfip_node_t* idx, * neg_idx;
@@ -1153,6 +1191,9 @@ bool sfvar_ip_in(sfip_var_t* var, const SfIp* ip)
     if (!var || !ip)
         return false;
 
+    if (var->lpm)
+        return var->lpm->contains(ip);
+
     /* Since this is a performance-critical function it uses different
      * codepaths for IPv6 and IPv4 traffic, rather than the dual-stack
      * functions. */
@@ -1466,5 +1507,97 @@ TEST_CASE("SfIpVarAny", "[SfIpVar]")
     sfvt_free_table(table);
 }
 
+static bool list_ip_in(sfip_var_t* var, const SfIp* ip)
+{
+    return ip->get_family() == AF_INET ? sfvar_ip_in4(var, ip) : sfvar_ip_in6(var, ip);
+}
+
+TEST_CASE("SfIpVarLpm", "[SfIpVar]")
+{
+    vartable_t* table = sfvt_alloc_table();
+    std::string str = "big [";
+    char buf[64];
+
+    for (unsigned i = 0; i < 200; i++)
+    {
+        snprintf(buf, sizeof(buf), "10.%u.%u.0/24,", i % 13, i);
+        str += buf;
+
+        if (i % 3 == 0)
+        {
+            snprintf(buf, sizeof(buf), "!10.%u.%u.%u/%u,", i % 13, i, (i % 4) * 64, 26 + i % 5);
+            str += buf;
+        }
+        snprintf(buf, sizeof(buf), "2001:db8:%x::/%u,", i, 40 + i % 17);
+        str += buf;
+
+        if (i % 5 == 0)
+        {
+            snprintf(buf, sizeof(buf), "!2001:db8:%x:%x::/64,", i, i % 7);
+            str += buf;
+        }
+    }
+    str += "172.16.0.0/12,0.0.0.0/32]";
+
+    sfip_var_t* var;
+    REQUIRE(sfvt_add_str(table, str.c_str(), &var) == SFIP_SUCCESS);
+    REQUIRE(var->lpm);
+
+    sfip_var_t* copy = sfvar_create_alias(var, "copy");
+    CHECK(copy->lpm == var->lpm);
+
+    unsigned seed = 1;
+    unsigned hits = 0;
+
+    for (unsigned i = 0; i < 100000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        SfIp ip;
+
+        if (i & 1)
+        {
+            uint32_t a = htonl((10u << 24) | ((seed >> 8) % 13 << 16) |
+                (((seed >> 4) & 0xff) << 8) | ((seed >> 16) & 0xff));
+            REQUIRE(ip.set(&a, AF_INET) == SFIP_SUCCESS);
+        }
+        else
+        {
+            uint16_t a[8] = { htons(0x2001), htons(0xdb8), htons((seed >> 8) % 220),
+                htons((seed >> 4) % 8), htons(seed & 0xffff), 0, 0, htons(1) };
+            REQUIRE(ip.set(a, AF_INET6) == SFIP_SUCCESS);
+        }
+
+        bool in = sfvar_ip_in(copy, &ip);
+        CHECK(in == list_ip_in(copy, &ip));
+        hits += in;
+    }
+    CHECK(hits > 0);
+    CHECK(hits < 100000);
+
+    sfvar_free(copy);
+    sfvt_free_table(table);
+}
+
+TEST_CASE("SfIpVarLpmNegated", "[SfIpVar]")
+{
+    // negated lists without positive entries match everything else
+    vartable_t* table = sfvt_alloc_table();
+    sfip_var_t* var;
+    REQUIRE(sfvt_add_str(table, "neg [!10.0.0.0/8,!2001:db8::/32]", &var) == SFIP_SUCCESS);
+    REQUIRE(var->lpm);
+
+    SfIp ip;
+    ip.set("10.1.2.3");
+    CHECK(!sfvar_ip_in(var, &ip));
+    ip.set("11.1.2.3");
+    CHECK(sfvar_ip_in(var, &ip));
+    ip.set("2001:db8::1");
+    CHECK(!sfvar_ip_in(var, &ip));
+    ip.set("2001:db9::1");
+    CHECK(sfvar_ip_in(var, &ip));
+
+    sfvt_free_table(table);
+}
+
 #endif
 
@@ -37,6 +37,8 @@
 
 #include "sfip/sf_returns.h"
 
+class SfIpLpm;
+
 namespace snort
 {
 struct SfIp;
@@ -75,9 +77,8 @@ struct sfip_var_t
     sfip_node_t* head;
     sfip_node_t* neg_head;
 
-    /* The mode above will select whether to use the sfip_node_t linked list
-     * or the IP routing table */
-//    sfrt rt;
+    /* Compiled from the lists above whenever they change; used for lookups */
+    SfIpLpm* lpm;
 
     /* Linked list of IP variables for the variable table */
     sfip_var_t* next;
@@ -76,6 +76,10 @@ const PegInfo base_pegs[] =
     { CountType::SUM, "expected_realized", "number of expected flows realized" },
     { CountType::SUM, "expected_pruned", "number of expected flows pruned" },
     { CountType::SUM, "expected_overflows", "number of expected cache overflows" },
+    { CountType::SUM, "expected_expired", "number of expected flows expired unrealized" },
+    { CountType::SUM, "expected_capped", "number of expected flows rejected by the per flow limit" },
+    { CountType::SUM, "expected_lookups", "number of expected cache lookups" },
+    { CountType::SUM, "expected_probes", "number of expected cache slots probed by lookups" },
     { CountType::SUM, "reload_tuning_idle", "number of times stream resource tuner called while idle" },
     { CountType::SUM, "reload_tuning_packets", "number of times stream resource tuner called while processing packets" },
     { CountType::SUM, "reload_total_adds", "number of flows added by config reloads" },
@@ -125,6 +129,10 @@ void base_prep()
         stream_base_stats.expected_realized = exp_cache->get_realized();
         stream_base_stats.expected_pruned = exp_cache->get_prunes();
         stream_base_stats.expected_overflows = exp_cache->get_overflows();
+        stream_base_stats.expected_expired = exp_cache->get_expired();
+        stream_base_stats.expected_capped = exp_cache->get_capped();
+        stream_base_stats.expected_lookups = exp_cache->get_lookups();
+        stream_base_stats.expected_probes = exp_cache->get_probes();
     }
 }
 
@@ -250,7 +258,7 @@ void StreamBase::tinit()
         flow_con->init_proto(PktType::FILE, f);
 
     if ( config.flow_cache_cfg.max_flows > 0 )
-        flow_con->init_exp(config.flow_cache_cfg.max_flows);
+        flow_con->init_exp(config.flow_cache_cfg.max_flows, config.max_expected_per_flow);
 
     TcpStreamTracker::set_held_packet_timeout(config.held_packet_timeout);
 
@@ -94,6 +94,9 @@ static const Parameter s_params[] =
     { "held_packet_timeout", Parameter::PT_INT, "1:max32", "1000",
       "timeout in milliseconds for held packets" },
 
+    { "max_expected_per_flow", Parameter::PT_INT, "0:max32", "0",
+      "maximum expected flow tuples one control flow may hold at once (0 is unlimited)" },
+
     FLOW_TYPE_TABLE("ip_cache",   "ip",   ip_params),
     FLOW_TYPE_TABLE("icmp_cache", "icmp", icmp_params),
     FLOW_TYPE_TABLE("tcp_cache",  "tcp",  tcp_params),
@@ -196,6 +199,11 @@ bool StreamModule::set(const char* fqn, Value& v, SnortConfig* c)
         config.held_packet_timeout = v.get_uint32();
         return true;
     }
+    else if ( v.is("max_expected_per_flow") )
+    {
+        config.max_expected_per_flow = v.get_uint32();
+        return true;
+    }
     else if ( strstr(fqn, "ip_cache") )
         type = PktType::IP;
     else if ( strstr(fqn, "icmp_cache") )
@@ -352,6 +360,7 @@ void StreamModuleConfig::show() const
     ConfigLogger::log_value("max_aux_ip", SnortConfig::get_conf()->max_aux_ip);
     ConfigLogger::log_value("pruning_timeout", flow_cache_cfg.pruning_timeout);
     ConfigLogger::log_value("prune_flows", flow_cache_cfg.prune_flows);
+    ConfigLogger::log_value("max_expected_per_flow", max_expected_per_flow);
 
     for (int i = to_utype(PktType::IP); i < to_utype(PktType::PDU); ++i)
     {
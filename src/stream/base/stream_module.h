@@ -66,6 +66,10 @@ struct BaseStats
      PegCount expected_realized;
      PegCount expected_pruned;
      PegCount expected_overflows;
+     PegCount expected_expired;
+     PegCount expected_capped;
+     PegCount expected_lookups;
+     PegCount expected_probes;
      PegCount reload_tuning_idle;
      PegCount reload_tuning_packets;
      PegCount reload_total_adds;
@@ -93,6 +97,7 @@ struct StreamModuleConfig
     unsigned footprint = 0;
 #endif
     uint32_t held_packet_timeout = 1000;  // in milliseconds
+    uint32_t max_expected_per_flow = 0;   // 0 is unlimited
 
     void show() const;
 };
@@ -75,6 +75,12 @@ static std::mutex stream_xtra_mutex;
 Flow* Stream::get_flow(const FlowKey* key)
 { return flow_con->find_flow(key); }
 
+void Stream::prefetch_flow(Packet* p)
+{
+    if ( flow_con )
+        flow_con->prefetch_flow(p);
+}
+
 Flow* Stream::new_flow(const FlowKey* key)
 { return flow_con->new_flow(key); }
 
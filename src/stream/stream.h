@@ -84,6 +84,11 @@ public:
     // pointer to flow session object if found, otherwise null.
     static Flow* get_flow(const FlowKey*);
 
+    // Looks up the flow for a decoded packet ahead of inspection without
+    // changing the flow or the cache.  This is only a hint; the packet's
+    // flow is still found or created when stream processes it.
+    static void prefetch_flow(Packet*);
+
     // Allocates a flow session object from the flow cache table for the protocol
     // type of the specified key.  If no cache exists for that protocol type null is
     // returned.  If a flow already exists for the key a pointer to that session
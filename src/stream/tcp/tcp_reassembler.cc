@@ -34,6 +34,7 @@
 #include "profiler/profiler.h"
 #include "protocols/packet_manager.h"
 #include "time/packet_time.h"
+#include "trace/trace_points.h"
 
 #include "tcp_module.h"
 #include "tcp_normalizers.h"
@@ -566,9 +567,12 @@ int TcpReassembler::flush_to_seq(
     assert( trs.sos.seglist_base_seq == tsn->c_seq);
 
     Packet* pdu = initialize_pdu(trs, p, pkt_flags, tsn->tv);
+    uint64_t trace_start = TracePoints::start();
     int32_t flushed_bytes = flush_data_segments(trs, bytes, pdu);
     assert( flushed_bytes );
 
+    TracePoints::add(TP_STREAM_FLUSH, p, flushed_bytes, trace_start);
+
     trs.sos.seglist_base_seq += flushed_bytes;
 
     if ( pdu->data )
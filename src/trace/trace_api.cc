@@ -34,6 +34,7 @@
 
 #include "trace_config.h"
 #include "trace_logger.h"
+#include "trace_points.h"
 
 using namespace snort;
 
@@ -72,10 +73,12 @@ void TraceApi::thread_init(const TraceConfig* trace_config)
     set_logger_options(trace_config);
     update_constraints(trace_config->constraints);
     trace_config->setup_module_trace();
+    TracePoints::thread_init(trace_config);
 }
 
 void TraceApi::thread_term()
 {
+    TracePoints::thread_term();
     g_packet_constraints = nullptr;
 
     delete g_trace_logger;
@@ -87,6 +90,7 @@ void TraceApi::thread_reinit(const TraceConfig* trace_config)
     set_logger_options(trace_config);
     update_constraints(trace_config->constraints);
     trace_config->setup_module_trace();
+    TracePoints::thread_init(trace_config);
 }
 
 bool TraceApi::override_logger_factory(SnortConfig* sc, TraceLoggerFactory* factory)
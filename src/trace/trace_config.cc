@@ -49,6 +49,8 @@ TraceConfig::TraceConfig(const TraceConfig& other)
     traces = other.traces;
     ntuple = other.ntuple;
     timestamp = other.timestamp;
+    points = other.points;
+    points_size = other.points_size;
     if ( other.constraints )
         constraints = new PacketConstraints(*other.constraints);
 }
@@ -50,6 +50,9 @@ public:
     bool timestamp = false;
     bool initialized = false;
 
+    bool points = false;
+    size_t points_size = 8 * 1024 * 1024;
+
 private:
     Traces traces;
 };
@@ -153,6 +153,12 @@ void TraceModule::generate_params()
         { "timestamp", Parameter::PT_BOOL, nullptr, "false",
           "print message timestamps with trace messages" },
 
+        { "points", Parameter::PT_BOOL, nullptr, "false",
+          "write binary tracepoints for the main pipeline stages to trace_points.bin" },
+
+        { "points_size", Parameter::PT_INT, "1:maxSZ", "8",
+          "size of each packet thread's tracepoint ring in MB" },
+
         { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
     };
 
@@ -202,6 +208,16 @@ bool TraceModule::set(const char* fqn, Value& v, SnortConfig*)
         trace_parser->get_trace_config().timestamp = v.get_bool();
         return true;
     }
+    else if ( v.is("points") )
+    {
+        trace_parser->get_trace_config().points = v.get_bool();
+        return true;
+    }
+    else if ( v.is("points_size") )
+    {
+        trace_parser->get_trace_config().points_size = v.get_size() * 1024 * 1024;
+        return true;
+    }
     else if ( strstr(fqn, "trace.modules.") == fqn )
     {
         std::string option_name = extract_module_option(fqn);
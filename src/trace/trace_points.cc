@@ -0,0 +1,409 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// trace_points.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "trace_points.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+#include "detection/ips_context.h"
+#include "flow/flow.h"
+#include "flow/flow_key.h"
+#include "log/messages.h"
+#include "protocols/packet.h"
+#include "utils/stats.h"
+#include "utils/util.h"
+
+#include "trace_config.h"
+
+#ifdef UNIT_TEST
+#include <vector>
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+#define F_NAME "trace_points.bin"
+
+//-------------------------------------------------------------------------
+// ring file
+//-------------------------------------------------------------------------
+
+namespace snort
+{
+class TracePointRing
+{
+public:
+    TracePointRing() = default;
+    ~TracePointRing()
+    { close(); }
+
+    bool open(const char* file, size_t size, unsigned thread);
+    void close();
+
+    void add(TracePointId, uint64_t flow, uint32_t pkt_num, uint32_t arg,
+        uint64_t start, const char* name);
+
+    const TraceRingHeader* get_header() const
+    { return hdr; }
+
+    const TraceRecord* get_records() const
+    { return slots; }
+
+    const char* get_name(uint16_t idx) const
+    { return names[idx]; }
+
+private:
+    uint16_t get_name(const char*);
+
+private:
+    int fd = -1;
+    uint8_t* base = nullptr;
+    size_t len = 0;
+
+    TraceRingHeader* hdr = nullptr;
+    TraceRecord* slots = nullptr;
+    char (*names)[TRACE_RING_NAME_LEN] = nullptr;
+
+    uint64_t capacity = 0;
+    uint64_t next = 0;
+    uint16_t num_names = 1;
+
+    // direct mapped by pointer so the usual hit is a compare of the name
+    // with its table entry, without hashing or copying the string; the
+    // compare catches names freed and their addresses reused on reload
+    struct NameCache
+    {
+        const char* ptr;
+        uint16_t idx;
+    };
+    static constexpr unsigned name_cache_size = 64;
+    NameCache name_cache[name_cache_size] = { };
+};
+
+THREAD_LOCAL TracePointRing* trace_point_ring = nullptr;
+}
+
+static double get_ticks_per_usec()
+{
+#ifdef USE_TSC_CLOCK
+    return clock_scale();
+#else
+    return std::chrono::duration_cast<hr_duration>(std::chrono::microseconds(1)).count();
+#endif
+}
+
+bool TracePointRing::open(const char* file, size_t size, unsigned thread)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t hdr_size = sizeof(TraceRingHeader) + TRACE_RING_NAMES * TRACE_RING_NAME_LEN;
+    hdr_size = (hdr_size + page - 1) / page * page;
+
+    capacity = size / sizeof(TraceRecord);
+    len = hdr_size + capacity * sizeof(TraceRecord);
+
+    if ( !capacity )
+        return false;
+
+    fd = ::open(file, O_RDWR | O_CREAT | O_TRUNC, 0640);
+
+    if ( fd < 0 )
+    {
+        ErrorMessage("trace: can't open %s: %s\n", file, get_error(errno));
+        return false;
+    }
+
+    void* map = MAP_FAILED;
+
+    if ( !ftruncate(fd, len) )
+        map = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if ( map == MAP_FAILED )
+    {
+        ErrorMessage("trace: can't map %s: %s\n", file, get_error(errno));
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    base = (uint8_t*)map;
+    hdr = (TraceRingHeader*)base;
+    names = (char(*)[TRACE_RING_NAME_LEN])(base + sizeof(TraceRingHeader));
+    slots = (TraceRecord*)(base + hdr_size);
+
+    hdr->version = TRACE_RING_VERSION;
+    hdr->header_size = hdr_size;
+    hdr->record_size = sizeof(TraceRecord);
+    hdr->capacity = capacity;
+    hdr->ticks_per_usec = get_ticks_per_usec();
+    hdr->thread = thread;
+    hdr->names_offset = sizeof(TraceRingHeader);
+    hdr->head.store(0, std::memory_order_relaxed);
+
+    // readers check the magic before anything else
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(hdr->magic, TRACE_RING_MAGIC, sizeof(hdr->magic));
+
+    return true;
+}
+
+void TracePointRing::close()
+{
+    if ( !base )
+        return;
+
+    munmap(base, len);
+    ::close(fd);
+
+    fd = -1;
+    base = nullptr;
+    hdr = nullptr;
+    slots = nullptr;
+    names = nullptr;
+}
+
+uint16_t TracePointRing::get_name(const char* s)
+{
+    if ( !s )
+        return 0;
+
+    NameCache& nc = name_cache[((uintptr_t)s >> 3) % name_cache_size];
+
+    if ( nc.ptr == s and nc.idx and !strncmp(names[nc.idx], s, TRACE_RING_NAME_LEN - 1) )
+        return nc.idx;
+
+    uint16_t idx = 0;
+
+    for ( uint16_t i = 1; i < num_names; ++i )
+    {
+        if ( !strncmp(names[i], s, TRACE_RING_NAME_LEN - 1) )
+        {
+            idx = i;
+            break;
+        }
+    }
+
+    if ( !idx and num_names < TRACE_RING_NAMES )
+    {
+        idx = num_names++;
+        strncpy(names[idx], s, TRACE_RING_NAME_LEN - 1);
+    }
+
+    // a full table maps new names to 0, which is not cached
+    nc = { s, idx };
+    return idx;
+}
+
+void TracePointRing::add(TracePointId id, uint64_t flow, uint32_t pkt_num,
+    uint32_t arg, uint64_t start, const char* name)
+{
+    if ( !slots )
+        return;
+
+    uint64_t now = TracePoints::ticks();
+    uint16_t name_idx = get_name(name);
+
+    // the last head must be visible before the slot is rewritten so a reader
+    // that copies a partly rewritten record sees that it was lapped; the
+    // release store below only orders the fill before the new head
+    std::atomic_thread_fence(std::memory_order_release);
+
+    TraceRecord& r = slots[next % capacity];
+
+    r.time = now;
+    r.flow = flow;
+    r.pkt_num = pkt_num;
+    r.arg = arg;
+    r.elapsed = ( start and now > start ) ? std::min(now - start, (uint64_t)UINT32_MAX) : 0;
+    r.name = name_idx;
+    r.point = id;
+    r.pad = 0;
+
+    hdr->head.store(++next, std::memory_order_release);
+}
+
+//-------------------------------------------------------------------------
+// api
+//-------------------------------------------------------------------------
+
+// FNV-1a; stable for the flow's lifetime and cheap next to the rest
+static uint64_t get_flow_id(const Flow* flow)
+{
+    if ( !flow or !flow->key )
+        return 0;
+
+    const uint8_t* k = (const uint8_t*)flow->key;
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for ( unsigned i = 0; i < sizeof(*flow->key); ++i )
+        h = (h ^ k[i]) * 0x100000001b3ULL;
+
+    return h ? h : 1;
+}
+
+void TracePoints::thread_init(const TraceConfig* tc)
+{
+    if ( !is_packet_thread() )
+        return;
+
+    if ( !tc->points )
+    {
+        thread_term();
+        return;
+    }
+
+    // a reload doesn't resize an open ring
+    if ( trace_point_ring )
+        return;
+
+    std::string file;
+    get_instance_file(file, F_NAME);
+
+    trace_point_ring = new TracePointRing;
+
+    if ( !trace_point_ring->open(file.c_str(), tc->points_size, get_instance_id()) )
+        thread_term();
+}
+
+void TracePoints::thread_term()
+{
+    delete trace_point_ring;
+    trace_point_ring = nullptr;
+}
+
+void TracePoints::record(TracePointId id, const Flow* f, const Packet* p,
+    uint32_t arg, uint64_t start, const char* name)
+{
+    if ( !f and p )
+        f = p->flow;
+
+    uint64_t flow = get_flow_id(f);
+    uint64_t pkt_num = ( p and p->context ) ? p->context->packet_number : get_packet_number();
+
+    trace_point_ring->add(id, flow, (uint32_t)pkt_num, arg, start, name);
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE("trace point ring", "[trace_points]")
+{
+    char file[] = "/tmp/trace_points_XXXXXX";
+    int fd = mkstemp(file);
+    REQUIRE(fd >= 0);
+    ::close(fd);
+
+    TracePointRing ring;
+    REQUIRE(ring.open(file, 4 * sizeof(TraceRecord), 3));
+
+    const TraceRingHeader* h = ring.get_header();
+    const TraceRecord* r = ring.get_records();
+
+    CHECK(!memcmp(h->magic, TRACE_RING_MAGIC, sizeof(h->magic)));
+    CHECK(h->capacity == 4);
+    CHECK(h->thread == 3);
+    CHECK(h->record_size == sizeof(TraceRecord));
+    CHECK(h->header_size % sysconf(_SC_PAGESIZE) == 0);
+
+    SECTION("records")
+    {
+        const char* http = "http_inspect";
+        std::string copy(http);
+
+        ring.add(TP_DAQ_RECV, 0, 7, 60, 0, nullptr);
+        ring.add(TP_INSPECTOR_EVAL, 99, 7, 0, 1, http);
+        ring.add(TP_INSPECTOR_EVAL, 99, 7, 0, 0, copy.c_str());
+
+        CHECK(h->head.load() == 3);
+
+        CHECK(r[0].point == TP_DAQ_RECV);
+        CHECK(r[0].pkt_num == 7);
+        CHECK(r[0].arg == 60);
+        CHECK(r[0].flow == 0);
+        CHECK(r[0].name == 0);
+        CHECK(r[0].elapsed == 0);
+
+        CHECK(r[1].flow == 99);
+        CHECK(r[1].name == 1);
+        CHECK(r[1].elapsed > 0);
+        CHECK(r[1].time >= r[0].time);
+
+        // same name, different pointer
+        CHECK(r[2].name == 1);
+        CHECK(!strcmp(ring.get_name(1), "http_inspect"));
+
+        // same pointer, different name
+        copy = "ftp_server";
+        ring.add(TP_INSPECTOR_EVAL, 99, 7, 0, 0, copy.c_str());
+        CHECK(r[3].name == 2);
+        CHECK(!strcmp(ring.get_name(2), "ftp_server"));
+    }
+    SECTION("names")
+    {
+        // more names than cache entries and more than the table holds
+        std::vector<std::string> names;
+
+        for ( unsigned i = 0; i < TRACE_RING_NAMES + 8; ++i )
+            names.emplace_back("inspector_" + std::to_string(i));
+
+        for ( unsigned pass = 0; pass < 2; ++pass )
+        {
+            for ( unsigned i = 0; i < names.size(); ++i )
+            {
+                ring.add(TP_INSPECTOR_EVAL, 0, i, 0, 0, names[i].c_str());
+                const TraceRecord& rec = r[(h->head.load() - 1) % h->capacity];
+
+                if ( i + 1 < TRACE_RING_NAMES )
+                {
+                    CHECK(rec.name == i + 1);
+                    CHECK(names[i] == ring.get_name(rec.name));
+                }
+                else
+                    CHECK(rec.name == 0);
+            }
+        }
+    }
+    SECTION("wrap")
+    {
+        for ( unsigned i = 0; i < 6; ++i )
+            ring.add(TP_EVENT_QUEUE, 0, i, i, 0, nullptr);
+
+        CHECK(h->head.load() == 6);
+        CHECK(r[0].pkt_num == 4);
+        CHECK(r[1].pkt_num == 5);
+        CHECK(r[2].pkt_num == 2);
+        CHECK(r[3].pkt_num == 3);
+    }
+    ring.close();
+    unlink(file);
+}
+
+#endif
@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// trace_points.h
+
+#ifndef TRACE_POINTS_H
+#define TRACE_POINTS_H
+
+// Binary tracepoints for the main packet pipeline stages.  Unlike trace
+// messages there is no formatting; when trace.points is enabled each packet
+// thread writes fixed size records to a memory mapped ring file (see
+// trace_ring.h) and tools/trace_timeline turns them into per flow
+// timelines.  When disabled, each point costs one thread local test.
+
+#include <cstdint>
+
+#include "main/snort_types.h"
+#include "main/thread.h"
+#include "time/clock_defs.h"
+#include "trace/trace_ring.h"
+
+class TraceConfig;
+
+namespace snort
+{
+class Flow;
+struct Packet;
+class TracePointRing;
+
+SO_PUBLIC extern THREAD_LOCAL TracePointRing* trace_point_ring;
+
+class SO_PUBLIC TracePoints
+{
+public:
+    static void thread_init(const TraceConfig*);
+    static void thread_term();
+
+    static bool enabled()
+    { return trace_point_ring != nullptr; }
+
+    // pass the result to add() to record the elapsed time
+    static uint64_t start()
+    { return enabled() ? ticks() : 0; }
+
+    // the flow is taken from the packet, if any
+    static void add(TracePointId id, const Packet* p, uint32_t arg = 0,
+        uint64_t start = 0, const char* name = nullptr)
+    {
+        if ( enabled() )
+            record(id, nullptr, p, arg, start, name);
+    }
+
+    // for use before the packet is bound to the flow
+    static void add_flow(TracePointId id, const Flow* f, const Packet* p,
+        uint32_t arg = 0, uint64_t start = 0)
+    {
+        if ( enabled() )
+            record(id, f, p, arg, start, nullptr);
+    }
+
+    static uint64_t ticks()
+    {
+#ifdef USE_TSC_CLOCK
+        return SnortClock::now();
+#else
+        return SnortClock::now().time_since_epoch().count();
+#endif
+    }
+
+private:
+    static void record(TracePointId, const Flow*, const Packet*,
+        uint32_t arg, uint64_t start, const char*);
+};
+}
+
+#endif
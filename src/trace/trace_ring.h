@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// trace_ring.h
+
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+// Layout of the binary tracepoint ring files, shared with the reader under
+// tools/.  Everything is in host byte order.
+//
+// <file> ::= <header> <names> <pad> <record>*
+//
+// Each packet thread writes its own file.  Records start at header_size, a
+// multiple of the page size, and there are capacity of them.  Record n is
+// written to slot n % capacity and head is then advanced to n + 1 with a
+// release store.  The writer issues a release fence before filling a slot
+// so head == n is visible before record n overwrites record n - capacity;
+// a reader that copies slot pos % capacity and then finds head still less
+// than pos + capacity has an intact record.  Names (inspectors) are added to the table before the
+// first record that refers to them is published; index 0 is no name.
+
+#include <atomic>
+#include <cstdint>
+
+#define TRACE_RING_MAGIC "TPRG"
+#define TRACE_RING_VERSION 1
+
+#define TRACE_RING_NAMES 256
+#define TRACE_RING_NAME_LEN 32
+
+enum TracePointId : uint8_t
+{
+    TP_DAQ_RECV,        // arg = packet length
+    TP_FLOW_LOOKUP,     // arg = 1 if the flow was created
+    TP_STREAM_FLUSH,    // arg = bytes flushed
+    TP_INSPECTOR_EVAL,  // name = inspector
+    TP_MPSE_SEARCH,     // arg = batched searches, 0 if immediate
+    TP_EVENT_QUEUE,     // arg = queued events
+    TP_MAX
+};
+
+struct TraceRecord
+{
+    uint64_t time;      // clock ticks at the end of the event
+    uint64_t flow;      // flow key hash, 0 if none
+    uint32_t pkt_num;   // low 32 bits of the thread's packet number
+    uint32_t arg;       // see TracePointId
+    uint32_t elapsed;   // clock ticks in the event, 0 for instants
+    uint16_t name;      // index into the name table
+    uint8_t point;      // TracePointId
+    uint8_t pad;
+};
+
+static_assert(sizeof(TraceRecord) == 32, "keep records a power of 2");
+
+struct TraceRingHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;
+    uint64_t capacity;
+    double ticks_per_usec;
+    uint32_t thread;
+    uint32_t names_offset;
+
+    // the only field updated after the file is created
+    alignas(64) std::atomic<uint64_t> head;
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+    "head must have the same layout in every process");
+
+#endif
@@ -279,6 +279,16 @@ void DropStats(ControlConn* ctrlcon)
     s_ctrlcon = nullptr;
 }
 
+// current module counts from the packet thread snapshots; unlike DropStats
+// this runs entirely on the calling thread
+void PeekStats(ControlConn* ctrlcon, const char* module)
+{
+    s_ctrlcon = ctrlcon;
+    LogLabel("Module Statistics");
+    ModuleManager::dump_snapshots(module);
+    s_ctrlcon = nullptr;
+}
+
 //-------------------------------------------------------------------------
 
 void PrintStatistics()
@@ -120,6 +120,7 @@ void show_stats(SimpleStats*, const char* module_name);
 
 double CalcPct(uint64_t, uint64_t);
 void DropStats(ControlConn* ctrlcon = nullptr);
+void PeekStats(ControlConn*, const char* module = nullptr);
 void PrintStatistics();
 void TimeStart();
 void TimeStop();
@@ -0,0 +1,233 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// alert_ring_spew.cc
+
+// print the records of an alert_ring file using the schema in its header
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "log/alert_ring.h"
+
+// sleep between polls for new records when following
+#define POLL_US 10000
+
+static void print_field(const AlertRingField& f, const uint8_t* rec)
+{
+    const uint8_t* p = rec + f.offset;
+
+    switch ( f.type )
+    {
+    case ART_U8:
+        printf("%u", *p);
+        break;
+
+    case ART_U16:
+    {
+        uint16_t v;
+        memcpy(&v, p, sizeof(v));
+        printf("%u", v);
+        break;
+    }
+    case ART_U32:
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        printf("%u", v);
+        break;
+    }
+    case ART_U64:
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        printf("%" PRIu64, v);
+        break;
+    }
+    case ART_IP:
+    {
+        static const uint8_t mapped[12] = { 0,0,0,0, 0,0,0,0, 0,0,0xff,0xff };
+        char buf[INET6_ADDRSTRLEN];
+
+        if ( !memcmp(p, mapped, sizeof(mapped)) )
+            inet_ntop(AF_INET, p + sizeof(mapped), buf, sizeof(buf));
+        else
+            inet_ntop(AF_INET6, p, buf, sizeof(buf));
+
+        printf("%s", buf);
+        break;
+    }
+    case ART_STR:
+        printf("\"%.*s\"", (int)strnlen((const char*)p, f.size), (const char*)p);
+        break;
+
+    default:
+        printf("?");
+    }
+}
+
+static void print_record(const std::vector<AlertRingField>& schema, const uint8_t* rec)
+{
+    const char* sep = "";
+
+    for ( const auto& f : schema )
+    {
+        printf("%s%s=", sep, f.name);
+        print_field(f, rec);
+        sep = " ";
+    }
+    printf("\n");
+}
+
+static bool load_schema(
+    const uint8_t* base, size_t len, std::vector<AlertRingField>& schema)
+{
+    const AlertRingHeader* h = (const AlertRingHeader*)base;
+
+    if ( len < sizeof(*h) or memcmp(h->magic, ALERT_RING_MAGIC, sizeof(h->magic)) )
+    {
+        printf("ERROR: not an alert_ring file\n");
+        return false;
+    }
+    if ( h->version != ALERT_RING_VERSION )
+    {
+        printf("ERROR: unsupported version %u\n", h->version);
+        return false;
+    }
+    if ( h->schema_offset + (uint64_t)h->num_fields * sizeof(AlertRingField) > h->header_size or
+        h->header_size + h->capacity * h->record_size > len or !h->capacity )
+    {
+        printf("ERROR: bad header\n");
+        return false;
+    }
+
+    const AlertRingField* f = (const AlertRingField*)(base + h->schema_offset);
+    schema.assign(f, f + h->num_fields);
+
+    for ( auto& s : schema )
+    {
+        s.name[sizeof(s.name) - 1] = '\0';
+
+        if ( s.type >= ART_MAX or s.offset + s.size > h->record_size )
+        {
+            printf("ERROR: bad field %s\n", s.name);
+            return false;
+        }
+    }
+    return true;
+}
+
+static int spew(const char* file, bool follow)
+{
+    int fd = open(file, O_RDONLY);
+
+    if ( fd < 0 )
+    {
+        printf("ERROR: Failed to open file: %s\n\tErrno: %s\n", file, strerror(errno));
+        return 1;
+    }
+
+    struct stat st;
+    void* map = MAP_FAILED;
+
+    if ( !fstat(fd, &st) and st.st_size > 0 )
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if ( map == MAP_FAILED )
+    {
+        printf("ERROR: Failed to map file: %s\n", file);
+        return 1;
+    }
+
+    const uint8_t* base = (const uint8_t*)map;
+    std::vector<AlertRingField> schema;
+
+    if ( !load_schema(base, st.st_size, schema) )
+    {
+        munmap(map, st.st_size);
+        return 1;
+    }
+
+    const AlertRingHeader* h = (const AlertRingHeader*)base;
+    const uint8_t* slots = base + h->header_size;
+    std::vector<uint8_t> rec(h->record_size);
+
+    uint64_t head = h->head.load(std::memory_order_acquire);
+    uint64_t pos = head > h->capacity ? head - h->capacity : 0;
+    uint64_t lost = pos;
+
+    while ( true )
+    {
+        if ( pos == head )
+        {
+            if ( !follow )
+                break;
+
+            fflush(stdout);
+            usleep(POLL_US);
+            head = h->head.load(std::memory_order_acquire);
+            continue;
+        }
+
+        // the writer may have reused the slot during the copy
+        uint64_t from = pos;
+
+        if ( !alert_ring_copy(h, slots, pos, head, rec.data()) )
+        {
+            lost += pos - from;
+            continue;
+        }
+
+        print_record(schema, rec.data());
+        pos++;
+    }
+
+    if ( lost )
+        printf("%" PRIu64 " records overwritten before they were read\n", lost);
+
+    munmap(map, st.st_size);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    bool follow = (argc == 3 and !strcmp(argv[1], "-f"));
+
+    if ( argc != 2 and !follow )
+    {
+        puts("usage: alert_ring_spew [-f] <file>");
+        return 1;
+    }
+
+    return spew(argv[argc - 1], follow);
+}
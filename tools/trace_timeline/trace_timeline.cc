@@ -0,0 +1,296 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2023 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// trace_timeline.cc
+
+// build per flow timelines from one or more binary tracepoint ring files
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "trace/trace_ring.h"
+
+static const char* point_names[TP_MAX] =
+{
+    "daq_recv",
+    "flow_lookup",
+    "stream_flush",
+    "inspector_eval",
+    "mpse_search",
+    "event_queue",
+};
+
+struct Event
+{
+    TraceRecord rec;
+    unsigned file;
+};
+
+struct RingData
+{
+    unsigned thread;
+    double ticks_per_usec;
+    std::vector<std::string> names;
+};
+
+static bool load(const char* file, unsigned idx, RingData& rd, std::vector<Event>& events)
+{
+    int fd = open(file, O_RDONLY);
+
+    if ( fd < 0 )
+    {
+        printf("ERROR: Failed to open file: %s\n\tErrno: %s\n", file, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    void* map = MAP_FAILED;
+
+    if ( !fstat(fd, &st) and st.st_size > 0 )
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if ( map == MAP_FAILED )
+    {
+        printf("ERROR: Failed to map file: %s\n", file);
+        return false;
+    }
+
+    const uint8_t* base = (const uint8_t*)map;
+    const TraceRingHeader* h = (const TraceRingHeader*)base;
+    size_t len = st.st_size;
+
+    if ( len < sizeof(*h) or memcmp(h->magic, TRACE_RING_MAGIC, sizeof(h->magic)) or
+        h->version != TRACE_RING_VERSION or h->record_size != sizeof(TraceRecord) or
+        h->names_offset + TRACE_RING_NAMES * TRACE_RING_NAME_LEN > h->header_size or
+        h->header_size + h->capacity * h->record_size > len or !h->capacity )
+    {
+        printf("ERROR: not a usable trace ring file: %s\n", file);
+        munmap(map, len);
+        return false;
+    }
+
+    rd.thread = h->thread;
+    rd.ticks_per_usec = h->ticks_per_usec > 0 ? h->ticks_per_usec : 1.0;
+
+    uint64_t head = h->head.load(std::memory_order_acquire);
+    uint64_t pos = head > h->capacity ? head - h->capacity : 0;
+    const TraceRecord* slots = (const TraceRecord*)(base + h->header_size);
+
+    // names are written before the records that use them
+    const char* names = (const char*)(base + h->names_offset);
+
+    for ( unsigned i = 0; i < TRACE_RING_NAMES; ++i )
+    {
+        const char* s = names + i * TRACE_RING_NAME_LEN;
+        rd.names.emplace_back(s, strnlen(s, TRACE_RING_NAME_LEN));
+    }
+
+    size_t start = events.size();
+    uint64_t first = pos;
+
+    for ( ; pos < head; ++pos )
+    {
+        Event e;
+        e.rec = slots[pos % h->capacity];
+        e.file = idx;
+        events.emplace_back(e);
+    }
+
+    // the writer may have reused the oldest slots while they were copied;
+    // slot pos is rewritten while head == pos + capacity
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t now = h->head.load(std::memory_order_acquire);
+
+    if ( now >= first + h->capacity )
+    {
+        size_t stale = std::min<uint64_t>(now - h->capacity - first + 1, events.size() - start);
+        events.erase(events.begin() + start, events.begin() + start + stale);
+    }
+
+    events.erase(std::remove_if(events.begin() + start, events.end(),
+        [](const Event& ev) { return ev.rec.point >= TP_MAX; }), events.end());
+
+    munmap(map, len);
+    return true;
+}
+
+// packets are traced before they are bound to a flow so borrow the flow
+// from another record for the same packet on the same thread
+static void assign_flows(std::vector<Event>& events)
+{
+    std::map<std::pair<unsigned, uint32_t>, uint64_t> pkt_flows;
+
+    for ( const auto& e : events )
+    {
+        if ( e.rec.flow )
+            pkt_flows[{ e.file, e.rec.pkt_num }] = e.rec.flow;
+    }
+
+    for ( auto& e : events )
+    {
+        if ( e.rec.flow )
+            continue;
+
+        auto it = pkt_flows.find({ e.file, e.rec.pkt_num });
+
+        if ( it != pkt_flows.end() )
+            e.rec.flow = it->second;
+    }
+}
+
+static void print_event(const Event& e, const RingData& rd, uint64_t first)
+{
+    const TraceRecord& r = e.rec;
+    double at = (r.time - first) / rd.ticks_per_usec;
+
+    printf("  %12.3f us  t%-3u pkt %-10u %-15s", at, rd.thread, r.pkt_num, point_names[r.point]);
+
+    switch ( r.point )
+    {
+    case TP_DAQ_RECV:
+        printf(" len=%u", r.arg);
+        break;
+    case TP_FLOW_LOOKUP:
+        printf(" %s", r.arg ? "new" : "found");
+        break;
+    case TP_STREAM_FLUSH:
+        printf(" bytes=%u", r.arg);
+        break;
+    case TP_INSPECTOR_EVAL:
+        printf(" %s", r.name < rd.names.size() and !rd.names[r.name].empty() ?
+            rd.names[r.name].c_str() : "?");
+        break;
+    case TP_MPSE_SEARCH:
+        if ( r.arg )
+            printf(" batch=%u", r.arg);
+        else
+            printf(" immediate");
+        break;
+    case TP_EVENT_QUEUE:
+        printf(" events=%u", r.arg);
+        break;
+    }
+
+    if ( r.elapsed )
+        printf(" (%.3f us)", r.elapsed / rd.ticks_per_usec);
+
+    printf("\n");
+}
+
+static void usage()
+{
+    puts("usage: trace_timeline [-f <flow>] <file> [<file> ...]");
+    puts("    -f <flow>: only show the flow with this id (hex)");
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t only = 0;
+    int opt;
+
+    while ( (opt = getopt(argc, argv, "f:h")) != -1 )
+    {
+        switch ( opt )
+        {
+        case 'f':
+            only = strtoull(optarg, nullptr, 16);
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    if ( optind >= argc )
+    {
+        usage();
+        return 1;
+    }
+
+    std::vector<RingData> rings;
+    std::vector<Event> events;
+
+    for ( int i = optind; i < argc; ++i )
+    {
+        RingData rd;
+
+        if ( !load(argv[i], rings.size(), rd, events) )
+            return 1;
+
+        rings.emplace_back(rd);
+    }
+
+    assign_flows(events);
+
+    // all threads use the same clock so flows that move between threads
+    // still come out in order
+    std::stable_sort(events.begin(), events.end(),
+        [](const Event& l, const Event& r)
+        {
+            if ( l.rec.flow != r.rec.flow )
+                return l.rec.flow < r.rec.flow;
+            return l.rec.time < r.rec.time;
+        });
+
+    size_t i = 0;
+
+    while ( i < events.size() )
+    {
+        uint64_t flow = events[i].rec.flow;
+        size_t end = i;
+
+        while ( end < events.size() and events[end].rec.flow == flow )
+            ++end;
+
+        if ( !only or flow == only )
+        {
+            if ( flow )
+                printf("flow %016" PRIx64 ": %zu records\n", flow, end - i);
+            else
+                printf("no flow: %zu records\n", end - i);
+
+            uint64_t first = events[i].rec.time;
+
+            for ( size_t j = i; j < end; ++j )
+                print_event(events[j], rings[events[j].file], first);
+
+            printf("\n");
+        }
+        i = end;
+    }
+
+    return 0;
+}